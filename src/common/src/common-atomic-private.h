@@ -583,7 +583,26 @@ mcommon_atomic_ptr_compare_exchange_weak (void *volatile *ptr,
 static BSON_INLINE void *
 mcommon_atomic_ptr_fetch (void *volatile const *ptr, enum mcommon_memory_order ord)
 {
+#if !defined(_MSC_VER) && (defined(__GNUC__) || defined(__clang__)) && !defined(MCOMMON_USE_LEGACY_GCC_ATOMICS)
+   /* Unlike the compare-exchange below, a plain load does not take the cache
+    * line for writing. GNU doesn't want RELEASE order for the load. */
+   switch (ord) {
+   case mcommon_memory_order_release:
+   case mcommon_memory_order_acq_rel:
+   case mcommon_memory_order_seq_cst:
+      return __atomic_load_n (ptr, __ATOMIC_SEQ_CST);
+   case mcommon_memory_order_acquire:
+      return __atomic_load_n (ptr, __ATOMIC_ACQUIRE);
+   case mcommon_memory_order_consume:
+      return __atomic_load_n (ptr, __ATOMIC_CONSUME);
+   case mcommon_memory_order_relaxed:
+      return __atomic_load_n (ptr, __ATOMIC_RELAXED);
+   default:
+      BSON_UNREACHABLE ("Invalid mcommon_memory_order value");
+   }
+#else
    return mcommon_atomic_ptr_compare_exchange_strong ((void *volatile *) ptr, NULL, NULL, ord);
+#endif
 }
 
 #undef DECL_ATOMIC_STDINT
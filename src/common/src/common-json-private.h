@@ -23,6 +23,8 @@
 
 #define mcommon_iso8601_string_append COMMON_NAME (iso8601_string_append)
 #define mcommon_json_append_escaped COMMON_NAME (json_append_escaped)
+#define mcommon_json_append_value_int32 COMMON_NAME (json_append_value_int32)
+#define mcommon_json_append_value_int64 COMMON_NAME (json_append_value_int64)
 #define mcommon_json_append_value_double COMMON_NAME (json_append_value_double)
 #define mcommon_json_append_value_decimal128 COMMON_NAME (json_append_value_decimal128)
 #define mcommon_json_append_value_oid COMMON_NAME (json_append_value_oid)
@@ -37,6 +39,7 @@
 #define mcommon_json_append_bson_values COMMON_NAME (json_append_bson_values)
 #define mcommon_json_append_bson_document COMMON_NAME (json_append_bson_document)
 #define mcommon_json_append_bson_array COMMON_NAME (json_append_bson_array)
+#define mcommon_json_estimate_len COMMON_NAME (json_estimate_len)
 
 // Needed by libbson and common-json
 #ifndef BSON_MAX_RECURSION
@@ -127,13 +130,8 @@ mcommon_json_append_value_utf8 (mcommon_string_append_t *append, const char *str
  * @param mode One of the JSON serialization modes, as a bson_json_mode_t.
  * @returns true on success, false if this 'append' has exceeded its max length
  */
-static BSON_INLINE bool
-mcommon_json_append_value_int32 (mcommon_string_append_t *append, int32_t value, bson_json_mode_t mode)
-{
-   return mode == BSON_JSON_MODE_CANONICAL
-             ? mcommon_string_append_printf (append, "{ \"$numberInt\" : \"%" PRId32 "\" }", value)
-             : mcommon_string_append_printf (append, "%" PRId32, value);
-}
+bool
+mcommon_json_append_value_int32 (mcommon_string_append_t *append, int32_t value, bson_json_mode_t mode);
 
 /**
  * @brief Append an int64_t value, serialized according to a bson_json_mode_t
@@ -142,13 +140,8 @@ mcommon_json_append_value_int32 (mcommon_string_append_t *append, int32_t value,
  * @param mode One of the JSON serialization modes, as a bson_json_mode_t.
  * @returns true on success, false if this 'append' has exceeded its max length
  */
-static BSON_INLINE bool
-mcommon_json_append_value_int64 (mcommon_string_append_t *append, int64_t value, bson_json_mode_t mode)
-{
-   return mode == BSON_JSON_MODE_CANONICAL
-             ? mcommon_string_append_printf (append, "{ \"$numberLong\" : \"%" PRId64 "\" }", value)
-             : mcommon_string_append_printf (append, "%" PRId64, value);
-}
+bool
+mcommon_json_append_value_int64 (mcommon_string_append_t *append, int64_t value, bson_json_mode_t mode);
 
 /**
  * @brief Append a JSON compatible bool value
@@ -394,4 +387,17 @@ mcommon_json_append_bson_array (mcommon_string_append_t *append,
                                 bson_json_mode_t mode,
                                 unsigned max_depth);
 
+/**
+ * @brief Estimate the length of a BSON document serialized as JSON, to choose an initial buffer capacity
+ * @param bson bson_t document or array
+ * @param mode One of the JSON serialization modes, as a bson_json_mode_t
+ * @param max_len Maximum length of interest, usually the append limit. The walk stops once the estimate reaches it.
+ * @returns The estimated length in bytes, at most max_len
+ *
+ * Walks the elements without formatting them. Strings are assumed to need no escaping, and numbers are given typical
+ * widths, so the estimate is close for common documents but is not a bound. Invalid BSON ends the walk early.
+ */
+uint32_t
+mcommon_json_estimate_len (const bson_t *bson, bson_json_mode_t mode, uint32_t max_len);
+
 #endif /* MONGO_C_DRIVER_COMMON_JSON_PRIVATE_H */
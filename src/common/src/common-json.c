@@ -20,348 +20,196 @@
 #include <common-string-private.h>
 #include <common-utf8-private.h>
 #include <common-json-private.h>
+#include <common-ryu-private.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MCOMMON_JSON_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define MCOMMON_JSON_NEON
+#endif
 
 
-typedef struct {
-   mcommon_string_append_t *append;
-   unsigned max_depth;
-   bson_json_mode_t mode;
-   bool has_keys;
-   bool not_first_item;
-   bool is_corrupt;
-} mcommon_json_append_visit_t;
-
-
-static bool
-mcommon_json_append_visit_utf8 (
-   const bson_iter_t *iter, const char *key, size_t v_utf8_len, const char *v_utf8, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_utf8_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   return !mcommon_json_append_value_utf8 (state->append, v_utf8, (uint32_t) v_utf8_len, true);
-}
-
-static bool
-mcommon_json_append_visit_int32 (const bson_iter_t *iter, const char *key, int32_t v_int32, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_int32 (state->append, v_int32, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_int64 (const bson_iter_t *iter, const char *key, int64_t v_int64, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_int64 (state->append, v_int64, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_decimal128 (const bson_iter_t *iter,
-                                      const char *key,
-                                      const bson_decimal128_t *value,
-                                      void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_decimal128 (state->append, value);
-}
-
-static bool
-mcommon_json_append_visit_double (const bson_iter_t *iter, const char *key, double v_double, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_double (state->append, v_double, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_undefined (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_undefined (state->append);
-}
-
-static bool
-mcommon_json_append_visit_null (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_null (state->append);
-}
-
-static bool
-mcommon_json_append_visit_oid (const bson_iter_t *iter, const char *key, const bson_oid_t *oid, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_oid (state->append, oid);
-}
-
-static bool
-mcommon_json_append_visit_binary (const bson_iter_t *iter,
-                                  const char *key,
-                                  bson_subtype_t v_subtype,
-                                  size_t v_binary_len,
-                                  const uint8_t *v_binary,
-                                  void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_binary_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   return !mcommon_json_append_value_binary (state->append, v_subtype, v_binary, (uint32_t) v_binary_len, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_bool (const bson_iter_t *iter, const char *key, bool v_bool, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_bool (state->append, v_bool);
-}
-
-static bool
-mcommon_json_append_visit_date_time (const bson_iter_t *iter, const char *key, int64_t msec_since_epoch, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_date_time (state->append, msec_since_epoch, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_regex (
-   const bson_iter_t *iter, const char *key, const char *v_regex, const char *v_options, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   size_t v_regex_len = strlen (v_regex);
-   size_t v_options_len = strlen (v_options);
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_regex_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   return !mcommon_json_append_value_regex (
-      state->append, v_regex, (uint32_t) v_regex_len, v_options, v_options_len, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_timestamp (
-   const bson_iter_t *iter, const char *key, uint32_t v_timestamp, uint32_t v_increment, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_timestamp (state->append, v_timestamp, v_increment);
-}
-
-static bool
-mcommon_json_append_visit_dbpointer (const bson_iter_t *iter,
-                                     const char *key,
-                                     size_t v_collection_len,
-                                     const char *v_collection,
-                                     const bson_oid_t *v_oid,
-                                     void *data)
+bool
+mcommon_json_append_bson_values (
+   mcommon_string_append_t *append, const bson_t *bson, bson_json_mode_t mode, bool has_keys, unsigned max_depth)
 {
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_collection_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
+   bson_iter_t iter;
+   if (!bson_iter_init (&iter, bson)) {
+      return false;
    }
-   return !mcommon_json_append_value_dbpointer (
-      state->append, v_collection, (uint32_t) v_collection_len, v_oid, state->mode);
-}
 
-static bool
-mcommon_json_append_visit_minkey (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_minkey (state->append);
-}
-
-static bool
-mcommon_json_append_visit_maxkey (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_json_append_value_maxkey (state->append);
-}
-
-static bool
-mcommon_json_append_visit_before (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-
-   if (!mcommon_string_status_from_append (state->append)) {
-      return true;
-   }
+   /* Dispatch on each element's type directly rather than through bson_iter_visit_all(), with the same validation:
+    * keys must be valid UTF-8, string contents must be valid UTF-8 (internal NULs allowed), and nested documents must
+    * be well formed. Once the append fails we stop reading, so our success is based only on the BSON we read. */
+   bool not_first_item = false;
+   while (bson_iter_next (&iter)) {
+      const char *key = bson_iter_key_unsafe (&iter);
+      const uint32_t key_len = bson_iter_key_len (&iter);
+      if (key_len && !bson_utf8_validate (key, key_len, false)) {
+         return false;
+      }
 
-   if (state->not_first_item) {
-      if (!mcommon_json_append_separator (state->append)) {
+      if (!mcommon_string_status_from_append (append)) {
          return true;
       }
-   } else {
-      state->not_first_item = true;
-   }
 
-   if (state->has_keys) {
-      size_t key_len = strlen (key);
-      if (!mlib_in_range (uint32_t, key_len)) {
-         mcommon_string_append_overflow (state->append);
-         return true;
+      if (not_first_item) {
+         if (!mcommon_json_append_separator (append)) {
+            return true;
+         }
+      } else {
+         not_first_item = true;
       }
-      if (!mcommon_json_append_key (state->append, key, (uint32_t) key_len)) {
+
+      if (has_keys && !mcommon_json_append_key (append, key, key_len)) {
          return true;
       }
-   }
-
-   return false;
-}
-
-static bool
-mcommon_json_append_visit_after (const bson_iter_t *iter, const char *key, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   return !mcommon_string_status_from_append (state->append);
-}
-
-static void
-mcommon_json_append_visit_corrupt (const bson_iter_t *iter, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   state->is_corrupt = true;
-}
-
-static bool
-mcommon_json_append_visit_code (
-   const bson_iter_t *iter, const char *key, size_t v_code_len, const char *v_code, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_code_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   return !mcommon_json_append_value_code (state->append, v_code, (uint32_t) v_code_len);
-}
-
-static bool
-mcommon_json_append_visit_symbol (
-   const bson_iter_t *iter, const char *key, size_t v_symbol_len, const char *v_symbol, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_symbol_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   return !mcommon_json_append_value_symbol (state->append, v_symbol, (uint32_t) v_symbol_len, state->mode);
-}
-
-static bool
-mcommon_json_append_visit_codewscope (
-   const bson_iter_t *iter, const char *key, size_t v_code_len, const char *v_code, const bson_t *v_scope, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (!mlib_in_range (uint32_t, v_code_len)) {
-      mcommon_string_append_overflow (state->append);
-      return true;
-   }
-   if (mcommon_json_append_value_codewscope (
-          state->append, v_code, (uint32_t) v_code_len, v_scope, state->mode, state->max_depth)) {
-      return !mcommon_string_status_from_append (state->append);
-   } else {
-      state->is_corrupt = true;
-      return true;
-   }
-}
 
-static bool
-mcommon_json_append_visit_document (const bson_iter_t *iter, const char *key, const bson_t *v_document, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (mcommon_json_append_bson_document (state->append, v_document, state->mode, state->max_depth)) {
-      return !mcommon_string_status_from_append (state->append);
-   } else {
-      state->is_corrupt = true;
-      return true;
-   }
-}
+      bool appended = true;
+      switch (bson_iter_type (&iter)) {
+      case BSON_TYPE_DOUBLE:
+         appended = mcommon_json_append_value_double (append, bson_iter_double_unsafe (&iter), mode);
+         break;
+      case BSON_TYPE_UTF8: {
+         uint32_t utf8_len;
+         const char *utf8 = bson_iter_utf8 (&iter, &utf8_len);
+         if (!bson_utf8_validate (utf8, utf8_len, true)) {
+            return false;
+         }
+         appended = mcommon_json_append_value_utf8 (append, utf8, utf8_len, true);
+      } break;
+      case BSON_TYPE_DOCUMENT:
+      case BSON_TYPE_ARRAY: {
+         const uint8_t *data = NULL;
+         uint32_t data_len = 0;
+         bson_t child;
+         if (bson_iter_type (&iter) == BSON_TYPE_DOCUMENT) {
+            bson_iter_document (&iter, &data_len, &data);
+         } else {
+            bson_iter_array (&iter, &data_len, &data);
+         }
+         if (!bson_init_static (&child, data, data_len)) {
+            return false;
+         }
+         if (!(bson_iter_type (&iter) == BSON_TYPE_DOCUMENT
+                  ? mcommon_json_append_bson_document (append, &child, mode, max_depth)
+                  : mcommon_json_append_bson_array (append, &child, mode, max_depth))) {
+            return false;
+         }
+      } break;
+      case BSON_TYPE_BINARY: {
+         const uint8_t *binary = NULL;
+         bson_subtype_t subtype = BSON_SUBTYPE_BINARY;
+         uint32_t binary_len = 0;
+         bson_iter_binary (&iter, &subtype, &binary_len, &binary);
+         appended = mcommon_json_append_value_binary (append, subtype, binary, binary_len, mode);
+      } break;
+      case BSON_TYPE_UNDEFINED:
+         appended = mcommon_json_append_value_undefined (append);
+         break;
+      case BSON_TYPE_OID:
+         appended = mcommon_json_append_value_oid (append, bson_iter_oid_unsafe (&iter));
+         break;
+      case BSON_TYPE_BOOL:
+         appended = mcommon_json_append_value_bool (append, bson_iter_bool (&iter));
+         break;
+      case BSON_TYPE_DATE_TIME:
+         appended = mcommon_json_append_value_date_time (append, bson_iter_date_time (&iter), mode);
+         break;
+      case BSON_TYPE_NULL:
+         appended = mcommon_json_append_value_null (append);
+         break;
+      case BSON_TYPE_REGEX: {
+         const char *options = NULL;
+         const char *regex = bson_iter_regex (&iter, &options);
+         const size_t regex_len = strlen (regex);
+         if (!bson_utf8_validate (regex, regex_len, true)) {
+            return false;
+         }
+         if (!mlib_in_range (uint32_t, regex_len)) {
+            mcommon_string_append_overflow (append);
+            return true;
+         }
+         appended =
+            mcommon_json_append_value_regex (append, regex, (uint32_t) regex_len, options, strlen (options), mode);
+      } break;
+      case BSON_TYPE_DBPOINTER: {
+         uint32_t collection_len = 0;
+         const char *collection = NULL;
+         const bson_oid_t *oid = NULL;
+         bson_iter_dbpointer (&iter, &collection_len, &collection, &oid);
+         if (!bson_utf8_validate (collection, collection_len, true)) {
+            return false;
+         }
+         appended = mcommon_json_append_value_dbpointer (append, collection, collection_len, oid, mode);
+      } break;
+      case BSON_TYPE_CODE: {
+         uint32_t code_len;
+         const char *code = bson_iter_code (&iter, &code_len);
+         if (!bson_utf8_validate (code, code_len, true)) {
+            return false;
+         }
+         appended = mcommon_json_append_value_code (append, code, code_len);
+      } break;
+      case BSON_TYPE_SYMBOL: {
+         uint32_t symbol_len;
+         const char *symbol = bson_iter_symbol (&iter, &symbol_len);
+         if (!bson_utf8_validate (symbol, symbol_len, true)) {
+            return false;
+         }
+         appended = mcommon_json_append_value_symbol (append, symbol, symbol_len, mode);
+      } break;
+      case BSON_TYPE_CODEWSCOPE: {
+         uint32_t code_len = 0;
+         const uint8_t *scope_data = NULL;
+         uint32_t scope_len = 0;
+         bson_t scope;
+         const char *code = bson_iter_codewscope (&iter, &code_len, &scope_len, &scope_data);
+         if (!bson_utf8_validate (code, code_len, true) || !bson_init_static (&scope, scope_data, scope_len)) {
+            return false;
+         }
+         if (!mcommon_json_append_value_codewscope (append, code, code_len, &scope, mode, max_depth)) {
+            return false;
+         }
+      } break;
+      case BSON_TYPE_INT32:
+         appended = mcommon_json_append_value_int32 (append, bson_iter_int32_unsafe (&iter), mode);
+         break;
+      case BSON_TYPE_TIMESTAMP: {
+         uint32_t timestamp;
+         uint32_t increment;
+         bson_iter_timestamp (&iter, &timestamp, &increment);
+         appended = mcommon_json_append_value_timestamp (append, timestamp, increment);
+      } break;
+      case BSON_TYPE_INT64:
+         appended = mcommon_json_append_value_int64 (append, bson_iter_int64_unsafe (&iter), mode);
+         break;
+      case BSON_TYPE_DECIMAL128: {
+         bson_decimal128_t dec;
+         bson_iter_decimal128 (&iter, &dec);
+         appended = mcommon_json_append_value_decimal128 (append, &dec);
+      } break;
+      case BSON_TYPE_MAXKEY:
+         appended = mcommon_json_append_value_maxkey (append);
+         break;
+      case BSON_TYPE_MINKEY:
+         appended = mcommon_json_append_value_minkey (append);
+         break;
+      case BSON_TYPE_EOD:
+      default:
+         // bson_iter_next() stops at unsupported types, so this is unreachable.
+         return false;
+      }
 
-static bool
-mcommon_json_append_visit_array (const bson_iter_t *iter, const char *key, const bson_t *v_array, void *data)
-{
-   mcommon_json_append_visit_t *state = data;
-   BSON_UNUSED (iter);
-   BSON_UNUSED (key);
-   if (mcommon_json_append_bson_array (state->append, v_array, state->mode, state->max_depth)) {
-      return !mcommon_string_status_from_append (state->append);
-   } else {
-      state->is_corrupt = true;
-      return true;
+      // Stop at the first value that cannot be appended, such as a regex with a NUL. What was read so far is valid.
+      if (!appended || !mcommon_string_status_from_append (append)) {
+         return true;
+      }
    }
-}
 
-bool
-mcommon_json_append_bson_values (
-   mcommon_string_append_t *append, const bson_t *bson, bson_json_mode_t mode, bool has_keys, unsigned max_depth)
-{
-   mcommon_json_append_visit_t state = {.append = append, .max_depth = max_depth, .mode = mode, .has_keys = has_keys};
-   bson_iter_t iter;
-   if (!bson_iter_init (&iter, bson)) {
-      return false;
-   }
-   static const bson_visitor_t visitors = {
-      mcommon_json_append_visit_before,     mcommon_json_append_visit_after,     mcommon_json_append_visit_corrupt,
-      mcommon_json_append_visit_double,     mcommon_json_append_visit_utf8,      mcommon_json_append_visit_document,
-      mcommon_json_append_visit_array,      mcommon_json_append_visit_binary,    mcommon_json_append_visit_undefined,
-      mcommon_json_append_visit_oid,        mcommon_json_append_visit_bool,      mcommon_json_append_visit_date_time,
-      mcommon_json_append_visit_null,       mcommon_json_append_visit_regex,     mcommon_json_append_visit_dbpointer,
-      mcommon_json_append_visit_code,       mcommon_json_append_visit_symbol,    mcommon_json_append_visit_codewscope,
-      mcommon_json_append_visit_int32,      mcommon_json_append_visit_timestamp, mcommon_json_append_visit_int64,
-      mcommon_json_append_visit_maxkey,     mcommon_json_append_visit_minkey,    NULL, /* visit_unsupported_type */
-      mcommon_json_append_visit_decimal128,
-   };
-   /* Note that early exit from bson_iter_visit_all does not affect our success, which is based only on BSON validity.
-    * BSON errors will set is_corrupt if they prevent full traversal, but non-fatal parse errors (like invalid UTF-8)
-    * may let bson_iter_visit_all() succeed while leaving an error status in iter.err_off. */
-   (void) bson_iter_visit_all (&iter, &visitors, &state);
-   return iter.err_off == 0 && !state.is_corrupt;
+   return iter.err_off == 0;
 }
 
 static BSON_INLINE bool
@@ -408,6 +256,90 @@ mcommon_json_append_bson_array (mcommon_string_append_t *append,
    return mcommon_json_append_bson_container (append, bson, mode, max_depth, false, "[ ]", "[ ", " ]", "[ ... ]");
 }
 
+/**
+ * @brief Add the estimated JSON length of each element of a document or array to '*len', stopping once it reaches
+ * 'max_len'.
+ */
+static void
+mcommon_json_estimate_values_len (
+   bson_iter_t *iter, bson_json_mode_t mode, bool has_keys, unsigned max_depth, uint64_t max_len, uint64_t *len)
+{
+   const bool canonical = mode == BSON_JSON_MODE_CANONICAL;
+   const bool legacy = mode == BSON_JSON_MODE_LEGACY;
+
+   while (*len < max_len && bson_iter_next (iter)) {
+      // ", " and the quoted key with its " : ".
+      *len += 2u + (has_keys ? bson_iter_key_len (iter) + 5u : 0u);
+
+      switch (bson_iter_type (iter)) {
+      case BSON_TYPE_DOUBLE:
+         *len += canonical ? 44u : 20u;
+         break;
+      case BSON_TYPE_UTF8:
+      case BSON_TYPE_SYMBOL:
+      case BSON_TYPE_CODE:
+         // Most strings need no escaping. Code and symbols are wrapped when not legacy.
+         *len += (uint64_t) bson_iter_utf8_len_unsafe (iter) + 2u;
+         if (bson_iter_type (iter) != BSON_TYPE_UTF8) {
+            *len += 14u;
+         }
+         break;
+      case BSON_TYPE_DOCUMENT:
+      case BSON_TYPE_ARRAY: {
+         bson_iter_t child;
+         *len += 4u;
+         if (max_depth > 0u && bson_iter_recurse (iter, &child)) {
+            mcommon_json_estimate_values_len (
+               &child, mode, bson_iter_type (iter) == BSON_TYPE_DOCUMENT, max_depth - 1u, max_len, len);
+         }
+      } break;
+      case BSON_TYPE_BINARY: {
+         const uint8_t *binary = NULL;
+         bson_subtype_t subtype;
+         uint32_t binary_len = 0;
+         bson_iter_binary (iter, &subtype, &binary_len, &binary);
+         // Base64 grows the data by a third, within { "$binary" : { "base64" : "", "subType" : "00" } }.
+         *len += (uint64_t) binary_len / 3u * 4u + 56u;
+      } break;
+      case BSON_TYPE_OID:
+         *len += 39u;
+         break;
+      case BSON_TYPE_BOOL:
+         *len += 5u;
+         break;
+      case BSON_TYPE_NULL:
+         *len += 4u;
+         break;
+      case BSON_TYPE_INT32:
+         *len += canonical ? 26u : 6u;
+         break;
+      case BSON_TYPE_INT64:
+         *len += canonical ? 34u : 13u;
+         break;
+      case BSON_TYPE_DATE_TIME:
+         *len += legacy ? 24u : 44u;
+         break;
+      default:
+         // Rarer types, whose lengths are close enough to a constant.
+         *len += 48u;
+         break;
+      }
+   }
+}
+
+uint32_t
+mcommon_json_estimate_len (const bson_t *bson, bson_json_mode_t mode, uint32_t max_len)
+{
+   BSON_ASSERT_PARAM (bson);
+
+   bson_iter_t iter;
+   uint64_t len = 4u;
+   if (bson_iter_init (&iter, bson)) {
+      mcommon_json_estimate_values_len (&iter, mode, true, BSON_MAX_RECURSION, max_len, &len);
+   }
+   return (uint32_t) BSON_MIN (len, (uint64_t) max_len);
+}
+
 /**
  * @brief Like mcommon_string_append_printf (append, "\\u%04x", c) but intended to be more optimizable.
  */
@@ -443,20 +375,43 @@ mcommon_json_append_escaped_considers_byte_as_special (uint8_t byte)
 
 /**
  * @brief Measure the number of consecutive non-special bytes.
+ *
+ * Runs are checked 16 bytes at a time with SSE2 or NEON, then the table finds the exact byte that ended the run.
  */
 static BSON_INLINE uint32_t
 mcommon_json_append_escaped_count_non_special_bytes (const char *str, uint32_t len)
 {
    uint32_t result = 0;
-   // Good candidate for architecture-specific optimizations.
-   // SSE4 strcspn is nearly what we want, but our table of special bytes would be too large (34 > 16)
-   while (len) {
-      if (mcommon_json_append_escaped_considers_byte_as_special ((uint8_t) *str)) {
+#if defined(MCOMMON_JSON_SSE2)
+   const __m128i max_control = _mm_set1_epi8 (0x1f);
+   const __m128i quote = _mm_set1_epi8 ('"');
+   const __m128i backslash = _mm_set1_epi8 ('\\');
+   const __m128i c0 = _mm_set1_epi8 ((char) 0xc0);
+   for (; result + 16u <= len; result += 16u) {
+      const __m128i chunk = _mm_loadu_si128 ((const __m128i *) (str + result));
+      // Unsigned bytes up to 0x1F are those left unchanged by an unsigned minimum with 0x1F.
+      __m128i special = _mm_cmpeq_epi8 (_mm_min_epu8 (chunk, max_control), chunk);
+      special = _mm_or_si128 (special, _mm_cmpeq_epi8 (chunk, quote));
+      special = _mm_or_si128 (special, _mm_cmpeq_epi8 (chunk, backslash));
+      special = _mm_or_si128 (special, _mm_cmpeq_epi8 (chunk, c0));
+      if (_mm_movemask_epi8 (special)) {
+         break;
+      }
+   }
+#elif defined(MCOMMON_JSON_NEON)
+   for (; result + 16u <= len; result += 16u) {
+      const uint8x16_t chunk = vld1q_u8 ((const uint8_t *) (str + result));
+      uint8x16_t special = vcltq_u8 (chunk, vdupq_n_u8 (0x20));
+      special = vorrq_u8 (special, vceqq_u8 (chunk, vdupq_n_u8 ('"')));
+      special = vorrq_u8 (special, vceqq_u8 (chunk, vdupq_n_u8 ('\\')));
+      special = vorrq_u8 (special, vceqq_u8 (chunk, vdupq_n_u8 (0xc0)));
+      if (vmaxvq_u8 (special)) {
          break;
       }
+   }
+#endif
+   while (result < len && !mcommon_json_append_escaped_considers_byte_as_special ((uint8_t) str[result])) {
       result++;
-      str++;
-      len--;
    }
    return result;
 }
@@ -580,6 +535,178 @@ mcommon_iso8601_string_append (mcommon_string_append_t *append, int64_t msec_sin
    }
 }
 
+static const char mcommon_json_digit_pairs[] = "00010203040506070809"
+                                               "10111213141516171819"
+                                               "20212223242526272829"
+                                               "30313233343536373839"
+                                               "40414243444546474849"
+                                               "50515253545556575859"
+                                               "60616263646566676869"
+                                               "70717273747576777879"
+                                               "80818283848586878889"
+                                               "90919293949596979899";
+
+/**
+ * @brief Write the decimal digits of 'value' so they end just before 'end', two digits at a time.
+ * @returns A pointer to the first digit.
+ */
+static BSON_INLINE char *
+mcommon_json_format_uint64_backward (char *end, uint64_t value)
+{
+   while (value >= 100u) {
+      const uint32_t pair = (uint32_t) (value % 100u) * 2u;
+      value /= 100u;
+      *--end = mcommon_json_digit_pairs[pair + 1u];
+      *--end = mcommon_json_digit_pairs[pair];
+   }
+   if (value >= 10u) {
+      const uint32_t pair = (uint32_t) value * 2u;
+      *--end = mcommon_json_digit_pairs[pair + 1u];
+      *--end = mcommon_json_digit_pairs[pair];
+   } else {
+      *--end = (char) ('0' + value);
+   }
+   return end;
+}
+
+/**
+ * @brief Append a signed integer, or a canonical extended JSON wrapper such as { "$numberInt" : "1" } if 'wrapper' is
+ * a key such as "$numberInt".
+ */
+static BSON_INLINE bool
+mcommon_json_append_integer (mcommon_string_append_t *append, int64_t value, const char *wrapper)
+{
+   // Room for "-9223372036854775808".
+   char digits[20];
+   char *const end = digits + sizeof digits;
+   char *begin = mcommon_json_format_uint64_backward (end, value < 0 ? 0u - (uint64_t) value : (uint64_t) value);
+   if (value < 0) {
+      *--begin = '-';
+   }
+   const size_t digits_len = (size_t) (end - begin);
+
+   if (!wrapper) {
+      return mcommon_string_append_bytes (append, begin, (uint32_t) digits_len);
+   }
+
+   // Build the whole wrapper so it takes a single append.
+   char buf[64];
+   const size_t wrapper_len = strlen (wrapper);
+   BSON_ASSERT (wrapper_len + digits_len + 11u <= sizeof buf);
+   char *p = buf;
+   memcpy (p, "{ \"", 3u);
+   p += 3;
+   memcpy (p, wrapper, wrapper_len);
+   p += wrapper_len;
+   memcpy (p, "\" : \"", 5u);
+   p += 5;
+   memcpy (p, begin, digits_len);
+   p += digits_len;
+   memcpy (p, "\" }", 3u);
+   p += 3;
+   return mcommon_string_append_bytes (append, buf, (uint32_t) (p - buf));
+}
+
+bool
+mcommon_json_append_value_int32 (mcommon_string_append_t *append, int32_t value, bson_json_mode_t mode)
+{
+   return mcommon_json_append_integer (append, value, mode == BSON_JSON_MODE_CANONICAL ? "$numberInt" : NULL);
+}
+
+bool
+mcommon_json_append_value_int64 (mcommon_string_append_t *append, int64_t value, bson_json_mode_t mode)
+{
+   return mcommon_json_append_integer (append, value, mode == BSON_JSON_MODE_CANONICAL ? "$numberLong" : NULL);
+}
+
+// Room for "-0.0000" and 17 significant digits, or "-d." with 16 more digits and "e-324".
+#define MCOMMON_JSON_DOUBLE_MAX_LEN 32
+
+/**
+ * @brief Format a finite double with the fewest significant digits that read back as the same value.
+ * @returns The length of the text written to 'buf', which is not NUL terminated.
+ *
+ * The layout matches the "%.20g" printf() format used before: fixed notation for decimal exponents from -4 through 19,
+ * otherwise one digit before the decimal point and an exponent of at least two digits. A trailing ".0" distinguishes
+ * "3.0" from "3".
+ */
+static uint32_t
+mcommon_json_format_double (char buf[MCOMMON_JSON_DOUBLE_MAX_LEN], double value)
+{
+   char *p = buf;
+   uint64_t bits;
+   memcpy (&bits, &value, sizeof bits);
+   if (bits >> 63) {
+      *p++ = '-';
+   }
+
+   if (value == 0.0) {
+      memcpy (p, "0.0", 3u);
+      return (uint32_t) (p - buf) + 3u;
+   }
+
+   uint64_t significand;
+   int32_t exponent;
+   mcommon_ryu_d2d (value, &significand, &exponent);
+   while (significand % 10u == 0u) {
+      significand /= 10u;
+      exponent++;
+   }
+
+   char digits[20];
+   char *const digits_end = digits + sizeof digits;
+   const char *const digits_begin = mcommon_json_format_uint64_backward (digits_end, significand);
+   const int32_t num_digits = (int32_t) (digits_end - digits_begin);
+   const int32_t sci_exponent = exponent + num_digits - 1;
+
+   if (sci_exponent >= -4 && sci_exponent < 20) {
+      if (sci_exponent < 0) {
+         // 0.000ddd
+         memcpy (p, "0.0000", 1u - (size_t) sci_exponent);
+         p += 1 - sci_exponent;
+         memcpy (p, digits_begin, (size_t) num_digits);
+         p += num_digits;
+      } else if (num_digits <= sci_exponent + 1) {
+         // ddd000.0
+         memcpy (p, digits_begin, (size_t) num_digits);
+         p += num_digits;
+         memset (p, '0', (size_t) (sci_exponent + 1 - num_digits));
+         p += sci_exponent + 1 - num_digits;
+         memcpy (p, ".0", 2u);
+         p += 2;
+      } else {
+         // ddd.ddd
+         memcpy (p, digits_begin, (size_t) sci_exponent + 1u);
+         p += sci_exponent + 1;
+         *p++ = '.';
+         memcpy (p, digits_begin + sci_exponent + 1, (size_t) (num_digits - sci_exponent - 1));
+         p += num_digits - sci_exponent - 1;
+      }
+   } else {
+      // d.ddde+XX
+      *p++ = digits_begin[0];
+      if (num_digits > 1) {
+         *p++ = '.';
+         memcpy (p, digits_begin + 1, (size_t) num_digits - 1u);
+         p += num_digits - 1;
+      }
+      *p++ = 'e';
+      *p++ = sci_exponent < 0 ? '-' : '+';
+      const uint32_t abs_exponent = (uint32_t) (sci_exponent < 0 ? -sci_exponent : sci_exponent);
+      if (abs_exponent < 10u) {
+         *p++ = '0';
+      }
+      char exponent_digits[3];
+      const char *const exponent_begin =
+         mcommon_json_format_uint64_backward (exponent_digits + sizeof exponent_digits, abs_exponent);
+      const size_t exponent_len = (size_t) (exponent_digits + sizeof exponent_digits - exponent_begin);
+      memcpy (p, exponent_begin, exponent_len);
+      p += exponent_len;
+   }
+
+   return (uint32_t) (p - buf);
+}
+
 bool
 mcommon_json_append_value_double (mcommon_string_append_t *append, double value, bson_json_mode_t mode)
 {
@@ -601,15 +728,12 @@ mcommon_json_append_value_double (mcommon_string_append_t *append, double value,
       } else {
          mcommon_string_append (append, "-Infinity");
       }
+   } else if (value != value || value * 0 != 0) {
+      /* legacy mode writes non-finite values as the platform's printf does */
+      mcommon_string_append_printf (append, "%.20g", value);
    } else {
-      const mcommon_string_t *string = mcommon_string_from_append (append);
-      uint32_t start_len = string->len;
-      if (mcommon_string_append_printf (append, "%.20g", value)) {
-         /* ensure trailing ".0" to distinguish "3" from "3.0" */
-         if (strspn (&string->str[start_len], "0123456789-") == string->len - start_len) {
-            mcommon_string_append (append, ".0");
-         }
-      }
+      char buf[MCOMMON_JSON_DOUBLE_MAX_LEN];
+      (void) mcommon_string_append_bytes (append, buf, mcommon_json_format_double (buf, value));
    }
 
    if (!legacy) {
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <common-prelude.h>
+
+#ifndef MONGO_C_DRIVER_COMMON_RYU_PRIVATE_H
+#define MONGO_C_DRIVER_COMMON_RYU_PRIVATE_H
+
+#include <bson/bson.h>
+
+#define mcommon_ryu_d2d COMMON_NAME (ryu_d2d)
+
+/**
+ * @brief Find the shortest decimal representation of a double that reads back as the same value
+ * @param value A finite, nonzero double. The sign is ignored.
+ * @param digits Set to the decimal significand, at most 17 digits
+ * @param exponent Set to the power of ten, such that |value| rounds to digits * 10^exponent
+ *
+ * This is the Ryu algorithm by Ulf Adams. Among the shortest representations, the one closest to the exact value is
+ * chosen, breaking ties toward an even last digit.
+ */
+void
+mcommon_ryu_d2d (double value, uint64_t *digits, int32_t *exponent);
+
+#endif /* MONGO_C_DRIVER_COMMON_RYU_PRIVATE_H */
@@ -56,15 +56,20 @@ typedef struct mcommon_string_t {
  *
  * 'max_len_exceeded' only includes operations undertaken on this specific mcommon_string_append_t. It will not be set
  * if the string was already overlong, or if a different mcommon_string_append_t experiences an overage.
+ *
+ * '_arena' is the bson_arena_t the string and its buffer were allocated from by mcommon_string_new_arena_as_append(),
+ * or NULL if they were allocated with bson_malloc(). Growth through this append operation reallocates within the arena.
  */
 typedef struct mcommon_string_append_t {
    mcommon_string_t *_string;
    uint32_t _max_len;
    bool _max_len_exceeded;
+   bson_arena_t *_arena;
 } mcommon_string_append_t;
 
 #define mcommon_string_new_with_capacity COMMON_NAME (string_new_with_capacity)
 #define mcommon_string_new_with_buffer COMMON_NAME (string_new_with_buffer)
+#define mcommon_string_new_arena_as_append COMMON_NAME (string_new_arena_as_append)
 #define mcommon_string_destroy COMMON_NAME (string_destroy)
 #define mcommon_string_destroy_with_steal COMMON_NAME (string_destroy_with_steal)
 #define mcommon_string_grow_to_capacity COMMON_NAME (string_grow_to_capacity)
@@ -245,6 +250,7 @@ mcommon_string_set_append_with_limit (mcommon_string_t *string, mcommon_string_a
    new_append->_string = string;
    new_append->_max_len = max_len;
    new_append->_max_len_exceeded = false;
+   new_append->_arena = NULL;
 }
 
 /**
@@ -329,6 +335,20 @@ mcommon_string_new_as_fixed_capacity_append (mcommon_string_append_t *new_append
    mcommon_string_set_append_with_limit (mcommon_string_new_with_capacity ("", 0, capacity), new_append, capacity);
 }
 
+/**
+ * @brief Allocate an empty mcommon_string_t and its buffer from an arena, and set an append operation for it with
+ * maximum length
+ * @param arena Arena to allocate from. The string grows within the arena.
+ * @param new_append Pointer to an uninitialized mcommon_string_append_t
+ * @param capacity Initial capacity for the string, in bytes, not including NUL termination
+ *
+ * The string is valid until the arena is reset or destroyed, and must only be grown through this append operation or
+ * copies of it. mcommon_string_from_append_destroy() releases nothing, and
+ * mcommon_string_from_append_destroy_with_steal() returns a copy of the string that must be freed with bson_free().
+ */
+void
+mcommon_string_new_arena_as_append (bson_arena_t *arena, mcommon_string_append_t *new_append, uint32_t capacity);
+
 /**
  * @brief Check the status of an append operation.
  * @param append Append operation, initialized with mcommon_string_set_append
@@ -399,7 +419,9 @@ mcommon_string_from_append_destroy (const mcommon_string_append_t *append)
 {
    BSON_ASSERT_PARAM (append);
 
-   mcommon_string_destroy (mcommon_string_from_append (append));
+   if (!append->_arena) {
+      mcommon_string_destroy (mcommon_string_from_append (append));
+   }
 }
 
 /**
@@ -427,6 +449,10 @@ mcommon_string_from_append_destroy_with_steal (const mcommon_string_append_t *ap
 {
    BSON_ASSERT_PARAM (append);
 
+   if (append->_arena) {
+      // The caller frees the result with bson_free(), so copy it out of the arena.
+      return bson_strndup (mcommon_str_from_append (append), mcommon_strlen_from_append (append));
+   }
    return mcommon_string_destroy_with_steal (mcommon_string_from_append (append));
 }
 
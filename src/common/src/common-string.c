@@ -47,6 +47,22 @@ mcommon_string_new_with_buffer (char *buffer, uint32_t length, uint32_t alloc)
    return string;
 }
 
+void
+mcommon_string_new_arena_as_append (bson_arena_t *arena, mcommon_string_append_t *new_append, uint32_t capacity)
+{
+   BSON_ASSERT_PARAM (arena);
+   BSON_ASSERT_PARAM (new_append);
+   BSON_ASSERT (capacity < UINT32_MAX);
+   uint32_t alloc = capacity + 1u;
+   mcommon_string_t *string = bson_arena_alloc (arena, sizeof *string);
+   string->str = bson_arena_alloc (arena, alloc);
+   string->str[0] = '\0';
+   string->len = 0;
+   string->alloc = alloc;
+   mcommon_string_set_append (string, new_append);
+   new_append->_arena = arena;
+}
+
 void
 mcommon_string_destroy (mcommon_string_t *string)
 {
@@ -81,6 +97,24 @@ mcommon_string_grow_to_capacity (mcommon_string_t *string, uint32_t capacity)
    }
 }
 
+// Like mcommon_string_grow_to_capacity(), but reallocates within the append operation's arena if it has one
+static void
+_mcommon_string_append_grow_to_capacity (mcommon_string_append_t *append, uint32_t capacity)
+{
+   mcommon_string_t *string = append->_string;
+   BSON_ASSERT (capacity < UINT32_MAX);
+   if (!append->_arena) {
+      mcommon_string_grow_to_capacity (string, capacity);
+      return;
+   }
+   uint32_t min_alloc_needed = capacity + 1u;
+   if (string->alloc < min_alloc_needed) {
+      uint32_t alloc = mcommon_next_power_of_two_u32 (min_alloc_needed);
+      string->str = bson_arena_realloc_ctx (string->str, alloc, append->_arena);
+      string->alloc = alloc;
+   }
+}
+
 // Handle cases omitted from the inlined mcommon_string_append_bytes()
 bool
 mcommon_string_append_bytes_internal (mcommon_string_append_t *append, const char *str, uint32_t len)
@@ -101,7 +135,7 @@ mcommon_string_append_bytes_internal (mcommon_string_append_t *append, const cha
 
    uint32_t new_len = old_len + truncated_append_len;
    BSON_ASSERT (new_len <= max_len);
-   mcommon_string_grow_to_capacity (string, new_len);
+   _mcommon_string_append_grow_to_capacity (append, new_len);
    char *buffer = string->str;
 
    memcpy (buffer + old_len, str, truncated_append_len);
@@ -136,7 +170,7 @@ mcommon_string_append_bytes_all_or_none (mcommon_string_append_t *append, const
 
    uint32_t new_len = old_len + len;
    BSON_ASSERT (new_len <= max_len);
-   mcommon_string_grow_to_capacity (string, new_len);
+   _mcommon_string_append_grow_to_capacity (append, new_len);
    char *buffer = string->str;
 
    memcpy (buffer + old_len, str, len);
@@ -160,7 +194,7 @@ mcommon_string_append_unichar_internal (mcommon_string_append_t *append, bson_un
    // Usually we can write the UTF-8 sequence directly
    if (BSON_LIKELY (max_append_len >= sizeof max_utf8_sequence)) {
       uint32_t actual_sequence_len;
-      mcommon_string_grow_to_capacity (string, old_len + sizeof max_utf8_sequence);
+      _mcommon_string_append_grow_to_capacity (append, old_len + sizeof max_utf8_sequence);
       char *buffer = string->str;
       mcommon_utf8_from_unichar (unichar, buffer + old_len, &actual_sequence_len);
       BSON_ASSERT (actual_sequence_len <= sizeof max_utf8_sequence);
@@ -199,7 +233,7 @@ mcommon_string_append_base64_encode (mcommon_string_append_t *append, const uint
 
    if (encoded_target_len <= (size_t) max_append_len) {
       // No truncation needed. Grow the buffer and encode directly.
-      mcommon_string_grow_to_capacity (string, old_len + encoded_target_len);
+      _mcommon_string_append_grow_to_capacity (append, old_len + encoded_target_len);
       BSON_ASSERT (encoded_target_len ==
                    mcommon_b64_ntop (bytes, (size_t) len, string->str + old_len, encoded_target_len + 1));
       BSON_ASSERT (mlib_in_range (uint32_t, encoded_target_len));
@@ -219,7 +253,7 @@ mcommon_string_append_base64_encode (mcommon_string_append_t *append, const uint
        * Remainders longer than 3 bytes in / 4 bytes out are never necessary, and further portions of the input data
        * will not be used.
        */
-      mcommon_string_grow_to_capacity (string, max_len);
+      _mcommon_string_append_grow_to_capacity (append, max_len);
       char *buffer = string->str;
 
       uint32_t remainder_truncated_len = max_append_len % 4;
@@ -239,7 +273,7 @@ mcommon_string_append_base64_encode (mcommon_string_append_t *append, const uint
                                                               (size_t) remainder_input_len,
                                                               remainder_buffer,
                                                               sizeof remainder_buffer));
-      memcpy (buffer + old_len + direct_encoded_len, remainder_buffer, remainder_encoded_len);
+      memcpy (buffer + old_len + direct_encoded_len, remainder_buffer, remainder_truncated_len);
 
       BSON_ASSERT (old_len + direct_encoded_len + remainder_truncated_len == max_len);
       buffer[max_len] = '\0';
@@ -317,7 +351,7 @@ mcommon_string_append_vprintf (mcommon_string_append_t *append, const char *form
       // do want that to be available to vsnprintf().
 
       min_format_buffer_capacity = BSON_MIN (min_format_buffer_capacity, max_append_len);
-      mcommon_string_grow_to_capacity (string, old_len + min_format_buffer_capacity);
+      _mcommon_string_append_grow_to_capacity (append, old_len + min_format_buffer_capacity);
       uint32_t alloc = string->alloc;
       BSON_ASSERT (alloc > 0 && alloc - 1u >= old_len);
       char *format_buffer = string->str + old_len;
@@ -0,0 +1,352 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+#include <bson/bson-arena.h>
+
+#include <string.h>
+
+
+#define BSON_ARENA_DEFAULT_CHUNK_SIZE 4096u
+
+/* The minimum alignment of an allocation, and the room reserved before each
+ * allocation to record its size for bson_arena_realloc_ctx(). */
+#define BSON_ARENA_ALIGN 16u
+
+
+typedef struct _bson_arena_chunk_t {
+   struct _bson_arena_chunk_t *next;
+   /* The number of bytes available following the chunk header. */
+   size_t size;
+   size_t used;
+} bson_arena_chunk_t;
+
+
+/* Allocations are made from the chunk header rounded up to the alignment. */
+#define BSON_ARENA_CHUNK_HEADER \
+   ((sizeof (bson_arena_chunk_t) + BSON_ARENA_ALIGN - 1u) & ~(size_t) (BSON_ARENA_ALIGN - 1u))
+
+
+struct _bson_arena_t {
+   size_t chunk_size;
+   /* Chunks of chunk_size bytes, beginning with the one allocated along with
+    * the arena. They are kept for reuse when the arena is reset. */
+   bson_arena_chunk_t *first;
+   /* The chunk allocations are made from. Chunks after it are unused. */
+   bson_arena_chunk_t *current;
+   /* Chunks holding a single allocation too large for chunk_size, freed when
+    * the arena is reset. */
+   bson_arena_chunk_t *large;
+   /* The most recent allocation from the current chunk, which may be grown in
+    * place, or NULL. */
+   uint8_t *last;
+};
+
+
+static uint8_t *
+_bson_arena_chunk_data (bson_arena_chunk_t *chunk)
+{
+   return (uint8_t *) chunk + BSON_ARENA_CHUNK_HEADER;
+}
+
+
+static size_t
+_bson_arena_size_of (const uint8_t *mem)
+{
+   size_t size;
+
+   memcpy (&size, mem - sizeof size, sizeof size);
+
+   return size;
+}
+
+
+static void
+_bson_arena_set_size_of (uint8_t *mem, size_t size)
+{
+   memcpy (mem - sizeof size, &size, sizeof size);
+}
+
+
+static bson_arena_chunk_t *
+_bson_arena_chunk_new (size_t size)
+{
+   bson_arena_chunk_t *const chunk = bson_malloc (BSON_ARENA_CHUNK_HEADER + size);
+
+   chunk->next = NULL;
+   chunk->size = size;
+   chunk->used = 0u;
+
+   return chunk;
+}
+
+
+/* Returns @num_bytes from the unused space of @chunk aligned to @alignment,
+ * or NULL if they do not fit. */
+static uint8_t *
+_bson_arena_chunk_alloc (bson_arena_chunk_t *chunk, size_t alignment, size_t num_bytes)
+{
+   uint8_t *const data = _bson_arena_chunk_data (chunk);
+   const uintptr_t end = (uintptr_t) (data + chunk->size);
+   uintptr_t start;
+
+   /* leave room for the size before the allocation */
+   start = (uintptr_t) (data + chunk->used) + BSON_ARENA_ALIGN;
+   start = (start + alignment - 1u) & ~(uintptr_t) (alignment - 1u);
+
+   if (start > end || num_bytes > end - start) {
+      return NULL;
+   }
+
+   chunk->used = (size_t) (start - (uintptr_t) data) + num_bytes;
+   _bson_arena_set_size_of ((uint8_t *) start, num_bytes);
+
+   return (uint8_t *) start;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_new --
+ *
+ *       Creates a region allocator that hands out memory from chunks of
+ *       @chunk_size bytes, or a default size if @chunk_size is zero.
+ *       Allocations are not freed individually; they are all released at
+ *       once by bson_arena_reset() or bson_arena_destroy().
+ *
+ *       Documents bound to the arena with bson_init_arena(),
+ *       bson_copy_to_arena() or bson_array_builder_new_arena() grow within
+ *       it, so building many short-lived documents does not allocate once
+ *       the arena has grown to fit them.
+ *
+ *       An arena must not be used by more than one thread at a time.
+ *
+ * Returns:
+ *       A newly allocated bson_arena_t to be freed with
+ *       bson_arena_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_arena_t *
+bson_arena_new (size_t chunk_size)
+{
+   bson_arena_t *arena;
+   const size_t arena_size = (sizeof *arena + BSON_ARENA_ALIGN - 1u) & ~(size_t) (BSON_ARENA_ALIGN - 1u);
+
+   if (chunk_size == 0u) {
+      chunk_size = BSON_ARENA_DEFAULT_CHUNK_SIZE;
+   }
+
+   BSON_ASSERT (chunk_size <= SIZE_MAX - arena_size - BSON_ARENA_CHUNK_HEADER);
+
+   /* the first chunk is allocated along with the arena */
+   arena = bson_malloc (arena_size + BSON_ARENA_CHUNK_HEADER + chunk_size);
+   arena->chunk_size = chunk_size;
+   arena->first = (bson_arena_chunk_t *) ((uint8_t *) arena + arena_size);
+   arena->first->next = NULL;
+   arena->first->size = chunk_size;
+   arena->first->used = 0u;
+   arena->current = arena->first;
+   arena->large = NULL;
+   arena->last = NULL;
+
+   return arena;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_aligned_alloc --
+ *
+ *       Allocates @num_bytes from @arena aligned to @alignment, which must
+ *       be a power of two.
+ *
+ * Returns:
+ *       Uninitialized memory valid until @arena is reset or destroyed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void *
+bson_arena_aligned_alloc (bson_arena_t *arena, size_t alignment, size_t num_bytes)
+{
+   size_t max_chunk_alloc;
+   uint8_t *mem;
+
+   BSON_ASSERT_PARAM (arena);
+   BSON_ASSERT (alignment > 0u && (alignment & (alignment - 1u)) == 0u);
+
+   if (alignment < BSON_ARENA_ALIGN) {
+      alignment = BSON_ARENA_ALIGN;
+   }
+
+   /* an allocation taking more than half a chunk gets a chunk of its own */
+   max_chunk_alloc = arena->chunk_size / 2u;
+   max_chunk_alloc = max_chunk_alloc > alignment + BSON_ARENA_ALIGN ? max_chunk_alloc - alignment - BSON_ARENA_ALIGN : 0u;
+
+   if (num_bytes > max_chunk_alloc) {
+      bson_arena_chunk_t *chunk;
+
+      BSON_ASSERT (num_bytes <= SIZE_MAX - BSON_ARENA_CHUNK_HEADER - alignment - BSON_ARENA_ALIGN);
+
+      chunk = _bson_arena_chunk_new (num_bytes + alignment + BSON_ARENA_ALIGN);
+      chunk->next = arena->large;
+      arena->large = chunk;
+
+      mem = _bson_arena_chunk_alloc (chunk, alignment, num_bytes);
+      BSON_ASSERT (mem);
+
+      return mem;
+   }
+
+   mem = _bson_arena_chunk_alloc (arena->current, alignment, num_bytes);
+
+   if (!mem) {
+      /* move on to the next chunk, reusing one kept from before a reset */
+      if (!arena->current->next) {
+         arena->current->next = _bson_arena_chunk_new (arena->chunk_size);
+      }
+
+      arena->current = arena->current->next;
+      arena->current->used = 0u;
+
+      mem = _bson_arena_chunk_alloc (arena->current, alignment, num_bytes);
+      BSON_ASSERT (mem);
+   }
+
+   arena->last = mem;
+
+   return mem;
+}
+
+
+void *
+bson_arena_alloc (bson_arena_t *arena, size_t num_bytes)
+{
+   return bson_arena_aligned_alloc (arena, BSON_ARENA_ALIGN, num_bytes);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_realloc_ctx --
+ *
+ *       A bson_realloc_func that resizes @mem, which must be NULL or have
+ *       been allocated from the bson_arena_t @ctx. The most recent
+ *       allocation is grown in place when there is room for it.
+ *
+ * Returns:
+ *       Memory holding the contents of @mem, valid until the arena is reset
+ *       or destroyed.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void *
+bson_arena_realloc_ctx (void *mem, size_t num_bytes, void *ctx)
+{
+   bson_arena_t *const arena = ctx;
+   uint8_t *const old = mem;
+   uint8_t *new_mem;
+   size_t old_size;
+
+   BSON_ASSERT_PARAM (ctx);
+
+   if (!old) {
+      return bson_arena_alloc (arena, num_bytes);
+   }
+
+   old_size = _bson_arena_size_of (old);
+
+   if (num_bytes <= old_size) {
+      return old;
+   }
+
+   if (old == arena->last) {
+      bson_arena_chunk_t *const chunk = arena->current;
+      uint8_t *const data = _bson_arena_chunk_data (chunk);
+
+      if (num_bytes <= (size_t) (data + chunk->size - old)) {
+         chunk->used = (size_t) (old - data) + num_bytes;
+         _bson_arena_set_size_of (old, num_bytes);
+         return old;
+      }
+   }
+
+   new_mem = bson_arena_alloc (arena, num_bytes);
+   memcpy (new_mem, old, old_size);
+
+   return new_mem;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_arena_reset --
+ *
+ *       Releases every allocation made from @arena at once. Chunks of the
+ *       configured size are kept to serve later allocations.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_arena_reset (bson_arena_t *arena)
+{
+   BSON_ASSERT_PARAM (arena);
+
+   while (arena->large) {
+      bson_arena_chunk_t *const next = arena->large->next;
+
+      bson_free (arena->large);
+      arena->large = next;
+   }
+
+   arena->first->used = 0u;
+   arena->current = arena->first;
+   arena->last = NULL;
+}
+
+
+void
+bson_arena_destroy (bson_arena_t *arena)
+{
+   bson_arena_chunk_t *chunk;
+
+   if (!arena) {
+      return;
+   }
+
+   bson_arena_reset (arena);
+
+   /* the first chunk is freed with the arena */
+   chunk = arena->first->next;
+
+   while (chunk) {
+      bson_arena_chunk_t *const next = chunk->next;
+
+      bson_free (chunk);
+      chunk = next;
+   }
+
+   bson_free (arena);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bson/bson-prelude.h>
+
+
+#ifndef BSON_ARENA_H
+#define BSON_ARENA_H
+
+
+#include <bson/bson-macros.h>
+#include <bson/bson-types.h>
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _bson_arena_t bson_arena_t;
+
+
+BSON_EXPORT (bson_arena_t *)
+bson_arena_new (size_t chunk_size);
+
+BSON_EXPORT (void *)
+bson_arena_alloc (bson_arena_t *arena, size_t num_bytes);
+
+BSON_EXPORT (void *)
+bson_arena_aligned_alloc (bson_arena_t *arena, size_t alignment, size_t num_bytes);
+
+BSON_EXPORT (void *)
+bson_arena_realloc_ctx (void *mem, size_t num_bytes, void *ctx);
+
+BSON_EXPORT (void)
+bson_arena_reset (bson_arena_t *arena);
+
+BSON_EXPORT (void)
+bson_arena_destroy (bson_arena_t *arena);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_ARENA_H */
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+#include <bson/bson-index.h>
+
+#include <string.h>
+
+
+/* Slots held within the index itself. Documents with up to half as many
+ * fields are indexed without a second allocation. */
+#define BSON_INDEX_INLINE_SLOTS 32
+
+
+typedef struct {
+   /* Offset of the element within the document, or 0 for an empty slot. */
+   uint32_t offset;
+   uint32_t keylen;
+   uint32_t hash;
+} bson_index_slot_t;
+
+
+struct _bson_index_t {
+   const uint8_t *data;
+   uint32_t len;
+   /* The number of slots less one. The number of slots is a power of two. */
+   uint32_t mask;
+   uint32_t count;
+   bson_index_slot_t *slots;
+   bson_index_slot_t inline_slots[BSON_INDEX_INLINE_SLOTS];
+};
+
+
+/* FNV-1a. */
+static uint32_t
+_bson_index_hash (const char *key, size_t keylen)
+{
+   uint32_t hash = 2166136261u;
+
+   for (size_t i = 0u; i < keylen; i++) {
+      hash ^= (uint8_t) key[i];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+/* Returns the slot holding @key, or the empty slot where it belongs. */
+static bson_index_slot_t *
+_bson_index_probe (const bson_index_t *index, const char *key, uint32_t keylen, uint32_t hash)
+{
+   uint32_t i = hash & index->mask;
+
+   for (;;) {
+      bson_index_slot_t *const slot = &index->slots[i];
+
+      if (slot->offset == 0u) {
+         return slot;
+      }
+
+      /* The key of the element begins after its type byte. */
+      if (slot->hash == hash && slot->keylen == keylen &&
+          0 == memcmp (index->data + slot->offset + 1u, key, (size_t) keylen)) {
+         return slot;
+      }
+
+      i = (i + 1u) & index->mask;
+   }
+}
+
+
+static void
+_bson_index_grow (bson_index_t *index)
+{
+   bson_index_slot_t *const old_slots = index->slots;
+   const uint32_t old_size = index->mask + 1u;
+   const uint32_t size = old_size * 2u;
+
+   index->slots = bson_malloc0 (size * sizeof (bson_index_slot_t));
+   index->mask = size - 1u;
+
+   for (uint32_t i = 0u; i < old_size; i++) {
+      const bson_index_slot_t *const old_slot = &old_slots[i];
+
+      if (old_slot->offset != 0u) {
+         uint32_t j = old_slot->hash & index->mask;
+
+         while (index->slots[j].offset != 0u) {
+            j = (j + 1u) & index->mask;
+         }
+
+         index->slots[j] = *old_slot;
+      }
+   }
+
+   if (old_slots != index->inline_slots) {
+      bson_free (old_slots);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_new --
+ *
+ *       Indexes the top-level keys of @bson in a single pass so they can be
+ *       found without scanning the document. @bson must not be modified or
+ *       destroyed while the index is in use.
+ *
+ *       If a key appears more than once the first field with that key is
+ *       found, as with bson_iter_find(). If the document is corrupt, the
+ *       fields before the corruption are indexed.
+ *
+ * Returns:
+ *       A newly allocated bson_index_t to be freed with
+ *       bson_index_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_index_t *
+bson_index_new (const bson_t *bson)
+{
+   bson_index_t *index;
+   bson_iter_t iter;
+
+   BSON_ASSERT_PARAM (bson);
+
+   index = bson_malloc0 (sizeof *index);
+   index->data = bson_get_data (bson);
+   index->len = bson->len;
+   index->mask = BSON_INDEX_INLINE_SLOTS - 1u;
+   index->slots = index->inline_slots;
+
+   if (!bson_iter_init (&iter, bson)) {
+      return index;
+   }
+
+   while (bson_iter_next (&iter)) {
+      const char *const key = bson_iter_key_unsafe (&iter);
+      const uint32_t keylen = bson_iter_key_len (&iter);
+      const uint32_t hash = _bson_index_hash (key, keylen);
+      bson_index_slot_t *slot;
+
+      /* keep the load factor at most one half */
+      if ((index->count + 1u) * 2u > index->mask + 1u) {
+         _bson_index_grow (index);
+      }
+
+      slot = _bson_index_probe (index, key, keylen, hash);
+
+      if (slot->offset == 0u) {
+         slot->offset = bson_iter_offset (&iter);
+         slot->keylen = keylen;
+         slot->hash = hash;
+         index->count++;
+      }
+   }
+
+   return index;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_index_find_w_len --
+ *
+ *       Finds the field of the indexed document with the key @key.
+ *       @keylen is the length of @key, or -1 to determine the length with
+ *       strlen().
+ *
+ * Returns:
+ *       true if the field was found and @iter is observing it. @iter may
+ *       then be advanced to the following fields as usual.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_index_find_w_len (const bson_index_t *index, const char *key, int keylen, bson_iter_t *iter)
+{
+   const bson_index_slot_t *slot;
+
+   BSON_ASSERT_PARAM (index);
+   BSON_ASSERT_PARAM (key);
+   BSON_ASSERT_PARAM (iter);
+
+   if (keylen < 0) {
+      keylen = (int) strlen (key);
+   }
+
+   slot = _bson_index_probe (index, key, (uint32_t) keylen, _bson_index_hash (key, (size_t) keylen));
+
+   if (slot->offset == 0u) {
+      return false;
+   }
+
+   return bson_iter_init_from_data_at_offset (iter, index->data, index->len, slot->offset, slot->keylen);
+}
+
+
+bool
+bson_index_find (const bson_index_t *index, const char *key, bson_iter_t *iter)
+{
+   return bson_index_find_w_len (index, key, -1, iter);
+}
+
+
+void
+bson_index_destroy (bson_index_t *index)
+{
+   if (!index) {
+      return;
+   }
+
+   if (index->slots != index->inline_slots) {
+      bson_free (index->slots);
+   }
+
+   bson_free (index);
+}
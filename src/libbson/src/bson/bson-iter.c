@@ -24,6 +24,11 @@
 #define ITER_TYPE(i) ((bson_type_t) * ((i)->raw + (i)->type))
 
 
+static bool
+_bson_iter_next_internal (
+   bson_iter_t *iter, uint32_t next_keylen, const char **key, uint32_t *bson_type, bool *unsupported);
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -298,15 +303,17 @@ bson_iter_find_w_len (bson_iter_t *iter, /* INOUT */
                       int keylen)        /* IN */
 {
    const char *ikey;
+   uint32_t bson_type;
+   bool unsupported;
 
    if (keylen < 0) {
       keylen = (int) strlen (key);
    }
 
-   while (bson_iter_next (iter)) {
-      ikey = bson_iter_key (iter);
-
-      if ((0 == strncmp (key, ikey, keylen)) && (ikey[keylen] == '\0')) {
+   /* the length of each key is known once its element is decoded, so only
+    * keys of the same length are compared */
+   while (_bson_iter_next_internal (iter, 0, &ikey, &bson_type, &unsupported)) {
+      if (iter->d1 - iter->key - 1u == (uint32_t) keylen && 0 == memcmp (key, ikey, (size_t) keylen)) {
          return true;
       }
    }
@@ -366,11 +373,18 @@ bool
 bson_iter_find_case (bson_iter_t *iter, /* INOUT */
                      const char *key)   /* IN */
 {
+   const char *ikey;
+   uint32_t bson_type;
+   bool unsupported;
+   size_t keylen;
+
    BSON_ASSERT (iter);
    BSON_ASSERT (key);
 
-   while (bson_iter_next (iter)) {
-      if (!bson_strcasecmp (key, bson_iter_key (iter))) {
+   keylen = strlen (key);
+
+   while (_bson_iter_next_internal (iter, 0, &ikey, &bson_type, &unsupported)) {
+      if (iter->d1 - iter->key - 1u == keylen && !bson_strcasecmp (key, ikey)) {
          return true;
       }
    }
@@ -545,12 +559,14 @@ _bson_iter_next_internal (bson_iter_t *iter,    /* INOUT */
    iter->d4 = 0;
 
    if (next_keylen == 0) {
-      /* iterate from start to end of NULL-terminated key string */
-      for (o = iter->key; o < len; o++) {
-         if (!data[o]) {
-            iter->d1 = ++o;
-            goto fill_data_fields;
-         }
+      /* find the end of the NULL-terminated key string; memchr compares
+       * many bytes at a time where the C library vectorizes it */
+      const uint8_t *const key_end = memchr (data + iter->key, '\0', len - iter->key);
+
+      if (key_end) {
+         o = (uint32_t) (key_end - data) + 1u;
+         iter->d1 = o;
+         goto fill_data_fields;
       }
    } else {
       o = iter->key + next_keylen + 1;
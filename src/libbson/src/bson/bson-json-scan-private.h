@@ -0,0 +1,75 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bson/bson-prelude.h>
+
+
+#ifndef BSON_JSON_SCAN_PRIVATE_H
+#define BSON_JSON_SCAN_PRIVATE_H
+
+
+#include <bson/bson-macros.h>
+#include <bson/bson-types.h>
+
+
+BSON_BEGIN_DECLS
+
+
+/* The largest document that can be scanned, so that offsets and lengths fit in 32 bits. */
+#define BSON_JSON_SCAN_MAX_LEN ((size_t) INT32_MAX)
+
+
+/* The structural index of one JSON document, built 64 bytes at a time. */
+typedef struct {
+   /* The offsets, from the first byte of the document, of each bracket, colon
+    * and comma outside of strings, of each unescaped quote, and of the first
+    * byte of each number or literal. */
+   uint32_t *offsets;
+   size_t len;
+   size_t alloc;
+   /* The number of bytes scanned so far, a multiple of 64. */
+   size_t scanned;
+   /* All ones if the scanned bytes end inside a string. */
+   uint64_t in_string;
+   /* 1 if the next byte is escaped by a backslash. */
+   uint64_t escaped;
+   /* 1 if the last scanned byte is part of a number or literal. */
+   uint64_t in_scalar;
+   /* The nesting depth of brackets at the end of the scanned bytes. */
+   int64_t depth;
+} bson_json_scan_t;
+
+
+void
+_bson_json_scan_init (bson_json_scan_t *scan);
+
+void
+_bson_json_scan_reset (bson_json_scan_t *scan);
+
+void
+_bson_json_scan_cleanup (bson_json_scan_t *scan);
+
+bool
+_bson_json_scan (bson_json_scan_t *scan, const uint8_t *doc, size_t len, size_t *doc_len);
+
+bool
+_bson_json_scan_is_plain (const uint8_t *str, size_t len);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_JSON_SCAN_PRIVATE_H */
@@ -0,0 +1,433 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+#include <bson/bson-json-scan-private.h>
+
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BSON_JSON_SCAN_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BSON_JSON_SCAN_NEON
+#endif
+
+
+#define BSON_JSON_SCAN_BLOCK 64u
+
+
+/* One bit per byte of a 64-byte block for each class of byte. */
+typedef struct {
+   uint64_t open;  /* { or [ */
+   uint64_t close; /* } or ] */
+   uint64_t punct; /* : or , */
+   uint64_t quote;
+   uint64_t backslash;
+   uint64_t space; /* space, tab, newline or carriage return */
+} bson_json_scan_masks_t;
+
+
+static int
+_bson_json_scan_ctz (uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   return __builtin_ctzll (bits);
+#elif defined(_MSC_VER) && defined(_M_X64)
+   unsigned long index;
+   _BitScanForward64 (&index, bits);
+   return (int) index;
+#else
+   int n = 0;
+
+   while (!(bits & 1u)) {
+      bits >>= 1;
+      n++;
+   }
+
+   return n;
+#endif
+}
+
+
+static int
+_bson_json_scan_popcount (uint64_t bits)
+{
+#if defined(__GNUC__) || defined(__clang__)
+   return __builtin_popcountll (bits);
+#else
+   bits = bits - ((bits >> 1) & UINT64_C (0x5555555555555555));
+   bits = (bits & UINT64_C (0x3333333333333333)) + ((bits >> 2) & UINT64_C (0x3333333333333333));
+   bits = (bits + (bits >> 4)) & UINT64_C (0x0F0F0F0F0F0F0F0F);
+   return (int) ((bits * UINT64_C (0x0101010101010101)) >> 56);
+#endif
+}
+
+
+/* Each bit of the result is the parity of the bits of @bits at and below it,
+ * so it is set for every byte from an opening quote up to a closing one. */
+static uint64_t
+_bson_json_scan_prefix_xor (uint64_t bits)
+{
+   bits ^= bits << 1;
+   bits ^= bits << 2;
+   bits ^= bits << 4;
+   bits ^= bits << 8;
+   bits ^= bits << 16;
+   bits ^= bits << 32;
+   return bits;
+}
+
+
+#if defined(BSON_JSON_SCAN_NEON)
+static uint64_t
+_bson_json_scan_neon_movemask (uint8x16_t matches)
+{
+   static const uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+   const uint8x16_t bits = vandq_u8 (matches, vld1q_u8 (weights));
+
+   return (uint64_t) vaddv_u8 (vget_low_u8 (bits)) | ((uint64_t) vaddv_u8 (vget_high_u8 (bits)) << 8);
+}
+#endif
+
+
+static void
+_bson_json_scan_classify (const uint8_t *block, bson_json_scan_masks_t *masks)
+{
+   memset (masks, 0, sizeof *masks);
+
+#if defined(BSON_JSON_SCAN_SSE2)
+   for (unsigned i = 0u; i < BSON_JSON_SCAN_BLOCK; i += 16u) {
+      const __m128i chunk = _mm_loadu_si128 ((const __m128i *) (block + i));
+      /* '[' and '{' differ only in the bit 0x20, as do ']' and '}'. */
+      const __m128i folded = _mm_or_si128 (chunk, _mm_set1_epi8 (0x20));
+      const __m128i punct = _mm_or_si128 (_mm_cmpeq_epi8 (chunk, _mm_set1_epi8 (':')),
+                                          _mm_cmpeq_epi8 (chunk, _mm_set1_epi8 (',')));
+      const __m128i space =
+         _mm_or_si128 (_mm_or_si128 (_mm_cmpeq_epi8 (chunk, _mm_set1_epi8 (' ')),
+                                     _mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('\t'))),
+                       _mm_or_si128 (_mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('\n')),
+                                     _mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('\r'))));
+
+      masks->open |= (uint64_t) (uint16_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (folded, _mm_set1_epi8 ('{'))) << i;
+      masks->close |= (uint64_t) (uint16_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (folded, _mm_set1_epi8 ('}'))) << i;
+      masks->punct |= (uint64_t) (uint16_t) _mm_movemask_epi8 (punct) << i;
+      masks->quote |= (uint64_t) (uint16_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('"'))) << i;
+      masks->backslash |= (uint64_t) (uint16_t) _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('\\')))
+                          << i;
+      masks->space |= (uint64_t) (uint16_t) _mm_movemask_epi8 (space) << i;
+   }
+#elif defined(BSON_JSON_SCAN_NEON)
+   for (unsigned i = 0u; i < BSON_JSON_SCAN_BLOCK; i += 16u) {
+      const uint8x16_t chunk = vld1q_u8 (block + i);
+      const uint8x16_t folded = vorrq_u8 (chunk, vdupq_n_u8 (0x20));
+      const uint8x16_t punct = vorrq_u8 (vceqq_u8 (chunk, vdupq_n_u8 (':')), vceqq_u8 (chunk, vdupq_n_u8 (',')));
+      const uint8x16_t space = vorrq_u8 (vorrq_u8 (vceqq_u8 (chunk, vdupq_n_u8 (' ')), vceqq_u8 (chunk, vdupq_n_u8 ('\t'))),
+                                         vorrq_u8 (vceqq_u8 (chunk, vdupq_n_u8 ('\n')), vceqq_u8 (chunk, vdupq_n_u8 ('\r'))));
+
+      masks->open |= _bson_json_scan_neon_movemask (vceqq_u8 (folded, vdupq_n_u8 ('{'))) << i;
+      masks->close |= _bson_json_scan_neon_movemask (vceqq_u8 (folded, vdupq_n_u8 ('}'))) << i;
+      masks->punct |= _bson_json_scan_neon_movemask (punct) << i;
+      masks->quote |= _bson_json_scan_neon_movemask (vceqq_u8 (chunk, vdupq_n_u8 ('"'))) << i;
+      masks->backslash |= _bson_json_scan_neon_movemask (vceqq_u8 (chunk, vdupq_n_u8 ('\\'))) << i;
+      masks->space |= _bson_json_scan_neon_movemask (space) << i;
+   }
+#else
+   for (unsigned i = 0u; i < BSON_JSON_SCAN_BLOCK; i++) {
+      const uint64_t bit = UINT64_C (1) << i;
+
+      switch (block[i]) {
+      case '{':
+      case '[':
+         masks->open |= bit;
+         break;
+      case '}':
+      case ']':
+         masks->close |= bit;
+         break;
+      case ':':
+      case ',':
+         masks->punct |= bit;
+         break;
+      case '"':
+         masks->quote |= bit;
+         break;
+      case '\\':
+         masks->backslash |= bit;
+         break;
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+         masks->space |= bit;
+         break;
+      default:
+         break;
+      }
+   }
+#endif
+}
+
+
+/* Returns the bytes escaped by a backslash, given the backslashes of a block.
+ * @carry is 1 if the first byte is escaped, and is set to whether the first
+ * byte of the next block is. */
+static uint64_t
+_bson_json_scan_escaped (uint64_t backslash, uint64_t *carry)
+{
+   uint64_t escaped = *carry;
+
+   *carry = 0u;
+
+   /* runs of backslashes are rare, so walk them in order: a backslash escapes
+    * the next byte unless it is escaped itself. */
+   while (backslash) {
+      const uint64_t bit = backslash & (0u - backslash);
+
+      backslash ^= bit;
+
+      if (escaped & bit) {
+         continue;
+      }
+
+      if (bit == UINT64_C (1) << 63) {
+         *carry = 1u;
+      } else {
+         escaped |= bit << 1;
+      }
+   }
+
+   return escaped;
+}
+
+
+/* Scans the 64-byte @block at offset @base of the document. Returns true and
+ * sets @doc_len if the top-level value closes within it. */
+static bool
+_bson_json_scan_block (bson_json_scan_t *scan, const uint8_t *block, size_t base, size_t *doc_len)
+{
+   bson_json_scan_masks_t masks;
+   uint64_t quote;
+   uint64_t in_string;
+   uint64_t scalar;
+   uint64_t tokens;
+   uint64_t brackets;
+   uint64_t end = 0u;
+
+   _bson_json_scan_classify (block, &masks);
+
+   quote = masks.quote & ~_bson_json_scan_escaped (masks.backslash, &scan->escaped);
+   /* set from each opening quote up to, but not including, its closing quote */
+   in_string = _bson_json_scan_prefix_xor (quote) ^ scan->in_string;
+   scan->in_string = 0u - (in_string >> 63);
+
+   scalar = ~(masks.open | masks.close | masks.punct | masks.quote | masks.space | in_string);
+   tokens = ((masks.open | masks.close | masks.punct) & ~in_string) | quote | (scalar & ~((scalar << 1) | scan->in_scalar));
+   scan->in_scalar = scalar >> 63;
+
+   brackets = (masks.open | masks.close) & ~in_string;
+
+   if (brackets) {
+      const uint64_t open = brackets & masks.open;
+      const uint64_t close = brackets & masks.close;
+
+      if (scan->depth > _bson_json_scan_popcount (close)) {
+         /* the top-level value cannot close within this block */
+         scan->depth += _bson_json_scan_popcount (open) - _bson_json_scan_popcount (close);
+      } else {
+         while (brackets) {
+            const uint64_t bit = brackets & (0u - brackets);
+
+            brackets ^= bit;
+            scan->depth += (bit & open) ? 1 : -1;
+
+            if (scan->depth == 0) {
+               /* drop the tokens after the end of the document */
+               end = bit | (bit - 1u);
+               tokens &= end;
+               break;
+            }
+         }
+      }
+   }
+
+   if (scan->alloc < scan->len + BSON_JSON_SCAN_BLOCK) {
+      scan->alloc = bson_next_power_of_two (scan->len + BSON_JSON_SCAN_BLOCK);
+      scan->offsets = bson_realloc (scan->offsets, scan->alloc * sizeof *scan->offsets);
+   }
+
+   while (tokens) {
+      scan->offsets[scan->len++] = (uint32_t) (base + (size_t) _bson_json_scan_ctz (tokens));
+      tokens &= tokens - 1u;
+   }
+
+   if (end) {
+      *doc_len = base + (size_t) _bson_json_scan_popcount (end);
+      return true;
+   }
+
+   return false;
+}
+
+
+void
+_bson_json_scan_init (bson_json_scan_t *scan)
+{
+   BSON_ASSERT_PARAM (scan);
+
+   memset (scan, 0, sizeof *scan);
+}
+
+
+/* Prepares @scan for a new document, keeping its allocation. */
+void
+_bson_json_scan_reset (bson_json_scan_t *scan)
+{
+   BSON_ASSERT_PARAM (scan);
+
+   scan->len = 0u;
+   scan->scanned = 0u;
+   scan->in_string = 0u;
+   scan->escaped = 0u;
+   scan->in_scalar = 0u;
+   scan->depth = 0;
+}
+
+
+void
+_bson_json_scan_cleanup (bson_json_scan_t *scan)
+{
+   if (scan) {
+      bson_free (scan->offsets);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_json_scan --
+ *
+ *       Indexes the structure of the first @len bytes of the JSON document
+ *       at @doc, which begins with '{' or '['. Each call continues from
+ *       where the last one stopped, so more bytes of the same document may
+ *       be passed as they are read. A final block of fewer than 64 bytes is
+ *       scanned as if padded with spaces, and scanned again by the next
+ *       call.
+ *
+ *       @len must not exceed BSON_JSON_SCAN_MAX_LEN.
+ *
+ * Returns:
+ *       true and sets @doc_len to the length of the document if its
+ *       top-level value closes within @len bytes, otherwise false.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_bson_json_scan (bson_json_scan_t *scan, const uint8_t *doc, size_t len, size_t *doc_len)
+{
+   BSON_ASSERT_PARAM (scan);
+   BSON_ASSERT_PARAM (doc);
+   BSON_ASSERT_PARAM (doc_len);
+   BSON_ASSERT (len <= BSON_JSON_SCAN_MAX_LEN);
+
+   for (; scan->scanned + BSON_JSON_SCAN_BLOCK <= len; scan->scanned += BSON_JSON_SCAN_BLOCK) {
+      if (_bson_json_scan_block (scan, doc + scan->scanned, scan->scanned, doc_len)) {
+         return true;
+      }
+   }
+
+   if (scan->scanned < len) {
+      /* the bytes of a partial block are indexed correctly, since the state
+       * of each byte depends only on the bytes before it. */
+      uint8_t block[BSON_JSON_SCAN_BLOCK];
+      const bson_json_scan_t saved = *scan;
+
+      memset (block, ' ', sizeof block);
+      memcpy (block, doc + scan->scanned, len - scan->scanned);
+
+      if (_bson_json_scan_block (scan, block, scan->scanned, doc_len)) {
+         return true;
+      }
+
+      /* scan the block again once it is complete */
+      scan->len = saved.len;
+      scan->in_string = saved.in_string;
+      scan->escaped = saved.escaped;
+      scan->in_scalar = saved.in_scalar;
+      scan->depth = saved.depth;
+   }
+
+   return false;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_json_scan_is_plain --
+ *
+ *       Checks whether the contents of a JSON string are ASCII without
+ *       escapes or control characters, so that they can be used as they
+ *       are.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+_bson_json_scan_is_plain (const uint8_t *str, size_t len)
+{
+   size_t i = 0u;
+
+#if defined(BSON_JSON_SCAN_SSE2)
+   for (; i + 16u <= len; i += 16u) {
+      const __m128i chunk = _mm_loadu_si128 ((const __m128i *) (str + i));
+      /* bytes below 0x20, compared as signed after flipping the high bit */
+      const __m128i control =
+         _mm_cmplt_epi8 (_mm_xor_si128 (chunk, _mm_set1_epi8 ((char) 0x80)), _mm_set1_epi8 ((char) (0x20 ^ 0x80)));
+      const __m128i backslash = _mm_cmpeq_epi8 (chunk, _mm_set1_epi8 ('\\'));
+
+      if (_mm_movemask_epi8 (_mm_or_si128 (chunk, _mm_or_si128 (control, backslash)))) {
+         return false;
+      }
+   }
+#elif defined(BSON_JSON_SCAN_NEON)
+   for (; i + 16u <= len; i += 16u) {
+      const uint8x16_t chunk = vld1q_u8 (str + i);
+      const uint8x16_t stop = vorrq_u8 (vorrq_u8 (vcgeq_u8 (chunk, vdupq_n_u8 (0x80)), vcltq_u8 (chunk, vdupq_n_u8 (0x20))),
+                                        vceqq_u8 (chunk, vdupq_n_u8 ('\\')));
+
+      if (vmaxvq_u8 (stop)) {
+         return false;
+      }
+   }
+#endif
+
+   for (; i < len; i++) {
+      if (str[i] < 0x20u || str[i] >= 0x80u || str[i] == '\\') {
+         return false;
+      }
+   }
+
+   return true;
+}
@@ -25,6 +25,7 @@
 #include <bson/bson-error-private.h>
 #include <bson/bson-json.h>
 #include <bson/bson-json-private.h>
+#include <bson/bson-json-scan-private.h>
 #include <bson/bson-iso8601-private.h>
 
 #include <mlib/cmp.h>
@@ -231,6 +232,21 @@ typedef struct {
 } bson_json_reader_producer_t;
 
 
+/* the state of the indexed parser */
+typedef struct {
+   bson_json_parser_t parser;
+   /* input read from the producer, of which the bytes from 'pos' on are yet
+    * to be parsed */
+   bson_json_buf_t input;
+   size_t pos;
+   bson_json_scan_t scan;
+   /* unescaped keys and values, reused from one document to the next */
+   bson_json_buf_t unescaped[3];
+   /* a document is built here if the caller's document is not empty */
+   bson_t *scratch;
+} bson_json_reader_indexed_t;
+
+
 struct _bson_json_reader_t {
    bson_json_reader_producer_t producer;
    bson_json_reader_bson_t bson;
@@ -240,6 +256,7 @@ struct _bson_json_reader_t {
    ssize_t advance;
    bson_json_buf_t tok_accumulator;
    bson_error_t *error;
+   bson_json_reader_indexed_t indexed;
 };
 
 
@@ -714,8 +731,9 @@ _bson_json_read_integer (bson_json_reader_t *reader, uint64_t val, int64_t sign)
 }
 
 
+/* parse a double with strtod, returning false if it is out of range */
 static bool
-_bson_json_parse_double (bson_json_reader_t *reader, const char *val, size_t vlen, double *d)
+_bson_json_strtod (const char *val, size_t vlen, double *d)
 {
    errno = 0;
    *d = strtod (val, NULL);
@@ -739,20 +757,29 @@ _bson_json_parse_double (bson_json_reader_t *reader, const char *val, size_t vle
    }
 
    if ((*d == HUGE_VAL || *d == -HUGE_VAL) && errno == ERANGE) {
-      _bson_json_read_set_error (reader, "Number \"%.*s\" is out of range", (int) vlen, val);
-
       return false;
    }
 #else
-   /* not MSVC -  set err on overflow, but avoid err for infinity */
+   /* not MSVC -  fail on overflow, but not for infinity */
    if ((*d == HUGE_VAL || *d == -HUGE_VAL) && errno == ERANGE && strncasecmp (val, "infinity", vlen) &&
        strncasecmp (val, "-infinity", vlen)) {
+      return false;
+   }
+
+#endif /* _MSC_VER */
+   return true;
+}
+
+
+static bool
+_bson_json_parse_double (bson_json_reader_t *reader, const char *val, size_t vlen, double *d)
+{
+   if (!_bson_json_strtod (val, vlen, d)) {
       _bson_json_read_set_error (reader, "Number \"%.*s\" is out of range", (int) vlen, val);
 
       return false;
    }
 
-#endif /* _MSC_VER */
    return true;
 }
 
@@ -1982,6 +2009,1012 @@ _error_callback (jsonsl_t json, jsonsl_error_t err, struct jsonsl_state_st *stat
 }
 
 
+/* The deepest nesting converted by the indexed parser. Deeper documents are
+ * left to the streaming parser, which limits them to STACK_MAX. */
+#define BSON_JSON_EMIT_DEPTH_MAX (STACK_MAX - 4)
+
+
+/* converts a document indexed by _bson_json_scan to BSON */
+typedef struct {
+   const uint8_t *doc;
+   const uint32_t *offsets;
+   size_t len;
+   /* the next token */
+   size_t i;
+   int depth;
+   /* [0] for keys, [1] and [2] for values */
+   bson_json_buf_t *unescaped;
+} bson_json_emit_t;
+
+
+static size_t
+_bson_json_skip_space (const uint8_t *data, size_t i, size_t len)
+{
+   while (i < len && (data[i] == ' ' || data[i] == '\t' || data[i] == '\n' || data[i] == '\r')) {
+      i++;
+   }
+
+   return i;
+}
+
+
+/* the first byte of the next token, or -1 at the end of the document */
+static int
+_bson_json_emit_peek (const bson_json_emit_t *e)
+{
+   return e->i < e->len ? e->doc[e->offsets[e->i]] : -1;
+}
+
+
+static bool
+_bson_json_emit_expect (bson_json_emit_t *e, char c)
+{
+   if (_bson_json_emit_peek (e) != c) {
+      return false;
+   }
+
+   e->i++;
+   return true;
+}
+
+
+/* the length of the number or literal at @p, which is followed by a
+ * delimiter since every document ends with a bracket */
+static size_t
+_bson_json_emit_scalar_len (const uint8_t *p)
+{
+   size_t n = 0u;
+
+   for (;;) {
+      switch (p[n]) {
+      case ' ':
+      case '\t':
+      case '\n':
+      case '\r':
+      case ',':
+      case ':':
+      case '[':
+      case ']':
+      case '{':
+      case '}':
+      case '"':
+         return n;
+      default:
+         n++;
+      }
+   }
+}
+
+
+static bool
+_bson_json_is_digit (char c)
+{
+   return c >= '0' && c <= '9';
+}
+
+
+static int
+_bson_json_hex_value (uint8_t c)
+{
+   if (c >= '0' && c <= '9') {
+      return c - '0';
+   } else if (c >= 'a' && c <= 'f') {
+      return c - 'a' + 10;
+   } else if (c >= 'A' && c <= 'F') {
+      return c - 'A' + 10;
+   }
+
+   return -1;
+}
+
+
+/* unescape the @len bytes of a string into @buf and null-terminate them.
+ * Returns false for control characters, invalid escapes, and escaped
+ * surrogates, which are left to the streaming parser. */
+static bool
+_bson_json_emit_unescape (bson_json_buf_t *buf, const uint8_t *str, size_t len)
+{
+   uint8_t *out;
+
+   /* unescaping never lengthens a string */
+   _bson_json_buf_ensure (buf, len + 1u);
+   out = buf->buf;
+
+   for (size_t i = 0u; i < len; i++) {
+      uint32_t cp = 0u;
+
+      if (str[i] < 0x20u) {
+         return false;
+      } else if (str[i] != '\\') {
+         *out++ = str[i];
+         continue;
+      } else if (++i == len) {
+         return false;
+      }
+
+      switch (str[i]) {
+      case '"':
+      case '\\':
+      case '/':
+         *out++ = str[i];
+         break;
+      case 'b':
+         *out++ = '\b';
+         break;
+      case 'f':
+         *out++ = '\f';
+         break;
+      case 'n':
+         *out++ = '\n';
+         break;
+      case 'r':
+         *out++ = '\r';
+         break;
+      case 't':
+         *out++ = '\t';
+         break;
+      case 'u':
+         if (len - i < 5u) {
+            return false;
+         }
+
+         for (int j = 1; j <= 4; j++) {
+            const int v = _bson_json_hex_value (str[i + (size_t) j]);
+
+            if (v < 0) {
+               return false;
+            }
+
+            cp = (cp << 4) | (uint32_t) v;
+         }
+
+         i += 4u;
+
+         if (cp >= 0xD800u && cp <= 0xDFFFu) {
+            return false;
+         } else if (cp < 0x80u) {
+            *out++ = (uint8_t) cp;
+         } else if (cp < 0x800u) {
+            *out++ = (uint8_t) (0xC0u | (cp >> 6));
+            *out++ = (uint8_t) (0x80u | (cp & 0x3Fu));
+         } else {
+            *out++ = (uint8_t) (0xE0u | (cp >> 12));
+            *out++ = (uint8_t) (0x80u | ((cp >> 6) & 0x3Fu));
+            *out++ = (uint8_t) (0x80u | (cp & 0x3Fu));
+         }
+         break;
+      default:
+         return false;
+      }
+   }
+
+   buf->len = (size_t) (out - buf->buf);
+   *out = '\0';
+
+   return true;
+}
+
+
+/* read the string at the next token. Its contents are used in place if they
+ * need no unescaping and @terminate is false, otherwise they are unescaped
+ * into @buf and null-terminated. */
+static bool
+_bson_json_emit_string (
+   bson_json_emit_t *e, bson_json_buf_t *buf, bool allow_null, bool terminate, const char **str, size_t *len)
+{
+   const uint8_t *begin;
+   size_t n;
+
+   /* the next token is the closing quote */
+   if (_bson_json_emit_peek (e) != '"' || e->i + 1u >= e->len) {
+      return false;
+   }
+
+   begin = e->doc + e->offsets[e->i] + 1u;
+   n = (size_t) (e->offsets[e->i + 1u] - e->offsets[e->i] - 1u);
+   e->i += 2u;
+
+   if (_bson_json_scan_is_plain (begin, n)) {
+      if (!terminate) {
+         *str = (const char *) begin;
+         *len = n;
+         return true;
+      }
+
+      _bson_json_buf_set (buf, begin, n);
+   } else if (!_bson_json_emit_unescape (buf, begin, n) ||
+              !bson_utf8_validate ((const char *) buf->buf, buf->len, allow_null)) {
+      return false;
+   }
+
+   *str = (const char *) buf->buf;
+   *len = buf->len;
+
+   return true;
+}
+
+
+/* read the key at the next token, and its colon, without unescaping it */
+static bool
+_bson_json_emit_raw_key (bson_json_emit_t *e, const char **key, size_t *len)
+{
+   if (_bson_json_emit_peek (e) != '"' || e->i + 1u >= e->len) {
+      return false;
+   }
+
+   *key = (const char *) e->doc + e->offsets[e->i] + 1u;
+   *len = (size_t) (e->offsets[e->i + 1u] - e->offsets[e->i] - 1u);
+   e->i += 2u;
+
+   return _bson_json_emit_expect (e, ':');
+}
+
+
+#define BSON_JSON_KEY_IS(_key, _len, _name) ((_len) == sizeof (_name) - 1u && 0 == memcmp ((_key), (_name), (_len)))
+
+
+/* parse a number as the streaming parser does. An integer is returned in
+ * @val and @negative, anything else in @d. Returns false for numbers it
+ * would reject, or that jsonsl does not convert exactly. */
+static bool
+_bson_json_emit_parse_number (
+   const char *text, size_t len, bool *is_double, bool *negative, uint64_t *val, double *d)
+{
+   size_t i = 0u;
+   size_t digits;
+
+   *negative = len > 0u && text[0] == '-';
+   i = *negative ? 1u : 0u;
+   *val = 0u;
+
+   if (i == len || !_bson_json_is_digit (text[i]) || (text[i] == '0' && i + 1u < len && _bson_json_is_digit (text[i + 1u]))) {
+      return false;
+   }
+
+   for (digits = i; i < len && _bson_json_is_digit (text[i]); i++) {
+      *val = *val * 10u + (uint64_t) (text[i] - '0');
+   }
+
+   digits = i - digits;
+
+   if (i == len) {
+      *is_double = false;
+
+      /* beyond 19 digits, the value wraps around in jsonsl */
+      return digits <= 19u && *val <= (*negative ? (uint64_t) INT64_MAX + 1u : (uint64_t) INT64_MAX);
+   }
+
+   if (text[i] == '.') {
+      const size_t start = ++i;
+
+      while (i < len && _bson_json_is_digit (text[i])) {
+         i++;
+      }
+
+      if (i == start) {
+         return false;
+      }
+   }
+
+   if (i < len && (text[i] == 'e' || text[i] == 'E')) {
+      size_t start;
+
+      if (++i < len && (text[i] == '+' || text[i] == '-')) {
+         i++;
+      }
+
+      for (start = i; i < len && _bson_json_is_digit (text[i]); i++) {
+      }
+
+      if (i == start) {
+         return false;
+      }
+   }
+
+   *is_double = true;
+
+   /* strtod stops at the delimiter after the number */
+   return i == len && _bson_json_strtod (text, len, d);
+}
+
+
+/* read the integer at the next token */
+static bool
+_bson_json_emit_integer (bson_json_emit_t *e, bool *negative, uint64_t *val)
+{
+   const char *text;
+   size_t len;
+   bool is_double;
+   double d;
+
+   if (e->i >= e->len) {
+      return false;
+   }
+
+   text = (const char *) e->doc + e->offsets[e->i];
+   len = _bson_json_emit_scalar_len ((const uint8_t *) text);
+   e->i++;
+
+   return _bson_json_emit_parse_number (text, len, &is_double, negative, val, &d) && !is_double;
+}
+
+
+/* parse the string of a $numberInt or $numberLong */
+static bool
+_bson_json_emit_parse_int64 (const char *str, size_t len, int64_t *v64)
+{
+   const bool negative = len > 0u && str[0] == '-';
+   size_t i = negative ? 1u : 0u;
+   int64_t v = 0;
+
+   /* up to 18 digits cannot overflow; leave longer ones to bson_ascii_strtoll */
+   if (i == len || len - i > 18u) {
+      return false;
+   }
+
+   for (; i < len; i++) {
+      if (!_bson_json_is_digit (str[i])) {
+         return false;
+      }
+
+      v = v * 10 + (str[i] - '0');
+   }
+
+   *v64 = negative ? -v : v;
+
+   return true;
+}
+
+
+static bool
+_bson_json_emit_int_value (bson_t *bson, const char *key, size_t key_len, bool negative, uint64_t val)
+{
+   if (val <= INT32_MAX || (negative && val <= (uint64_t) INT32_MAX + 1u)) {
+      return bson_append_int32 (
+         bson, key, (int) key_len, negative ? (int32_t) (0 - (int64_t) (val - 1u) - 1) : (int32_t) val);
+   }
+
+   return bson_append_int64 (bson, key, (int) key_len, negative ? -(int64_t) (val - 1u) - 1 : (int64_t) val);
+}
+
+
+/* convert the number or literal at the next token */
+static bool
+_bson_json_emit_scalar (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len)
+{
+   const char *text;
+   size_t len;
+   bool is_double;
+   bool negative;
+   uint64_t val;
+   double d;
+
+   if (e->i >= e->len) {
+      return false;
+   }
+
+   text = (const char *) e->doc + e->offsets[e->i];
+   len = _bson_json_emit_scalar_len ((const uint8_t *) text);
+   e->i++;
+
+   if (BSON_JSON_KEY_IS (text, len, "true")) {
+      return bson_append_bool (bson, key, (int) key_len, true);
+   } else if (BSON_JSON_KEY_IS (text, len, "false")) {
+      return bson_append_bool (bson, key, (int) key_len, false);
+   } else if (BSON_JSON_KEY_IS (text, len, "null")) {
+      return bson_append_null (bson, key, (int) key_len);
+   } else if (!_bson_json_emit_parse_number (text, len, &is_double, &negative, &val, &d)) {
+      return false;
+   }
+
+   return is_double ? bson_append_double (bson, key, (int) key_len, d)
+                    : _bson_json_emit_int_value (bson, key, key_len, negative, val);
+}
+
+
+/* convert the members of a wrapper like {"$binary": {"base64": ..., "subType": ...}},
+ * after its opening bracket */
+static bool
+_bson_json_emit_binary (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len)
+{
+   const char *name;
+   size_t name_len;
+   const char *str;
+   size_t len;
+   bool has_data = false;
+   bool has_subtype = false;
+   unsigned int subtype;
+   int data_len = 0;
+
+   do {
+      if (!_bson_json_emit_raw_key (e, &name, &name_len) ||
+          !_bson_json_emit_string (e, &e->unescaped[1], true, true, &str, &len)) {
+         return false;
+      }
+
+      if (BSON_JSON_KEY_IS (name, name_len, "base64") && !has_data) {
+         data_len = mcommon_b64_pton (str, NULL, 0);
+
+         if (data_len < 0) {
+            return false;
+         }
+
+         _bson_json_buf_ensure (&e->unescaped[2], (size_t) data_len + 1u);
+
+         if (mcommon_b64_pton (str, e->unescaped[2].buf, (size_t) data_len + 1u) < 0) {
+            return false;
+         }
+
+         has_data = true;
+      } else if (BSON_JSON_KEY_IS (name, name_len, "subType") && !has_subtype) {
+         if (SSCANF (str, "%02x", &subtype) != 1) {
+            return false;
+         }
+
+         has_subtype = true;
+      } else {
+         return false;
+      }
+   } while (_bson_json_emit_expect (e, ','));
+
+   return has_data && has_subtype && _bson_json_emit_expect (e, '}') &&
+          bson_append_binary (
+             bson, key, (int) key_len, (bson_subtype_t) subtype, e->unescaped[2].buf, (uint32_t) data_len);
+}
+
+
+static bool
+_bson_json_emit_timestamp (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len)
+{
+   const char *name;
+   size_t name_len;
+   bool negative;
+   uint64_t val;
+   bool has_t = false;
+   bool has_i = false;
+   uint32_t t = 0u;
+   uint32_t i = 0u;
+
+   do {
+      /* jsonsl truncates values beyond 32 bits */
+      if (!_bson_json_emit_raw_key (e, &name, &name_len) || !_bson_json_emit_integer (e, &negative, &val) ||
+          negative || val > UINT32_MAX) {
+         return false;
+      }
+
+      if (BSON_JSON_KEY_IS (name, name_len, "t") && !has_t) {
+         t = (uint32_t) val;
+         has_t = true;
+      } else if (BSON_JSON_KEY_IS (name, name_len, "i") && !has_i) {
+         i = (uint32_t) val;
+         has_i = true;
+      } else {
+         return false;
+      }
+   } while (_bson_json_emit_expect (e, ','));
+
+   return has_t && has_i && _bson_json_emit_expect (e, '}') && bson_append_timestamp (bson, key, (int) key_len, t, i);
+}
+
+
+static bool
+_bson_json_emit_regex (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len)
+{
+   const char *name;
+   size_t name_len;
+   const char *pattern = NULL;
+   const char *options = NULL;
+   const char *str;
+   size_t len;
+
+   do {
+      /* embedded nulls are prohibited in regular expressions */
+      if (!_bson_json_emit_raw_key (e, &name, &name_len)) {
+         return false;
+      }
+
+      if (BSON_JSON_KEY_IS (name, name_len, "pattern") && !pattern) {
+         if (!_bson_json_emit_string (e, &e->unescaped[1], false, true, &str, &len)) {
+            return false;
+         }
+
+         pattern = str;
+      } else if (BSON_JSON_KEY_IS (name, name_len, "options") && !options) {
+         if (!_bson_json_emit_string (e, &e->unescaped[2], false, true, &str, &len)) {
+            return false;
+         }
+
+         options = str;
+      } else {
+         return false;
+      }
+   } while (_bson_json_emit_expect (e, ','));
+
+   return pattern && options && _bson_json_emit_expect (e, '}') &&
+          bson_append_regex (bson, key, (int) key_len, pattern, options);
+}
+
+
+/*
+ * convert the extended JSON value whose first key, @type, is at the next
+ * token, like {"$oid": "..."}. Returns false for the forms it does not
+ * convert: legacy $binary, $regex and $type, $uuid, $dbPointer, and code
+ * with scope. The streaming parser converts them instead.
+ */
+static bool
+_bson_json_emit_extended (
+   bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len, const char *type, size_t type_len)
+{
+   const char *str;
+   size_t len;
+   bool negative;
+   uint64_t val;
+   int64_t v64;
+   bool ok;
+
+   e->i += 2u;
+
+   if (!_bson_json_emit_expect (e, ':')) {
+      return false;
+   }
+
+   if (BSON_JSON_KEY_IS (type, type_len, "$oid")) {
+      bson_oid_t oid;
+
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) && len == 24u &&
+           bson_oid_is_valid (str, len);
+
+      if (ok) {
+         bson_oid_init_from_string (&oid, str);
+         ok = bson_append_oid (bson, key, (int) key_len, &oid);
+      }
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$numberInt")) {
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+           _bson_json_emit_parse_int64 (str, len, &v64) && v64 >= INT32_MIN && v64 <= INT32_MAX &&
+           bson_append_int32 (bson, key, (int) key_len, (int32_t) v64);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$numberLong")) {
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+           _bson_json_emit_parse_int64 (str, len, &v64) && bson_append_int64 (bson, key, (int) key_len, v64);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$numberDouble")) {
+      double d;
+
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, true, &str, &len) &&
+           _bson_json_strtod (str, len, &d) && bson_append_double (bson, key, (int) key_len, d);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$numberDecimal")) {
+      bson_decimal128_t dec;
+
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, true, &str, &len) &&
+           bson_decimal128_from_string (str, &dec) && bson_append_decimal128 (bson, key, (int) key_len, &dec);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$date")) {
+      const char *name;
+      size_t name_len;
+
+      switch (_bson_json_emit_peek (e)) {
+      case '"':
+         ok = _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+              _bson_iso8601_date_parse (str, (int32_t) len, &v64, NULL);
+         break;
+      case '{':
+         e->i++;
+         ok = _bson_json_emit_raw_key (e, &name, &name_len) && BSON_JSON_KEY_IS (name, name_len, "$numberLong") &&
+              _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+              _bson_json_emit_parse_int64 (str, len, &v64) && _bson_json_emit_expect (e, '}');
+         break;
+      default:
+         ok = _bson_json_emit_integer (e, &negative, &val);
+         v64 = negative ? -(int64_t) (val - 1u) - 1 : (int64_t) val;
+      }
+
+      ok = ok && bson_append_date_time (bson, key, (int) key_len, v64);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$binary")) {
+      return _bson_json_emit_expect (e, '{') && _bson_json_emit_binary (e, bson, key, key_len) &&
+             _bson_json_emit_expect (e, '}');
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$timestamp")) {
+      return _bson_json_emit_expect (e, '{') && _bson_json_emit_timestamp (e, bson, key, key_len) &&
+             _bson_json_emit_expect (e, '}');
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$regularExpression")) {
+      return _bson_json_emit_expect (e, '{') && _bson_json_emit_regex (e, bson, key, key_len) &&
+             _bson_json_emit_expect (e, '}');
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$minKey")) {
+      ok = _bson_json_emit_integer (e, &negative, &val) && !negative && val == 1u &&
+           bson_append_minkey (bson, key, (int) key_len);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$maxKey")) {
+      ok = _bson_json_emit_integer (e, &negative, &val) && !negative && val == 1u &&
+           bson_append_maxkey (bson, key, (int) key_len);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$undefined")) {
+      /* the streaming parser accepts either boolean */
+      ok = e->i < e->len;
+
+      if (ok) {
+         str = (const char *) e->doc + e->offsets[e->i];
+         len = _bson_json_emit_scalar_len ((const uint8_t *) str);
+         e->i++;
+         ok = (BSON_JSON_KEY_IS (str, len, "true") || BSON_JSON_KEY_IS (str, len, "false")) &&
+              bson_append_undefined (bson, key, (int) key_len);
+      }
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$symbol")) {
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+           bson_append_symbol (bson, key, (int) key_len, str, (int) len);
+   } else if (BSON_JSON_KEY_IS (type, type_len, "$code")) {
+      /* code without scope, truncated at a null as the streaming parser does */
+      ok = _bson_json_emit_string (e, &e->unescaped[1], true, true, &str, &len) &&
+           _bson_json_emit_peek (e) == '}' && bson_append_code_with_scope (bson, key, (int) key_len, str, NULL);
+   } else {
+      return false;
+   }
+
+   return ok && _bson_json_emit_expect (e, '}');
+}
+
+
+static bool
+_bson_json_emit_value (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len);
+
+
+/* convert the members of an object, after its opening bracket */
+static bool
+_bson_json_emit_members (bson_json_emit_t *e, bson_t *bson)
+{
+   const char *key;
+   size_t key_len;
+
+   if (_bson_json_emit_expect (e, '}')) {
+      return true;
+   }
+
+   do {
+      if (!_bson_json_emit_string (e, &e->unescaped[0], false, false, &key, &key_len) ||
+          !_bson_json_emit_expect (e, ':') || !_bson_json_emit_value (e, bson, key, key_len)) {
+         return false;
+      }
+   } while (_bson_json_emit_expect (e, ','));
+
+   return _bson_json_emit_expect (e, '}');
+}
+
+
+/* convert the elements of an array, after its opening bracket */
+static bool
+_bson_json_emit_elements (bson_json_emit_t *e, bson_t *bson)
+{
+   char buf[16];
+   const char *key;
+   uint32_t index = 0u;
+
+   if (_bson_json_emit_expect (e, ']')) {
+      return true;
+   }
+
+   do {
+      const size_t key_len = bson_uint32_to_string (index++, &key, buf, sizeof buf);
+
+      if (!_bson_json_emit_value (e, bson, key, key_len)) {
+         return false;
+      }
+   } while (_bson_json_emit_expect (e, ','));
+
+   return _bson_json_emit_expect (e, ']');
+}
+
+
+static bool
+_bson_json_emit_value (bson_json_emit_t *e, bson_t *bson, const char *key, size_t key_len)
+{
+   bson_t child;
+   const char *str;
+   size_t len;
+   bool ok;
+
+   switch (_bson_json_emit_peek (e)) {
+   case '"':
+      return _bson_json_emit_string (e, &e->unescaped[1], true, false, &str, &len) &&
+             bson_append_utf8 (bson, key, (int) key_len, str, (int) len);
+   case '{':
+      if (e->depth >= BSON_JSON_EMIT_DEPTH_MAX) {
+         return false;
+      }
+
+      e->i++;
+
+      if (_bson_json_emit_peek (e) == '"' && e->i + 1u < e->len) {
+         /* the first key of a nested object may begin an extended JSON value */
+         const char *first = (const char *) e->doc + e->offsets[e->i] + 1u;
+         const size_t first_len = (size_t) (e->offsets[e->i + 1u] - e->offsets[e->i] - 1u);
+
+         if (!memchr (first, '\\', first_len)) {
+            if (_is_known_key (first, first_len)) {
+               return _bson_json_emit_extended (e, bson, key, key_len, first, first_len);
+            }
+         } else if (!_bson_json_emit_unescape (&e->unescaped[1], (const uint8_t *) first, first_len) ||
+                    _is_known_key ((const char *) e->unescaped[1].buf, e->unescaped[1].len)) {
+            /* an escaped type, like "\u0024oid", is rare enough to leave to
+             * the streaming parser */
+            return false;
+         }
+      }
+
+      if (!bson_append_document_begin (bson, key, (int) key_len, &child)) {
+         return false;
+      }
+
+      e->depth++;
+      ok = _bson_json_emit_members (e, &child);
+      e->depth--;
+
+      /* end the child even on failure, so that @bson can be reinitialized */
+      return bson_append_document_end (bson, &child) && ok;
+   case '[':
+      if (e->depth >= BSON_JSON_EMIT_DEPTH_MAX) {
+         return false;
+      }
+
+      e->i++;
+
+      if (!bson_append_array_begin (bson, key, (int) key_len, &child)) {
+         return false;
+      }
+
+      e->depth++;
+      ok = _bson_json_emit_elements (e, &child);
+      e->depth--;
+
+      return bson_append_array_end (bson, &child) && ok;
+   default:
+      return _bson_json_emit_scalar (e, bson, key, key_len);
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_json_emit --
+ *
+ *       Converts the document at @doc, indexed by @scan, to BSON appended
+ *       to @bson, as the streaming parser would.
+ *
+ * Returns:
+ *       true if successful. false if the document must be parsed by the
+ *       streaming parser instead: because it is invalid, so that the error
+ *       is the same, or because it uses a rare form that is not converted
+ *       here. @bson is then left partly appended.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bool
+_bson_json_emit (const bson_json_scan_t *scan, const uint8_t *doc, bson_json_buf_t unescaped[3], bson_t *bson)
+{
+   bson_json_emit_t e = {doc, scan->offsets, scan->len, 0u, 0, unescaped};
+   bool ok;
+
+   if (_bson_json_emit_expect (&e, '{')) {
+      ok = _bson_json_emit_members (&e, bson);
+   } else if (_bson_json_emit_expect (&e, '[')) {
+      ok = _bson_json_emit_elements (&e, bson);
+   } else {
+      ok = false;
+   }
+
+   return ok && e.i == e.len;
+}
+
+
+/* convert the document at the start of @data with the indexed parser */
+static bool
+_bson_json_read_indexed_data (const uint8_t *data, size_t len, bson_json_buf_t unescaped[3], bson_t *bson)
+{
+   bson_json_scan_t scan;
+   size_t doc;
+   size_t doc_len;
+   size_t next;
+   bool ok;
+
+   doc = _bson_json_skip_space (data, 0u, len);
+
+   if (doc == len || (data[doc] != '{' && data[doc] != '[') || len - doc > BSON_JSON_SCAN_MAX_LEN) {
+      return false;
+   }
+
+   _bson_json_scan_init (&scan);
+   ok = _bson_json_scan (&scan, data + doc, len - doc, &doc_len);
+
+   if (ok) {
+      /* the streaming parser rejects anything but whitespace or another
+       * document after the document */
+      next = _bson_json_skip_space (data, doc + doc_len, len);
+      ok = (next == len || data[next] == '{') && _bson_json_emit (&scan, data + doc, unescaped, bson);
+   }
+
+   _bson_json_scan_cleanup (&scan);
+
+   return ok;
+}
+
+
+/* read more input for the indexed parser, first discarding the bytes
+ * that have been parsed. Returns the result of the callback. */
+static ssize_t
+_bson_json_reader_fill (bson_json_reader_t *reader)
+{
+   bson_json_reader_producer_t *p = &reader->producer;
+   bson_json_reader_indexed_t *ix = &reader->indexed;
+   ssize_t r;
+
+   if (ix->pos > 0u) {
+      memmove (ix->input.buf, ix->input.buf + ix->pos, ix->input.len - ix->pos);
+      ix->input.len -= ix->pos;
+      ix->pos = 0u;
+   }
+
+   if (ix->input.n_bytes - ix->input.len < p->buf_size) {
+      ix->input.n_bytes = bson_next_power_of_two (ix->input.len + p->buf_size);
+      ix->input.buf = bson_realloc (ix->input.buf, ix->input.n_bytes);
+   }
+
+   r = p->cb (p->data, ix->input.buf + ix->input.len, p->buf_size);
+
+   if (r > 0) {
+      ix->input.len += (size_t) r;
+   }
+
+   return r;
+}
+
+
+/* parse @len bytes of input with the streaming parser, as if they were the
+ * rest of the stream, and consume them */
+static int
+_bson_json_reader_read_fallback (bson_json_reader_t *reader, bson_t *bson, size_t len, bson_error_t *error)
+{
+   bson_json_reader_indexed_t *ix = &reader->indexed;
+   bson_json_reader_t *streaming;
+   int r;
+
+   streaming = bson_json_data_reader_new (false, BSON_JSON_DEFAULT_BUF_SIZE);
+   bson_json_data_reader_ingest (streaming, ix->input.buf + ix->pos, len);
+   r = bson_json_reader_read (streaming, bson, error);
+   bson_json_reader_destroy (streaming);
+
+   ix->pos += len;
+
+   return r;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_json_reader_read_indexed --
+ *
+ *       bson_json_reader_read() with the indexed parser. Each document is
+ *       buffered whole and indexed before it is converted. Documents the
+ *       indexed parser does not convert are passed to the streaming parser
+ *       with the whitespace before them, so that errors, and their
+ *       positions, are the same.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static int
+_bson_json_reader_read_indexed (bson_json_reader_t *reader, bson_t *bson, bson_error_t *error)
+{
+   bson_json_reader_indexed_t *ix = &reader->indexed;
+   bson_t *target = bson;
+   /* offsets from ix->pos, which stays at the start of the document while
+    * more input is read */
+   size_t doc = 0u;
+   size_t doc_len;
+   size_t next;
+   ssize_t r;
+
+   if (error) {
+      memset (error, 0, sizeof *error);
+   }
+
+#define AVAILABLE (ix->input.len - ix->pos)
+#define INPUT (ix->input.buf + ix->pos)
+
+   for (;;) {
+      doc = _bson_json_skip_space (INPUT, doc, AVAILABLE);
+
+      if (doc < AVAILABLE) {
+         break;
+      }
+
+      if ((r = _bson_json_reader_fill (reader)) < 0) {
+         goto cb_failure;
+      } else if (r == 0) {
+         /* whitespace alone is an incomplete document */
+         return doc == 0u ? 0 : _bson_json_reader_read_fallback (reader, bson, AVAILABLE, error);
+      }
+   }
+
+   if (INPUT[doc] != '{' && INPUT[doc] != '[') {
+      goto fallback_all;
+   }
+
+   _bson_json_scan_reset (&ix->scan);
+
+   for (;;) {
+      if (AVAILABLE - doc > BSON_JSON_SCAN_MAX_LEN) {
+         goto fallback_all;
+      } else if (_bson_json_scan (&ix->scan, INPUT + doc, AVAILABLE - doc, &doc_len)) {
+         break;
+      } else if ((r = _bson_json_reader_fill (reader)) < 0) {
+         goto cb_failure;
+      } else if (r == 0) {
+         /* incomplete */
+         goto fallback_all;
+      }
+   }
+
+   /* like the streaming parser, read on to the next document or the end of
+    * the input */
+   next = doc + doc_len;
+
+   for (;;) {
+      next = _bson_json_skip_space (INPUT, next, AVAILABLE);
+
+      if (next < AVAILABLE) {
+         break;
+      } else if ((r = _bson_json_reader_fill (reader)) < 0) {
+         goto cb_failure;
+      } else if (r == 0) {
+         break;
+      }
+   }
+
+   if (next < AVAILABLE && INPUT[next] != '{') {
+      goto fallback_all;
+   }
+
+   if (!bson_empty (bson)) {
+      if (!ix->scratch) {
+         ix->scratch = bson_new ();
+      }
+
+      target = ix->scratch;
+   }
+
+   if (!_bson_json_emit (&ix->scan, INPUT + doc, ix->unescaped, target) ||
+       (target != bson && !bson_concat (bson, target))) {
+      bson_reinit (target);
+      return _bson_json_reader_read_fallback (reader, bson, next, error);
+   }
+
+   if (target != bson) {
+      bson_reinit (target);
+   }
+
+   ix->pos += next;
+
+   return 1;
+
+fallback_all:
+   /* the streaming parser stops at the first error, which may come after
+    * more input */
+   while ((r = _bson_json_reader_fill (reader)) > 0) {
+   }
+
+   if (r < 0) {
+      goto cb_failure;
+   }
+
+   return _bson_json_reader_read_fallback (reader, bson, AVAILABLE, error);
+
+cb_failure:
+   if (error) {
+      bson_set_error (error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CB_FAILURE, "reader cb failed");
+   }
+
+   return -1;
+
+#undef AVAILABLE
+#undef INPUT
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -2022,6 +3055,10 @@ bson_json_reader_read (bson_json_reader_t *reader, /* IN */
    BSON_ASSERT (reader);
    BSON_ASSERT (bson);
 
+   if (reader->indexed.parser == BSON_JSON_PARSER_INDEXED) {
+      return _bson_json_reader_read_indexed (reader, bson, error);
+   }
+
    p = &reader->producer;
 
    reader->bson.bson = bson;
@@ -2173,12 +3210,32 @@ bson_json_reader_destroy (bson_json_reader_t *reader) /* IN */
 
    _bson_json_code_cleanup (&b->code_data);
 
+   bson_free (reader->indexed.input.buf);
+   _bson_json_scan_cleanup (&reader->indexed.scan);
+
+   for (i = 0; i < 3; i++) {
+      bson_free (reader->indexed.unescaped[i].buf);
+   }
+
+   bson_destroy (reader->indexed.scratch);
+
    jsonsl_destroy (reader->json);
    bson_free (reader->tok_accumulator.buf);
    bson_free (reader);
 }
 
 
+void
+bson_json_reader_set_parser (bson_json_reader_t *reader, /* IN */
+                             bson_json_parser_t parser)  /* IN */
+{
+   BSON_ASSERT (reader);
+   BSON_ASSERT (parser == BSON_JSON_PARSER_STREAMING || parser == BSON_JSON_PARSER_INDEXED);
+
+   reader->indexed.parser = parser;
+}
+
+
 void
 bson_json_opts_set_outermost_array (bson_json_opts_t *opts, bool is_outermost_array)
 {
@@ -2306,6 +3363,49 @@ bson_init_from_json (bson_t *bson,        /* OUT */
 }
 
 
+bool
+bson_init_from_json_with_parser (bson_t *bson,              /* OUT */
+                                 const char *data,          /* IN */
+                                 ssize_t len,               /* IN */
+                                 bson_json_parser_t parser, /* IN */
+                                 bson_error_t *error)       /* OUT */
+{
+   bson_json_buf_t unescaped[3] = {{0}};
+   bool ok;
+
+   BSON_ASSERT (bson);
+   BSON_ASSERT (data);
+   BSON_ASSERT (parser == BSON_JSON_PARSER_STREAMING || parser == BSON_JSON_PARSER_INDEXED);
+
+   if (parser == BSON_JSON_PARSER_STREAMING) {
+      return bson_init_from_json (bson, data, len, error);
+   }
+
+   if (len < 0) {
+      len = strlen (data);
+   }
+
+   bson_init (bson);
+   ok = _bson_json_read_indexed_data ((const uint8_t *) data, (size_t) len, unescaped, bson);
+
+   for (int i = 0; i < 3; i++) {
+      bson_free (unescaped[i].buf);
+   }
+
+   if (!ok) {
+      /* for the error, or a form the indexed parser does not convert */
+      bson_destroy (bson);
+      return bson_init_from_json (bson, data, len, error);
+   }
+
+   if (error) {
+      memset (error, 0, sizeof *error);
+   }
+
+   return true;
+}
+
+
 static void
 _bson_json_reader_handle_fd_destroy (void *handle) /* IN */
 {
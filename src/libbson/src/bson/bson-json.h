@@ -64,6 +64,20 @@ bson_json_opts_destroy (bson_json_opts_t *opts);
 BSON_EXPORT (void)
 bson_json_opts_set_outermost_array (bson_json_opts_t *opts, bool is_outermost_array);
 
+/**
+ * bson_json_parser_t:
+ *
+ * This enumeration contains the engines that can parse JSON into BSON.
+ * BSON_JSON_PARSER_STREAMING converts JSON as it is read.
+ * BSON_JSON_PARSER_INDEXED indexes the structure of each document, 64 bytes
+ * at a time, before converting it, which is faster for large inputs. Both
+ * produce the same BSON and report the same errors.
+ */
+typedef enum {
+   BSON_JSON_PARSER_STREAMING,
+   BSON_JSON_PARSER_INDEXED,
+} bson_json_parser_t;
+
 typedef ssize_t (*bson_json_reader_cb) (void *handle, uint8_t *buf, size_t count);
 typedef void (*bson_json_destroy_cb) (void *handle);
 
@@ -76,6 +90,8 @@ bson_json_reader_new_from_fd (int fd, bool close_on_destroy);
 BSON_EXPORT (bson_json_reader_t *)
 bson_json_reader_new_from_file (const char *filename, bson_error_t *error);
 BSON_EXPORT (void)
+bson_json_reader_set_parser (bson_json_reader_t *reader, bson_json_parser_t parser);
+BSON_EXPORT (void)
 bson_json_reader_destroy (bson_json_reader_t *reader);
 BSON_EXPORT (int)
 bson_json_reader_read (bson_json_reader_t *reader, bson_t *bson, bson_error_t *error);
@@ -83,6 +99,9 @@ BSON_EXPORT (bson_json_reader_t *)
 bson_json_data_reader_new (bool allow_multiple, size_t size);
 BSON_EXPORT (void)
 bson_json_data_reader_ingest (bson_json_reader_t *reader, const uint8_t *data, size_t len);
+BSON_EXPORT (bool)
+bson_init_from_json_with_parser (
+   bson_t *bson, const char *data, ssize_t len, bson_json_parser_t parser, bson_error_t *error);
 
 
 BSON_END_DECLS
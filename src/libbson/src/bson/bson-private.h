@@ -84,6 +84,13 @@ typedef struct {
 BSON_STATIC_ASSERT2 (impl_alloc_t, sizeof (bson_impl_alloc_t) <= 128);
 
 
+/* Grow @bson by @n_bytes of elements that the caller writes to the returned
+ * pointer. The length and trailing byte of @bson are updated. Returns NULL if
+ * @bson would exceed BSON_MAX_SIZE. */
+uint8_t *
+_bson_append_reserve (bson_t *bson, uint32_t n_bytes);
+
+
 BSON_END_DECLS
 
 
@@ -26,14 +26,22 @@
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#ifndef BSON_OS_WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
 
 #include <bson/bson-reader.h>
 #include <bson/bson-memory.h>
+#include <common-atomic-private.h>
+#include <common-thread-private.h>
+#include <mlib/cmp.h>
 
 
 typedef enum {
    BSON_READER_HANDLE = 1,
    BSON_READER_DATA = 2,
+   BSON_READER_MMAP = 3,
 } bson_reader_type_t;
 
 
@@ -68,6 +76,40 @@ typedef struct {
 } bson_reader_data_t;
 
 
+/* A read-only mapping of a file, shared by the readers partitioned from it. */
+typedef struct {
+   int refcount;
+   void *addr;
+   size_t len;
+} bson_reader_mapping_t;
+
+
+/* The most documents, and for readers that do not return documents from
+ * memory they own, the most bytes copied, to process in one parallel batch. */
+#define BSON_READER_PARALLEL_BATCH_DOCS 4096
+#define BSON_READER_PARALLEL_BATCH_BYTES (16 * 1024 * 1024)
+
+
+/* A batch of documents shared by the threads of bson_reader_read_parallel. */
+typedef struct {
+   bson_t *docs;
+   void **results;
+   int next;
+   int count;
+   bson_reader_map_func_t map;
+   void *ctx;
+} bson_reader_parallel_batch_t;
+
+
+/* Reads the documents of a range of a mapped file. The leading data reader
+ * covers the range, so reading and resetting are the same as for a buffer. */
+typedef struct {
+   bson_reader_data_t data;
+   bson_reader_mapping_t *mapping;
+   size_t start;
+} bson_reader_mmap_t;
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -614,13 +656,381 @@ _bson_reader_data_tell (bson_reader_data_t *reader) /* IN */
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_mapping_new --
+ *
+ *       Map the file at @path read-only and advise the kernel that it
+ *       will be read sequentially.
+ *
+ * Returns:
+ *       A mapping with a reference count of one if successful,
+ *       otherwise NULL and @error is set.
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bson_reader_mapping_t *
+_bson_reader_mapping_new (const char *path,    /* IN */
+                          bson_error_t *error) /* OUT */
+{
+   bson_reader_mapping_t *mapping;
+   void *addr = NULL;
+   size_t len = 0;
+
+#ifdef BSON_OS_WIN32
+   HANDLE file;
+   LARGE_INTEGER size;
+
+   file = CreateFileA (
+      path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+
+   if (file == INVALID_HANDLE_VALUE) {
+      bson_set_error (
+         error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "cannot open file: error %lu", GetLastError ());
+      return NULL;
+   }
+
+   if (!GetFileSizeEx (file, &size) || !mlib_in_range (size_t, size.QuadPart)) {
+      bson_set_error (error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "cannot map file: file is too large");
+      CloseHandle (file);
+      return NULL;
+   }
+
+   len = (size_t) size.QuadPart;
+
+   /* A zero-length file cannot be mapped, and has no documents. */
+   if (len > 0) {
+      /* The view keeps the file and the mapping object open after their
+       * handles are closed. */
+      HANDLE map = CreateFileMappingA (file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+      if (map) {
+         addr = MapViewOfFile (map, FILE_MAP_READ, 0, 0, 0);
+      }
+
+      if (!addr) {
+         bson_set_error (
+            error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "cannot map file: error %lu", GetLastError ());
+      }
+
+      if (map) {
+         CloseHandle (map);
+      }
+   }
+
+   CloseHandle (file);
+
+   if (len > 0 && !addr) {
+      return NULL;
+   }
+#else
+   char errmsg_buf[BSON_ERROR_BUFFER_SIZE];
+   struct stat st;
+   int fd;
+
+   fd = open (path, O_RDONLY);
+
+   if (fd == -1 || fstat (fd, &st) != 0) {
+      bson_set_error (error,
+                      BSON_ERROR_READER,
+                      BSON_ERROR_READER_BADFD,
+                      "%s",
+                      bson_strerror_r (errno, errmsg_buf, sizeof errmsg_buf));
+      if (fd != -1) {
+         close (fd);
+      }
+      return NULL;
+   }
+
+   if (!mlib_in_range (size_t, st.st_size)) {
+      bson_set_error (error, BSON_ERROR_READER, BSON_ERROR_READER_BADFD, "cannot map file: file is too large");
+      close (fd);
+      return NULL;
+   }
+
+   len = (size_t) st.st_size;
+
+   /* A zero-length file cannot be mapped, and has no documents. */
+   if (len > 0) {
+      addr = mmap (NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+
+      if (addr == MAP_FAILED) {
+         bson_set_error (error,
+                         BSON_ERROR_READER,
+                         BSON_ERROR_READER_BADFD,
+                         "cannot map file: %s",
+                         bson_strerror_r (errno, errmsg_buf, sizeof errmsg_buf));
+         close (fd);
+         return NULL;
+      }
+
+#ifdef MADV_SEQUENTIAL
+      /* Only a hint: read ahead aggressively and drop pages once read. */
+      (void) madvise (addr, len, MADV_SEQUENTIAL);
+#endif
+   }
+
+   /* The mapping remains valid after the descriptor is closed. */
+   close (fd);
+#endif
+
+   mapping = bson_malloc0 (sizeof *mapping);
+   mapping->refcount = 1;
+   mapping->addr = addr;
+   mapping->len = len;
+
+   return mapping;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_mapping_release --
+ *
+ *       Release a reference to @mapping, unmapping the file when the
+ *       last reader using it is destroyed.
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_bson_reader_mapping_release (bson_reader_mapping_t *mapping) /* IN */
+{
+   if (mcommon_atomic_int_fetch_sub (&mapping->refcount, 1, mcommon_memory_order_acq_rel) != 1) {
+      return;
+   }
+
+   if (mapping->addr) {
+#ifdef BSON_OS_WIN32
+      UnmapViewOfFile (mapping->addr);
+#else
+      munmap (mapping->addr, mapping->len);
+#endif
+   }
+
+   bson_free (mapping);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_mmap_new --
+ *
+ *       Create a reader of the documents in the range [@start, @end) of
+ *       @mapping, taking a reference to @mapping.
+ *
+ * Returns:
+ *       A newly allocated bson_reader_t.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static bson_reader_t *
+_bson_reader_mmap_new (bson_reader_mapping_t *mapping, /* IN */
+                       size_t start,                   /* IN */
+                       size_t end)                     /* IN */
+{
+   bson_reader_mmap_t *real;
+
+   BSON_ASSERT (start <= end && end <= mapping->len);
+
+   mcommon_atomic_int_fetch_add (&mapping->refcount, 1, mcommon_memory_order_relaxed);
+
+   real = BSON_ALIGNED_ALLOC0 (bson_reader_mmap_t);
+   real->data.type = BSON_READER_MMAP;
+   real->data.data = mapping->addr ? (const uint8_t *) mapping->addr + start : NULL;
+   real->data.length = end - start;
+   real->data.offset = 0;
+   real->mapping = mapping;
+   real->start = start;
+
+   return (bson_reader_t *) real;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_new_from_mmap --
+ *
+ *       Map the file at @path into memory and read the sequence of BSON
+ *       documents it contains. The documents returned by
+ *       bson_reader_read() point directly into the mapping, so they are
+ *       never copied.
+ *
+ * Returns:
+ *       A new bson_reader_t if successful, otherwise NULL and
+ *       @error is set. Free the non-NULL result with
+ *       bson_reader_destroy().
+ *
+ * Side effects:
+ *       @error may be set.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_reader_t *
+bson_reader_new_from_mmap (const char *path,    /* IN */
+                           bson_error_t *error) /* OUT */
+{
+   bson_reader_mapping_t *mapping;
+   bson_reader_t *reader;
+
+   BSON_ASSERT (path);
+
+   if (!(mapping = _bson_reader_mapping_new (path, error))) {
+      return NULL;
+   }
+
+   reader = _bson_reader_mmap_new (mapping, 0, mapping->len);
+
+   /* The reader holds the only reference now. */
+   _bson_reader_mapping_release (mapping);
+
+   return reader;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_mmap_tell --
+ *
+ *       Tell the current position in the mapped file.
+ *
+ * Returns:
+ *       An off_t of the current offset.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static off_t
+_bson_reader_mmap_tell (bson_reader_mmap_t *reader) /* IN */
+{
+   return (off_t) (reader->start + reader->data.offset);
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_partition --
+ *
+ *       Split the documents that @reader has not yet read into at most
+ *       @max_parts readers of about the same number of bytes, so that
+ *       several threads can read one file concurrently. Every part
+ *       begins and ends on a document boundary, found by following the
+ *       length prefixes of the documents.
+ *
+ *       If a document's length prefix is corrupt, the remainder of the
+ *       file is left in the last part, where reading it reports the
+ *       error.
+ *
+ *       @reader is not advanced, and may be destroyed before the parts.
+ *       Valid only for readers created with bson_reader_new_from_mmap()
+ *       or partitioned from one.
+ *
+ * Returns:
+ *       The number of readers stored in @parts, which is zero if no
+ *       documents remain. Free each with bson_reader_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+size_t
+bson_reader_partition (bson_reader_t *reader, /* IN */
+                       bson_reader_t **parts, /* OUT */
+                       size_t max_parts)      /* IN */
+{
+   bson_reader_mmap_t *real = (bson_reader_mmap_t *) reader;
+   const uint8_t *file;
+   size_t begin;
+   size_t end;
+   size_t part_begin;
+   size_t pos;
+   size_t n = 0;
+
+   BSON_ASSERT (reader);
+   BSON_ASSERT (parts || !max_parts);
+
+   if (reader->type != BSON_READER_MMAP) {
+      fprintf (stderr, "Reader type cannot be partitioned\n");
+      return 0;
+   }
+
+   file = real->mapping->addr;
+   begin = real->start + real->data.offset;
+   end = real->start + real->data.length;
+   part_begin = pos = begin;
+
+   if (!max_parts || begin == end) {
+      return 0;
+   }
+
+   for (size_t i = 1; i < max_parts && pos < end; i++) {
+      const size_t target = begin + (end - begin) / max_parts * i;
+
+      while (pos < target) {
+         int32_t blen;
+
+         if (end - pos < 5) {
+            pos = end;
+            break;
+         }
+
+         memcpy (&blen, &file[pos], sizeof blen);
+         blen = BSON_UINT32_FROM_LE (blen);
+
+         if (blen < 5 || (size_t) blen > end - pos) {
+            pos = end;
+            break;
+         }
+
+         pos += (size_t) blen;
+      }
+
+      if (pos > part_begin && pos < end) {
+         parts[n++] = _bson_reader_mmap_new (real->mapping, part_begin, pos);
+         part_begin = pos;
+      }
+   }
+
+   parts[n++] = _bson_reader_mmap_new (real->mapping, part_begin, end);
+
+   return n;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
  * bson_reader_destroy --
  *
  *       Release a bson_reader_t created with bson_reader_new_from_data(),
- *       bson_reader_new_from_fd(), or bson_reader_new_from_handle().
+ *       bson_reader_new_from_fd(), bson_reader_new_from_handle(),
+ *       bson_reader_new_from_mmap(), or bson_reader_partition().
  *
  * Returns:
  *       None.
@@ -652,6 +1062,9 @@ bson_reader_destroy (bson_reader_t *reader) /* IN */
    } break;
    case BSON_READER_DATA:
       break;
+   case BSON_READER_MMAP:
+      _bson_reader_mapping_release (((bson_reader_mmap_t *) reader)->mapping);
+      break;
    default:
       fprintf (stderr, "No such reader type: %02x\n", reader->type);
       break;
@@ -702,6 +1115,7 @@ bson_reader_read (bson_reader_t *reader, /* IN */
       return _bson_reader_handle_read ((bson_reader_handle_t *) reader, reached_eof);
 
    case BSON_READER_DATA:
+   case BSON_READER_MMAP:
       return _bson_reader_data_read ((bson_reader_data_t *) reader, reached_eof);
 
    default:
@@ -742,6 +1156,9 @@ bson_reader_tell (bson_reader_t *reader) /* IN */
    case BSON_READER_DATA:
       return _bson_reader_data_tell ((bson_reader_data_t *) reader);
 
+   case BSON_READER_MMAP:
+      return _bson_reader_mmap_tell ((bson_reader_mmap_t *) reader);
+
    default:
       fprintf (stderr, "No such reader type: %02x\n", reader->type);
       return -1;
@@ -802,7 +1219,8 @@ bson_reader_new_from_file (const char *path,    /* IN */
  * bson_reader_reset --
  *
  *       Restore the reader to its initial state. Valid only for readers
- *       created with bson_reader_new_from_data.
+ *       created with bson_reader_new_from_data, bson_reader_new_from_mmap,
+ *       or bson_reader_partition.
  *
  *--------------------------------------------------------------------------
  */
@@ -812,10 +1230,179 @@ bson_reader_reset (bson_reader_t *reader)
 {
    bson_reader_data_t *real = (bson_reader_data_t *) reader;
 
-   if (real->type != BSON_READER_DATA) {
+   if (real->type != BSON_READER_DATA && real->type != BSON_READER_MMAP) {
       fprintf (stderr, "Reader type cannot be reset\n");
       return;
    }
 
    real->offset = 0;
 }
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _bson_reader_parallel_map --
+ *
+ *       Map documents of the batch until none are left. Run by each
+ *       worker thread and by the thread calling
+ *       bson_reader_read_parallel().
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       Results are stored in @batch.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+static void
+_bson_reader_parallel_map (bson_reader_parallel_batch_t *batch) /* IN */
+{
+   int i;
+
+   while ((i = mcommon_atomic_int_fetch_add (&batch->next, 1, mcommon_memory_order_relaxed)) < batch->count) {
+      batch->results[i] = batch->map (&batch->docs[i], batch->ctx);
+   }
+}
+
+
+static BSON_THREAD_FUN (_bson_reader_parallel_worker, data)
+{
+   _bson_reader_parallel_map ((bson_reader_parallel_batch_t *) data);
+
+   BSON_THREAD_RETURN;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_read_parallel --
+ *
+ *       Read every remaining document of @reader, calling @map for each
+ *       on up to @num_threads threads, then @deliver with each result
+ *       on the calling thread in the order of the documents.
+ *
+ *       Documents are processed in batches. For each batch, the
+ *       document boundaries are found first on the calling thread by
+ *       reading the length prefixes, which is cheap, then the documents
+ *       are mapped concurrently. Documents of readers created with
+ *       bson_reader_new_from_data() or bson_reader_new_from_mmap() are
+ *       not copied; those of other readers are copied into the batch.
+ *
+ *       @num_threads includes the calling thread; if it is 0 or 1, or
+ *       no threads can be started, every document is mapped on the
+ *       calling thread.
+ *
+ * Returns:
+ *       true if the end of the stream was reached, false if the stream
+ *       is corrupt or could not be read. Every document before the
+ *       corruption is delivered.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_reader_read_parallel (bson_reader_t *reader,              /* IN */
+                           size_t num_threads,                 /* IN */
+                           bson_reader_map_func_t map,         /* IN */
+                           bson_reader_deliver_func_t deliver, /* IN */
+                           void *ctx)                          /* IN */
+{
+   bson_reader_parallel_batch_t batch = {0};
+   bson_thread_t *threads;
+   size_t *offsets;
+   uint8_t *copy = NULL;
+   size_t copy_len = 0;
+   size_t copy_alloc = 0;
+   bool in_memory;
+   bool reached_eof = false;
+   bool more = true;
+
+   BSON_ASSERT (reader);
+   BSON_ASSERT (map);
+   BSON_ASSERT (deliver);
+
+   num_threads = BSON_MIN (BSON_MAX (num_threads, 1u), (size_t) BSON_READER_PARALLEL_BATCH_DOCS);
+   in_memory = reader->type == BSON_READER_DATA || reader->type == BSON_READER_MMAP;
+
+   batch.docs = bson_malloc (sizeof *batch.docs * BSON_READER_PARALLEL_BATCH_DOCS);
+   batch.results = bson_malloc (sizeof *batch.results * BSON_READER_PARALLEL_BATCH_DOCS);
+   batch.map = map;
+   batch.ctx = ctx;
+   threads = bson_malloc (sizeof *threads * num_threads);
+   offsets = in_memory ? NULL : bson_malloc (sizeof *offsets * BSON_READER_PARALLEL_BATCH_DOCS);
+
+   while (more) {
+      const bson_t *doc;
+      size_t num_started = 0;
+
+      /* Find the documents of the next batch. */
+      batch.count = 0;
+      batch.next = 0;
+      copy_len = 0;
+
+      while (batch.count < BSON_READER_PARALLEL_BATCH_DOCS && copy_len < BSON_READER_PARALLEL_BATCH_BYTES) {
+         if (!(doc = bson_reader_read (reader, &reached_eof))) {
+            more = false;
+            break;
+         }
+
+         if (in_memory) {
+            /* The document remains valid after the next read. */
+            BSON_ASSERT (bson_init_static (&batch.docs[batch.count], bson_get_data (doc), doc->len));
+         } else {
+            if (copy_alloc - copy_len < doc->len) {
+               copy_alloc = BSON_MAX (copy_alloc * 2u, copy_len + doc->len);
+               copy = bson_realloc (copy, copy_alloc);
+            }
+
+            memcpy (copy + copy_len, bson_get_data (doc), doc->len);
+            offsets[batch.count] = copy_len;
+            copy_len += doc->len;
+            batch.docs[batch.count].len = doc->len;
+         }
+
+         batch.count++;
+      }
+
+      /* The copy may have moved while it grew, so point into it last. */
+      if (!in_memory) {
+         for (int i = 0; i < batch.count; i++) {
+            BSON_ASSERT (bson_init_static (&batch.docs[i], copy + offsets[i], batch.docs[i].len));
+         }
+      }
+
+      /* Map the documents, with the calling thread as one of the workers. */
+      for (size_t i = 1; i < num_threads && i < (size_t) batch.count; i++) {
+         if (mcommon_thread_create (&threads[num_started], _bson_reader_parallel_worker, &batch) != 0) {
+            break;
+         }
+
+         num_started++;
+      }
+
+      _bson_reader_parallel_map (&batch);
+
+      for (size_t i = 0; i < num_started; i++) {
+         BSON_ASSERT (mcommon_thread_join (threads[i]) == 0);
+      }
+
+      for (int i = 0; i < batch.count; i++) {
+         deliver (&batch.docs[i], batch.results[i], ctx);
+      }
+   }
+
+   bson_free (offsets);
+   bson_free (threads);
+   bson_free (copy);
+   bson_free (batch.results);
+   bson_free (batch.docs);
+
+   return reached_eof;
+}
@@ -87,6 +87,60 @@ typedef ssize_t (*bson_reader_read_func_t) (void *handle,  /* IN */
 typedef void (*bson_reader_destroy_func_t) (void *handle); /* IN */
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_map_func_t --
+ *
+ *       Callback used by bson_reader_read_parallel() to process a
+ *       document, such as to validate it or convert it to JSON. It is
+ *       called concurrently from several threads.
+ *
+ * Parameters:
+ *       @doc: The document, valid until @doc is delivered.
+ *       @ctx: The context passed to bson_reader_read_parallel().
+ *
+ * Returns:
+ *       A result to pass to the bson_reader_deliver_func_t.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+typedef void *(*bson_reader_map_func_t) (const bson_t *doc, /* IN */
+                                         void *ctx);        /* IN */
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_reader_deliver_func_t --
+ *
+ *       Callback used by bson_reader_read_parallel() to receive the
+ *       result of each document, in the order of the documents, on the
+ *       thread that called bson_reader_read_parallel().
+ *
+ * Parameters:
+ *       @doc: The document.
+ *       @result: The result returned by the bson_reader_map_func_t.
+ *       @ctx: The context passed to bson_reader_read_parallel().
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+typedef void (*bson_reader_deliver_func_t) (const bson_t *doc, /* IN */
+                                            void *result,      /* IN */
+                                            void *ctx);        /* IN */
+
+
 BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_handle (void *handle, bson_reader_read_func_t rf, bson_reader_destroy_func_t df);
 BSON_EXPORT (bson_reader_t *)
@@ -95,6 +149,10 @@ BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_file (const char *path, bson_error_t *error);
 BSON_EXPORT (bson_reader_t *)
 bson_reader_new_from_data (const uint8_t *data, size_t length);
+BSON_EXPORT (bson_reader_t *)
+bson_reader_new_from_mmap (const char *path, bson_error_t *error);
+BSON_EXPORT (size_t)
+bson_reader_partition (bson_reader_t *reader, bson_reader_t **parts, size_t max_parts);
 BSON_EXPORT (void)
 bson_reader_destroy (bson_reader_t *reader);
 BSON_EXPORT (void)
@@ -107,6 +165,12 @@ BSON_EXPORT (off_t)
 bson_reader_tell (bson_reader_t *reader);
 BSON_EXPORT (void)
 bson_reader_reset (bson_reader_t *reader);
+BSON_EXPORT (bool)
+bson_reader_read_parallel (bson_reader_t *reader,
+                           size_t num_threads,
+                           bson_reader_map_func_t map,
+                           bson_reader_deliver_func_t deliver,
+                           void *ctx);
 
 BSON_END_DECLS
 
@@ -0,0 +1,424 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bson.h>
+#include <bson/bson-private.h>
+#include <bson/bson-template.h>
+
+#include <string.h>
+
+
+typedef struct {
+   bson_type_t type;
+   /* Offset in the skeleton just past the element header and, for a
+    * fixed-size type, the placeholder for its value. */
+   uint32_t end;
+   /* The size of the value of a fixed-size type, or 0 for a variable-size
+    * type, whose value is written after the header. */
+   uint32_t value_len;
+   bool variable;
+} bson_template_slot_t;
+
+
+struct _bson_template_t {
+   /* The elements of every slot, with zeroed fixed-size values and no
+    * variable-size values. */
+   uint8_t *skeleton;
+   uint32_t skeleton_len;
+   uint32_t skeleton_alloc;
+   bson_template_slot_t *slots;
+   size_t n_slots;
+   size_t slots_alloc;
+};
+
+
+/* Get the size of the value of @type, or whether it varies. Returns false if
+ * templates do not support @type. */
+static bool
+_bson_template_type_len (bson_type_t type, uint32_t *value_len, bool *variable)
+{
+   *value_len = 0u;
+   *variable = false;
+
+   switch (type) {
+   case BSON_TYPE_NULL:
+      return true;
+   case BSON_TYPE_BOOL:
+      *value_len = 1u;
+      return true;
+   case BSON_TYPE_INT32:
+      *value_len = 4u;
+      return true;
+   case BSON_TYPE_DOUBLE:
+   case BSON_TYPE_DATE_TIME:
+   case BSON_TYPE_TIMESTAMP:
+   case BSON_TYPE_INT64:
+      *value_len = 8u;
+      return true;
+   case BSON_TYPE_OID:
+      *value_len = 12u;
+      return true;
+   case BSON_TYPE_DECIMAL128:
+      *value_len = 16u;
+      return true;
+   case BSON_TYPE_UTF8:
+   case BSON_TYPE_DOCUMENT:
+   case BSON_TYPE_ARRAY:
+      *variable = true;
+      return true;
+   case BSON_TYPE_EOD:
+   case BSON_TYPE_BINARY:
+   case BSON_TYPE_UNDEFINED:
+   case BSON_TYPE_REGEX:
+   case BSON_TYPE_DBPOINTER:
+   case BSON_TYPE_CODE:
+   case BSON_TYPE_SYMBOL:
+   case BSON_TYPE_CODEWSCOPE:
+   case BSON_TYPE_MAXKEY:
+   case BSON_TYPE_MINKEY:
+   default:
+      return false;
+   }
+}
+
+
+/* The encoded size of a variable-size @value, or 0 if it is invalid. */
+static uint64_t
+_bson_template_variable_len (const bson_value_t *value)
+{
+   if (value->value_type == BSON_TYPE_UTF8) {
+      /* The length prefix, the string, and its trailing NUL. */
+      return 4u + (uint64_t) value->value.v_utf8.len + 1u;
+   }
+
+   /* A document or array. */
+   return value->value.v_doc.data_len >= 5u ? value->value.v_doc.data_len : 0u;
+}
+
+
+/* Write a variable-size @value to @out. */
+static void
+_bson_template_write_variable (uint8_t *out, const bson_value_t *value)
+{
+   if (value->value_type == BSON_TYPE_UTF8) {
+      const uint32_t len_le = BSON_UINT32_TO_LE (value->value.v_utf8.len + 1u);
+
+      memcpy (out, &len_le, sizeof len_le);
+      /* str may be NULL for an empty string. */
+      if (value->value.v_utf8.len) {
+         memcpy (out + 4, value->value.v_utf8.str, value->value.v_utf8.len);
+      }
+      out[4u + value->value.v_utf8.len] = '\0';
+      return;
+   }
+
+   memcpy (out, value->value.v_doc.data, value->value.v_doc.data_len);
+}
+
+
+/* Write a fixed-size @value to @out. */
+static void
+_bson_template_write_fixed (uint8_t *out, const bson_value_t *value)
+{
+   switch (value->value_type) {
+   case BSON_TYPE_BOOL:
+      out[0] = value->value.v_bool ? 1u : 0u;
+      break;
+   case BSON_TYPE_INT32: {
+      const uint32_t v = BSON_UINT32_TO_LE ((uint32_t) value->value.v_int32);
+      memcpy (out, &v, sizeof v);
+   } break;
+   case BSON_TYPE_DOUBLE: {
+      const double v = BSON_DOUBLE_TO_LE (value->value.v_double);
+      memcpy (out, &v, sizeof v);
+   } break;
+   case BSON_TYPE_DATE_TIME: {
+      const uint64_t v = BSON_UINT64_TO_LE ((uint64_t) value->value.v_datetime);
+      memcpy (out, &v, sizeof v);
+   } break;
+   case BSON_TYPE_TIMESTAMP: {
+      const uint64_t v = BSON_UINT64_TO_LE ((((uint64_t) value->value.v_timestamp.timestamp) << 32) |
+                                            ((uint64_t) value->value.v_timestamp.increment));
+      memcpy (out, &v, sizeof v);
+   } break;
+   case BSON_TYPE_INT64: {
+      const uint64_t v = BSON_UINT64_TO_LE ((uint64_t) value->value.v_int64);
+      memcpy (out, &v, sizeof v);
+   } break;
+   case BSON_TYPE_OID:
+      memcpy (out, value->value.v_oid.bytes, sizeof value->value.v_oid.bytes);
+      break;
+   case BSON_TYPE_DECIMAL128: {
+      const uint64_t low = BSON_UINT64_TO_LE (value->value.v_decimal128.low);
+      const uint64_t high = BSON_UINT64_TO_LE (value->value.v_decimal128.high);
+      memcpy (out, &low, sizeof low);
+      memcpy (out + 8, &high, sizeof high);
+   } break;
+   case BSON_TYPE_NULL:
+   case BSON_TYPE_EOD:
+   case BSON_TYPE_UTF8:
+   case BSON_TYPE_DOCUMENT:
+   case BSON_TYPE_ARRAY:
+   case BSON_TYPE_BINARY:
+   case BSON_TYPE_UNDEFINED:
+   case BSON_TYPE_REGEX:
+   case BSON_TYPE_DBPOINTER:
+   case BSON_TYPE_CODE:
+   case BSON_TYPE_SYMBOL:
+   case BSON_TYPE_CODEWSCOPE:
+   case BSON_TYPE_MAXKEY:
+   case BSON_TYPE_MINKEY:
+   default:
+      break;
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_template_new --
+ *
+ *       Create a template without slots. Add slots with
+ *       bson_template_add().
+ *
+ * Returns:
+ *       A newly allocated bson_template_t that should be freed with
+ *       bson_template_destroy().
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_template_t *
+bson_template_new (void)
+{
+   return bson_malloc0 (sizeof (bson_template_t));
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_template_add --
+ *
+ *       Add a slot for a field named @key of type @type, encoding its
+ *       element header once.
+ *
+ *       Supported types are double, UTF-8, document, array, ObjectId,
+ *       bool, datetime, null, int32, timestamp, int64, and decimal128.
+ *
+ * Returns:
+ *       true if successful; false if @type is not supported or @key
+ *       contains an embedded NUL.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_template_add (bson_template_t *tmpl, const char *key, int key_length, bson_type_t type)
+{
+   bson_template_slot_t *slot;
+   uint32_t value_len;
+   bool variable;
+   size_t key_len;
+   uint64_t element_len;
+
+   BSON_ASSERT_PARAM (tmpl);
+   BSON_ASSERT_PARAM (key);
+
+   if (!_bson_template_type_len (type, &value_len, &variable)) {
+      return false;
+   }
+
+   if (key_length < 0) {
+      key_len = strlen (key);
+   } else {
+      key_len = (size_t) key_length;
+
+      if (memchr (key, '\0', key_len)) {
+         return false;
+      }
+   }
+
+   /* The type, key, and NUL, followed by the placeholder for the value. */
+   element_len = 1u + (uint64_t) key_len + 1u + value_len;
+
+   if (element_len > BSON_MAX_SIZE - (uint64_t) tmpl->skeleton_len) {
+      return false;
+   }
+
+   if (tmpl->skeleton_alloc - tmpl->skeleton_len < element_len) {
+      tmpl->skeleton_alloc = (uint32_t) BSON_MAX ((uint64_t) tmpl->skeleton_alloc * 2u, tmpl->skeleton_len + element_len);
+      tmpl->skeleton = bson_realloc (tmpl->skeleton, tmpl->skeleton_alloc);
+   }
+
+   if (tmpl->n_slots == tmpl->slots_alloc) {
+      tmpl->slots_alloc = BSON_MAX (tmpl->slots_alloc * 2u, 4u);
+      tmpl->slots = bson_realloc (tmpl->slots, sizeof *tmpl->slots * tmpl->slots_alloc);
+   }
+
+   {
+      uint8_t *const element = tmpl->skeleton + tmpl->skeleton_len;
+
+      element[0] = (uint8_t) type;
+      memcpy (element + 1, key, key_len);
+      memset (element + 1 + key_len, 0, 1u + value_len);
+   }
+
+   tmpl->skeleton_len += (uint32_t) element_len;
+
+   slot = &tmpl->slots[tmpl->n_slots++];
+   slot->type = type;
+   slot->end = tmpl->skeleton_len;
+   slot->value_len = value_len;
+   slot->variable = variable;
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_template_append --
+ *
+ *       Append a field to @bson for each slot of @tmpl, in the order
+ *       the slots were added, with the values in @values.
+ *
+ *       @bson is grown once. The pre-encoded element headers and
+ *       fixed-size values are copied in one run between each
+ *       variable-size value, so a template of only fixed-size types
+ *       is appended with a single copy.
+ *
+ * Returns:
+ *       true if successful; false if @n_values is not the number of
+ *       slots, the type of a value differs from its slot, a document
+ *       value is shorter than an empty document, or @bson would
+ *       exceed the maximum BSON size. @bson is unmodified on failure.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+bson_template_append (const bson_template_t *tmpl, bson_t *bson, const bson_value_t *values, size_t n_values)
+{
+   uint64_t n_bytes;
+   uint8_t *out;
+   uint32_t copied = 0u;
+   uint64_t shift = 0u;
+
+   BSON_ASSERT_PARAM (tmpl);
+   BSON_ASSERT_PARAM (bson);
+   BSON_ASSERT (values || n_values == 0u);
+
+   if (n_values != tmpl->n_slots) {
+      return false;
+   }
+
+   n_bytes = tmpl->skeleton_len;
+
+   for (size_t i = 0u; i < n_values; i++) {
+      const bson_template_slot_t *const slot = &tmpl->slots[i];
+
+      if (values[i].value_type != slot->type) {
+         return false;
+      }
+
+      if (slot->variable) {
+         const uint64_t len = _bson_template_variable_len (&values[i]);
+
+         if (!len) {
+            return false;
+         }
+
+         n_bytes += len;
+      }
+   }
+
+   if (n_bytes > BSON_MAX_SIZE || !(out = _bson_append_reserve (bson, (uint32_t) n_bytes))) {
+      return false;
+   }
+
+   /* Copy the skeleton in runs that end at each variable-size value. */
+   for (size_t i = 0u; i < n_values; i++) {
+      const bson_template_slot_t *const slot = &tmpl->slots[i];
+
+      if (slot->variable) {
+         memcpy (out + copied + shift, tmpl->skeleton + copied, slot->end - copied);
+         _bson_template_write_variable (out + slot->end + shift, &values[i]);
+         shift += _bson_template_variable_len (&values[i]);
+         copied = slot->end;
+      }
+   }
+
+   if (copied < tmpl->skeleton_len) {
+      memcpy (out + copied + shift, tmpl->skeleton + copied, tmpl->skeleton_len - copied);
+   }
+
+   /* Patch the fixed-size values over their placeholders. */
+   shift = 0u;
+
+   for (size_t i = 0u; i < n_values; i++) {
+      const bson_template_slot_t *const slot = &tmpl->slots[i];
+
+      if (slot->variable) {
+         shift += _bson_template_variable_len (&values[i]);
+      } else {
+         _bson_template_write_fixed (out + shift + slot->end - slot->value_len, &values[i]);
+      }
+   }
+
+   return true;
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * bson_template_destroy --
+ *
+ *       Free a template created with bson_template_new().
+ *
+ * Returns:
+ *       None.
+ *
+ * Side effects:
+ *       None.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+bson_template_destroy (bson_template_t *tmpl)
+{
+   if (!tmpl) {
+      return;
+   }
+
+   bson_free (tmpl->skeleton);
+   bson_free (tmpl->slots);
+   bson_free (tmpl);
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <bson/bson-prelude.h>
+
+
+#ifndef BSON_TEMPLATE_H
+#define BSON_TEMPLATE_H
+
+
+#include <bson/bson-macros.h>
+#include <bson/bson-types.h>
+#include <bson/bson-value.h>
+
+
+BSON_BEGIN_DECLS
+
+
+typedef struct _bson_template_t bson_template_t;
+
+
+BSON_EXPORT (bson_template_t *)
+bson_template_new (void);
+
+BSON_EXPORT (bool)
+bson_template_add (bson_template_t *tmpl, const char *key, int key_length, bson_type_t type);
+
+BSON_EXPORT (bool)
+bson_template_append (const bson_template_t *tmpl, bson_t *bson, const bson_value_t *values, size_t n_values);
+
+BSON_EXPORT (void)
+bson_template_destroy (bson_template_t *tmpl);
+
+
+BSON_END_DECLS
+
+
+#endif /* BSON_TEMPLATE_H */
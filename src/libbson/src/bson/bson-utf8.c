@@ -25,6 +25,133 @@
 #include <common-utf8-private.h>
 #include <bson/bson-utf8.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BSON_UTF8_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define BSON_UTF8_NEON
+#endif
+
+
+/*
+ * Returns the number of bytes at the start of @bytes that are ASCII, and not
+ * NUL unless @allow_null is true.
+ */
+static size_t
+_bson_utf8_ascii_len (const uint8_t *bytes, size_t len, bool allow_null)
+{
+   size_t i = 0;
+
+#if defined(BSON_UTF8_SSE2)
+   const __m128i zero = _mm_setzero_si128 ();
+
+   for (; i + 16u <= len; i += 16u) {
+      const __m128i chunk = _mm_loadu_si128 ((const __m128i *) (bytes + i));
+      /* the high bit of each byte, and whether it is zero. */
+      int mask = _mm_movemask_epi8 (chunk);
+
+      if (!allow_null) {
+         mask |= _mm_movemask_epi8 (_mm_cmpeq_epi8 (chunk, zero));
+      }
+
+      if (mask) {
+         break;
+      }
+   }
+#elif defined(BSON_UTF8_NEON)
+   for (; i + 16u <= len; i += 16u) {
+      const uint8x16_t chunk = vld1q_u8 (bytes + i);
+      uint8x16_t stop = vcgeq_u8 (chunk, vdupq_n_u8 (0x80));
+
+      if (!allow_null) {
+         stop = vorrq_u8 (stop, vceqq_u8 (chunk, vdupq_n_u8 (0)));
+      }
+
+      if (vmaxvq_u8 (stop)) {
+         break;
+      }
+   }
+#endif
+
+   for (; i + 8u <= len; i += 8u) {
+      uint64_t word;
+      uint64_t stop;
+
+      memcpy (&word, bytes + i, sizeof word);
+      stop = word & UINT64_C (0x8080808080808080);
+
+      if (!allow_null) {
+         /* the high bit of any zero byte, exact when no byte has its high bit set. */
+         stop |= (word - UINT64_C (0x0101010101010101)) & ~word & UINT64_C (0x8080808080808080);
+      }
+
+      if (stop) {
+         break;
+      }
+   }
+
+   /* find the exact byte that stopped the loops above. */
+   for (; i < len; i++) {
+      if (bytes[i] >= 0x80 || (!allow_null && !bytes[i])) {
+         break;
+      }
+   }
+
+   return i;
+}
+
+
+/*
+ * Returns the length of the multi-byte sequence at the start of @bytes, or 0
+ * if it is not well-formed. "C0 80" is accepted if @allow_null is true.
+ */
+static size_t
+_bson_utf8_multibyte_len (const uint8_t *bytes, size_t len, bool allow_null)
+{
+   const uint8_t lead = bytes[0];
+   /* the range of the second byte: narrower after some leads, to exclude
+    * non-shortest forms, surrogates, and code points above U+10FFFF. */
+   uint8_t lo = 0x80;
+   uint8_t hi = 0xBF;
+   size_t seq_length;
+
+   if (lead >= 0xC2 && lead <= 0xDF) {
+      seq_length = 2;
+   } else if (lead >= 0xE0 && lead <= 0xEF) {
+      seq_length = 3;
+      if (lead == 0xE0) {
+         lo = 0xA0;
+      } else if (lead == 0xED) {
+         hi = 0x9F;
+      }
+   } else if (lead >= 0xF0 && lead <= 0xF4) {
+      seq_length = 4;
+      if (lead == 0xF0) {
+         lo = 0x90;
+      } else if (lead == 0xF4) {
+         hi = 0x8F;
+      }
+   } else if (lead == 0xC0 && allow_null) {
+      /* Two-byte representation for NULL. */
+      return (len >= 2u && bytes[1] == 0x80) ? 2u : 0u;
+   } else {
+      return 0;
+   }
+
+   if (len < seq_length || bytes[1] < lo || bytes[1] > hi) {
+      return 0;
+   }
+
+   for (size_t j = 2u; j < seq_length; j++) {
+      if ((bytes[j] & 0xC0) != 0x80) {
+         return 0;
+      }
+   }
+
+   return seq_length;
+}
+
 
 /*
  *--------------------------------------------------------------------------
@@ -45,6 +172,10 @@
  *       internal NUL, for historical reasons. This sequence is considered
  *       invalid according to RFC3629.
  *
+ *       Runs of ASCII are checked 16 bytes at a time with SSE2 or NEON, or
+ *       8 bytes at a time otherwise, and multi-byte sequences against the
+ *       byte ranges of well-formed UTF-8 in the Unicode Standard, Table 3-7.
+ *
  * Parameters:
  *       @utf8: A UTF-8 encoded string.
  *       @utf8_len: The length of @utf8 in bytes.
@@ -64,115 +195,29 @@ bson_utf8_validate (const char *utf8, /* IN */
                     size_t utf8_len,  /* IN */
                     bool allow_null)  /* IN */
 {
-   bson_unichar_t c;
-   uint8_t first_mask;
-   uint8_t seq_length;
-   size_t i;
-   size_t j;
+   const uint8_t *const bytes = (const uint8_t *) utf8;
+   size_t i = 0;
 
    BSON_ASSERT (utf8);
 
-   for (i = 0; i < utf8_len; i += seq_length) {
-      mcommon_utf8_get_sequence (&utf8[i], &seq_length, &first_mask);
-
-      /*
-       * Ensure we have a valid multi-byte sequence length.
-       */
-      if (!seq_length) {
-         return false;
-      }
+   while (i < utf8_len) {
+      if (bytes[i] < 0x80) {
+         const size_t ascii_len = _bson_utf8_ascii_len (bytes + i, utf8_len - i, allow_null);
 
-      /*
-       * Ensure we have enough bytes left.
-       */
-      if ((utf8_len - i) < seq_length) {
-         return false;
-      }
-
-      /*
-       * Also calculate the next char as a unichar so we can
-       * check code ranges for non-shortest form.
-       */
-      c = utf8[i] & first_mask;
-
-      /*
-       * Check the high-bits for each additional sequence byte.
-       */
-      for (j = i + 1; j < (i + seq_length); j++) {
-         c = (c << 6) | (utf8[j] & 0x3F);
-         if ((utf8[j] & 0xC0) != 0x80) {
+         if (!ascii_len) {
+            /* a NUL byte. */
             return false;
          }
-      }
-
-      /*
-       * Check for NULL bytes afterwards.
-       *
-       * Hint: if you want to optimize this function, starting here to do
-       * this in the same pass as the data above would probably be a good
-       * idea. You would add a branch into the inner loop, but save possibly
-       * on cache-line bouncing on larger strings. Just a thought.
-       */
-      if (!allow_null) {
-         for (j = 0; j < seq_length; j++) {
-            if (((i + j) > utf8_len) || !utf8[i + j]) {
-               return false;
-            }
-         }
-      }
-
-      /*
-       * Code point won't fit in utf-16, not allowed.
-       */
-      if (c > 0x0010FFFF) {
-         return false;
-      }
 
-      /*
-       * Byte is in reserved range for UTF-16 high-marks
-       * for surrogate pairs.
-       */
-      if ((c & 0xFFFFF800) == 0xD800) {
-         return false;
-      }
-
-      /*
-       * Check non-shortest form unicode.
-       */
-      switch (seq_length) {
-      case 1:
-         if (c <= 0x007F) {
-            continue;
-         }
-         return false;
-
-      case 2:
-         if ((c >= 0x0080) && (c <= 0x07FF)) {
-            continue;
-         } else if (c == 0) {
-            /* Two-byte representation for NULL. */
-            if (!allow_null) {
-               return false;
-            }
-            continue;
-         }
-         return false;
-
-      case 3:
-         if (((c >= 0x0800) && (c <= 0x0FFF)) || ((c >= 0x1000) && (c <= 0xFFFF))) {
-            continue;
-         }
-         return false;
+         i += ascii_len;
+      } else {
+         const size_t seq_length = _bson_utf8_multibyte_len (bytes + i, utf8_len - i, allow_null);
 
-      case 4:
-         if (((c >= 0x10000) && (c <= 0x3FFFF)) || ((c >= 0x40000) && (c <= 0xFFFFF)) ||
-             ((c >= 0x100000) && (c <= 0x10FFFF))) {
-            continue;
+         if (!seq_length) {
+            return false;
          }
-         return false;
 
-      default:
-         return false;
+         i += seq_length;
       }
    }
 
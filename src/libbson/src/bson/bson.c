@@ -33,7 +33,6 @@
 
 
 typedef enum {
-   BSON_VALIDATE_PHASE_START,
    BSON_VALIDATE_PHASE_TOP,
    BSON_VALIDATE_PHASE_LF_REF_KEY,
    BSON_VALIDATE_PHASE_LF_REF_UTF8,
@@ -50,7 +49,6 @@ typedef enum {
 typedef struct {
    bson_validate_flags_t flags;
    ssize_t err_offset;
-   bson_validate_phase_t phase;
    bson_error_t error;
 } bson_validate_state_t;
 
@@ -329,6 +327,27 @@ BSON_STATIC_ASSERT2 (size_t_gte_uint32_t, SIZE_MAX >= UINT32_MAX);
    ((void) 0)
 
 
+uint8_t *
+_bson_append_reserve (bson_t *bson, uint32_t n_bytes)
+{
+   uint8_t *data;
+
+   BSON_ASSERT_PARAM (bson);
+
+   if (BSON_UNLIKELY (n_bytes > BSON_MAX_SIZE - bson->len) || BSON_UNLIKELY (!_bson_grow (bson, n_bytes))) {
+      return NULL;
+   }
+
+   /* The elements overwrite the trailing byte, which moves past them. */
+   data = _bson_data (bson) + (bson->len - 1u);
+   bson->len += n_bytes;
+   _bson_encode_length (bson);
+   data[n_bytes] = '\0';
+
+   return data;
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1785,6 +1804,53 @@ bson_init (bson_t *bson)
 }
 
 
+/* The initial buffer size of a document bound to an arena, enough for a small
+ * document to be built without growing. */
+#define BSON_ARENA_INITIAL_SIZE 128u
+
+
+void
+bson_init_arena (bson_t *bson, bson_arena_t *arena)
+{
+   bson_impl_alloc_t *impl = (bson_impl_alloc_t *) bson;
+
+   BSON_ASSERT_PARAM (bson);
+   BSON_ASSERT_PARAM (arena);
+
+   /* the buffer belongs to the arena, so bson_destroy() must not free it */
+   impl->flags = BSON_FLAG_STATIC | BSON_FLAG_NO_FREE;
+   impl->len = 5;
+   impl->parent = NULL;
+   impl->depth = 0;
+   impl->buf = &impl->alloc;
+   impl->buflen = &impl->alloclen;
+   impl->offset = 0;
+   impl->alloclen = BSON_ARENA_INITIAL_SIZE;
+   impl->alloc = bson_arena_alloc (arena, impl->alloclen);
+   impl->alloc[0] = 5;
+   impl->alloc[1] = 0;
+   impl->alloc[2] = 0;
+   impl->alloc[3] = 0;
+   impl->alloc[4] = 0;
+   impl->realloc = bson_arena_realloc_ctx;
+   impl->realloc_func_ctx = arena;
+}
+
+
+/* Returns the arena @bson is bound to, or NULL. */
+static bson_arena_t *
+_bson_arena_of (const bson_t *bson)
+{
+   const bson_impl_alloc_t *impl = (const bson_impl_alloc_t *) bson;
+
+   if ((bson->flags & BSON_FLAG_INLINE) || impl->realloc != bson_arena_realloc_ctx) {
+      return NULL;
+   }
+
+   return impl->realloc_func_ctx;
+}
+
+
 void
 bson_reinit (bson_t *bson)
 {
@@ -1843,6 +1909,47 @@ bson_init_static (bson_t *bson, const uint8_t *data, size_t length)
 }
 
 
+bool
+bson_init_from_buffer_steal (bson_t *bson, uint8_t *buf, size_t buf_len, size_t offset)
+{
+   bson_impl_alloc_t *impl = (bson_impl_alloc_t *) bson;
+   uint32_t len_le;
+   size_t length;
+
+   BSON_ASSERT (bson);
+   BSON_ASSERT (buf);
+
+   if ((offset > buf_len) || (buf_len - offset < 5)) {
+      return false;
+   }
+
+   memcpy (&len_le, buf + offset, sizeof (len_le));
+   length = (size_t) BSON_UINT32_FROM_LE (len_le);
+
+   if ((length < 5) || (length > BSON_MAX_SIZE) || (length > buf_len - offset)) {
+      return false;
+   }
+
+   if (buf[offset + length - 1]) {
+      return false;
+   }
+
+   impl->flags = BSON_FLAG_STATIC;
+   impl->len = (uint32_t) length;
+   impl->parent = NULL;
+   impl->depth = 0;
+   impl->buf = &impl->alloc;
+   impl->buflen = &impl->alloclen;
+   impl->offset = offset;
+   impl->alloc = buf;
+   impl->alloclen = buf_len;
+   impl->realloc = bson_realloc_ctx;
+   impl->realloc_func_ctx = NULL;
+
+   return true;
+}
+
+
 bson_t *
 bson_new (void)
 {
@@ -2036,6 +2143,28 @@ bson_copy_to (const bson_t *src, bson_t *dst)
 }
 
 
+void
+bson_copy_to_arena (const bson_t *src, bson_t *dst, bson_arena_t *arena)
+{
+   bson_impl_alloc_t *adst;
+   size_t len;
+
+   BSON_ASSERT_PARAM (src);
+   BSON_ASSERT_PARAM (dst);
+   BSON_ASSERT_PARAM (arena);
+
+   len = BSON_MAX (bson_next_power_of_two ((size_t) src->len), BSON_ARENA_INITIAL_SIZE);
+
+   bson_init_arena (dst, arena);
+
+   adst = (bson_impl_alloc_t *) dst;
+   adst->alloc = bson_arena_realloc_ctx (adst->alloc, len, arena);
+   adst->alloclen = len;
+   adst->len = src->len;
+   memcpy (adst->alloc, _bson_data (src), src->len);
+}
+
+
 static bool
 should_ignore (const char *first_exclude, va_list args, const char *name)
 {
@@ -2228,12 +2357,22 @@ bson_destroy_with_steal (bson_t *bson, bool steal, uint32_t *length)
       inl = (bson_impl_inline_t *) bson;
       ret = bson_malloc (bson->len);
       memcpy (ret, inl->data, bson->len);
+   } else if (_bson_arena_of (bson)) {
+      /* the caller frees the result with bson_free(), so copy it out of the
+       * arena */
+      ret = bson_malloc (bson->len);
+      memcpy (ret, _bson_data (bson), bson->len);
    } else {
       bson_impl_alloc_t *alloc;
 
       alloc = (bson_impl_alloc_t *) bson;
       ret = *alloc->buf;
       *alloc->buf = NULL;
+
+      /* the caller expects the document at the start of the buffer */
+      if (alloc->offset) {
+         memmove (ret, ret + alloc->offset, bson->len);
+      }
    }
 
    bson_destroy (bson);
@@ -2339,9 +2478,12 @@ bson_as_json_with_opts (const bson_t *bson, size_t *length, const bson_json_opts
       limit_u32 = (uint32_t) limit_i32;
    }
 
-   // Use the bson length as an initial buffer capacity guess
+   // Size the buffer from an estimate of the output length, so it rarely needs to grow
    mcommon_string_append_t append;
-   mcommon_string_set_append_with_limit (mcommon_string_new_with_capacity ("", 0, bson->len), &append, limit_u32);
+   mcommon_string_set_append_with_limit (
+      mcommon_string_new_with_capacity ("", 0, mcommon_json_estimate_len (bson, opts->mode, limit_u32)),
+      &append,
+      limit_u32);
 
    if (opts->is_outermost_array ? mcommon_json_append_bson_array (&append, bson, opts->mode, BSON_MAX_RECURSION)
                                 : mcommon_json_append_bson_document (&append, bson, opts->mode, BSON_MAX_RECURSION)) {
@@ -2421,190 +2563,259 @@ bson_array_as_canonical_extended_json (const bson_t *bson, size_t *length)
 
 #define VALIDATION_ERR(_flag, _msg, ...) bson_set_error (&state->error, BSON_ERROR_INVALID, _flag, _msg, __VA_ARGS__)
 
-static bool
-_bson_iter_validate_utf8 (const bson_iter_t *iter, const char *key, size_t v_utf8_len, const char *v_utf8, void *data)
-{
-   bson_validate_state_t *state = data;
-   bool allow_null;
-
-   if ((state->flags & BSON_VALIDATE_UTF8)) {
-      allow_null = !!(state->flags & BSON_VALIDATE_UTF8_ALLOW_NULL);
-
-      if (!bson_utf8_validate (v_utf8, v_utf8_len, allow_null)) {
-         state->err_offset = iter->off;
-         VALIDATION_ERR (BSON_VALIDATE_UTF8, "invalid utf8 string for key \"%s\"", key);
-         return true;
-      }
-   }
+/* Number of nested documents _bson_validate_internal tracks without
+ * allocating. Deeper documents move the stack to the heap. */
+#define BSON_VALIDATE_STACK_INLINE 16
 
-   if ((state->flags & BSON_VALIDATE_DOLLAR_KEYS)) {
-      if (state->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8) {
-         state->phase = BSON_VALIDATE_PHASE_LF_ID_KEY;
-      } else if (state->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
-         state->phase = BSON_VALIDATE_PHASE_NOT_DBREF;
-      }
-   }
 
-   return false;
-}
-
-
-static void
-_bson_iter_validate_corrupt (const bson_iter_t *iter, void *data)
-{
-   bson_validate_state_t *state = data;
-
-   state->err_offset = iter->err_off;
-   VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt BSON");
-}
+/* A document being validated. Offsets reported for errors within it are
+ * relative to the start of the document. */
+typedef struct {
+   bson_iter_t iter;
+   bson_validate_phase_t phase;
+   /* The scope of a code-with-scope, validated as a top-level document. */
+   bool is_scope;
+} bson_validate_frame_t;
 
 
 static bool
-_bson_iter_validate_before (const bson_iter_t *iter, const char *key, void *data)
+_bson_validate_key (bson_validate_state_t *state, bson_validate_frame_t *frame, const char *key, size_t key_len)
 {
-   bson_validate_state_t *state = data;
+   const bson_iter_t *const iter = &frame->iter;
+
+   if (key_len > 0u && !bson_utf8_validate (key, key_len, false)) {
+      state->err_offset = iter->off;
+      VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt BSON");
+      return false;
+   }
 
    if ((state->flags & BSON_VALIDATE_EMPTY_KEYS)) {
-      if (key[0] == '\0') {
+      if (key_len == 0u) {
          state->err_offset = iter->off;
          VALIDATION_ERR (BSON_VALIDATE_EMPTY_KEYS, "%s", "empty key");
-         return true;
+         return false;
       }
    }
 
    if ((state->flags & BSON_VALIDATE_DOLLAR_KEYS)) {
       if (key[0] == '$') {
-         if (state->phase == BSON_VALIDATE_PHASE_LF_REF_KEY && strcmp (key, "$ref") == 0) {
-            state->phase = BSON_VALIDATE_PHASE_LF_REF_UTF8;
-         } else if (state->phase == BSON_VALIDATE_PHASE_LF_ID_KEY && strcmp (key, "$id") == 0) {
-            state->phase = BSON_VALIDATE_PHASE_LF_DB_KEY;
-         } else if (state->phase == BSON_VALIDATE_PHASE_LF_DB_KEY && strcmp (key, "$db") == 0) {
-            state->phase = BSON_VALIDATE_PHASE_LF_DB_UTF8;
+         if (frame->phase == BSON_VALIDATE_PHASE_LF_REF_KEY && key_len == 4u && memcmp (key, "$ref", 4u) == 0) {
+            frame->phase = BSON_VALIDATE_PHASE_LF_REF_UTF8;
+         } else if (frame->phase == BSON_VALIDATE_PHASE_LF_ID_KEY && key_len == 3u && memcmp (key, "$id", 3u) == 0) {
+            frame->phase = BSON_VALIDATE_PHASE_LF_DB_KEY;
+         } else if (frame->phase == BSON_VALIDATE_PHASE_LF_DB_KEY && key_len == 3u && memcmp (key, "$db", 3u) == 0) {
+            frame->phase = BSON_VALIDATE_PHASE_LF_DB_UTF8;
          } else {
             state->err_offset = iter->off;
             VALIDATION_ERR (BSON_VALIDATE_DOLLAR_KEYS, "keys cannot begin with \"$\": \"%s\"", key);
-            return true;
+            return false;
          }
-      } else if (state->phase == BSON_VALIDATE_PHASE_LF_ID_KEY || state->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8 ||
-                 state->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
+      } else if (frame->phase == BSON_VALIDATE_PHASE_LF_ID_KEY || frame->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8 ||
+                 frame->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
          state->err_offset = iter->off;
          VALIDATION_ERR (BSON_VALIDATE_DOLLAR_KEYS, "invalid key within DBRef subdocument: \"%s\"", key);
-         return true;
+         return false;
       } else {
-         state->phase = BSON_VALIDATE_PHASE_NOT_DBREF;
+         frame->phase = BSON_VALIDATE_PHASE_NOT_DBREF;
       }
    }
 
    if ((state->flags & BSON_VALIDATE_DOT_KEYS)) {
-      if (strstr (key, ".")) {
+      if (memchr (key, '.', key_len)) {
          state->err_offset = iter->off;
          VALIDATION_ERR (BSON_VALIDATE_DOT_KEYS, "keys cannot contain \".\": \"%s\"", key);
-         return true;
+         return false;
       }
    }
 
-   return false;
+   return true;
 }
 
 
 static bool
-_bson_iter_validate_codewscope (
-   const bson_iter_t *iter, const char *key, size_t v_code_len, const char *v_code, const bson_t *v_scope, void *data)
+_bson_validate_utf8 (bson_validate_state_t *state, bson_validate_frame_t *frame, const char *key)
 {
-   bson_validate_state_t *state = data;
-   size_t offset = 0;
+   const bson_iter_t *const iter = &frame->iter;
 
-   BSON_UNUSED (key);
-   BSON_UNUSED (v_code_len);
-   BSON_UNUSED (v_code);
+   if ((state->flags & BSON_VALIDATE_UTF8)) {
+      uint32_t len_le;
 
-   if (!bson_validate (v_scope, state->flags, &offset)) {
-      state->err_offset = iter->off + offset;
-      VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt code-with-scope");
-      return false;
+      /* The length includes the trailing NUL, checked by bson_iter_next. */
+      memcpy (&len_le, iter->raw + iter->d1, sizeof (len_le));
+
+      if (!bson_utf8_validate ((const char *) (iter->raw + iter->d2),
+                               BSON_UINT32_FROM_LE (len_le) - 1u,
+                               !!(state->flags & BSON_VALIDATE_UTF8_ALLOW_NULL))) {
+         state->err_offset = iter->off;
+         VALIDATION_ERR (BSON_VALIDATE_UTF8, "invalid utf8 string for key \"%s\"", key);
+         return false;
+      }
+   }
+
+   if ((state->flags & BSON_VALIDATE_DOLLAR_KEYS)) {
+      if (frame->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8) {
+         frame->phase = BSON_VALIDATE_PHASE_LF_ID_KEY;
+      } else if (frame->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
+         frame->phase = BSON_VALIDATE_PHASE_NOT_DBREF;
+      }
    }
 
    return true;
 }
 
 
+/* Checks the framing of the embedded document at @offset of the current
+ * element and initializes @child to iterate it. */
 static bool
-_bson_iter_validate_document (const bson_iter_t *iter, const char *key, const bson_t *v_document, void *data);
-
-
-static const bson_visitor_t bson_validate_funcs = {
-   _bson_iter_validate_before,
-   NULL, /* visit_after */
-   _bson_iter_validate_corrupt,
-   NULL, /* visit_double */
-   _bson_iter_validate_utf8,
-   _bson_iter_validate_document,
-   _bson_iter_validate_document, /* visit_array */
-   NULL,                         /* visit_binary */
-   NULL,                         /* visit_undefined */
-   NULL,                         /* visit_oid */
-   NULL,                         /* visit_bool */
-   NULL,                         /* visit_date_time */
-   NULL,                         /* visit_null */
-   NULL,                         /* visit_regex */
-   NULL,                         /* visit_dbpoint */
-   NULL,                         /* visit_code */
-   NULL,                         /* visit_symbol */
-   _bson_iter_validate_codewscope,
-};
-
-
-static bool
-_bson_iter_validate_document (const bson_iter_t *iter, const char *key, const bson_t *v_document, void *data)
+_bson_validate_child (bson_validate_state_t *state,
+                      const bson_iter_t *iter,
+                      uint32_t offset,
+                      bson_validate_frame_t *child)
 {
-   bson_validate_state_t *state = data;
-   bson_iter_t child;
-   bson_validate_phase_t phase = state->phase;
+   const uint8_t *const data = iter->raw + offset;
+   uint32_t len_le;
+   uint32_t len;
 
-   BSON_UNUSED (key);
+   memcpy (&len_le, data, sizeof (len_le));
+   len = BSON_UINT32_FROM_LE (len_le);
 
-   if (!bson_iter_init (&child, v_document)) {
+   /* bson_iter_next checked that the document fits within its parent. */
+   if (len < 5u || data[len - 1u] != '\0') {
       state->err_offset = iter->off;
-      return true;
-   }
-
-   if (state->phase == BSON_VALIDATE_PHASE_START) {
-      state->phase = BSON_VALIDATE_PHASE_TOP;
-   } else {
-      state->phase = BSON_VALIDATE_PHASE_LF_REF_KEY;
-   }
-
-   (void) bson_iter_visit_all (&child, &bson_validate_funcs, state);
-
-   if (state->phase == BSON_VALIDATE_PHASE_LF_ID_KEY || state->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8 ||
-       state->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
-      if (state->err_offset <= 0) {
-         state->err_offset = iter->off;
-      }
-
-      return true;
+      VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt BSON");
+      return false;
    }
 
-   state->phase = phase;
+   memset (&child->iter, 0, sizeof child->iter);
+   child->iter.raw = data;
+   child->iter.len = len;
+   child->iter.next_off = 4u;
 
-   return false;
+   return true;
 }
 
 
+/*
+ * Validates @bson in a single pass, descending into embedded documents with
+ * an explicit stack rather than recursion. The first error found stops
+ * validation. Error offsets are relative to the innermost enclosing
+ * document, except within a code-with-scope, where they are relative to the
+ * document containing the code-with-scope.
+ */
 static void
 _bson_validate_internal (const bson_t *bson, bson_validate_state_t *state)
 {
-   bson_iter_t iter;
+   bson_validate_frame_t stack_inline[BSON_VALIDATE_STACK_INLINE];
+   bson_validate_frame_t *stack = stack_inline;
+   size_t stack_cap = BSON_VALIDATE_STACK_INLINE;
+   size_t depth = 0u;
 
    state->err_offset = -1;
-   state->phase = BSON_VALIDATE_PHASE_START;
    memset (&state->error, 0, sizeof state->error);
 
-   if (!bson_iter_init (&iter, bson)) {
+   if (!bson_iter_init (&stack[0].iter, bson)) {
       state->err_offset = 0;
       VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt BSON");
-   } else {
-      _bson_iter_validate_document (&iter, NULL, bson, state);
+      return;
+   }
+
+   stack[0].phase = BSON_VALIDATE_PHASE_TOP;
+   stack[0].is_scope = false;
+   depth = 1u;
+
+   while (depth > 0u) {
+      bson_validate_frame_t *frame = &stack[depth - 1u];
+      bson_iter_t *const iter = &frame->iter;
+      bson_validate_frame_t *child;
+      const char *key;
+
+      if (!bson_iter_next (iter)) {
+         if (iter->err_off) {
+            state->err_offset = iter->err_off;
+            VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt BSON");
+            goto fail;
+         }
+
+         /* Only embedded documents enter these phases, so there is a parent. */
+         if (frame->phase == BSON_VALIDATE_PHASE_LF_ID_KEY || frame->phase == BSON_VALIDATE_PHASE_LF_REF_UTF8 ||
+             frame->phase == BSON_VALIDATE_PHASE_LF_DB_UTF8) {
+            state->err_offset = stack[depth - 2u].iter.off;
+            VALIDATION_ERR (BSON_VALIDATE_DOLLAR_KEYS, "%s", "incomplete DBRef subdocument");
+            goto fail;
+         }
+
+         depth--;
+         continue;
+      }
+
+      key = bson_iter_key_unsafe (iter);
+
+      if (!_bson_validate_key (state, frame, key, iter->d1 - iter->key - 1u)) {
+         goto fail;
+      }
+
+      switch (bson_iter_type_unsafe (iter)) {
+      case BSON_TYPE_UTF8:
+         if (!_bson_validate_utf8 (state, frame, key)) {
+            goto fail;
+         }
+         continue;
+      case BSON_TYPE_DOCUMENT:
+      case BSON_TYPE_ARRAY:
+      case BSON_TYPE_CODEWSCOPE:
+         break;
+      default:
+         continue;
+      }
+
+      if (depth == stack_cap) {
+         stack_cap *= 2u;
+
+         if (stack == stack_inline) {
+            stack = bson_malloc (stack_cap * sizeof *stack);
+            memcpy (stack, stack_inline, sizeof stack_inline);
+         } else {
+            stack = bson_realloc (stack, stack_cap * sizeof *stack);
+         }
+
+         frame = &stack[depth - 1u];
+      }
+
+      child = &stack[depth];
+
+      if (bson_iter_type_unsafe (&frame->iter) == BSON_TYPE_CODEWSCOPE) {
+         if (!_bson_validate_child (state, &frame->iter, frame->iter.d4, child)) {
+            goto fail;
+         }
+
+         child->phase = BSON_VALIDATE_PHASE_TOP;
+         child->is_scope = true;
+      } else {
+         if (!_bson_validate_child (state, &frame->iter, frame->iter.d1, child)) {
+            goto fail;
+         }
+
+         child->phase = BSON_VALIDATE_PHASE_LF_REF_KEY;
+         child->is_scope = false;
+      }
+
+      depth++;
+   }
+
+   goto done;
+
+fail:
+   /* Errors within a scope are reported against the code-with-scope. */
+   for (; depth > 1u; depth--) {
+      if (stack[depth - 1u].is_scope) {
+         state->err_offset += (ssize_t) stack[depth - 2u].iter.off;
+         VALIDATION_ERR (BSON_VALIDATE_NONE, "%s", "corrupt code-with-scope");
+      }
+   }
+
+done:
+   if (stack != stack_inline) {
+      bson_free (stack);
    }
 }
 
@@ -2670,6 +2881,8 @@ append_failure:
 
 struct _bson_array_builder_t {
    uint32_t index;
+   // `arena` is the arena the builder is allocated from, or NULL.
+   bson_arena_t *arena;
    bson_t bson;
 };
 
@@ -2681,6 +2894,26 @@ bson_array_builder_new (void)
    return bab;
 }
 
+// `_bson_array_builder_alloc_arena` allocates a builder from `arena` without initializing its array.
+static bson_array_builder_t *
+_bson_array_builder_alloc_arena (bson_arena_t *arena)
+{
+   bson_array_builder_t *bab =
+      bson_arena_aligned_alloc (arena, BSON_ALIGNOF (bson_array_builder_t), sizeof (bson_array_builder_t));
+   memset (bab, 0, sizeof *bab);
+   bab->arena = arena;
+   return bab;
+}
+
+bson_array_builder_t *
+bson_array_builder_new_arena (bson_arena_t *arena)
+{
+   BSON_ASSERT_PARAM (arena);
+   bson_array_builder_t *bab = _bson_array_builder_alloc_arena (arena);
+   bson_init_arena (&bab->bson, arena);
+   return bab;
+}
+
 // `bson_array_builder_append_impl` generates the next key index, calls
 // `append_fn`, and may update the tracked next index.
 #define bson_array_builder_append_impl(append_fn, ...)                               \
@@ -2948,7 +3181,11 @@ bson_array_builder_build (bson_array_builder_t *bab, bson_t *out)
    if (!bson_steal (out, &bab->bson)) {
       return false;
    }
-   bson_init (&bab->bson);
+   if (bab->arena) {
+      bson_init_arena (&bab->bson, bab->arena);
+   } else {
+      bson_init (&bab->bson);
+   }
    bab->index = 0;
    return true;
 }
@@ -2956,7 +3193,8 @@ bson_array_builder_build (bson_array_builder_t *bab, bson_t *out)
 void
 bson_array_builder_destroy (bson_array_builder_t *bab)
 {
-   if (!bab) {
+   // Memory from an arena is released with the arena.
+   if (!bab || bab->arena) {
       return;
    }
    bson_destroy (&bab->bson);
@@ -2969,7 +3207,9 @@ bson_append_array_builder_begin (bson_t *bson, const char *key, int key_length,
    BSON_ASSERT_PARAM (bson);
    BSON_ASSERT_PARAM (key);
    BSON_ASSERT_PARAM (child);
-   *child = bson_array_builder_new ();
+   // A child of a document bound to an arena is allocated from the same arena.
+   bson_arena_t *const arena = _bson_arena_of (bson);
+   *child = arena ? _bson_array_builder_alloc_arena (arena) : bson_array_builder_new ();
    bool ok = bson_append_array_begin (bson, key, key_length, &(*child)->bson);
    if (!ok) {
       bson_array_builder_destroy (*child);
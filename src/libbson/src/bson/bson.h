@@ -27,12 +27,15 @@
 
 #include <bson/bson-macros.h>
 #include <bson/bson-config.h>
+#include <bson/bson-arena.h>
 #include <bson/bson-atomic.h> // Deprecated.
 #include <bson/bson-cmp.h>    // Deprecated.
 #include <bson/bson-context.h>
 #include <bson/bson-clock.h>
 #include <bson/bson-decimal128.h>
 #include <bson/bson-error.h>
+#include <bson/bson-index.h>
+#include <bson/bson-template.h>
 #include <bson/bson-iter.h>
 #include <bson/bson-json.h>
 #include <bson/bson-keys.h>
@@ -191,6 +194,24 @@ BSON_EXPORT (bool)
 bson_init_static (bson_t *b, const uint8_t *data, size_t length);
 
 
+/**
+ * bson_init_from_buffer_steal:
+ * @bson: A pointer to a bson_t.
+ * @buf: A buffer allocated with bson_malloc() containing a BSON document.
+ * @buf_len: The allocated length of @buf.
+ * @offset: The offset of the BSON document within @buf.
+ *
+ * Initializes a bson_t that takes ownership of @buf, which must have been
+ * allocated with bson_malloc() or bson_realloc(). The document located at
+ * @offset is used in place without copying. @buf is freed when @bson is
+ * destroyed. On failure, ownership of @buf remains with the caller.
+ *
+ * Returns: true if initialized successfully; otherwise false.
+ */
+BSON_EXPORT (bool)
+bson_init_from_buffer_steal (bson_t *bson, uint8_t *buf, size_t buf_len, size_t offset);
+
+
 /**
  * bson_init:
  * @b: A pointer to a bson_t.
@@ -208,6 +229,20 @@ BSON_EXPORT (void)
 bson_init (bson_t *b);
 
 
+/**
+ * bson_init_arena:
+ * @b: A pointer to a bson_t.
+ * @arena: The bson_arena_t to allocate from.
+ *
+ * Initializes a bson_t whose buffer is allocated from @arena and grows within
+ * it. Documents built from it, including child documents and copies made with
+ * bson_steal(), remain valid until @arena is reset or destroyed. Calling
+ * bson_destroy() on @b is allowed but releases nothing.
+ */
+BSON_EXPORT (void)
+bson_init_arena (bson_t *b, bson_arena_t *arena);
+
+
 /**
  * bson_reinit:
  * @b: (inout): A bson_t.
@@ -291,6 +326,19 @@ BSON_EXPORT (void)
 bson_copy_to (const bson_t *src, bson_t *dst);
 
 
+/**
+ * bson_copy_to_arena:
+ * @src: The source bson_t.
+ * @dst: The destination bson_t.
+ * @arena: The bson_arena_t to allocate from.
+ *
+ * Initializes @dst with bson_init_arena() and copies the content from @src
+ * into @dst.
+ */
+BSON_EXPORT (void)
+bson_copy_to_arena (const bson_t *src, bson_t *dst, bson_arena_t *arena);
+
+
 /**
  * bson_copy_to_excluding:
  * @src: A bson_t.
@@ -589,6 +637,9 @@ typedef struct _bson_array_builder_t bson_array_builder_t;
 // `bson_append_array_builder_begin`.
 BSON_EXPORT (bson_array_builder_t *) bson_array_builder_new (void);
 
+// bson_array_builder_new_arena is bson_array_builder_new allocating the builder and the array from `arena`.
+BSON_EXPORT (bson_array_builder_t *) bson_array_builder_new_arena (bson_arena_t *arena);
+
 // bson_array_builder_build initializes and moves BSON data to `out`.
 // `bab` may be reused and will start appending a new array at index "0".
 BSON_EXPORT (bool)
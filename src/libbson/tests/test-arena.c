@@ -0,0 +1,293 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+
+#include <bson/bcon.h>
+#include <bson/bson.h>
+
+#include <common-string-private.h>
+
+#include "TestSuite.h"
+#include "test-conveniences.h"
+
+
+static void
+test_bson_arena_alloc (void)
+{
+   bson_arena_t *arena;
+   uint8_t *a;
+   uint8_t *b;
+   uint8_t *big;
+   void *aligned;
+
+   arena = bson_arena_new (256);
+
+   a = bson_arena_alloc (arena, 10);
+   b = bson_arena_alloc (arena, 10);
+   BSON_ASSERT (a != b);
+   ASSERT_CMPUINT64 ((uint64_t) ((uintptr_t) a % 16u), ==, 0u);
+   ASSERT_CMPUINT64 ((uint64_t) ((uintptr_t) b % 16u), ==, 0u);
+   memset (a, 'a', 10);
+   memset (b, 'b', 10);
+   ASSERT_CMPINT (a[9], ==, 'a');
+
+   aligned = bson_arena_aligned_alloc (arena, 128, 40);
+   ASSERT_CMPUINT64 ((uint64_t) ((uintptr_t) aligned % 128u), ==, 0u);
+
+   /* larger than the chunk size */
+   big = bson_arena_alloc (arena, 10000);
+   memset (big, 'c', 10000);
+   ASSERT_CMPINT (b[0], ==, 'b');
+
+   /* fill several chunks */
+   for (int i = 0; i < 100; i++) {
+      uint8_t *const mem = bson_arena_alloc (arena, 50);
+      memset (mem, i, 50);
+   }
+
+   ASSERT_CMPINT (a[0], ==, 'a');
+   ASSERT_CMPINT (big[9999], ==, 'c');
+
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_realloc (void)
+{
+   bson_arena_t *arena;
+   uint8_t *mem;
+   uint8_t *grown;
+   uint8_t *other;
+
+   arena = bson_arena_new (1024);
+
+   mem = bson_arena_realloc_ctx (NULL, 16, arena);
+   memset (mem, 'x', 16);
+
+   /* the most recent allocation grows in place */
+   grown = bson_arena_realloc_ctx (mem, 64, arena);
+   BSON_ASSERT (grown == mem);
+
+   /* shrinking keeps the allocation */
+   BSON_ASSERT (bson_arena_realloc_ctx (grown, 8, arena) == grown);
+
+   /* an earlier allocation moves, keeping its contents */
+   other = bson_arena_alloc (arena, 16);
+   BSON_ASSERT (other);
+   grown = bson_arena_realloc_ctx (mem, 128, arena);
+   BSON_ASSERT (grown != mem);
+
+   for (int i = 0; i < 16; i++) {
+      ASSERT_CMPINT (grown[i], ==, 'x');
+   }
+
+   /* growing beyond the chunk moves the allocation */
+   mem = bson_arena_realloc_ctx (grown, 4096, arena);
+   for (int i = 0; i < 16; i++) {
+      ASSERT_CMPINT (mem[i], ==, 'x');
+   }
+
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_reset (void)
+{
+   bson_arena_t *arena;
+   void *first;
+
+   arena = bson_arena_new (0);
+   first = bson_arena_alloc (arena, 100);
+
+   for (int i = 0; i < 1000; i++) {
+      BSON_ASSERT (bson_arena_alloc (arena, 100));
+   }
+
+   BSON_ASSERT (bson_arena_alloc (arena, 100000));
+
+   /* memory is reused from the start */
+   bson_arena_reset (arena);
+   BSON_ASSERT (bson_arena_alloc (arena, 100) == first);
+
+   for (int i = 0; i < 1000; i++) {
+      BSON_ASSERT (bson_arena_alloc (arena, 100));
+   }
+
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_bson (void)
+{
+   bson_arena_t *arena;
+   bson_t expected = BSON_INITIALIZER;
+   bson_t b;
+   bson_t child;
+   bson_t stolen;
+   uint8_t *buf;
+   uint32_t len;
+
+   arena = bson_arena_new (512);
+   bson_init_arena (&b, arena);
+   BSON_ASSERT (bson_empty (&b));
+
+   /* grow past the inline size and the chunk size, with a child document */
+   for (int i = 0; i < 100; i++) {
+      char key[16];
+
+      bson_snprintf (key, sizeof key, "%d", i);
+      BSON_ASSERT (bson_append_int32 (&expected, key, -1, i));
+      BSON_ASSERT (bson_append_int32 (&b, key, -1, i));
+   }
+
+   BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (&expected, "child", &child));
+   BSON_ASSERT (BSON_APPEND_UTF8 (&child, "x", "y"));
+   BSON_ASSERT (bson_append_document_end (&expected, &child));
+   BSON_ASSERT (BSON_APPEND_DOCUMENT_BEGIN (&b, "child", &child));
+   BSON_ASSERT (BSON_APPEND_UTF8 (&child, "x", "y"));
+   BSON_ASSERT (bson_append_document_end (&b, &child));
+
+   ASSERT_CMPUINT32 (b.len, ==, expected.len);
+   BSON_ASSERT (bson_equal (&b, &expected));
+
+   /* a stolen document stays in the arena */
+   BSON_ASSERT (bson_steal (&stolen, &b));
+   BSON_ASSERT (bson_equal (&stolen, &expected));
+   BSON_ASSERT (BSON_APPEND_BOOL (&stolen, "z", true));
+
+   /* stealing the buffer returns a copy to be freed with bson_free */
+   buf = bson_destroy_with_steal (&stolen, true, &len);
+   ASSERT_CMPUINT32 (len, ==, expected.len + 4u);
+   /* the fields of the stolen document precede the appended one */
+   ASSERT_CMPINT (memcmp (buf + 4, bson_get_data (&expected) + 4, expected.len - 5u), ==, 0);
+   bson_free (buf);
+
+   bson_init_arena (&b, arena);
+   BSON_ASSERT (BSON_APPEND_INT32 (&b, "a", 1));
+   bson_reinit (&b);
+   BSON_ASSERT (bson_empty (&b));
+   bson_destroy (&b);
+
+   bson_destroy (&expected);
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_copy_to (void)
+{
+   bson_arena_t *arena;
+   bson_t *src;
+   bson_t dst;
+
+   arena = bson_arena_new (0);
+   src = BCON_NEW ("a", BCON_INT32 (1), "b", "[", BCON_UTF8 ("c"), "]");
+
+   bson_copy_to_arena (src, &dst, arena);
+   BSON_ASSERT (bson_equal (src, &dst));
+
+   /* the copy may grow */
+   BSON_ASSERT (BSON_APPEND_UTF8 (&dst, "d", "e"));
+   ASSERT_CMPUINT32 (dst.len, ==, src->len + 9u);
+
+   bson_destroy (&dst);
+   bson_destroy (src);
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_array_builder (void)
+{
+   bson_arena_t *arena;
+   bson_array_builder_t *bab;
+   bson_array_builder_t *child;
+   bson_t doc;
+   bson_t out;
+
+   arena = bson_arena_new (0);
+
+   bab = bson_array_builder_new_arena (arena);
+   BSON_ASSERT (bson_array_builder_append_int32 (bab, 1));
+   BSON_ASSERT (bson_array_builder_append_array_builder_begin (bab, &child));
+   BSON_ASSERT (bson_array_builder_append_utf8 (child, "two", -1));
+   BSON_ASSERT (bson_array_builder_append_array_builder_end (bab, child));
+   BSON_ASSERT (bson_array_builder_build (bab, &out));
+   ASSERT_MATCH (&out, "[1, ['two']]");
+
+   /* the builder can be reused after building */
+   BSON_ASSERT (bson_array_builder_append_bool (bab, true));
+   bson_array_builder_destroy (bab);
+   bson_destroy (&out);
+
+   /* a child builder of a document in an arena uses the arena */
+   bson_init_arena (&doc, arena);
+   BSON_ASSERT (BSON_APPEND_ARRAY_BUILDER_BEGIN (&doc, "a", &child));
+   BSON_ASSERT (bson_array_builder_append_int32 (child, 3));
+   BSON_ASSERT (bson_append_array_builder_end (&doc, child));
+   ASSERT_MATCH (&doc, "{'a': [3]}");
+   bson_destroy (&doc);
+
+   bson_arena_destroy (arena);
+}
+
+
+static void
+test_bson_arena_string (void)
+{
+   bson_arena_t *arena;
+   mcommon_string_append_t append;
+   char *str;
+
+   arena = bson_arena_new (64);
+
+   mcommon_string_new_arena_as_append (arena, &append, 0);
+   BSON_ASSERT (mcommon_string_append (&append, "abc"));
+
+   for (int i = 0; i < 100; i++) {
+      BSON_ASSERT (mcommon_string_append (&append, "def"));
+   }
+
+   ASSERT_CMPUINT32 (mcommon_strlen_from_append (&append), ==, 303u);
+   ASSERT_CMPINT (strncmp (mcommon_str_from_append (&append), "abcdefdef", 9), ==, 0);
+
+   str = mcommon_string_from_append_destroy_with_steal (&append);
+   ASSERT_CMPSIZE_T (strlen (str), ==, 303u);
+   bson_free (str);
+
+   mcommon_string_new_arena_as_append (arena, &append, 100);
+   BSON_ASSERT (mcommon_string_append (&append, "abc"));
+   mcommon_string_from_append_destroy (&append);
+
+   bson_arena_destroy (arena);
+}
+
+
+void
+test_arena_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/arena/alloc", test_bson_arena_alloc);
+   TestSuite_Add (suite, "/bson/arena/realloc", test_bson_arena_realloc);
+   TestSuite_Add (suite, "/bson/arena/reset", test_bson_arena_reset);
+   TestSuite_Add (suite, "/bson/arena/bson", test_bson_arena_bson);
+   TestSuite_Add (suite, "/bson/arena/copy_to", test_bson_arena_copy_to);
+   TestSuite_Add (suite, "/bson/arena/array_builder", test_bson_arena_array_builder);
+   TestSuite_Add (suite, "/bson/arena/string", test_bson_arena_string);
+}
@@ -92,6 +92,33 @@ is_test_skipped (const char *scenario, const char *description)
 }
 
 
+/* the indexed JSON parser must produce the same document, or the same error,
+ * as the streaming parser */
+static void
+compare_json_parsers (const char *json, ssize_t len)
+{
+   bson_t streaming;
+   bson_t indexed;
+   bson_error_t streaming_error;
+   bson_error_t indexed_error;
+   bool r;
+
+   r = bson_init_from_json_with_parser (&streaming, json, len, BSON_JSON_PARSER_STREAMING, &streaming_error);
+   ASSERT_CMPINT (
+      r, ==, bson_init_from_json_with_parser (&indexed, json, len, BSON_JSON_PARSER_INDEXED, &indexed_error));
+
+   if (r) {
+      compare_data (bson_get_data (&indexed), indexed.len, bson_get_data (&streaming), streaming.len);
+      bson_destroy (&indexed);
+      bson_destroy (&streaming);
+   } else {
+      ASSERT_CMPUINT32 (indexed_error.domain, ==, streaming_error.domain);
+      ASSERT_CMPUINT32 (indexed_error.code, ==, streaming_error.code);
+      ASSERT_CMPSTR (indexed_error.message, streaming_error.message);
+   }
+}
+
+
 /*
 See:
 github.com/mongodb/specifications/blob/master/source/bson-corpus/bson-corpus.rst
@@ -145,6 +172,7 @@ test_bson_corpus_valid (test_bson_valid_type_t *test)
    }
 
    decode_cE = bson_new_from_json ((const uint8_t *) test->cE, -1, &error);
+   compare_json_parsers (test->cE, -1);
 
    ASSERT_OR_PRINT (decode_cE, error);
 
@@ -165,6 +193,7 @@ test_bson_corpus_valid (test_bson_valid_type_t *test)
 
    if (test->dE) {
       decode_dE = bson_new_from_json ((const uint8_t *) test->dE, -1, &error);
+   compare_json_parsers (test->dE, -1);
 
       ASSERT_OR_PRINT (decode_dE, error);
       ASSERT_CMPJSON (bson_as_canonical_extended_json (decode_dE, NULL), test->cE);
@@ -178,6 +207,7 @@ test_bson_corpus_valid (test_bson_valid_type_t *test)
 
    if (test->rE) {
       decode_rE = bson_new_from_json ((const uint8_t *) test->rE, -1, &error);
+   compare_json_parsers (test->rE, -1);
 
       ASSERT_OR_PRINT (decode_rE, error);
       ASSERT_CMPJSON (bson_as_relaxed_extended_json (decode_rE, NULL), test->rE);
@@ -240,6 +270,7 @@ test_bson_corpus_parse_error (test_bson_parse_error_type_t *test)
    case BSON_TYPE_EOD: /* top-level document to be parsed as JSON */
    case BSON_TYPE_BINARY:
       ASSERT (!bson_new_from_json ((uint8_t *) test->str, test->str_len, NULL));
+      compare_json_parsers (test->str, (ssize_t) test->str_len);
       break;
    case BSON_TYPE_DECIMAL128: {
       bson_decimal128_t dec;
@@ -1233,6 +1233,89 @@ test_bson_validate (void)
 }
 
 
+/* Validation stops at the first error, wherever it is. */
+static void
+test_bson_validate_first_error (void)
+{
+   bson_t b, child;
+   bson_t *scope;
+   size_t offset;
+   bson_error_t error;
+
+   /* invalid UTF-8 is reported only when asked for */
+   bson_init (&b);
+   BSON_ASSERT (bson_append_utf8 (&b, "a", 1, "x\xff", 2));
+   BSON_ASSERT (bson_append_utf8 (&b, "$b", 2, "y", 1));
+   BSON_ASSERT (bson_validate_with_error_and_offset (&b, BSON_VALIDATE_NONE, &offset, &error));
+   BSON_ASSERT (!bson_validate_with_error_and_offset (&b, BSON_VALIDATE_UTF8, &offset, &error));
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) 4);
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_UTF8, "invalid utf8 string for key \"a\"");
+   /* the elements after the invalid string are still checked */
+   BSON_ASSERT (!bson_validate_with_error_and_offset (&b, BSON_VALIDATE_DOLLAR_KEYS, &offset, &error));
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) 14);
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_DOLLAR_KEYS, "keys cannot begin with \"$\": \"$b\"");
+   bson_destroy (&b);
+
+   /* the elements after a code-with-scope are checked */
+   bson_init (&b);
+   scope = BCON_NEW ("x", BCON_INT32 (1));
+   BSON_ASSERT (bson_append_code_with_scope (&b, "c", 1, "f", scope));
+   BSON_ASSERT (bson_append_int32 (&b, "$z", 2, 1));
+   BSON_ASSERT (!bson_validate_with_error_and_offset (&b, BSON_VALIDATE_DOLLAR_KEYS, &offset, &error));
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) (b.len - 9u));
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_DOLLAR_KEYS, "keys cannot begin with \"$\": \"$z\"");
+   bson_destroy (scope);
+   bson_destroy (&b);
+
+   /* errors within a scope are reported against the code-with-scope */
+   bson_init (&b);
+   scope = BCON_NEW ("$x", BCON_INT32 (1));
+   BSON_ASSERT (bson_append_code_with_scope (&b, "c", 1, "f", scope));
+   BSON_ASSERT (!bson_validate_with_error_and_offset (&b, BSON_VALIDATE_DOLLAR_KEYS, &offset, &error));
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) 4 + 4);
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_NONE, "corrupt code-with-scope");
+   bson_destroy (scope);
+   bson_destroy (&b);
+
+   /* a DBRef missing "$id" is reported against the subdocument */
+   bson_init (&b);
+   BSON_APPEND_DOCUMENT_BEGIN (&b, "dbref", &child);
+   BSON_APPEND_UTF8 (&child, "$ref", "foo");
+   bson_append_document_end (&b, &child);
+   BSON_ASSERT (!bson_validate_with_error_and_offset (&b, BSON_VALIDATE_DOLLAR_KEYS, &offset, &error));
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) 4);
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_DOLLAR_KEYS, "incomplete DBRef subdocument");
+   bson_destroy (&b);
+}
+
+
+/* Documents nested deeper than the validator's inline stack. */
+static void
+test_bson_validate_deep (void)
+{
+   bson_t *docs[101];
+   size_t offset;
+   bson_error_t error;
+   int i;
+
+   docs[100] = BCON_NEW ("x.y", BCON_INT32 (1));
+   for (i = 99; i >= 0; i--) {
+      docs[i] = bson_new ();
+      BSON_ASSERT (BSON_APPEND_DOCUMENT (docs[i], "a", docs[i + 1]));
+   }
+
+   BSON_ASSERT (bson_validate_with_error_and_offset (docs[0], BSON_VALIDATE_DOLLAR_KEYS, &offset, &error));
+   BSON_ASSERT (!bson_validate_with_error_and_offset (docs[0], BSON_VALIDATE_DOT_KEYS, &offset, &error));
+   /* relative to the innermost document */
+   ASSERT_CMPSIZE_T (offset, ==, (size_t) 4);
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_INVALID, BSON_VALIDATE_DOT_KEYS, "keys cannot contain \".\": \"x.y\"");
+
+   for (i = 0; i <= 100; i++) {
+      bson_destroy (docs[i]);
+   }
+}
+
+
 static void
 test_bson_init (void)
 {
@@ -1948,6 +2031,52 @@ test_bson_destroy_with_steal (void)
 }
 
 
+static void
+test_bson_init_from_buffer_steal (void)
+{
+   bson_t *src;
+   bson_t b;
+   uint8_t *buf;
+   uint8_t *data;
+   size_t buf_len;
+   uint32_t len;
+   bson_iter_t iter;
+
+   src = BCON_NEW ("a", BCON_INT32 (1), "b", BCON_UTF8 ("two"));
+
+   /* document preceded by a header that must be skipped, as in a wire reply */
+   buf_len = 21u + src->len;
+   buf = bson_malloc0 (buf_len);
+   memcpy (buf + 21, bson_get_data (src), src->len);
+
+   BSON_ASSERT (!bson_init_from_buffer_steal (&b, buf, buf_len, 22));
+   BSON_ASSERT (!bson_init_from_buffer_steal (&b, buf, buf_len - 1u, 21));
+   BSON_ASSERT (!bson_init_from_buffer_steal (&b, buf, buf_len, buf_len + 1u));
+
+   BSON_ASSERT (bson_init_from_buffer_steal (&b, buf, buf_len, 21));
+   BSON_ASSERT (bson_get_data (&b) == buf + 21);
+   BSON_ASSERT (bson_equal (&b, src));
+
+   /* the adopted buffer can still be grown */
+   BSON_APPEND_INT64 (&b, "c", 3);
+   BSON_ASSERT (bson_iter_init_find (&iter, &b, "b"));
+   ASSERT_CMPSTR (bson_iter_utf8 (&iter, NULL), "two");
+   BSON_ASSERT (bson_iter_init_find (&iter, &b, "c"));
+   BSON_ASSERT (bson_iter_int64 (&iter) == 3);
+
+   /* stealing back returns the document at the start of the buffer */
+   len = b.len;
+   data = bson_destroy_with_steal (&b, true, NULL);
+   BSON_ASSERT (data);
+   BSON_ASSERT (bson_init_static (&b, data, len));
+   BSON_ASSERT (bson_iter_init_find (&iter, &b, "a"));
+   BSON_ASSERT (bson_iter_int32 (&iter) == 1);
+   bson_free (data);
+
+   bson_destroy (src);
+}
+
+
 static void
 test_bson_has_field (void)
 {
@@ -3250,6 +3379,8 @@ test_bson_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/validate/bool", test_bson_validate_bool);
    TestSuite_Add (suite, "/bson/validate/dbpointer", test_bson_validate_dbpointer);
    TestSuite_Add (suite, "/bson/validate/with_error_and_offset", test_bson_validate_with_error_and_offset);
+   TestSuite_Add (suite, "/bson/validate/first_error", test_bson_validate_first_error);
+   TestSuite_Add (suite, "/bson/validate/deep", test_bson_validate_deep);
    TestSuite_Add (suite, "/bson/new_1mm", test_bson_new_1mm);
    TestSuite_Add (suite, "/bson/init_1mm", test_bson_init_1mm);
    TestSuite_Add (suite, "/bson/build_child", test_bson_build_child);
@@ -3269,6 +3400,7 @@ test_bson_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/reserve_buffer", test_bson_reserve_buffer);
    TestSuite_Add (suite, "/bson/reserve_buffer/errors", test_bson_reserve_buffer_errors);
    TestSuite_Add (suite, "/bson/destroy_with_steal", test_bson_destroy_with_steal);
+   TestSuite_Add (suite, "/bson/init_from_buffer_steal", test_bson_init_from_buffer_steal);
    TestSuite_Add (suite, "/bson/has_field", test_bson_has_field);
    TestSuite_Add (suite, "/bson/visit_invalid_field", test_bson_visit_invalid_field);
    TestSuite_Add (suite, "/bson/unsupported_type", test_bson_visit_unsupported_type);
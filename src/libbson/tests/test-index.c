@@ -0,0 +1,159 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bcon.h>
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+
+
+static void
+test_bson_index_find (void)
+{
+   bson_t *b;
+   bson_index_t *index;
+   bson_iter_t iter;
+
+   b = BCON_NEW ("a", BCON_INT32 (1), "ab", BCON_UTF8 ("two"), "", BCON_INT32 (3), "c", "{", "d", BCON_INT32 (4), "}");
+   index = bson_index_new (b);
+
+   BSON_ASSERT (bson_index_find (index, "a", &iter));
+   ASSERT_CMPSTR (bson_iter_key (&iter), "a");
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 1);
+
+   /* the iterator continues with the following fields */
+   BSON_ASSERT (bson_iter_next (&iter));
+   ASSERT_CMPSTR (bson_iter_key (&iter), "ab");
+   ASSERT_CMPSTR (bson_iter_utf8 (&iter, NULL), "two");
+
+   BSON_ASSERT (bson_index_find (index, "", &iter));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 3);
+
+   BSON_ASSERT (bson_index_find_w_len (index, "abc", 2, &iter));
+   ASSERT_CMPSTR (bson_iter_key (&iter), "ab");
+
+   BSON_ASSERT (bson_index_find (index, "c", &iter));
+   BSON_ASSERT (BSON_ITER_HOLDS_DOCUMENT (&iter));
+
+   /* only top-level keys are indexed, and the search is case-sensitive */
+   BSON_ASSERT (!bson_index_find (index, "d", &iter));
+   BSON_ASSERT (!bson_index_find (index, "c.d", &iter));
+   BSON_ASSERT (!bson_index_find (index, "A", &iter));
+   BSON_ASSERT (!bson_index_find (index, "abc", &iter));
+
+   bson_index_destroy (index);
+   bson_destroy (b);
+}
+
+
+/* As with bson_iter_find, the first of several fields with the same key is
+ * found. */
+static void
+test_bson_index_duplicate_keys (void)
+{
+   bson_t *b;
+   bson_index_t *index;
+   bson_iter_t iter;
+
+   b = BCON_NEW ("x", BCON_INT32 (1), "y", BCON_INT32 (2), "x", BCON_INT32 (3));
+   index = bson_index_new (b);
+
+   BSON_ASSERT (bson_index_find (index, "x", &iter));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 1);
+
+   bson_index_destroy (index);
+   bson_destroy (b);
+}
+
+
+/* Enough fields to outgrow the slots held within the index. */
+static void
+test_bson_index_wide (void)
+{
+   bson_t b = BSON_INITIALIZER;
+   bson_index_t *index;
+   bson_iter_t iter;
+   char key[16];
+   int i;
+
+   for (i = 0; i < 1000; i++) {
+      bson_snprintf (key, sizeof key, "field%d", i);
+      BSON_ASSERT (bson_append_int32 (&b, key, -1, i));
+   }
+
+   index = bson_index_new (&b);
+
+   for (i = 0; i < 1000; i++) {
+      bson_snprintf (key, sizeof key, "field%d", i);
+      BSON_ASSERT (bson_index_find (index, key, &iter));
+      ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, i);
+   }
+
+   BSON_ASSERT (!bson_index_find (index, "field1000", &iter));
+
+   bson_index_destroy (index);
+   bson_destroy (&b);
+}
+
+
+static void
+test_bson_index_empty (void)
+{
+   bson_t b = BSON_INITIALIZER;
+   bson_index_t *index;
+   bson_iter_t iter;
+
+   index = bson_index_new (&b);
+   BSON_ASSERT (!bson_index_find (index, "", &iter));
+   BSON_ASSERT (!bson_index_find (index, "a", &iter));
+   bson_index_destroy (index);
+   bson_destroy (&b);
+
+   bson_index_destroy (NULL);
+}
+
+
+/* The fields before a corrupt field are indexed. */
+static void
+test_bson_index_corrupt (void)
+{
+   /* {"a": 1, "b": true}, with the boolean value replaced by 2 */
+   const uint8_t data[] = "\x10\x00\x00\x00\x10\x61\x00\x01\x00\x00\x00\x08\x62\x00\x02";
+   bson_t b;
+   bson_index_t *index;
+   bson_iter_t iter;
+
+   BSON_ASSERT (bson_init_static (&b, data, sizeof data));
+   index = bson_index_new (&b);
+
+   BSON_ASSERT (bson_index_find (index, "a", &iter));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 1);
+   BSON_ASSERT (!bson_index_find (index, "b", &iter));
+
+   bson_index_destroy (index);
+}
+
+
+void
+test_index_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/index/find", test_bson_index_find);
+   TestSuite_Add (suite, "/bson/index/duplicate_keys", test_bson_index_duplicate_keys);
+   TestSuite_Add (suite, "/bson/index/wide", test_bson_index_wide);
+   TestSuite_Add (suite, "/bson/index/empty", test_bson_index_empty);
+   TestSuite_Add (suite, "/bson/index/corrupt", test_bson_index_corrupt);
+}
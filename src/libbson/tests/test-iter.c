@@ -373,6 +373,27 @@ test_bson_iter_find_w_len (void)
    BSON_ASSERT (bson_iter_init (&iter, &b));
    BSON_ASSERT (bson_iter_find_w_len (&iter, "key", -1));
    bson_destroy (&b);
+
+   /* keys sharing a prefix only match at their exact length */
+   bson_init (&b);
+   BSON_ASSERT (bson_append_int32 (&b, "k", -1, 1));
+   BSON_ASSERT (bson_append_int32 (&b, "keys", -1, 4));
+   BSON_ASSERT (bson_append_int32 (&b, "ke", -1, 2));
+   BSON_ASSERT (bson_append_int32 (&b, "key", -1, 3));
+   BSON_ASSERT (bson_iter_init (&iter, &b));
+   BSON_ASSERT (bson_iter_find_w_len (&iter, "keys", 3));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 3);
+   BSON_ASSERT (bson_iter_init (&iter, &b));
+   BSON_ASSERT (bson_iter_find (&iter, "ke"));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 2);
+   BSON_ASSERT (bson_iter_init (&iter, &b));
+   BSON_ASSERT (bson_iter_find_case (&iter, "KEY"));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, 3);
+   BSON_ASSERT (bson_iter_init (&iter, &b));
+   BSON_ASSERT (!bson_iter_find (&iter, "kez"));
+   BSON_ASSERT (bson_iter_init (&iter, &b));
+   BSON_ASSERT (!bson_iter_find_w_len (&iter, "", 0));
+   bson_destroy (&b);
 }
 
 
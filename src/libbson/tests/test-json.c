@@ -328,7 +328,6 @@ test_bson_as_json_double (void)
    size_t len;
    bson_t *b;
    char *str;
-   char *expected;
 
    b = bson_new ();
    BSON_ASSERT (bson_append_double (b, "foo", -1, 123.5));
@@ -338,22 +337,71 @@ test_bson_as_json_double (void)
    BSON_ASSERT (bson_append_double (b, "huge", -1, 1e99));
    str = bson_as_legacy_extended_json (b, &len);
 
-   expected = bson_strdup_printf ("{"
-                                  " \"foo\" : 123.5,"
-                                  " \"bar\" : 3.0,"
-                                  " \"baz\" : -1.0,"
-                                  " \"quux\" : 0.03125,"
-                                  " \"huge\" : %.20g }",
-                                  1e99);
-
-   ASSERT_CMPSTR (str, expected);
+   ASSERT_CMPSTR (str,
+                  "{"
+                  " \"foo\" : 123.5,"
+                  " \"bar\" : 3.0,"
+                  " \"baz\" : -1.0,"
+                  " \"quux\" : 0.03125,"
+                  " \"huge\" : 1e+99 }");
 
-   bson_free (expected);
    bson_free (str);
    bson_destroy (b);
 }
 
 
+/* Doubles are written with the fewest digits that read back as the same value, in the layout of "%.20g". */
+static void
+test_bson_as_json_double_shortest (void)
+{
+   const struct {
+      double value;
+      const char *expected;
+   } tests[] = {
+      {0.0, "0.0"},
+      {-0.0, "-0.0"},
+      {0.1, "0.1"},
+      {-0.3, "-0.3"},
+      {1.0 / 3.0, "0.3333333333333333"},
+      {2.5e-5, "2.5e-05"},
+      {0.000125, "0.000125"},
+      {1e19, "10000000000000000000.0"},
+      {1e20, "1e+20"},
+      {123456789012345678.0, "123456789012345680.0"},
+      {1.7976931348623157e308, "1.7976931348623157e+308"},
+      {2.2250738585072014e-308, "2.2250738585072014e-308"},
+      {5e-324, "5e-324"},
+      {-1.5e-7, "-1.5e-07"},
+   };
+
+   for (size_t i = 0; i < sizeof tests / sizeof tests[0]; i++) {
+      bson_t *b = bson_new ();
+      BSON_ASSERT (bson_append_double (b, "d", -1, tests[i].value));
+
+      char *expected = bson_strdup_printf ("{ \"d\" : %s }", tests[i].expected);
+      char *str = bson_as_relaxed_extended_json (b, NULL);
+      ASSERT_CMPSTR (str, expected);
+      bson_free (str);
+      bson_free (expected);
+
+      expected = bson_strdup_printf ("{ \"d\" : { \"$numberDouble\" : \"%s\" } }", tests[i].expected);
+      str = bson_as_canonical_extended_json (b, NULL);
+      ASSERT_CMPSTR (str, expected);
+
+      // Reading the output back gives the same value.
+      bson_error_t error;
+      bson_t *parsed = bson_new_from_json ((const uint8_t *) str, -1, &error);
+      ASSERT_OR_PRINT (parsed, error);
+      ASSERT (bson_equal (parsed, b));
+
+      bson_destroy (parsed);
+      bson_free (str);
+      bson_free (expected);
+      bson_destroy (b);
+   }
+}
+
+
 static void
 test_bson_as_json_double_nonfinite (void)
 {
@@ -827,6 +875,118 @@ test_bson_json_read_buffering (void)
    bson_destroy (&bson_out);
 }
 
+
+/* read every document of @json with both parsers, expecting the same
+ * documents and the same final result */
+static void
+compare_json_readers (const char *json, size_t buf_size)
+{
+   bson_json_reader_t *streaming;
+   bson_json_reader_t *indexed;
+   bson_t streaming_doc = BSON_INITIALIZER;
+   bson_t indexed_doc = BSON_INITIALIZER;
+   bson_error_t streaming_error;
+   bson_error_t indexed_error;
+   int r;
+
+   streaming = bson_json_data_reader_new (true, buf_size);
+   indexed = bson_json_data_reader_new (true, buf_size);
+   bson_json_reader_set_parser (indexed, BSON_JSON_PARSER_INDEXED);
+   bson_json_data_reader_ingest (streaming, (const uint8_t *) json, strlen (json));
+   bson_json_data_reader_ingest (indexed, (const uint8_t *) json, strlen (json));
+
+   do {
+      bson_reinit (&streaming_doc);
+      bson_reinit (&indexed_doc);
+      r = bson_json_reader_read (streaming, &streaming_doc, &streaming_error);
+      ASSERT_CMPINT (r, ==, bson_json_reader_read (indexed, &indexed_doc, &indexed_error));
+
+      if (r == 1) {
+         bson_eq_bson (&indexed_doc, &streaming_doc);
+      } else if (r < 0) {
+         ASSERT_CMPSTR (indexed_error.message, streaming_error.message);
+      }
+   } while (r == 1);
+
+   bson_destroy (&streaming_doc);
+   bson_destroy (&indexed_doc);
+   bson_json_reader_destroy (streaming);
+   bson_json_reader_destroy (indexed);
+}
+
+
+static void
+test_bson_json_read_indexed (void)
+{
+   const char *streams[] = {
+      "",
+      "  \n ",
+      "{}",
+      "{\"a\": 1}\n{\"b\": [1, 2.5, -3e10, true, false, null]}\n{\"c\": {\"d\": \"\\u00e9\\n\\\"\"}}\n",
+      /* top-level arrays, and documents not separated by whitespace */
+      "[1, {\"a\": 2}][]{\"x\": []}{}",
+      /* a document ending on the last byte of a 64-byte block */
+      "{\"a\":                                                         1}\n{\"b\": 2}",
+      /* canonical extended JSON, converted by the indexed parser */
+      "{\"_id\": {\"$oid\": \"56e1fc72e0c917e9c4714161\"}, \"i\": {\"$numberInt\": \"-42\"}, "
+      "\"l\": {\"$numberLong\": \"1234567890123\"}, \"d\": {\"$numberDouble\": \"-Infinity\"}, "
+      "\"dec\": {\"$numberDecimal\": \"1.23E+10\"}, \"date\": {\"$date\": {\"$numberLong\": \"1356351330501\"}}, "
+      "\"iso\": {\"$date\": \"2012-12-24T12:15:30.501Z\"}, \"bin\": {\"$binary\": {\"base64\": \"//8=\", "
+      "\"subType\": \"80\"}}, \"ts\": {\"$timestamp\": {\"t\": 4294967295, \"i\": 1}}, "
+      "\"re\": {\"$regularExpression\": {\"pattern\": \"a\\\\b\", \"options\": \"i\"}}, \"min\": {\"$minKey\": 1}, "
+      "\"max\": {\"$maxKey\": 1}, \"u\": {\"$undefined\": true}, \"sym\": {\"$symbol\": \"s\"}, "
+      "\"code\": {\"$code\": \"x = 1\"}}",
+      /* legacy and rare forms, converted by the streaming parser */
+      "{\"re\": {\"$regex\": \"a\", \"$options\": \"i\"}}\n{\"c\": {\"$code\": \"x\", \"$scope\": {\"y\": 1}}}\n"
+      "{\"t\": {\"$type\": \"string\"}}\n{\"u\": {\"\\u0024oid\": \"56e1fc72e0c917e9c4714161\"}}\n"
+      "{\"n\": 12345678901234567890}",
+      /* errors, reported after any valid documents before them */
+      "{\"a\": 1} {\"b\": }",
+      "{\"a\": 1} x",
+      "{\"a\": 1} {\"b\": 1",
+      "{\"a\": {\"$numberLong\": \"1\", \"x\": 1}}",
+      "{\"a\": \"\\ud800\"}",
+      "{\"a\\u0000\": 1}",
+      "{\"a\": 01}",
+   };
+
+   for (size_t i = 0u; i < sizeof streams / sizeof streams[0]; i++) {
+      compare_json_readers (streams[i], 1u);
+      compare_json_readers (streams[i], 7u);
+      compare_json_readers (streams[i], 0u /* default */);
+   }
+}
+
+
+static void
+test_bson_init_from_json_with_parser (void)
+{
+   const char *json = "{\"a\": [1, {\"$numberLong\": \"2\"}], \"b\": {\"c\": \"d\"}}";
+   bson_error_t error;
+   bson_t bson;
+   bson_t *expected;
+
+   expected = BCON_NEW ("a", "[", BCON_INT32 (1), BCON_INT64 (2), "]", "b", "{", "c", "d", "}");
+
+   ASSERT_OR_PRINT (bson_init_from_json_with_parser (&bson, json, -1, BSON_JSON_PARSER_INDEXED, &error), error);
+   bson_eq_bson (&bson, expected);
+   bson_destroy (&bson);
+
+   /* the deprecated merging of comma-separated documents is preserved */
+   json = "{\"a\": [1, {\"$numberLong\": \"2\"}]},{\"b\": {\"c\": \"d\"}}";
+   ASSERT_OR_PRINT (bson_init_from_json_with_parser (&bson, json, -1, BSON_JSON_PARSER_INDEXED, &error), error);
+   bson_eq_bson (&bson, expected);
+   bson_destroy (&bson);
+
+   BSON_ASSERT (!bson_init_from_json_with_parser (&bson, "{\"a\": 1", -1, BSON_JSON_PARSER_INDEXED, &error));
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_CORRUPT_JS, "Incomplete JSON");
+
+   BSON_ASSERT (!bson_init_from_json_with_parser (&bson, "", -1, BSON_JSON_PARSER_INDEXED, &error));
+   ASSERT_ERROR_CONTAINS (error, BSON_ERROR_JSON, BSON_JSON_ERROR_READ_INVALID_PARAM, "Empty JSON string");
+
+   bson_destroy (expected);
+}
+
 static void
 _test_bson_json_read_compare (const char *json, int size, ...)
 {
@@ -3801,6 +3961,7 @@ test_json_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/as_json/int32", test_bson_as_json_int32);
    TestSuite_Add (suite, "/bson/as_json/int64", test_bson_as_json_int64);
    TestSuite_Add (suite, "/bson/as_json/double", test_bson_as_json_double);
+   TestSuite_Add (suite, "/bson/as_json/double/shortest", test_bson_as_json_double_shortest);
    TestSuite_Add (suite, "/bson/as_json/double/nonfinite", test_bson_as_json_double_nonfinite);
    TestSuite_Add (suite, "/bson/as_json/code", test_bson_as_json_code);
    TestSuite_Add (suite, "/bson/as_json/date_time", test_bson_as_json_date_time);
@@ -3819,6 +3980,8 @@ test_json_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/array_as_canonical_json", test_bson_array_as_canonical_json);
    TestSuite_Add (suite, "/bson/json/allow_multiple", test_bson_json_allow_multiple);
    TestSuite_Add (suite, "/bson/json/read/buffering", test_bson_json_read_buffering);
+   TestSuite_Add (suite, "/bson/json/read/indexed", test_bson_json_read_indexed);
+   TestSuite_Add (suite, "/bson/json/init_from_json_with_parser", test_bson_init_from_json_with_parser);
    TestSuite_Add (suite, "/bson/json/read", test_bson_json_read);
    TestSuite_Add (suite, "/bson/json/inc", test_bson_json_inc);
    TestSuite_Add (suite, "/bson/json/array", test_bson_json_array);
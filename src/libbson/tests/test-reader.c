@@ -299,6 +299,258 @@ test_reader_reset (void)
 }
 
 
+static void
+test_reader_from_mmap (void)
+{
+   bson_reader_t *reader;
+   const bson_t *b;
+   bson_error_t error;
+   uint32_t i;
+   bool eof = true;
+
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/stream.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+
+   for (i = 0; i < 1000; i++) {
+      ASSERT_CMPINT (5 * i, ==, (int) bson_reader_tell (reader));
+      eof = false;
+      b = bson_reader_read (reader, &eof);
+      BSON_ASSERT (b);
+      BSON_ASSERT (bson_empty (b));
+   }
+
+   ASSERT_CMPINT (5000, ==, (int) bson_reader_tell (reader));
+   BSON_ASSERT (!eof);
+   BSON_ASSERT (!bson_reader_read (reader, &eof));
+   BSON_ASSERT (eof);
+
+   bson_reader_reset (reader);
+   ASSERT_CMPINT (0, ==, (int) bson_reader_tell (reader));
+   BSON_ASSERT (bson_reader_read (reader, &eof));
+
+   bson_reader_destroy (reader);
+
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/no_such_file.bson", &error);
+   BSON_ASSERT (!reader);
+   ASSERT_CMPUINT32 (error.domain, ==, BSON_ERROR_READER);
+   ASSERT_CMPUINT32 (error.code, ==, BSON_ERROR_READER_BADFD);
+}
+
+
+static void
+test_reader_from_mmap_corrupt (void)
+{
+   bson_reader_t *reader;
+   bson_error_t error;
+   uint32_t i;
+   bool eof;
+
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/stream_corrupt.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+
+   for (i = 0; i < 1000; i++) {
+      BSON_ASSERT (bson_reader_read (reader, &eof));
+   }
+
+   BSON_ASSERT (!bson_reader_read (reader, &eof));
+   BSON_ASSERT (!eof);
+
+   bson_reader_destroy (reader);
+}
+
+
+// Read every part of @reader split into @max_parts, checking that the parts are contiguous, and return the number of
+// documents read. @eof is set if the last part reached the end of the file.
+static uint32_t
+read_partitions (bson_reader_t *reader, size_t max_parts, size_t *num_parts, bool *eof)
+{
+   bson_reader_t *parts[8];
+   off_t expected_start = bson_reader_tell (reader);
+   uint32_t count = 0;
+
+   BSON_ASSERT (max_parts <= sizeof parts / sizeof parts[0]);
+
+   *num_parts = bson_reader_partition (reader, parts, max_parts);
+   BSON_ASSERT (*num_parts <= max_parts);
+
+   for (size_t i = 0; i < *num_parts; i++) {
+      ASSERT_CMPINT64 ((int64_t) bson_reader_tell (parts[i]), ==, (int64_t) expected_start);
+
+      while (bson_reader_read (parts[i], eof)) {
+         count++;
+      }
+
+      expected_start = bson_reader_tell (parts[i]);
+   }
+
+   // Destroy the parts after the reader they were partitioned from.
+   bson_reader_destroy (reader);
+
+   for (size_t i = 0; i < *num_parts; i++) {
+      bson_reader_destroy (parts[i]);
+   }
+
+   return count;
+}
+
+
+static void
+test_reader_partition (void)
+{
+   bson_reader_t *reader;
+   bson_error_t error;
+   size_t num_parts;
+   bool eof;
+
+   for (size_t max_parts = 1; max_parts <= 8; max_parts++) {
+      reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/stream.bson", &error);
+      ASSERT_OR_PRINT (reader, error);
+
+      eof = false;
+      ASSERT_CMPUINT32 (read_partitions (reader, max_parts, &num_parts, &eof), ==, 1000u);
+      ASSERT_CMPSIZE_T (num_parts, ==, max_parts);
+      BSON_ASSERT (eof);
+   }
+
+   /* Only the documents not yet read are partitioned. */
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/stream.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+
+   for (uint32_t i = 0; i < 998; i++) {
+      BSON_ASSERT (bson_reader_read (reader, &eof));
+   }
+
+   ASSERT_CMPUINT32 (read_partitions (reader, 8, &num_parts, &eof), ==, 2u);
+   ASSERT_CMPSIZE_T (num_parts, ==, 2u);
+
+   /* A single large document cannot be split. */
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/readergrow.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+   ASSERT_CMPUINT32 (read_partitions (reader, 4, &num_parts, &eof), ==, 1u);
+   ASSERT_CMPSIZE_T (num_parts, ==, 1u);
+
+   /* The remainder from a corrupt length prefix is left in the last part. */
+   reader = bson_reader_new_from_mmap (BSON_BINARY_DIR "/stream_corrupt.bson", &error);
+   ASSERT_OR_PRINT (reader, error);
+   eof = true;
+   ASSERT_CMPUINT32 (read_partitions (reader, 4, &num_parts, &eof), ==, 1000u);
+   BSON_ASSERT (!eof);
+}
+
+
+typedef struct {
+   int32_t next;
+   int32_t delivered;
+} parallel_ctx_t;
+
+
+static void *
+parallel_map (const bson_t *doc, void *ctx)
+{
+   bson_iter_t iter;
+
+   BSON_UNUSED (ctx);
+
+   BSON_ASSERT (bson_iter_init_find (&iter, doc, "i"));
+
+   // Return a non-NULL value derived from the document.
+   return (void *) (intptr_t) (bson_iter_int32 (&iter) + 1);
+}
+
+
+static void
+parallel_deliver (const bson_t *doc, void *result, void *ctx)
+{
+   parallel_ctx_t *const pctx = ctx;
+   bson_iter_t iter;
+
+   BSON_ASSERT (bson_iter_init_find (&iter, doc, "i"));
+   ASSERT_CMPINT32 (bson_iter_int32 (&iter), ==, pctx->delivered);
+   ASSERT_CMPINT64 ((int64_t) (intptr_t) result, ==, (int64_t) pctx->delivered + 1);
+
+   pctx->delivered++;
+}
+
+
+typedef struct {
+   const uint8_t *data;
+   size_t len;
+   size_t pos;
+} parallel_handle_t;
+
+
+// Read at most 1000 bytes at a time, so that documents span reads.
+static ssize_t
+parallel_handle_read (void *handle, void *buf, size_t len)
+{
+   parallel_handle_t *const h = handle;
+   const size_t n = BSON_MIN (BSON_MIN (len, h->len - h->pos), 1000u);
+
+   memcpy (buf, h->data + h->pos, n);
+   h->pos += n;
+
+   return (ssize_t) n;
+}
+
+
+static void
+test_reader_read_parallel (void)
+{
+   const int32_t num_docs = 10000;
+   uint8_t *data = NULL;
+   size_t len = 0;
+   bson_reader_t *reader;
+   parallel_ctx_t ctx;
+
+   // More documents than are processed in one batch.
+   for (int32_t i = 0; i < num_docs; i++) {
+      bson_t *const doc = BCON_NEW ("i", BCON_INT32 (i), "padding", BCON_UTF8 ("0123456789"));
+
+      data = bson_realloc (data, len + doc->len);
+      memcpy (data + len, bson_get_data (doc), doc->len);
+      len += doc->len;
+      bson_destroy (doc);
+   }
+
+   for (size_t num_threads = 0; num_threads <= 4; num_threads++) {
+      parallel_handle_t handle = {data, len, 0};
+
+      memset (&ctx, 0, sizeof ctx);
+      reader = bson_reader_new_from_data (data, len);
+      BSON_ASSERT (bson_reader_read_parallel (reader, num_threads, parallel_map, parallel_deliver, &ctx));
+      ASSERT_CMPINT32 (ctx.delivered, ==, num_docs);
+      bson_reader_destroy (reader);
+
+      // Documents from a handle are copied.
+      memset (&ctx, 0, sizeof ctx);
+      reader = bson_reader_new_from_handle (&handle, parallel_handle_read, NULL);
+      BSON_ASSERT (bson_reader_read_parallel (reader, num_threads, parallel_map, parallel_deliver, &ctx));
+      ASSERT_CMPINT32 (ctx.delivered, ==, num_docs);
+      bson_reader_destroy (reader);
+   }
+
+   // Documents before a corrupt length prefix are delivered.
+   data = bson_realloc (data, len + 5u);
+   memset (data + len, 0, 5u);
+   data[len] = 4;
+
+   memset (&ctx, 0, sizeof ctx);
+   reader = bson_reader_new_from_data (data, len + 5u);
+   BSON_ASSERT (!bson_reader_read_parallel (reader, 4, parallel_map, parallel_deliver, &ctx));
+   ASSERT_CMPINT32 (ctx.delivered, ==, num_docs);
+   bson_reader_destroy (reader);
+
+   // An empty stream.
+   memset (&ctx, 0, sizeof ctx);
+   reader = bson_reader_new_from_data (data, 0);
+   BSON_ASSERT (bson_reader_read_parallel (reader, 4, parallel_map, parallel_deliver, &ctx));
+   ASSERT_CMPINT32 (ctx.delivered, ==, 0);
+   bson_reader_destroy (reader);
+
+   bson_free (data);
+}
+
+
 void
 test_reader_install (TestSuite *suite)
 {
@@ -313,4 +565,8 @@ test_reader_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/reader/new_from_handle_corrupt", test_reader_from_handle_corrupt);
    TestSuite_Add (suite, "/bson/reader/grow_buffer", test_reader_grow_buffer);
    TestSuite_Add (suite, "/bson/reader/reset", test_reader_reset);
+   TestSuite_Add (suite, "/bson/reader/new_from_mmap", test_reader_from_mmap);
+   TestSuite_Add (suite, "/bson/reader/new_from_mmap_corrupt", test_reader_from_mmap_corrupt);
+   TestSuite_Add (suite, "/bson/reader/partition", test_reader_partition);
+   TestSuite_Add (suite, "/bson/reader/read_parallel", test_reader_read_parallel);
 }
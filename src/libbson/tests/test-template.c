@@ -0,0 +1,205 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <bson/bcon.h>
+#include <bson/bson.h>
+
+#include "TestSuite.h"
+#include "test-conveniences.h"
+
+
+static void
+test_bson_template_append (void)
+{
+   bson_template_t *tmpl;
+   bson_value_t values[12];
+   bson_t *child;
+   bson_t *array;
+   bson_t expected;
+   bson_t b;
+   bson_oid_t oid;
+   bson_decimal128_t dec;
+
+   bson_oid_init_from_string (&oid, "000102030405060708090a0b");
+   BSON_ASSERT (bson_decimal128_from_string ("1.5", &dec));
+   child = BCON_NEW ("x", BCON_INT32 (1));
+   array = BCON_NEW ("0", BCON_UTF8 ("a"), "1", BCON_UTF8 ("b"));
+
+   tmpl = bson_template_new ();
+   BSON_ASSERT (bson_template_add (tmpl, "getMore", -1, BSON_TYPE_INT64));
+   BSON_ASSERT (bson_template_add (tmpl, "collection", -1, BSON_TYPE_UTF8));
+   BSON_ASSERT (bson_template_add (tmpl, "i", 1, BSON_TYPE_INT32));
+   BSON_ASSERT (bson_template_add (tmpl, "doc", -1, BSON_TYPE_DOCUMENT));
+   BSON_ASSERT (bson_template_add (tmpl, "arr", -1, BSON_TYPE_ARRAY));
+   BSON_ASSERT (bson_template_add (tmpl, "d", -1, BSON_TYPE_DOUBLE));
+   BSON_ASSERT (bson_template_add (tmpl, "b", -1, BSON_TYPE_BOOL));
+   BSON_ASSERT (bson_template_add (tmpl, "oid", -1, BSON_TYPE_OID));
+   BSON_ASSERT (bson_template_add (tmpl, "date", -1, BSON_TYPE_DATE_TIME));
+   BSON_ASSERT (bson_template_add (tmpl, "null", -1, BSON_TYPE_NULL));
+   BSON_ASSERT (bson_template_add (tmpl, "ts", -1, BSON_TYPE_TIMESTAMP));
+   BSON_ASSERT (bson_template_add (tmpl, "dec", -1, BSON_TYPE_DECIMAL128));
+
+   values[0].value_type = BSON_TYPE_INT64;
+   values[0].value.v_int64 = INT64_MAX - 1;
+   values[1].value_type = BSON_TYPE_UTF8;
+   values[1].value.v_utf8.str = (char *) "coll";
+   values[1].value.v_utf8.len = 4u;
+   values[2].value_type = BSON_TYPE_INT32;
+   values[2].value.v_int32 = -2;
+   values[3].value_type = BSON_TYPE_DOCUMENT;
+   values[3].value.v_doc.data = (uint8_t *) bson_get_data (child);
+   values[3].value.v_doc.data_len = child->len;
+   values[4].value_type = BSON_TYPE_ARRAY;
+   values[4].value.v_doc.data = (uint8_t *) bson_get_data (array);
+   values[4].value.v_doc.data_len = array->len;
+   values[5].value_type = BSON_TYPE_DOUBLE;
+   values[5].value.v_double = 0.5;
+   values[6].value_type = BSON_TYPE_BOOL;
+   values[6].value.v_bool = true;
+   values[7].value_type = BSON_TYPE_OID;
+   bson_oid_copy (&oid, &values[7].value.v_oid);
+   values[8].value_type = BSON_TYPE_DATE_TIME;
+   values[8].value.v_datetime = 1234567890123;
+   values[9].value_type = BSON_TYPE_NULL;
+   values[10].value_type = BSON_TYPE_TIMESTAMP;
+   values[10].value.v_timestamp.timestamp = 100u;
+   values[10].value.v_timestamp.increment = 7u;
+   values[11].value_type = BSON_TYPE_DECIMAL128;
+   values[11].value.v_decimal128 = dec;
+
+   bson_init (&expected);
+   BSON_APPEND_UTF8 (&expected, "first", "field");
+   BSON_APPEND_INT64 (&expected, "getMore", INT64_MAX - 1);
+   BSON_APPEND_UTF8 (&expected, "collection", "coll");
+   BSON_APPEND_INT32 (&expected, "i", -2);
+   BSON_APPEND_DOCUMENT (&expected, "doc", child);
+   BSON_APPEND_ARRAY (&expected, "arr", array);
+   BSON_APPEND_DOUBLE (&expected, "d", 0.5);
+   BSON_APPEND_BOOL (&expected, "b", true);
+   BSON_APPEND_OID (&expected, "oid", &oid);
+   BSON_APPEND_DATE_TIME (&expected, "date", 1234567890123);
+   BSON_APPEND_NULL (&expected, "null");
+   BSON_APPEND_TIMESTAMP (&expected, "ts", 100u, 7u);
+   BSON_APPEND_DECIMAL128 (&expected, "dec", &dec);
+   BSON_APPEND_INT32 (&expected, "last", 1);
+
+   /* the fields are appended after any already in the document */
+   bson_init (&b);
+   BSON_APPEND_UTF8 (&b, "first", "field");
+   BSON_ASSERT (bson_template_append (tmpl, &b, values, 12u));
+   BSON_APPEND_INT32 (&b, "last", 1);
+   bson_eq_bson (&b, &expected);
+   bson_destroy (&b);
+
+   /* a template may be appended more than once with different values */
+   values[1].value.v_utf8.str = (char *) "";
+   values[1].value.v_utf8.len = 0u;
+   bson_init (&b);
+   BSON_ASSERT (bson_template_append (tmpl, &b, values, 12u));
+   BSON_ASSERT (bson_template_append (tmpl, &b, values, 12u));
+   BSON_ASSERT (bson_validate (&b, BSON_VALIDATE_NONE, NULL));
+   ASSERT_CMPSTR (bson_lookup_utf8 (&b, "collection"), "");
+   bson_destroy (&b);
+
+   bson_destroy (&expected);
+   bson_template_destroy (tmpl);
+   bson_destroy (array);
+   bson_destroy (child);
+}
+
+
+static void
+test_bson_template_fixed (void)
+{
+   bson_template_t *tmpl;
+   bson_value_t values[2];
+   bson_t b = BSON_INITIALIZER;
+
+   tmpl = bson_template_new ();
+   BSON_ASSERT (bson_template_add (tmpl, "a", -1, BSON_TYPE_INT32));
+   BSON_ASSERT (bson_template_add (tmpl, "bcd", 2, BSON_TYPE_INT64));
+
+   values[0].value_type = BSON_TYPE_INT32;
+   values[0].value.v_int32 = 1;
+   values[1].value_type = BSON_TYPE_INT64;
+   values[1].value.v_int64 = 2;
+
+   BSON_ASSERT (bson_template_append (tmpl, &b, values, 2u));
+   ASSERT_EQUAL_BSON (tmp_bson ("{'a': 1, 'bc': {'$numberLong': '2'}}"), &b);
+
+   bson_destroy (&b);
+   bson_template_destroy (tmpl);
+
+   /* an empty template appends nothing */
+   tmpl = bson_template_new ();
+   bson_init (&b);
+   BSON_ASSERT (bson_template_append (tmpl, &b, NULL, 0u));
+   BSON_ASSERT (bson_empty (&b));
+   bson_destroy (&b);
+   bson_template_destroy (tmpl);
+}
+
+
+static void
+test_bson_template_invalid (void)
+{
+   bson_template_t *tmpl;
+   bson_value_t values[2];
+   bson_t b = BSON_INITIALIZER;
+   uint8_t short_doc[4] = {4, 0, 0, 0};
+
+   tmpl = bson_template_new ();
+
+   /* unsupported types and keys with embedded NULs */
+   BSON_ASSERT (!bson_template_add (tmpl, "a", -1, BSON_TYPE_BINARY));
+   BSON_ASSERT (!bson_template_add (tmpl, "a", -1, BSON_TYPE_EOD));
+   BSON_ASSERT (!bson_template_add (tmpl, "a\0b", 3, BSON_TYPE_INT32));
+
+   BSON_ASSERT (bson_template_add (tmpl, "a", -1, BSON_TYPE_INT32));
+   BSON_ASSERT (bson_template_add (tmpl, "b", -1, BSON_TYPE_DOCUMENT));
+
+   values[0].value_type = BSON_TYPE_INT32;
+   values[0].value.v_int32 = 1;
+   values[1].value_type = BSON_TYPE_DOCUMENT;
+   values[1].value.v_doc.data = short_doc;
+   values[1].value.v_doc.data_len = sizeof short_doc;
+
+   /* the wrong number of values */
+   BSON_ASSERT (!bson_template_append (tmpl, &b, values, 1u));
+
+   /* a document shorter than an empty document */
+   BSON_ASSERT (!bson_template_append (tmpl, &b, values, 2u));
+
+   /* a value of the wrong type */
+   values[1].value_type = BSON_TYPE_ARRAY;
+   BSON_ASSERT (!bson_template_append (tmpl, &b, values, 2u));
+
+   /* the document is unmodified on failure */
+   BSON_ASSERT (bson_empty (&b));
+
+   bson_destroy (&b);
+   bson_template_destroy (tmpl);
+}
+
+
+void
+test_template_install (TestSuite *suite)
+{
+   TestSuite_Add (suite, "/bson/template/append", test_bson_template_append);
+   TestSuite_Add (suite, "/bson/template/fixed", test_bson_template_fixed);
+   TestSuite_Add (suite, "/bson/template/invalid", test_bson_template_invalid);
+}
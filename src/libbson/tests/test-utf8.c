@@ -304,6 +304,130 @@ test_bson_utf8_non_shortest (void)
 }
 
 
+/* Validates @len bytes by decoding code points, independently of how
+ * bson_utf8_validate checks byte ranges. */
+static bool
+_reference_utf8_validate (const uint8_t *bytes, size_t len, bool allow_null)
+{
+   static const bson_unichar_t min_code_point[] = {0, 0, 0x80, 0x800, 0x10000};
+   size_t i = 0;
+
+   while (i < len) {
+      size_t n;
+      bson_unichar_t c;
+
+      if (bytes[i] < 0x80) {
+         n = 1;
+         c = bytes[i];
+      } else if ((bytes[i] & 0xE0) == 0xC0) {
+         n = 2;
+         c = bytes[i] & 0x1F;
+      } else if ((bytes[i] & 0xF0) == 0xE0) {
+         n = 3;
+         c = bytes[i] & 0x0F;
+      } else if ((bytes[i] & 0xF8) == 0xF0) {
+         n = 4;
+         c = bytes[i] & 0x07;
+      } else {
+         return false;
+      }
+
+      if (len - i < n) {
+         return false;
+      }
+
+      for (size_t j = 1; j < n; j++) {
+         if ((bytes[i + j] & 0xC0) != 0x80) {
+            return false;
+         }
+         c = (c << 6) | (bytes[i + j] & 0x3F);
+      }
+
+      if (c == 0 && n <= 2) {
+         if (!allow_null) {
+            return false;
+         }
+      } else if (c < min_code_point[n] || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+         return false;
+      }
+
+      i += n;
+   }
+
+   return true;
+}
+
+
+/* Every sequence of up to three bytes validates as the reference does. */
+static void
+test_bson_utf8_validate_exhaustive (void)
+{
+   uint8_t bytes[3];
+
+   for (uint32_t v = 0; v < (1u << 24); v++) {
+      bytes[0] = (uint8_t) (v >> 16);
+      bytes[1] = (uint8_t) (v >> 8);
+      bytes[2] = (uint8_t) v;
+
+      for (size_t len = (v < (1u << 16)) ? 1u : 3u; len <= 3u; len++) {
+         const uint8_t *const start = bytes + 3u - len;
+
+         for (int allow_null = 0; allow_null <= 1; allow_null++) {
+            if (bson_utf8_validate ((const char *) start, len, allow_null) !=
+                _reference_utf8_validate (start, len, allow_null)) {
+               test_error ("mismatch validating %02x %02x %02x (length %zu, allow_null %d)",
+                           bytes[0],
+                           bytes[1],
+                           bytes[2],
+                           len,
+                           allow_null);
+            }
+         }
+      }
+   }
+}
+
+
+/* A character anywhere in a run of ASCII is found, whichever vector or word
+ * boundary it lands on. */
+static void
+test_bson_utf8_validate_boundaries (void)
+{
+   static const struct {
+      const char *bytes;
+      size_t len;
+      bool valid;
+      bool valid_with_null;
+   } cases[] = {
+      {"\x00", 1, false, true},
+      {"\xC3\xA9", 2, true, true},
+      {"\xE2\x82\xAC", 3, true, true},
+      {"\xF0\x9F\x98\x80", 4, true, true},
+      {"\xC0\x80", 2, false, true},
+      {"\xFF", 1, false, false},
+      {"\x80", 1, false, false},
+      {"\xED\xA0\x80", 3, false, false},
+      {"\xE2\x82", 2, false, false},
+   };
+   char buf[80];
+
+   for (size_t c = 0; c < sizeof cases / sizeof cases[0]; c++) {
+      for (size_t len = 0; len + cases[c].len <= sizeof buf; len++) {
+         for (size_t at = 0; at <= len; at++) {
+            const size_t total = len + cases[c].len;
+
+            memset (buf, 'a', sizeof buf);
+            memcpy (buf + at, cases[c].bytes, cases[c].len);
+
+            ASSERT_CMPINT ((int) bson_utf8_validate (buf + at, cases[c].len, false), ==, (int) cases[c].valid);
+            ASSERT_CMPINT ((int) bson_utf8_validate (buf, total, false), ==, (int) cases[c].valid);
+            ASSERT_CMPINT ((int) bson_utf8_validate (buf, total, true), ==, (int) cases[c].valid_with_null);
+         }
+      }
+   }
+}
+
+
 void
 test_utf8_install (TestSuite *suite)
 {
@@ -314,4 +438,6 @@ test_utf8_install (TestSuite *suite)
    TestSuite_Add (suite, "/bson/utf8/get_char_next_char", test_bson_utf8_get_char);
    TestSuite_Add (suite, "/bson/utf8/from_unichar", test_bson_utf8_from_unichar);
    TestSuite_Add (suite, "/bson/utf8/non_shortest", test_bson_utf8_non_shortest);
+   TestSuite_Add (suite, "/bson/utf8/validate/exhaustive", test_bson_utf8_validate_exhaustive);
+   TestSuite_Add (suite, "/bson/utf8/validate/boundaries", test_bson_utf8_validate_boundaries);
 }
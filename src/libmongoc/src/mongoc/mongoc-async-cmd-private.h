@@ -69,6 +69,17 @@ typedef struct _mongoc_async_cmd {
    char *ns;
    struct addrinfo *dns_result;
 
+   /* When the command is due to be initiated, or times out, in microseconds.
+    * See mongoc_async_cmd_reschedule. */
+   int64_t deadline;
+   /* The command's position in async->timers. */
+   size_t timer_index;
+   /* Whether the command's socket is registered with async->epoll_fd, and with
+    * which descriptor and events. */
+   bool watched;
+   int watched_fd;
+   int watched_events;
+
    struct _mongoc_async_cmd *next;
    struct _mongoc_async_cmd *prev;
 } mongoc_async_cmd_t;
@@ -222,8 +222,7 @@ mongoc_async_cmd_new (mongoc_async_t *async,
 
    _mongoc_async_cmd_state_start (acmd, is_setup_done);
 
-   async->ncmds++;
-   DL_APPEND (async->cmds, acmd);
+   mongoc_async_add_cmd (async, acmd);
 
    return acmd;
 }
@@ -234,8 +233,7 @@ mongoc_async_cmd_destroy (mongoc_async_cmd_t *acmd)
 {
    BSON_ASSERT (acmd);
 
-   DL_DELETE (acmd->async->cmds, acmd);
-   acmd->async->ncmds--;
+   mongoc_async_remove_cmd (acmd->async, acmd);
 
    bson_destroy (&acmd->cmd);
 
@@ -440,7 +438,7 @@ _mongoc_async_cmd_phase_recv_rpc (mongoc_async_cmd_t *acmd)
       void *decompressed_data;
       size_t decompressed_data_len;
 
-      if (!mcd_rpc_message_decompress_if_necessary (acmd->rpc, &decompressed_data, &decompressed_data_len)) {
+      if (!mcd_rpc_message_decompress_if_necessary (acmd->rpc, NULL, &decompressed_data, &decompressed_data_len)) {
          _mongoc_set_error (&acmd->error,
                             MONGOC_ERROR_PROTOCOL,
                             MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
@@ -20,6 +20,7 @@
 #define MONGOC_ASYNC_PRIVATE_H
 
 #include <bson/bson.h>
+#include <mongoc/mongoc-array-private.h>
 #include <mongoc/mongoc-stream.h>
 
 BSON_BEGIN_DECLS
@@ -30,6 +31,16 @@ typedef struct _mongoc_async {
    struct _mongoc_async_cmd *cmds;
    size_t ncmds;
    uint32_t request_id;
+   /* A binary min-heap of the commands by deadline: when each is due to be
+    * initiated, or times out. */
+   mongoc_array_t timers;
+   /* The epoll instance watching the commands' sockets while mongoc_async_run
+    * runs, or -1. */
+   int epoll_fd;
+   /* Set if a stream cannot be watched with epoll. */
+   bool epoll_failed;
+   /* for tests and benchmarks: always wait with mongoc_stream_poll. */
+   bool force_poll;
 } mongoc_async_t;
 
 typedef enum {
@@ -60,6 +71,18 @@ mongoc_async_destroy (mongoc_async_t *async);
 void
 mongoc_async_run (mongoc_async_t *async);
 
+/* Called by mongoc_async_cmd_new and mongoc_async_cmd_destroy. */
+void
+mongoc_async_add_cmd (mongoc_async_t *async, struct _mongoc_async_cmd *acmd);
+
+void
+mongoc_async_remove_cmd (mongoc_async_t *async, struct _mongoc_async_cmd *acmd);
+
+/* Recomputes the deadline of @acmd. Call after changing its state or its
+ * initiate_delay_ms outside of mongoc_async_run. */
+void
+mongoc_async_cmd_reschedule (struct _mongoc_async_cmd *acmd);
+
 BSON_END_DECLS
 
 #endif /* MONGOC_ASYNC_PRIVATE_H */
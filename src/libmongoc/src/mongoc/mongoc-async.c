@@ -23,17 +23,31 @@
 #include <mongoc/mongoc.h>
 #include <mongoc/mongoc-error-private.h>
 #include <mongoc/mongoc-socket-private.h>
+#include <mongoc/mongoc-stream-private.h>
 #include <mongoc/mongoc-util-private.h>
 
+#ifdef MONGOC_HAVE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
+
 #undef MONGOC_LOG_DOMAIN
 #define MONGOC_LOG_DOMAIN "async"
 
+/* The most events returned by one epoll_wait. */
+#define MONGOC_ASYNC_EPOLL_MAX_EVENTS 64
+
+#define TIMER(async, i) (_mongoc_array_index (&(async)->timers, mongoc_async_cmd_t *, (i)))
+
 
 mongoc_async_t *
 mongoc_async_new (void)
 {
    mongoc_async_t *async = (mongoc_async_t *) bson_malloc0 (sizeof (*async));
 
+   _mongoc_array_init (&async->timers, sizeof (mongoc_async_cmd_t *));
+   async->epoll_fd = -1;
+
    return async;
 }
 
@@ -47,11 +61,323 @@ mongoc_async_destroy (mongoc_async_t *async)
       mongoc_async_cmd_destroy (acmd);
    }
 
+   _mongoc_array_destroy (&async->timers);
    bson_free (async);
 }
 
+static void
+_timer_swap (mongoc_async_t *async, size_t a, size_t b)
+{
+   mongoc_async_cmd_t *const tmp = TIMER (async, a);
+
+   TIMER (async, a) = TIMER (async, b);
+   TIMER (async, b) = tmp;
+   TIMER (async, a)->timer_index = a;
+   TIMER (async, b)->timer_index = b;
+}
+
+/* Restores the heap order after the deadline of the command at @i changed. */
+static void
+_timer_fix (mongoc_async_t *async, size_t i)
+{
+   while (i > 0u && TIMER (async, (i - 1u) / 2u)->deadline > TIMER (async, i)->deadline) {
+      _timer_swap (async, i, (i - 1u) / 2u);
+      i = (i - 1u) / 2u;
+   }
+
+   for (;;) {
+      const size_t left = 2u * i + 1u;
+      const size_t right = left + 1u;
+      size_t smallest = i;
+
+      if (left < async->timers.len && TIMER (async, left)->deadline < TIMER (async, smallest)->deadline) {
+         smallest = left;
+      }
+
+      if (right < async->timers.len && TIMER (async, right)->deadline < TIMER (async, smallest)->deadline) {
+         smallest = right;
+      }
+
+      if (smallest == i) {
+         break;
+      }
+
+      _timer_swap (async, i, smallest);
+      i = smallest;
+   }
+}
+
 void
-mongoc_async_run (mongoc_async_t *async)
+mongoc_async_cmd_reschedule (mongoc_async_cmd_t *acmd)
+{
+   BSON_ASSERT_PARAM (acmd);
+
+   switch (acmd->state) {
+   case MONGOC_ASYNC_CMD_INITIATE:
+      acmd->deadline = acmd->connect_started + acmd->initiate_delay_ms * 1000;
+      break;
+   case MONGOC_ASYNC_CMD_CANCELED_STATE:
+      /* due now. */
+      acmd->deadline = INT64_MIN;
+      break;
+   case MONGOC_ASYNC_CMD_SETUP:
+   case MONGOC_ASYNC_CMD_SEND:
+   case MONGOC_ASYNC_CMD_RECV_LEN:
+   case MONGOC_ASYNC_CMD_RECV_RPC:
+   case MONGOC_ASYNC_CMD_ERROR_STATE:
+   default:
+      acmd->deadline = acmd->connect_started + acmd->timeout_msec * 1000;
+      break;
+   }
+
+   _timer_fix (acmd->async, acmd->timer_index);
+}
+
+#ifdef MONGOC_HAVE_EPOLL
+static uint32_t
+_epoll_events (int poll_events)
+{
+   return ((poll_events & POLLIN) ? (uint32_t) EPOLLIN : 0u) | ((poll_events & POLLOUT) ? (uint32_t) EPOLLOUT : 0u);
+}
+#endif
+
+/* Registers the socket of @acmd with the epoll instance, or updates the events
+ * it is watched for. Sets epoll_failed if the stream is not a socket. */
+static void
+_mongoc_async_watch (mongoc_async_t *async, mongoc_async_cmd_t *acmd)
+{
+#ifdef MONGOC_HAVE_EPOLL
+   struct epoll_event event = {0};
+   mongoc_stream_t *root;
+   mongoc_socket_t *sock;
+
+   if (async->epoll_fd < 0 || async->epoll_failed || !acmd->stream ||
+       (acmd->watched && acmd->watched_events == acmd->events)) {
+      return;
+   }
+
+   event.events = _epoll_events (acmd->events);
+   event.data.ptr = acmd;
+
+   if (acmd->watched) {
+      if (epoll_ctl (async->epoll_fd, EPOLL_CTL_MOD, acmd->watched_fd, &event) != 0) {
+         async->epoll_failed = true;
+         return;
+      }
+
+      acmd->watched_events = acmd->events;
+      return;
+   }
+
+   /* like mongoc_stream_poll, wait on the underlying socket. */
+   root = mongoc_stream_get_root_stream (acmd->stream);
+   sock = root->type == MONGOC_STREAM_SOCKET ? mongoc_stream_socket_get_socket ((mongoc_stream_socket_t *) root) : NULL;
+   if (!sock || epoll_ctl (async->epoll_fd, EPOLL_CTL_ADD, sock->sd, &event) != 0) {
+      async->epoll_failed = true;
+      return;
+   }
+
+   acmd->watched = true;
+   acmd->watched_fd = sock->sd;
+   acmd->watched_events = acmd->events;
+#else
+   BSON_UNUSED (async);
+   BSON_UNUSED (acmd);
+#endif
+}
+
+static void
+_mongoc_async_unwatch (mongoc_async_t *async, mongoc_async_cmd_t *acmd)
+{
+#ifdef MONGOC_HAVE_EPOLL
+   if (!acmd->watched) {
+      return;
+   }
+
+   /* the callback may already have closed the socket, which unregisters it. */
+   if (async->epoll_fd >= 0) {
+      (void) epoll_ctl (async->epoll_fd, EPOLL_CTL_DEL, acmd->watched_fd, NULL);
+   }
+
+   acmd->watched = false;
+#else
+   BSON_UNUSED (async);
+   BSON_UNUSED (acmd);
+#endif
+}
+
+void
+mongoc_async_add_cmd (mongoc_async_t *async, mongoc_async_cmd_t *acmd)
+{
+   BSON_ASSERT_PARAM (async);
+   BSON_ASSERT_PARAM (acmd);
+
+   async->ncmds++;
+   DL_APPEND (async->cmds, acmd);
+
+   acmd->timer_index = async->timers.len;
+   _mongoc_array_append_val (&async->timers, acmd);
+   mongoc_async_cmd_reschedule (acmd);
+
+   /* a callback started a new command while mongoc_async_run is running. */
+   _mongoc_async_watch (async, acmd);
+}
+
+void
+mongoc_async_remove_cmd (mongoc_async_t *async, mongoc_async_cmd_t *acmd)
+{
+   BSON_ASSERT_PARAM (async);
+   BSON_ASSERT_PARAM (acmd);
+
+   const size_t last = async->timers.len - 1u;
+
+   _mongoc_async_unwatch (async, acmd);
+
+   if (acmd->timer_index != last) {
+      const size_t i = acmd->timer_index;
+
+      _timer_swap (async, i, last);
+      async->timers.len--;
+      _timer_fix (async, i);
+   } else {
+      async->timers.len--;
+   }
+
+   DL_DELETE (async->cmds, acmd);
+   async->ncmds--;
+}
+
+static void
+_mongoc_async_cmd_set_poll_error (mongoc_async_cmd_t *acmd, bool hup)
+{
+   if (acmd->state == MONGOC_ASYNC_CMD_SEND) {
+      _mongoc_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_CONNECT,
+                         hup ? "connection refused" : "unknown connection error");
+   } else {
+      _mongoc_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_SOCKET,
+                         hup ? "connection closed" : "unknown socket error");
+   }
+
+   acmd->state = MONGOC_ASYNC_CMD_ERROR_STATE;
+}
+
+/* Reports a command that timed out or was canceled to its callback, and
+ * destroys it. */
+static void
+_mongoc_async_cmd_expire (mongoc_async_cmd_t *acmd, int64_t now)
+{
+   if (acmd->state == MONGOC_ASYNC_CMD_CANCELED_STATE && now <= acmd->connect_started + acmd->timeout_msec * 1000) {
+      acmd->cb (acmd, MONGOC_ASYNC_CMD_ERROR, NULL, (now - acmd->connect_started) / 1000);
+   } else {
+      _mongoc_set_error (&acmd->error,
+                         MONGOC_ERROR_STREAM,
+                         MONGOC_ERROR_STREAM_CONNECT,
+                         acmd->state == MONGOC_ASYNC_CMD_SEND ? "connection timeout" : "socket timeout");
+
+      acmd->cb (acmd, MONGOC_ASYNC_CMD_TIMEOUT, NULL, (now - acmd->connect_started) / 1000);
+   }
+
+   /* Remove acmd from the async->cmds doubly-linked list */
+   mongoc_async_cmd_destroy (acmd);
+}
+
+#ifdef MONGOC_HAVE_EPOLL
+/* Runs the commands with an epoll instance watching their sockets, taking
+ * the next deadline from the timer heap. A wakeup costs time in the number of
+ * ready and due commands, not the number of commands. Returns false, leaving
+ * the remaining commands to _mongoc_async_run_poll, if a stream cannot be
+ * watched. */
+static bool
+_mongoc_async_run_epoll (mongoc_async_t *async)
+{
+   struct epoll_event events[MONGOC_ASYNC_EPOLL_MAX_EVENTS];
+   mongoc_async_cmd_t *acmd;
+   bool done = false;
+
+   async->epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+   if (async->epoll_fd < 0) {
+      return false;
+   }
+
+   async->epoll_failed = false;
+
+   DL_FOREACH (async->cmds, acmd)
+   {
+      _mongoc_async_watch (async, acmd);
+   }
+
+   while (!async->epoll_failed) {
+      const int64_t now = bson_get_monotonic_time ();
+
+      /* initiate the cmds whose delay has passed, and expire the cmds that
+       * timed out or were canceled. */
+      while (async->timers.len > 0u && TIMER (async, 0u)->deadline <= now && !async->epoll_failed) {
+         acmd = TIMER (async, 0u);
+
+         if (acmd->state != MONGOC_ASYNC_CMD_INITIATE) {
+            _mongoc_async_cmd_expire (acmd, now);
+         } else if (mongoc_async_cmd_run (acmd)) {
+            BSON_ASSERT (acmd->stream);
+            mongoc_async_cmd_reschedule (acmd);
+            _mongoc_async_watch (async, acmd);
+         }
+      }
+
+      if (async->ncmds == 0) {
+         done = true;
+         break;
+      }
+
+      if (async->epoll_failed) {
+         break;
+      }
+
+      /* round up, so the earliest deadline has passed once we wake. */
+      const int64_t timeout_msec = BSON_MIN (BSON_MAX (0, (TIMER (async, 0u)->deadline - now + 999) / 1000), INT32_MAX);
+      const int nready = epoll_wait (async->epoll_fd, events, MONGOC_ASYNC_EPOLL_MAX_EVENTS, (int) timeout_msec);
+
+      if (nready < 0) {
+         if (errno == EINTR) {
+            continue;
+         }
+
+         break;
+      }
+
+      for (int i = 0; i < nready; i++) {
+         acmd = (mongoc_async_cmd_t *) events[i].data.ptr;
+
+         if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+            _mongoc_async_cmd_set_poll_error (acmd, events[i].events & EPOLLHUP);
+         }
+
+         if ((events[i].events & _epoll_events (acmd->events)) || acmd->state == MONGOC_ASYNC_CMD_ERROR_STATE) {
+            if (mongoc_async_cmd_run (acmd)) {
+               _mongoc_async_watch (async, acmd);
+            }
+         }
+      }
+   }
+
+   /* closing the instance unregisters every socket. */
+   close (async->epoll_fd);
+   async->epoll_fd = -1;
+
+   DL_FOREACH (async->cmds, acmd)
+   {
+      acmd->watched = false;
+   }
+
+   return done;
+}
+#endif
+
+static void
+_mongoc_async_run_poll (mongoc_async_t *async)
 {
    mongoc_async_cmd_t *acmd, *tmp;
    mongoc_async_cmd_t **acmds_polled = NULL;
@@ -66,12 +392,6 @@ mongoc_async_run (mongoc_async_t *async)
    now = bson_get_monotonic_time ();
    poll_size = 0;
 
-   /* CDRIVER-1571 reset start times in case a stream initiator was slow */
-   DL_FOREACH (async->cmds, acmd)
-   {
-      acmd->connect_started = now;
-   }
-
    while (async->ncmds) {
       /* ncmds grows if we discover a replica & start calling hello on it */
       if (poll_size < async->ncmds) {
@@ -98,7 +418,7 @@ mongoc_async_run (mongoc_async_t *async)
                }
             } else {
                /* don't poll longer than the earliest cmd ready to init. */
-               expire_at = BSON_MIN (expire_at, acmd->connect_started + acmd->initiate_delay_ms);
+               expire_at = BSON_MIN (expire_at, acmd->connect_started + acmd->initiate_delay_ms * 1000);
             }
          }
 
@@ -133,20 +453,7 @@ mongoc_async_run (mongoc_async_t *async)
          for (i = 0; i < nstreams; i++) {
             mongoc_async_cmd_t *iter = acmds_polled[i];
             if (poller[i].revents & (POLLERR | POLLHUP)) {
-               int hup = poller[i].revents & POLLHUP;
-               if (iter->state == MONGOC_ASYNC_CMD_SEND) {
-                  _mongoc_set_error (&iter->error,
-                                     MONGOC_ERROR_STREAM,
-                                     MONGOC_ERROR_STREAM_CONNECT,
-                                     hup ? "connection refused" : "unknown connection error");
-               } else {
-                  _mongoc_set_error (&iter->error,
-                                     MONGOC_ERROR_STREAM,
-                                     MONGOC_ERROR_STREAM_SOCKET,
-                                     hup ? "connection closed" : "unknown socket error");
-               }
-
-               iter->state = MONGOC_ASYNC_CMD_ERROR_STATE;
+               _mongoc_async_cmd_set_poll_error (iter, poller[i].revents & POLLHUP);
             }
 
             if ((poller[i].revents & poller[i].events) || iter->state == MONGOC_ASYNC_CMD_ERROR_STATE) {
@@ -163,21 +470,9 @@ mongoc_async_run (mongoc_async_t *async)
       DL_FOREACH_SAFE (async->cmds, acmd, tmp)
       {
          /* check if an initiated cmd has passed the connection timeout.  */
-         if (acmd->state != MONGOC_ASYNC_CMD_INITIATE && now > acmd->connect_started + acmd->timeout_msec * 1000) {
-            _mongoc_set_error (&acmd->error,
-                               MONGOC_ERROR_STREAM,
-                               MONGOC_ERROR_STREAM_CONNECT,
-                               acmd->state == MONGOC_ASYNC_CMD_SEND ? "connection timeout" : "socket timeout");
-
-            acmd->cb (acmd, MONGOC_ASYNC_CMD_TIMEOUT, NULL, (now - acmd->connect_started) / 1000);
-
-            /* Remove acmd from the async->cmds doubly-linked list */
-            mongoc_async_cmd_destroy (acmd);
-         } else if (acmd->state == MONGOC_ASYNC_CMD_CANCELED_STATE) {
-            acmd->cb (acmd, MONGOC_ASYNC_CMD_ERROR, NULL, (now - acmd->connect_started) / 1000);
-
-            /* Remove acmd from the async->cmds doubly-linked list */
-            mongoc_async_cmd_destroy (acmd);
+         if ((acmd->state != MONGOC_ASYNC_CMD_INITIATE && now > acmd->connect_started + acmd->timeout_msec * 1000) ||
+             acmd->state == MONGOC_ASYNC_CMD_CANCELED_STATE) {
+            _mongoc_async_cmd_expire (acmd, now);
          }
       }
 
@@ -187,3 +482,25 @@ mongoc_async_run (mongoc_async_t *async)
    bson_free (poller);
    bson_free (acmds_polled);
 }
+
+void
+mongoc_async_run (mongoc_async_t *async)
+{
+   mongoc_async_cmd_t *acmd;
+   const int64_t now = bson_get_monotonic_time ();
+
+   /* CDRIVER-1571 reset start times in case a stream initiator was slow */
+   DL_FOREACH (async->cmds, acmd)
+   {
+      acmd->connect_started = now;
+      mongoc_async_cmd_reschedule (acmd);
+   }
+
+#ifdef MONGOC_HAVE_EPOLL
+   if (!async->force_poll && _mongoc_async_run_epoll (async)) {
+      return;
+   }
+#endif
+
+   _mongoc_async_run_poll (async);
+}
@@ -43,6 +43,9 @@ void
 _mongoc_buffer_init (
    mongoc_buffer_t *buffer, uint8_t *buf, size_t buflen, bson_realloc_func realloc_func, void *realloc_data);
 
+uint8_t *
+_mongoc_buffer_reserve (mongoc_buffer_t *buffer, size_t size);
+
 bool
 _mongoc_buffer_append (mongoc_buffer_t *buffer, const uint8_t *data, size_t data_size);
 
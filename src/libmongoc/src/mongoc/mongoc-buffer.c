@@ -126,6 +126,27 @@ _mongoc_buffer_clear (mongoc_buffer_t *buffer, bool zero)
 }
 
 
+/**
+ * _mongoc_buffer_reserve:
+ * @buffer: A mongoc_buffer_t.
+ * @size: The number of bytes to make available.
+ *
+ * Ensures at least @size bytes are available past the current length of
+ * @buffer without further reallocation and returns a pointer to them. The
+ * caller is responsible for advancing @buffer->len past any bytes written.
+ */
+uint8_t *
+_mongoc_buffer_reserve (mongoc_buffer_t *buffer, size_t size)
+{
+   BSON_ASSERT_PARAM (buffer);
+   BSON_ASSERT (buffer->datalen);
+
+   make_space_for (buffer, size);
+
+   return &buffer->data[buffer->len];
+}
+
+
 bool
 _mongoc_buffer_append (mongoc_buffer_t *buffer, const uint8_t *data, size_t data_size)
 {
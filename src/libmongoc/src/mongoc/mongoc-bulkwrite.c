@@ -1181,20 +1181,24 @@ lookup_int32 (const bson_t *bson, const char *key, int32_t *out, const char *sou
    return false;
 }
 
-// `lookup_as_int64` looks for `key` as a BSON int32, int64, or double and returns as an int64_t. Doubles are truncated.
-static int64_t
-lookup_as_int64 (
-   const bson_t *bson, const char *key, int64_t *out, const char *source, mongoc_bulkwriteexception_t *exc)
-{
-   BSON_ASSERT_PARAM (bson);
+// `lookup_as_int64_found` returns the number found in `iter` as an int64_t, or sets an error naming `key` if the field
+// was not found or is not a number. Doubles are truncated.
+static bool
+lookup_as_int64_found (bool found,
+                       const bson_iter_t *iter,
+                       const char *key,
+                       int64_t *out,
+                       const char *source,
+                       mongoc_bulkwriteexception_t *exc)
+{
+   BSON_ASSERT_PARAM (iter);
    BSON_ASSERT_PARAM (key);
    BSON_ASSERT_PARAM (out);
    BSON_OPTIONAL_PARAM (source);
    BSON_ASSERT_PARAM (exc);
 
-   bson_iter_t iter;
-   if (bson_iter_init_find (&iter, bson, key) && BSON_ITER_HOLDS_NUMBER (&iter)) {
-      *out = bson_iter_as_int64 (&iter);
+   if (found && BSON_ITER_HOLDS_NUMBER (iter)) {
+      *out = bson_iter_as_int64 (iter);
       return true;
    }
    bson_error_t error;
@@ -1216,6 +1220,32 @@ lookup_as_int64 (
    return false;
 }
 
+// `lookup_as_int64` looks for `key` as a BSON int32, int64, or double and returns as an int64_t. Doubles are truncated.
+static bool
+lookup_as_int64 (
+   const bson_t *bson, const char *key, int64_t *out, const char *source, mongoc_bulkwriteexception_t *exc)
+{
+   BSON_ASSERT_PARAM (bson);
+   BSON_ASSERT_PARAM (key);
+
+   bson_iter_t iter;
+   const bool found = bson_iter_init_find (&iter, bson, key);
+   return lookup_as_int64_found (found, &iter, key, out, source, exc);
+}
+
+// `lookup_as_int64_indexed` is `lookup_as_int64` for a document indexed with `bson_index_new`.
+static bool
+lookup_as_int64_indexed (
+   const bson_index_t *index, const char *key, int64_t *out, const char *source, mongoc_bulkwriteexception_t *exc)
+{
+   BSON_ASSERT_PARAM (index);
+   BSON_ASSERT_PARAM (key);
+
+   bson_iter_t iter;
+   const bool found = bson_index_find (index, key, &iter);
+   return lookup_as_int64_found (found, &iter, key, out, source, exc);
+}
+
 static bool
 lookup_string (
    const bson_t *bson, const char *key, const char **out, const char *source, mongoc_bulkwriteexception_t *exc)
@@ -1260,64 +1290,51 @@ _bulkwritereturn_apply_reply (mongoc_bulkwritereturn_t *self, const bson_t *cmd_
    // Parse top-level fields.
    // These fields are expected to be int32 as of server 8.0. However, drivers return the values as int64.
    // Use `lookup_as_int64` to support other numeric types to future-proof.
-   int64_t nInserted;
-   if (!lookup_as_int64 (cmd_reply, "nInserted", &nInserted, NULL, self->exc)) {
-      return false;
-   }
-   self->res->insertedcount += nInserted;
-
-   int64_t nMatched;
-   if (!lookup_as_int64 (cmd_reply, "nMatched", &nMatched, NULL, self->exc)) {
-      return false;
-   }
-   self->res->matchedcount += nMatched;
-
-   int64_t nModified;
-   if (!lookup_as_int64 (cmd_reply, "nModified", &nModified, NULL, self->exc)) {
-      return false;
-   }
-   self->res->modifiedcount += nModified;
-
-   int64_t nDeleted;
-   if (!lookup_as_int64 (cmd_reply, "nDeleted", &nDeleted, NULL, self->exc)) {
-      return false;
-   }
-   self->res->deletedcount += nDeleted;
-
-   int64_t nUpserted;
-   if (!lookup_as_int64 (cmd_reply, "nUpserted", &nUpserted, NULL, self->exc)) {
-      return false;
-   }
-   self->res->upsertedcount += nUpserted;
-
-   int64_t nErrors;
-   if (!lookup_as_int64 (cmd_reply, "nErrors", &nErrors, NULL, self->exc)) {
-      return false;
+   // The reply has many top-level fields, so index it once instead of scanning it for each field.
+   const struct {
+      const char *key;
+      int64_t *count;
+   } counts[] = {
+      {"nInserted", &self->res->insertedcount},
+      {"nMatched", &self->res->matchedcount},
+      {"nModified", &self->res->modifiedcount},
+      {"nDeleted", &self->res->deletedcount},
+      {"nUpserted", &self->res->upsertedcount},
+      {"nErrors", &self->res->errorscount},
+   };
+   bson_index_t *const reply_index = bson_index_new (cmd_reply);
+   bool ok = false;
+
+   for (size_t i = 0; i < sizeof counts / sizeof counts[0]; i++) {
+      int64_t count;
+      if (!lookup_as_int64_indexed (reply_index, counts[i].key, &count, NULL, self->exc)) {
+         goto fail;
+      }
+      *counts[i].count += count;
    }
-   self->res->errorscount += nErrors;
 
    bson_error_t error;
    bson_iter_t iter;
-   if (bson_iter_init_find (&iter, cmd_reply, "writeConcernError")) {
+   if (bson_index_find (reply_index, "writeConcernError", &iter)) {
       bson_iter_t wce_iter;
       bson_t wce_bson;
 
       if (!_mongoc_iter_document_as_bson (&iter, &wce_bson, &error)) {
          _bulkwriteexception_set_error (self->exc, &error);
          _bulkwriteexception_set_error_reply (self->exc, cmd_reply);
-         return false;
+         goto fail;
       }
 
       // Parse `code`.
       int32_t code;
       if (!lookup_int32 (&wce_bson, "code", &code, "writeConcernError", self->exc)) {
-         return false;
+         goto fail;
       }
 
       // Parse `errmsg`.
       const char *errmsg;
       if (!lookup_string (&wce_bson, "errmsg", &errmsg, "writeConcernError", self->exc)) {
-         return false;
+         goto fail;
       }
 
       // Parse optional `errInfo`.
@@ -1326,14 +1343,18 @@ _bulkwritereturn_apply_reply (mongoc_bulkwritereturn_t *self, const bson_t *cmd_
          if (!_mongoc_iter_document_as_bson (&wce_iter, &errInfo, &error)) {
             _bulkwriteexception_set_error (self->exc, &error);
             _bulkwriteexception_set_error_reply (self->exc, cmd_reply);
-            return false;
+            goto fail;
          }
       }
 
       _bulkwriteexception_append_writeconcernerror (self->exc, code, errmsg, &errInfo);
    }
 
-   return true;
+   ok = true;
+
+fail:
+   bson_index_destroy (reply_index);
+   return ok;
 }
 
 // `_bulkwritereturn_apply_result` applies an individual cursor result to the returned results.
@@ -23,14 +23,17 @@
 #include <mongoc/mongoc-client-pool.h>
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-client-side-encryption-private.h>
+#include <mongoc/mongoc-cluster-private.h>
+#include <mongoc/mongoc-connection-pool-private.h>
 #include <mongoc/mongoc-error-private.h>
 #include <mongoc/mongoc-log-and-monitor-private.h>
-#include <mongoc/mongoc-queue-private.h>
 #include <mongoc/mongoc-thread-private.h>
 #include <mongoc/mongoc-topology-private.h>
 #include <mongoc/mongoc-topology-background-monitoring-private.h>
 #include <mongoc/mongoc-trace-private.h>
 
+#include <common-atomic-private.h>
+
 #ifdef MONGOC_ENABLE_SSL
 #include <mongoc/mongoc-ssl-private.h>
 #endif
@@ -39,10 +42,30 @@
 #include <mongoc/mongoc-openssl-private.h>
 #endif
 
+// Number of independently locked free lists idle clients are spread across.
+#define MONGOC_CLIENT_POOL_SHARDS 8u
+
+// How often the prewarm thread tops up the idle connections of each server.
+#define MONGOC_CLIENT_POOL_PREWARM_INTERVAL_MS 500
+
+/* A free list of idle clients. Checkouts and checkins take only the lock of
+ * the shard they land on, so threads hashed to different shards do not
+ * contend. */
+typedef struct {
+   bson_mutex_t mutex;
+   // A stack of mongoc_client_t *: the most recently pushed client is last.
+   mongoc_array_t clients;
+} mongoc_client_pool_shard_t;
+
 struct _mongoc_client_pool_t {
+   // Guards creating clients, the pool options, and waiting for a client when the pool is exhausted.
    bson_mutex_t mutex;
    mongoc_cond_t cond;
-   mongoc_queue_t queue;
+   mongoc_client_pool_shard_t shards[MONGOC_CLIENT_POOL_SHARDS];
+   // The number of clients in all shards.
+   int32_t num_pushed;
+   // The number of threads waiting on `cond` for a client.
+   int32_t num_waiters;
    mongoc_topology_t *topology;
    mongoc_uri_t *uri;
    uint32_t min_pool_size;
@@ -58,8 +81,18 @@ struct _mongoc_client_pool_t {
    bool client_initialized;
    int32_t error_api_version;
    mongoc_server_api_t *api;
-   // `last_known_serverids` is a sorted array of uint32_t.
-   mongoc_array_t last_known_serverids;
+   // Identifies the set of servers idle clients were last pruned against. See `_serverids_fingerprint`.
+   int64_t serverids_fingerprint;
+   // MONGOC_URI_MINIDLECONNECTIONS. The prewarm thread keeps this many idle connections to each server in the
+   // topology's connection pool. The fields below are guarded by `mutex`.
+   int32_t min_idle_connections;
+   bool prewarm_started;
+   bool prewarm_shutdown;
+   bson_thread_t prewarm_thread;
+   // Signaled to stop the prewarm thread.
+   mongoc_cond_t prewarm_cond;
+   // Establishes connections on behalf of the prewarm thread. Not counted in `size`.
+   mongoc_client_t *prewarm_client;
 };
 
 
@@ -161,16 +194,20 @@ mongoc_client_pool_new_with_error (const mongoc_uri_t *uri, bson_error_t *error)
    }
 
    pool = (mongoc_client_pool_t *) bson_malloc0 (sizeof *pool);
-   _mongoc_array_init (&pool->last_known_serverids, sizeof (uint32_t));
    bson_mutex_init (&pool->mutex);
    mongoc_cond_init (&pool->cond);
-   _mongoc_queue_init (&pool->queue);
+   mongoc_cond_init (&pool->prewarm_cond);
+   for (size_t i = 0u; i < MONGOC_CLIENT_POOL_SHARDS; i++) {
+      bson_mutex_init (&pool->shards[i].mutex);
+      _mongoc_array_init (&pool->shards[i].clients, sizeof (mongoc_client_t *));
+   }
    pool->uri = mongoc_uri_copy (uri);
    pool->min_pool_size = 0;
    pool->max_pool_size = 100;
    pool->size = 0;
    pool->topology = topology;
    pool->error_api_version = MONGOC_ERROR_API_VERSION_LEGACY;
+   pool->min_idle_connections = mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_MINIDLECONNECTIONS, 0);
 
    b = mongoc_uri_get_options (pool->uri);
 
@@ -223,14 +260,34 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
       EXIT;
    }
 
+   // Stop the prewarm thread before its connections and the topology go away.
+   bson_mutex_lock (&pool->mutex);
+   const bool prewarm_started = pool->prewarm_started;
+   pool->prewarm_shutdown = true;
+   mongoc_cond_signal (&pool->prewarm_cond);
+   bson_mutex_unlock (&pool->mutex);
+
+   if (prewarm_started) {
+      mcommon_thread_join (pool->prewarm_thread);
+   }
+
+   mongoc_client_destroy (pool->prewarm_client);
+
    if (!mongoc_server_session_pool_is_empty (pool->topology->session_pool)) {
       client = mongoc_client_pool_pop (pool);
       _mongoc_client_end_sessions (client);
       mongoc_client_pool_push (pool, client);
    }
 
-   while ((client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
-      mongoc_client_destroy (client);
+   for (size_t i = 0u; i < MONGOC_CLIENT_POOL_SHARDS; i++) {
+      mongoc_client_pool_shard_t *const shard = &pool->shards[i];
+
+      for (size_t j = 0u; j < shard->clients.len; j++) {
+         mongoc_client_destroy (_mongoc_array_index (&shard->clients, mongoc_client_t *, j));
+      }
+
+      _mongoc_array_destroy (&shard->clients);
+      bson_mutex_destroy (&shard->mutex);
    }
 
    mongoc_topology_destroy (pool->topology);
@@ -238,6 +295,7 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
    mongoc_uri_destroy (pool->uri);
    bson_mutex_destroy (&pool->mutex);
    mongoc_cond_destroy (&pool->cond);
+   mongoc_cond_destroy (&pool->prewarm_cond);
 
    mongoc_server_api_destroy (pool->api);
 
@@ -245,8 +303,6 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
    _mongoc_ssl_opts_cleanup (&pool->ssl_opts, true);
 #endif
 
-   _mongoc_array_destroy (&pool->last_known_serverids);
-
    bson_free (pool);
 
    mongoc_counter_client_pools_active_dec ();
@@ -259,7 +315,7 @@ mongoc_client_pool_destroy (mongoc_client_pool_t *pool)
 /*
  * Start the background topology scanner.
  *
- * This function assumes the pool's mutex is locked
+ * This function is safe to call concurrently: only the first call starts it.
  */
 static void
 _start_scanner_if_needed (mongoc_client_pool_t *pool)
@@ -293,6 +349,169 @@ _initialize_new_client (mongoc_client_pool_t *pool, mongoc_client_t *client)
 #endif
 }
 
+/* Tops up the idle connections to each data-bearing server in the topology
+ * to MONGOC_URI_MINIDLECONNECTIONS, after discarding those made stale by a
+ * pool clear. */
+static void
+_prewarm_servers (mongoc_client_pool_t *pool)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   mongoc_connection_pool_t *const connection_pool = pool->topology->connection_pool;
+   mc_shared_tpld td = mc_tpld_take_ref (pool->topology);
+   const mongoc_set_t *const servers = mc_tpld_servers_const (td.ptr);
+
+   mongoc_connection_pool_discard_stale (connection_pool, td.ptr);
+
+   for (size_t i = 0u; i < servers->items_len; i++) {
+      const mongoc_server_description_t *const sd = mongoc_set_get_item_const (servers, i);
+
+      switch (sd->type) {
+      case MONGOC_SERVER_STANDALONE:
+      case MONGOC_SERVER_MONGOS:
+      case MONGOC_SERVER_RS_PRIMARY:
+      case MONGOC_SERVER_RS_SECONDARY:
+      case MONGOC_SERVER_LOAD_BALANCER:
+         break;
+      default:
+         continue;
+      }
+
+      while (mongoc_connection_pool_begin_prewarm (connection_pool, sd->id, pool->min_idle_connections)) {
+         bson_error_t error;
+         mongoc_cluster_node_t *const node =
+            mongoc_cluster_create_node (&pool->prewarm_client->cluster, td.ptr, sd->id, &error);
+
+         if (node) {
+            mongoc_connection_pool_checkin (connection_pool, sd->id, node);
+         }
+
+         mongoc_connection_pool_connect_done (connection_pool, sd->id);
+
+         if (!node) {
+            MONGOC_DEBUG ("failed to prewarm a connection to %s: %s", sd->host.host_and_port, error.message);
+            break;
+         }
+      }
+   }
+
+   mc_tpld_drop_ref (&td);
+}
+
+static BSON_THREAD_FUN (_prewarm_thread, pool_void)
+{
+   mongoc_client_pool_t *const pool = (mongoc_client_pool_t *) pool_void;
+
+   bson_mutex_lock (&pool->mutex);
+   while (!pool->prewarm_shutdown) {
+      bson_mutex_unlock (&pool->mutex);
+      _prewarm_servers (pool);
+      bson_mutex_lock (&pool->mutex);
+
+      if (!pool->prewarm_shutdown) {
+         mongoc_cond_timedwait (&pool->prewarm_cond, &pool->mutex, MONGOC_CLIENT_POOL_PREWARM_INTERVAL_MS);
+      }
+   }
+   bson_mutex_unlock (&pool->mutex);
+
+   BSON_THREAD_RETURN;
+}
+
+/* Start the thread maintaining MONGOC_URI_MINIDLECONNECTIONS, if configured.
+ * This function assumes the pool's mutex is locked. */
+static void
+_start_prewarm_if_needed (mongoc_client_pool_t *pool)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   if (pool->prewarm_started || pool->prewarm_shutdown || pool->min_idle_connections <= 0 ||
+       !pool->topology->connection_pool) {
+      return;
+   }
+
+   if (!pool->prewarm_client) {
+      pool->prewarm_client = _mongoc_client_new_from_topology (pool->topology);
+      BSON_ASSERT (pool->prewarm_client);
+      _initialize_new_client (pool, pool->prewarm_client);
+   }
+
+   const int ret = mcommon_thread_create (&pool->prewarm_thread, _prewarm_thread, pool);
+   if (ret == 0) {
+      pool->prewarm_started = true;
+   } else {
+      char errmsg_buf[BSON_ERROR_BUFFER_SIZE];
+      char *errmsg = bson_strerror_r (ret, errmsg_buf, sizeof errmsg_buf);
+      MONGOC_ERROR ("Failed to start connection prewarm thread. Connections will "
+                    "be established on demand. Error: %s",
+                    errmsg);
+      // Do not retry on every checkout.
+      pool->prewarm_shutdown = true;
+   }
+}
+
+/* Returns the shard the calling thread should use first. Threads run on
+ * distinct stacks, so hashing the address of a local spreads them across the
+ * shards while keeping each thread on the same one. */
+static size_t
+_home_shard (void)
+{
+   const int local = 0;
+   // Ignore the low bits, which vary with the call depth.
+   const uint64_t stack_page = (uint64_t) (uintptr_t) &local >> 16;
+
+   return (size_t) ((stack_page * UINT64_C (0x9E3779B97F4A7C15)) >> 32) % MONGOC_CLIENT_POOL_SHARDS;
+}
+
+/* Pops the most recently pushed idle client, trying the @home shard first.
+ * Returns NULL if there are no idle clients. */
+static mongoc_client_t *
+_pool_take_idle_client (mongoc_client_pool_t *pool, size_t home)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   if (mcommon_atomic_int32_fetch (&pool->num_pushed, mcommon_memory_order_seq_cst) == 0) {
+      return NULL;
+   }
+
+   for (size_t i = 0u; i < MONGOC_CLIENT_POOL_SHARDS; i++) {
+      mongoc_client_pool_shard_t *const shard = &pool->shards[(home + i) % MONGOC_CLIENT_POOL_SHARDS];
+      mongoc_client_t *client = NULL;
+
+      bson_mutex_lock (&shard->mutex);
+      if (shard->clients.len > 0u) {
+         client = _mongoc_array_index (&shard->clients, mongoc_client_t *, shard->clients.len - 1u);
+         shard->clients.len--;
+         mcommon_atomic_int32_fetch_sub (&pool->num_pushed, 1, mcommon_memory_order_seq_cst);
+      }
+      bson_mutex_unlock (&shard->mutex);
+
+      if (client) {
+         return client;
+      }
+   }
+
+   return NULL;
+}
+
+/* Pops an idle client or creates one if the pool is below maxPoolSize.
+ * This function assumes the pool's mutex is locked. */
+static mongoc_client_t *
+_pool_take_or_create_client (mongoc_client_pool_t *pool, size_t home)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   mongoc_client_t *client = _pool_take_idle_client (pool, home);
+
+   if (!client && pool->size < pool->max_pool_size) {
+      client = _mongoc_client_new_from_topology (pool->topology);
+      BSON_ASSERT (client);
+      _initialize_new_client (pool, client);
+      pool->size++;
+   }
+
+   return client;
+}
+
 mongoc_client_t *
 mongoc_client_pool_pop (mongoc_client_pool_t *pool)
 {
@@ -306,39 +525,46 @@ mongoc_client_pool_pop (mongoc_client_pool_t *pool)
 
    BSON_ASSERT_PARAM (pool);
 
+   const size_t home = _home_shard ();
+
+   // Fast path: reuse an idle client without taking the pool's mutex.
+   if ((client = _pool_take_idle_client (pool, home))) {
+      _start_scanner_if_needed (pool);
+      RETURN (client);
+   }
+
    wait_queue_timeout_ms = mongoc_uri_get_option_as_int32 (pool->uri, MONGOC_URI_WAITQUEUETIMEOUTMS, -1);
    if (wait_queue_timeout_ms > 0) {
       expire_at_ms = (bson_get_monotonic_time () / 1000) + wait_queue_timeout_ms;
    }
    bson_mutex_lock (&pool->mutex);
 
+   // Announce the wait before checking the shards again so a concurrent push either leaves a client for this thread
+   // or sees the waiter and signals.
+   mcommon_atomic_int32_fetch_add (&pool->num_waiters, 1, mcommon_memory_order_seq_cst);
+
 again:
-   if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
-      if (pool->size < pool->max_pool_size) {
-         client = _mongoc_client_new_from_topology (pool->topology);
-         BSON_ASSERT (client);
-         _initialize_new_client (pool, client);
-         pool->size++;
-      } else {
-         if (wait_queue_timeout_ms > 0) {
-            now_ms = bson_get_monotonic_time () / 1000;
-            if (now_ms < expire_at_ms) {
-               r = mongoc_cond_timedwait (&pool->cond, &pool->mutex, expire_at_ms - now_ms);
-               if (mongo_cond_ret_is_timedout (r)) {
-                  GOTO (done);
-               }
-            } else {
+   if (!(client = _pool_take_or_create_client (pool, home))) {
+      if (wait_queue_timeout_ms > 0) {
+         now_ms = bson_get_monotonic_time () / 1000;
+         if (now_ms < expire_at_ms) {
+            r = mongoc_cond_timedwait (&pool->cond, &pool->mutex, expire_at_ms - now_ms);
+            if (mongo_cond_ret_is_timedout (r)) {
                GOTO (done);
             }
          } else {
-            mongoc_cond_wait (&pool->cond, &pool->mutex);
+            GOTO (done);
          }
-         GOTO (again);
+      } else {
+         mongoc_cond_wait (&pool->cond, &pool->mutex);
       }
+      GOTO (again);
    }
 
    _start_scanner_if_needed (pool);
+   _start_prewarm_if_needed (pool);
 done:
+   mcommon_atomic_int32_fetch_sub (&pool->num_waiters, 1, mcommon_memory_order_seq_cst);
    bson_mutex_unlock (&pool->mutex);
 
    RETURN (client);
@@ -354,19 +580,20 @@ mongoc_client_pool_try_pop (mongoc_client_pool_t *pool)
 
    BSON_ASSERT_PARAM (pool);
 
-   bson_mutex_lock (&pool->mutex);
+   const size_t home = _home_shard ();
 
-   if (!(client = (mongoc_client_t *) _mongoc_queue_pop_head (&pool->queue))) {
-      if (pool->size < pool->max_pool_size) {
-         client = _mongoc_client_new_from_topology (pool->topology);
-         BSON_ASSERT (client);
-         _initialize_new_client (pool, client);
-         pool->size++;
-      }
+   if ((client = _pool_take_idle_client (pool, home))) {
+      _start_scanner_if_needed (pool);
+      RETURN (client);
    }
 
+   bson_mutex_lock (&pool->mutex);
+
+   client = _pool_take_or_create_client (pool, home);
+
    if (client) {
       _start_scanner_if_needed (pool);
+      _start_prewarm_if_needed (pool);
    }
    bson_mutex_unlock (&pool->mutex);
 
@@ -421,6 +648,23 @@ prune_client (mongoc_client_t *client, mongoc_array_t *known_server_ids)
 }
 
 
+/* Returns a value that changes whenever the set of @server_ids changes. Server
+ * IDs are never reused and each new server gets a larger ID than any before
+ * it, so the count and the largest ID identify the set. */
+static int64_t
+_serverids_fingerprint (const mongoc_array_t *server_ids)
+{
+   BSON_ASSERT_PARAM (server_ids);
+
+   uint32_t max_id = 0u;
+
+   for (size_t i = 0u; i < server_ids->len; i++) {
+      max_id = BSON_MAX (max_id, _mongoc_array_index (server_ids, uint32_t, i));
+   }
+
+   return (int64_t) (((uint64_t) server_ids->len << 32) | max_id);
+}
+
 void
 mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
 {
@@ -432,62 +676,87 @@ mongoc_client_pool_push (mongoc_client_pool_t *pool, mongoc_client_t *client)
    /* reset sockettimeoutms to the default in case it was changed with mongoc_client_set_sockettimeoutms() */
    mongoc_cluster_reset_sockettimeoutms (&client->cluster);
 
-   bson_mutex_lock (&pool->mutex);
-   // Check if `last_known_server_ids` needs update.
-   bool serverids_have_changed = false;
-   {
-      mongoc_array_t current_serverids;
-      _mongoc_array_init (&current_serverids, sizeof (uint32_t));
-
-      {
-         mc_shared_tpld td = mc_tpld_take_ref (pool->topology);
-         const mongoc_set_t *servers = mc_tpld_servers_const (td.ptr);
-         for (size_t i = 0; i < servers->items_len; i++) {
-            _mongoc_array_append_val (&current_serverids, servers->items[i].id);
-         }
-         mc_tpld_drop_ref (&td);
-      }
-
-      serverids_have_changed = (current_serverids.len != pool->last_known_serverids.len) ||
-                               memcmp (current_serverids.data,
-                                       pool->last_known_serverids.data,
-                                       current_serverids.len * current_serverids.element_size) != 0;
+   mongoc_array_t current_serverids;
+   _mongoc_array_init (&current_serverids, sizeof (uint32_t));
 
-      if (serverids_have_changed) {
-         _mongoc_array_destroy (&pool->last_known_serverids);
-         pool->last_known_serverids = current_serverids; // Ownership transfer.
-      } else {
-         _mongoc_array_destroy (&current_serverids);
+   {
+      mc_shared_tpld td = mc_tpld_take_ref (pool->topology);
+      const mongoc_set_t *servers = mc_tpld_servers_const (td.ptr);
+      for (size_t i = 0; i < servers->items_len; i++) {
+         _mongoc_array_append_val (&current_serverids, servers->items[i].id);
       }
+      mc_tpld_drop_ref (&td);
    }
 
    // Check if pooled clients need to be pruned.
-   if (serverids_have_changed) {
-      // The set of last known server IDs has changed. Prune all clients in pool.
-      mongoc_queue_item_t *ptr = pool->queue.head;
-      while (ptr != NULL) {
-         prune_client ((mongoc_client_t *) ptr->data, &pool->last_known_serverids);
-         ptr = ptr->next;
+   const int64_t fingerprint = _serverids_fingerprint (&current_serverids);
+
+   if (fingerprint != mcommon_atomic_int64_fetch (&pool->serverids_fingerprint, mcommon_memory_order_acquire)) {
+      bson_mutex_lock (&pool->mutex);
+
+      if (fingerprint != pool->serverids_fingerprint) {
+         // The set of known server IDs has changed. Prune all clients in pool.
+         for (size_t i = 0u; i < MONGOC_CLIENT_POOL_SHARDS; i++) {
+            mongoc_client_pool_shard_t *const shard = &pool->shards[i];
+
+            bson_mutex_lock (&shard->mutex);
+            for (size_t j = 0u; j < shard->clients.len; j++) {
+               prune_client (_mongoc_array_index (&shard->clients, mongoc_client_t *, j), &current_serverids);
+            }
+            bson_mutex_unlock (&shard->mutex);
+         }
+
+         if (pool->topology->connection_pool) {
+            mongoc_connection_pool_prune (pool->topology->connection_pool, &current_serverids);
+         }
+
+         mcommon_atomic_int64_exchange (&pool->serverids_fingerprint, fingerprint, mcommon_memory_order_release);
       }
+
+      bson_mutex_unlock (&pool->mutex);
    }
 
    // Always prune incoming client. The topology may have changed while client was checked out.
-   prune_client (client, &pool->last_known_serverids);
+   prune_client (client, &current_serverids);
+   _mongoc_array_destroy (&current_serverids);
+
+   // Let other clients borrow this client's connections while it is idle.
+   if (pool->topology->connection_pool) {
+      mongoc_cluster_release_nodes (&client->cluster, pool->topology->connection_pool);
+   }
 
    // Push client back into pool.
-   _mongoc_queue_push_head (&pool->queue, client);
-
-   if (pool->min_pool_size && _mongoc_queue_get_length (&pool->queue) > pool->min_pool_size) {
-      mongoc_client_t *old_client;
-      old_client = (mongoc_client_t *) _mongoc_queue_pop_tail (&pool->queue);
-      if (old_client) {
-         mongoc_client_destroy (old_client);
-         pool->size--;
-      }
+   mongoc_client_pool_shard_t *const shard = &pool->shards[_home_shard ()];
+   mongoc_client_t *old_client = NULL;
+
+   bson_mutex_lock (&shard->mutex);
+   _mongoc_array_append_val (&shard->clients, client);
+   const int32_t num_pushed = mcommon_atomic_int32_fetch_add (&pool->num_pushed, 1, mcommon_memory_order_seq_cst) + 1;
+
+   if (pool->min_pool_size && (uint32_t) num_pushed > pool->min_pool_size) {
+      // Discard the least recently pushed client of this shard.
+      old_client = _mongoc_array_index (&shard->clients, mongoc_client_t *, 0);
+      memmove (shard->clients.data,
+               (mongoc_client_t **) shard->clients.data + 1,
+               (shard->clients.len - 1u) * sizeof (mongoc_client_t *));
+      shard->clients.len--;
+      mcommon_atomic_int32_fetch_sub (&pool->num_pushed, 1, mcommon_memory_order_seq_cst);
    }
+   bson_mutex_unlock (&shard->mutex);
 
-   mongoc_cond_signal (&pool->cond);
-   bson_mutex_unlock (&pool->mutex);
+   if (old_client) {
+      mongoc_client_destroy (old_client);
+
+      bson_mutex_lock (&pool->mutex);
+      pool->size--;
+      mongoc_cond_signal (&pool->cond);
+      bson_mutex_unlock (&pool->mutex);
+   } else if (mcommon_atomic_int32_fetch (&pool->num_waiters, mcommon_memory_order_seq_cst) > 0) {
+      // Only threads waiting for a client need the pool's mutex to be woken.
+      bson_mutex_lock (&pool->mutex);
+      mongoc_cond_signal (&pool->cond);
+      bson_mutex_unlock (&pool->mutex);
+   }
 
    EXIT;
 }
@@ -526,9 +795,7 @@ mongoc_client_pool_num_pushed (mongoc_client_pool_t *pool)
    ENTRY;
    BSON_ASSERT_PARAM (pool);
 
-   bson_mutex_lock (&pool->mutex);
-   num_pushed = pool->queue.length;
-   bson_mutex_unlock (&pool->mutex);
+   num_pushed = (size_t) mcommon_atomic_int32_fetch (&pool->num_pushed, mcommon_memory_order_seq_cst);
 
    RETURN (num_pushed);
 }
@@ -86,6 +86,10 @@ BSON_BEGIN_DECLS
 #define WIRE_VERSION_MIN WIRE_VERSION_4_0 /* a.k.a. minWireVersion */
 #define WIRE_VERSION_MAX WIRE_VERSION_8_0 /* a.k.a. maxWireVersion */
 
+/* Chunk size of a client's arena, enough for the documents of a typical
+ * command. */
+#define MONGOC_CLIENT_ARENA_CHUNK_SIZE 2048
+
 struct _mongoc_collection_t;
 
 struct _mongoc_client_t {
@@ -117,6 +121,12 @@ struct _mongoc_client_t {
    unsigned int csid_rand_seed;
 
    uint32_t generation;
+
+   /* holds the temporaries of the command being run, created on first use.
+    * arena_depth counts nested users; the arena is reset when the outermost
+    * one releases it. */
+   bson_arena_t *arena;
+   int arena_depth;
 };
 
 /* Defines whether _mongoc_client_command_with_opts() is acting as a read
@@ -205,6 +215,12 @@ _mongoc_client_push_server_session (mongoc_client_t *client, mongoc_server_sessi
 void
 _mongoc_client_end_sessions (mongoc_client_t *client);
 
+bson_arena_t *
+_mongoc_client_acquire_arena (mongoc_client_t *client);
+
+void
+_mongoc_client_release_arena (mongoc_client_t *client);
+
 mongoc_stream_t *
 mongoc_client_connect_tcp (int32_t connecttimeoutms, const mongoc_host_list_t *host, bson_error_t *error);
 
@@ -1165,6 +1165,8 @@ mongoc_client_destroy (mongoc_client_t *client)
       mongoc_uri_destroy (client->uri);
       mongoc_set_destroy (client->client_sessions);
       mongoc_server_api_destroy (client->api);
+      BSON_ASSERT (client->arena_depth == 0);
+      bson_arena_destroy (client->arena);
 
 #ifdef MONGOC_ENABLE_SSL
       _mongoc_ssl_opts_cleanup (&client->ssl_opts, true);
@@ -2803,6 +2805,47 @@ _mongoc_client_push_server_session (mongoc_client_t *client, mongoc_server_sessi
    _mongoc_topology_push_server_session (client->topology, server_session);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * _mongoc_client_acquire_arena --
+ *
+ *       Get the client's arena to allocate the temporaries of a command
+ *       from. Each call must be paired with _mongoc_client_release_arena.
+ *       Calls may nest, as when a command runs another command on the same
+ *       client; the memory of all of them is valid until the outermost
+ *       user releases the arena.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bson_arena_t *
+_mongoc_client_acquire_arena (mongoc_client_t *client)
+{
+   BSON_ASSERT_PARAM (client);
+
+   if (!client->arena) {
+      client->arena = bson_arena_new (MONGOC_CLIENT_ARENA_CHUNK_SIZE);
+   }
+
+   client->arena_depth++;
+
+   return client->arena;
+}
+
+
+void
+_mongoc_client_release_arena (mongoc_client_t *client)
+{
+   BSON_ASSERT_PARAM (client);
+   BSON_ASSERT (client->arena_depth > 0);
+
+   if (--client->arena_depth == 0) {
+      bson_arena_reset (client->arena);
+   }
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -26,6 +26,8 @@
 #include <mongoc/mongoc-buffer-private.h>
 #include <mongoc/mongoc-config.h>
 #include <mongoc/mongoc-client.h>
+#include <mongoc/mongoc-compression-private.h>
+#include <mongoc/mongoc-connection-pool-private.h>
 #include <mongoc/mongoc-list-private.h>
 #include <mongoc/mongoc-opcode.h>
 #include <mongoc/mongoc-rpc-private.h>
@@ -43,6 +45,23 @@
 BSON_BEGIN_DECLS
 
 
+/* Replies larger than this are handed to the caller rather than retained in
+ * the cluster's receive buffer, and a receive buffer that grew larger than
+ * this is released once the reply is read. */
+#define MONGOC_CLUSTER_RECV_BUFFER_MAX_SIZE (16 * 1024)
+
+/* Compressed messages larger than this are not retained in the cluster's
+ * compression buffer after being sent. */
+#define MONGOC_CLUSTER_COMPRESS_BUFFER_MAX_SIZE (64 * 1024)
+
+/* With compressionAdaptive, a command is sent uncompressed while its average
+ * compressed size exceeds this fraction of the original size. Every
+ * MONGOC_CLUSTER_COMPRESSION_PROBE_INTERVAL-th message of a skipped command is
+ * compressed anyway to notice changes in its payloads. */
+#define MONGOC_CLUSTER_COMPRESSION_MAX_RATIO 0.9
+#define MONGOC_CLUSTER_COMPRESSION_PROBE_INTERVAL 32
+
+
 typedef struct _mongoc_cluster_node_t {
    mongoc_stream_t *stream;
    char *connection_address;
@@ -63,6 +82,25 @@ typedef struct _mongoc_cluster_t {
 
    mongoc_set_t *nodes;
    mongoc_array_t iov;
+
+   /* Receive buffer reused across replies to avoid allocating per message.
+    * It is never retained at more than MONGOC_CLUSTER_RECV_BUFFER_MAX_SIZE
+    * between replies, so an idle cluster holds no memory for large replies. */
+   mongoc_buffer_t recv_buffer;
+
+   /* Output buffer for OP_COMPRESSED messages, reused across sends. */
+   mongoc_buffer_t compress_buffer;
+
+   /* zlib and zstd state reused across compressed sends and replies. */
+   mongoc_compression_ctx_t *compression_ctx;
+
+   /* Messages shorter than compressionMinBytes are sent uncompressed. With
+    * compressionAdaptive, the compression ratio achieved per command name is
+    * tracked in compression_stats and commands that do not compress well are
+    * sent uncompressed. */
+   int32_t compression_min_bytes;
+   bool compression_adaptive;
+   struct _mongoc_cluster_compression_stats_t *compression_stats;
 } mongoc_cluster_t;
 
 
@@ -81,15 +119,24 @@ mongoc_cluster_reset_sockettimeoutms (mongoc_cluster_t *cluster);
 void
 mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster, uint32_t id);
 
+mongoc_cluster_node_t *
+mongoc_cluster_create_node (mongoc_cluster_t *cluster,
+                            const mongoc_topology_description_t *td,
+                            uint32_t server_id,
+                            bson_error_t *error);
+
+void
+mongoc_cluster_release_nodes (mongoc_cluster_t *cluster, mongoc_connection_pool_t *connection_pool);
+
+void
+_mongoc_cluster_node_destroy (mongoc_cluster_node_t *node);
+
 int32_t
 mongoc_cluster_get_max_bson_obj_size (mongoc_cluster_t *cluster);
 
 int32_t
 mongoc_cluster_get_max_msg_size (mongoc_cluster_t *cluster);
 
-size_t
-_mongoc_cluster_buffer_iovec (mongoc_iovec_t *iov, size_t iovcnt, int skip, char *buffer);
-
 bool
 mongoc_cluster_check_interval (mongoc_cluster_t *cluster, uint32_t server_id);
 
@@ -220,6 +267,10 @@ mongoc_cluster_run_command_private (mongoc_cluster_t *cluster,
                                     bson_t *reply,
                                     bson_error_t *error);
 
+bool
+mongoc_cluster_run_opmsg_pipeline (
+   mongoc_cluster_t *cluster, mongoc_cmd_t *cmds, size_t n_cmds, bson_t *replies, bson_error_t *errors);
+
 void
 _mongoc_cluster_build_sasl_start (bson_t *cmd, const char *mechanism, const char *buf, uint32_t buflen);
 
@@ -265,17 +316,20 @@ _mongoc_cluster_get_auth_cmd_scram (mongoc_crypto_hash_algorithm_t algo,
 
 bool
 mcd_rpc_message_compress (mcd_rpc_message *rpc,
+                          mongoc_compression_ctx_t *ctx,
                           int32_t compressor_id,
                           int32_t compression_level,
-                          void **compressed_data,
-                          size_t *compressed_data_len,
+                          mongoc_buffer_t *buffer,
                           bson_error_t *error);
 
 bool
-mcd_rpc_message_decompress (mcd_rpc_message *rpc, void **data, size_t *data_len);
+mcd_rpc_message_decompress (mcd_rpc_message *rpc, mongoc_compression_ctx_t *ctx, void **data, size_t *data_len);
 
 bool
-mcd_rpc_message_decompress_if_necessary (mcd_rpc_message *rpc, void **data, size_t *data_len);
+mcd_rpc_message_decompress_if_necessary (mcd_rpc_message *rpc,
+                                         mongoc_compression_ctx_t *ctx,
+                                         void **data,
+                                         size_t *data_len);
 
 BSON_END_DECLS
 
@@ -50,8 +50,10 @@
 #include <mongoc/mongoc-uri-private.h>
 #include <mongoc/mongoc-rpc-private.h>
 #include <mongoc/mongoc-compression-private.h>
+#include <mongoc/mongoc-connection-pool-private.h>
 #include <mongoc/mongoc-cmd-private.h>
 #include <mongoc/utlist.h>
+#include <mongoc/uthash.h>
 #include <mongoc/mongoc-handshake-private.h>
 #include <mongoc/mongoc-cluster-aws-private.h>
 #include <mongoc/mongoc-error-private.h>
@@ -160,44 +162,14 @@ _compression_level_from_uri (int32_t compressor_id, const mongoc_uri_t *uri)
       return mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_ZLIBCOMPRESSIONLEVEL, -1);
    }
 
-   return -1;
-}
-
-
-size_t
-_mongoc_cluster_buffer_iovec (mongoc_iovec_t *iov, size_t iovcnt, int skip, char *buffer)
-{
-   size_t buffer_offset = 0;
-   int total_iov_len = 0;
-   size_t difference = 0;
-
-   for (size_t n = 0u; n < iovcnt; n++) {
-      BSON_ASSERT (mlib_in_range (int, iov[n].iov_len));
-      const int iov_len = (int) iov[n].iov_len;
-
-      total_iov_len += iov_len;
-
-      if (total_iov_len <= skip) {
-         continue;
-      }
-
-      /* If this iovec starts before the skip, and takes the total count
-       * beyond the skip, we need to figure out the portion of the iovec
-       * we should skip passed */
-      const int remaining = total_iov_len - iov_len;
-      if (remaining < skip) {
-         difference = (size_t) (skip - remaining);
-      } else {
-         difference = 0u;
-      }
-
-      memcpy (buffer + buffer_offset, ((char *) iov[n].iov_base) + difference, iov[n].iov_len - difference);
-      buffer_offset += iov[n].iov_len - difference;
+   if (compressor_id == MONGOC_COMPRESSOR_ZSTD_ID) {
+      return mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_ZSTDCOMPRESSIONLEVEL, -1);
    }
 
-   return buffer_offset;
+   return -1;
 }
 
+
 /* Allows caller to safely overwrite error->message with a formatted string,
  * even if the formatted string includes original error->message. */
 static void
@@ -235,6 +207,111 @@ _bson_error_message_printf (bson_error_t *error, const char *format, ...)
 static const int32_t message_header_length = 4u * sizeof (int32_t);
 
 
+/* Releases the cluster's compression buffer if it grew beyond the retained
+ * size. */
+static void
+_mongoc_cluster_compress_buffer_release (mongoc_cluster_t *cluster)
+{
+   BSON_ASSERT_PARAM (cluster);
+
+   if (cluster->compress_buffer.datalen > MONGOC_CLUSTER_COMPRESS_BUFFER_MAX_SIZE) {
+      _mongoc_buffer_destroy (&cluster->compress_buffer);
+      _mongoc_buffer_init (&cluster->compress_buffer, NULL, 0, NULL, NULL);
+   }
+}
+
+typedef struct _mongoc_cluster_compression_stats_t {
+   char *command_name; // Hash key.
+   int64_t samples;
+   double ratio; // Moving average of compressed / uncompressed message length.
+   int32_t skipped; // Messages sent uncompressed since the last sample.
+   UT_hash_handle hh;
+} mongoc_cluster_compression_stats_t;
+
+
+static mongoc_cluster_compression_stats_t *
+_mongoc_cluster_compression_stats (mongoc_cluster_t *cluster, const char *command_name)
+{
+   mongoc_cluster_compression_stats_t *stats = NULL;
+
+   HASH_FIND_STR (cluster->compression_stats, command_name, stats);
+
+   if (!stats) {
+      stats = bson_malloc0 (sizeof *stats);
+      stats->command_name = bson_strdup (command_name);
+      HASH_ADD_KEYPTR (hh, cluster->compression_stats, stats->command_name, strlen (stats->command_name), stats);
+   }
+
+   return stats;
+}
+
+
+/* Compresses @rpc unless it is shorter than compressionMinBytes or, with
+ * compressionAdaptive, compressing @command_name has not been paying off.
+ * @command_name is NULL for legacy opcodes, which are only subject to
+ * compressionMinBytes. */
+static bool
+_mongoc_cluster_compress (mongoc_cluster_t *cluster,
+                          mcd_rpc_message *rpc,
+                          int32_t compressor_id,
+                          const char *command_name,
+                          mongoc_buffer_t *buffer,
+                          bson_error_t *error)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (rpc);
+   BSON_OPTIONAL_PARAM (command_name);
+   BSON_ASSERT_PARAM (buffer);
+
+   const int32_t message_length = mcd_rpc_header_get_message_length (rpc);
+   mongoc_cluster_compression_stats_t *stats = NULL;
+
+   if (message_length < cluster->compression_min_bytes) {
+      mongoc_counter_compress_skipped_inc ();
+      return true;
+   }
+
+   if (cluster->compression_adaptive && command_name) {
+      stats = _mongoc_cluster_compression_stats (cluster, command_name);
+
+      if (stats->samples > 0 && stats->ratio > MONGOC_CLUSTER_COMPRESSION_MAX_RATIO &&
+          ++stats->skipped < MONGOC_CLUSTER_COMPRESSION_PROBE_INTERVAL) {
+         mongoc_counter_compress_skipped_inc ();
+         return true;
+      }
+
+      stats->skipped = 0;
+   }
+
+   const int64_t started = bson_get_monotonic_time ();
+
+   if (!mcd_rpc_message_compress (rpc,
+                                  cluster->compression_ctx,
+                                  compressor_id,
+                                  _compression_level_from_uri (compressor_id, cluster->uri),
+                                  buffer,
+                                  error)) {
+      return false;
+   }
+
+   mongoc_counter_compress_usec_add (bson_get_monotonic_time () - started);
+
+   const int32_t compressed_length = mcd_rpc_header_get_message_length (rpc);
+
+   mongoc_counter_compress_bytes_in_add (message_length);
+   mongoc_counter_compress_bytes_saved_add (message_length - compressed_length);
+
+   if (stats) {
+      const double ratio = (double) compressed_length / (double) message_length;
+
+      stats->ratio = stats->samples == 0 ? ratio : (3.0 * stats->ratio + ratio) / 4.0;
+      stats->samples++;
+   }
+
+   return true;
+}
+
+
 static bool
 _mongoc_cluster_run_command_opquery_send (
    mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, int32_t compressor_id, mcd_rpc_message *rpc, bson_error_t *error)
@@ -275,27 +352,22 @@ _mongoc_cluster_run_command_opquery_send (
       mcd_rpc_message_set_length (rpc, message_length);
    }
 
+   mongoc_iovec_t *iovecs = NULL;
    size_t num_iovecs = 0u;
-   mongoc_iovec_t *const iovecs = mcd_rpc_message_to_iovecs (rpc, &num_iovecs);
-   BSON_ASSERT (iovecs);
 
    const bool is_compressible =
       compressor_id != -1 && IS_NOT_COMMAND (HANDSHAKE_CMD_LEGACY_HELLO) && IS_NOT_COMMAND ("hello") &&
       IS_NOT_COMMAND ("saslstart") && IS_NOT_COMMAND ("saslcontinue") && IS_NOT_COMMAND ("getnonce") &&
       IS_NOT_COMMAND ("authenticate") && IS_NOT_COMMAND ("createuser") && IS_NOT_COMMAND ("updateuser");
 
-   void *compressed_data = NULL;
-   size_t compressed_data_len = 0u;
-
-   if (is_compressible && !mcd_rpc_message_compress (rpc,
-                                                     compressor_id,
-                                                     _compression_level_from_uri (compressor_id, cluster->uri),
-                                                     &compressed_data,
-                                                     &compressed_data_len,
-                                                     error)) {
+   if (is_compressible &&
+       !_mongoc_cluster_compress (cluster, rpc, compressor_id, cmd->command_name, &cluster->compress_buffer, error)) {
       goto done;
    }
 
+   iovecs = mcd_rpc_message_to_iovecs (rpc, &num_iovecs);
+   BSON_ASSERT (iovecs);
+
    if (cluster->client->in_exhaust) {
       _mongoc_set_error (
          error, MONGOC_ERROR_CLIENT, MONGOC_ERROR_CLIENT_IN_EXHAUST, "a cursor derived from this client is in exhaust");
@@ -312,13 +384,43 @@ _mongoc_cluster_run_command_opquery_send (
    ret = true;
 
 done:
-   bson_free (compressed_data);
+   _mongoc_cluster_compress_buffer_release (cluster);
    bson_free (iovecs);
    bson_free (ns);
 
    return ret;
 }
 
+/* Returns the cluster's receive buffer, emptied and ready for a new message. */
+static mongoc_buffer_t *
+_mongoc_cluster_recv_buffer_acquire (mongoc_cluster_t *cluster)
+{
+   BSON_ASSERT_PARAM (cluster);
+
+   mongoc_buffer_t *const buffer = &cluster->recv_buffer;
+
+   if (!buffer->data) {
+      _mongoc_buffer_init (buffer, NULL, 0, NULL, NULL);
+   }
+
+   _mongoc_buffer_clear (buffer, false);
+
+   return buffer;
+}
+
+/* Releases the cluster's receive buffer if it grew beyond the retained size,
+ * e.g. to read a compressed reply, so memory for a large reply is given back
+ * as soon as the reply is read rather than held while the cluster is idle. */
+static void
+_mongoc_cluster_recv_buffer_release (mongoc_cluster_t *cluster)
+{
+   BSON_ASSERT_PARAM (cluster);
+
+   if (cluster->recv_buffer.datalen > MONGOC_CLUSTER_RECV_BUFFER_MAX_SIZE) {
+      _mongoc_buffer_destroy (&cluster->recv_buffer);
+   }
+}
+
 static bool
 _mongoc_cluster_run_command_opquery_recv (
    mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, mcd_rpc_message *rpc, bson_t *reply, bson_error_t *error)
@@ -333,19 +435,18 @@ _mongoc_cluster_run_command_opquery_recv (
 
    mongoc_stream_t *const stream = cmd->server_stream->stream;
 
-   mongoc_buffer_t buffer;
-   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+   mongoc_buffer_t *const buffer = _mongoc_cluster_recv_buffer_acquire (cluster);
 
    void *decompressed_data = NULL;
    size_t decompressed_data_len = 0u;
 
-   if (!_mongoc_buffer_append_from_stream (&buffer, stream, sizeof (int32_t), cluster->sockettimeoutms, error)) {
+   if (!_mongoc_buffer_append_from_stream (buffer, stream, sizeof (int32_t), cluster->sockettimeoutms, error)) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "socket error or timeout");
       _handle_network_error (cluster, cmd->server_stream, error);
       goto done;
    }
 
-   const int32_t message_length = _int32_from_le (buffer.data);
+   const int32_t message_length = _int32_from_le (buffer->data);
 
    if (message_length < message_header_length || message_length > MONGOC_DEFAULT_MAX_MSG_SIZE) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "invalid message length");
@@ -355,20 +456,23 @@ _mongoc_cluster_run_command_opquery_recv (
 
    const size_t remaining_bytes = (size_t) message_length - sizeof (int32_t);
 
-   if (!_mongoc_buffer_append_from_stream (&buffer, stream, remaining_bytes, cluster->sockettimeoutms, error)) {
+   if (!_mongoc_buffer_append_from_stream (buffer, stream, remaining_bytes, cluster->sockettimeoutms, error)) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "socket error or timeout");
       _handle_network_error (cluster, cmd->server_stream, error);
       goto done;
    }
 
-   if (!mcd_rpc_message_from_data_in_place (rpc, buffer.data, buffer.len, NULL)) {
+   if (!mcd_rpc_message_from_data_in_place (rpc, buffer->data, buffer->len, NULL)) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "malformed reply from server");
       goto done;
    }
 
    mcd_rpc_message_ingress (rpc);
 
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (rpc,
+                                                 cluster->compression_ctx,
+                                                 &decompressed_data,
+                                                 &decompressed_data_len)) {
       RUN_CMD_ERR (MONGOC_ERROR_STREAM, MONGOC_ERROR_STREAM_SOCKET, "could not decompress server reply");
       goto done;
    }
@@ -393,7 +497,7 @@ _mongoc_cluster_run_command_opquery_recv (
 
 done:
    bson_free (decompressed_data);
-   _mongoc_buffer_destroy (&buffer);
+   _mongoc_cluster_recv_buffer_release (cluster);
 
    return ret;
 }
@@ -473,6 +577,141 @@ _handle_txn_error_labels (bool cmd_ret, const bson_error_t *cmd_err, const mongo
    _mongoc_write_error_handle_labels (cmd_ret, cmd_err, reply, cmd->server_stream->sd);
 }
 
+/* Logs the start of @cmd and publishes its CommandStartedEvent. */
+static void
+_mongoc_cluster_command_started (mongoc_cluster_t *cluster,
+                                 mongoc_cmd_t *cmd,
+                                 int32_t request_id,
+                                 bool *is_redacted_by_apm)
+{
+   const mongoc_server_stream_t *const server_stream = cmd->server_stream;
+   const mongoc_log_and_monitor_instance_t *log_and_monitor = &cluster->client->topology->log_and_monitor;
+   mongoc_apm_command_started_t started_event;
+
+   mongoc_structured_log (
+      log_and_monitor->structured_log,
+      MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
+      MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
+      "Command started",
+      int32 ("requestId", request_id),
+      server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
+      cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID, COMMAND));
+
+   if (log_and_monitor->apm_callbacks.started) {
+      mongoc_apm_command_started_init_with_cmd (
+         &started_event, cmd, request_id, is_redacted_by_apm, log_and_monitor->apm_context);
+
+      log_and_monitor->apm_callbacks.started (&started_event);
+      mongoc_apm_command_started_cleanup (&started_event);
+   }
+}
+
+/* Logs the success of @cmd, started at monotonic time @started, and
+ * publishes its CommandSucceededEvent. */
+static void
+_mongoc_cluster_command_succeeded (mongoc_cluster_t *cluster,
+                                   const mongoc_cmd_t *cmd,
+                                   int32_t request_id,
+                                   int64_t started,
+                                   const bson_t *reply,
+                                   bool is_redacted_by_apm)
+{
+   const mongoc_server_stream_t *const server_stream = cmd->server_stream;
+   const mongoc_log_and_monitor_instance_t *log_and_monitor = &cluster->client->topology->log_and_monitor;
+   mongoc_apm_command_succeeded_t succeeded_event;
+   bson_t fake_reply = BSON_INITIALIZER;
+   int64_t duration = bson_get_monotonic_time () - started;
+
+   /*
+    * Unacknowledged writes must provide a CommandSucceededEvent with an
+    * {ok: 1} reply.
+    * https://github.com/mongodb/specifications/blob/master/source/command-logging-and-monitoring/command-logging-and-monitoring.md#unacknowledgedacknowledged-writes
+    */
+   if (!cmd->is_acknowledged) {
+      bson_append_int32 (&fake_reply, "ok", 2, 1);
+   }
+
+   mongoc_structured_log (
+      log_and_monitor->structured_log,
+      MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
+      MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
+      "Command succeeded",
+      int32 ("requestId", request_id),
+      monotonic_time_duration (duration),
+      server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
+      cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID),
+      cmd_reply (cmd, cmd->is_acknowledged ? reply : &fake_reply));
+
+   if (log_and_monitor->apm_callbacks.succeeded) {
+      mongoc_apm_command_succeeded_init (&succeeded_event,
+                                         duration,
+                                         cmd->is_acknowledged ? reply : &fake_reply,
+                                         cmd->command_name,
+                                         cmd->db_name,
+                                         request_id,
+                                         cmd->operation_id,
+                                         &server_stream->sd->host,
+                                         server_stream->sd->id,
+                                         &server_stream->sd->service_id,
+                                         server_stream->sd->server_connection_id,
+                                         is_redacted_by_apm,
+                                         log_and_monitor->apm_context);
+
+      log_and_monitor->apm_callbacks.succeeded (&succeeded_event);
+      mongoc_apm_command_succeeded_cleanup (&succeeded_event);
+   }
+
+   bson_destroy (&fake_reply);
+}
+
+/* Logs the failure of @cmd, started at monotonic time @started, and
+ * publishes its CommandFailedEvent. */
+static void
+_mongoc_cluster_command_failed (mongoc_cluster_t *cluster,
+                                const mongoc_cmd_t *cmd,
+                                int32_t request_id,
+                                int64_t started,
+                                const bson_t *reply,
+                                const bson_error_t *error,
+                                bool is_redacted_by_apm)
+{
+   const mongoc_server_stream_t *const server_stream = cmd->server_stream;
+   const mongoc_log_and_monitor_instance_t *log_and_monitor = &cluster->client->topology->log_and_monitor;
+   mongoc_apm_command_failed_t failed_event;
+   int64_t duration = bson_get_monotonic_time () - started;
+
+   mongoc_structured_log (
+      log_and_monitor->structured_log,
+      MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
+      MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
+      "Command failed",
+      int32 ("requestId", request_id),
+      monotonic_time_duration (duration),
+      server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
+      cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID),
+      cmd_failure (cmd, reply, error));
+
+   if (log_and_monitor->apm_callbacks.failed) {
+      mongoc_apm_command_failed_init (&failed_event,
+                                      duration,
+                                      cmd->command_name,
+                                      cmd->db_name,
+                                      error,
+                                      reply,
+                                      request_id,
+                                      cmd->operation_id,
+                                      &server_stream->sd->host,
+                                      server_stream->sd->id,
+                                      &server_stream->sd->service_id,
+                                      server_stream->sd->server_connection_id,
+                                      is_redacted_by_apm,
+                                      log_and_monitor->apm_context);
+
+      log_and_monitor->apm_callbacks.failed (&failed_event);
+      mongoc_apm_command_failed_cleanup (&failed_event);
+   }
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -497,9 +736,6 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster, mongoc_cmd_t *c
    bool retval;
    const int32_t request_id = ++cluster->request_id;
    uint32_t server_id;
-   mongoc_apm_command_started_t started_event;
-   mongoc_apm_command_succeeded_t succeeded_event;
-   mongoc_apm_command_failed_t failed_event;
    int64_t started = bson_get_monotonic_time ();
    const mongoc_server_stream_t *server_stream;
    bson_t reply_local;
@@ -513,8 +749,6 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster, mongoc_cmd_t *c
    server_stream = cmd->server_stream;
    server_id = server_stream->sd->id;
 
-   const mongoc_log_and_monitor_instance_t *log_and_monitor = &cluster->client->topology->log_and_monitor;
-
    if (!reply) {
       reply = &reply_local;
    }
@@ -533,102 +767,17 @@ mongoc_cluster_run_command_monitored (mongoc_cluster_t *cluster, mongoc_cmd_t *c
       }
    }
 
-   mongoc_structured_log (
-      log_and_monitor->structured_log,
-      MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
-      MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
-      "Command started",
-      int32 ("requestId", request_id),
-      server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
-      cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID, COMMAND));
-
-   if (log_and_monitor->apm_callbacks.started) {
-      mongoc_apm_command_started_init_with_cmd (
-         &started_event, cmd, request_id, &is_redacted_by_apm, log_and_monitor->apm_context);
-
-      log_and_monitor->apm_callbacks.started (&started_event);
-      mongoc_apm_command_started_cleanup (&started_event);
-   }
+   _mongoc_cluster_command_started (cluster, cmd, request_id, &is_redacted_by_apm);
 
+   /* the powerOfTwoChoices selection policy prefers less busy servers */
+   mc_tpl_sd_add_operation_count (server_stream->sd, 1);
    retval = mongoc_cluster_run_opmsg (cluster, cmd, reply, error);
+   mc_tpl_sd_add_operation_count (server_stream->sd, -1);
 
    if (retval) {
-      bson_t fake_reply = BSON_INITIALIZER;
-      int64_t duration = bson_get_monotonic_time () - started;
-
-      /*
-       * Unacknowledged writes must provide a CommandSucceededEvent with an
-       * {ok: 1} reply.
-       * https://github.com/mongodb/specifications/blob/master/source/command-logging-and-monitoring/command-logging-and-monitoring.md#unacknowledgedacknowledged-writes
-       */
-      if (!cmd->is_acknowledged) {
-         bson_append_int32 (&fake_reply, "ok", 2, 1);
-      }
-
-      mongoc_structured_log (
-         log_and_monitor->structured_log,
-         MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
-         MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
-         "Command succeeded",
-         int32 ("requestId", request_id),
-         monotonic_time_duration (duration),
-         server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
-         cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID),
-         cmd_reply (cmd, cmd->is_acknowledged ? reply : &fake_reply));
-
-      if (log_and_monitor->apm_callbacks.succeeded) {
-         mongoc_apm_command_succeeded_init (&succeeded_event,
-                                            duration,
-                                            cmd->is_acknowledged ? reply : &fake_reply,
-                                            cmd->command_name,
-                                            cmd->db_name,
-                                            request_id,
-                                            cmd->operation_id,
-                                            &server_stream->sd->host,
-                                            server_id,
-                                            &server_stream->sd->service_id,
-                                            server_stream->sd->server_connection_id,
-                                            is_redacted_by_apm,
-                                            log_and_monitor->apm_context);
-
-         log_and_monitor->apm_callbacks.succeeded (&succeeded_event);
-         mongoc_apm_command_succeeded_cleanup (&succeeded_event);
-      }
-
-      bson_destroy (&fake_reply);
+      _mongoc_cluster_command_succeeded (cluster, cmd, request_id, started, reply, is_redacted_by_apm);
    } else {
-      int64_t duration = bson_get_monotonic_time () - started;
-
-      mongoc_structured_log (
-         log_and_monitor->structured_log,
-         MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
-         MONGOC_STRUCTURED_LOG_COMPONENT_COMMAND,
-         "Command failed",
-         int32 ("requestId", request_id),
-         monotonic_time_duration (duration),
-         server_description (server_stream->sd, SERVER_HOST, SERVER_PORT, SERVER_CONNECTION_ID, SERVICE_ID),
-         cmd (cmd, DATABASE_NAME, COMMAND_NAME, OPERATION_ID),
-         cmd_failure (cmd, reply, error));
-
-      if (log_and_monitor->apm_callbacks.failed) {
-         mongoc_apm_command_failed_init (&failed_event,
-                                         duration,
-                                         cmd->command_name,
-                                         cmd->db_name,
-                                         error,
-                                         reply,
-                                         request_id,
-                                         cmd->operation_id,
-                                         &server_stream->sd->host,
-                                         server_id,
-                                         &server_stream->sd->service_id,
-                                         server_stream->sd->server_connection_id,
-                                         is_redacted_by_apm,
-                                         log_and_monitor->apm_context);
-
-         log_and_monitor->apm_callbacks.failed (&failed_event);
-         mongoc_apm_command_failed_cleanup (&failed_event);
-      }
+      _mongoc_cluster_command_failed (cluster, cmd, request_id, started, reply, error, is_redacted_by_apm);
    }
 
    if (retval && _mongoc_cse_is_enabled (cluster->client)) {
@@ -1718,7 +1867,7 @@ mongoc_cluster_disconnect_node (mongoc_cluster_t *cluster, uint32_t server_id)
    EXIT;
 }
 
-static void
+void
 _mongoc_cluster_node_destroy (mongoc_cluster_node_t *node)
 {
    /* Failure, or Replica Set reconfigure without this node */
@@ -1824,25 +1973,24 @@ _mongoc_cluster_finish_speculative_auth (mongoc_cluster_t *cluster,
 /*
  *--------------------------------------------------------------------------
  *
- * mongoc_cluster_add_node --
- *
- *       Add a new node to this cluster for the given server description.
+ * mongoc_cluster_create_node --
  *
- *       NOTE: does NOT check if this server is already in the cluster.
+ *       Connect, handshake and authenticate a new connection to the given
+ *       server, with the options of this cluster.
  *
  * Returns:
- *       A stream connected to the server, or NULL on failure.
+ *       A node the caller owns, or NULL on failure.
  *
  * Side effects:
- *       Adds a cluster node, or sets error on failure.
+ *       Sets error on failure.
  *
  *--------------------------------------------------------------------------
  */
-static mongoc_cluster_node_t *
-_cluster_add_node (mongoc_cluster_t *cluster,
-                   const mongoc_topology_description_t *td,
-                   uint32_t server_id,
-                   bson_error_t *error /* OUT */)
+mongoc_cluster_node_t *
+mongoc_cluster_create_node (mongoc_cluster_t *cluster,
+                            const mongoc_topology_description_t *td,
+                            uint32_t server_id,
+                            bson_error_t *error /* OUT */)
 {
    mongoc_host_list_t *host = NULL;
    mongoc_cluster_node_t *cluster_node = NULL;
@@ -1906,7 +2054,6 @@ _cluster_add_node (mongoc_cluster_t *cluster,
       _mongoc_topology_get_connection_pool_generation (td, server_id, &handshake_sd->service_id);
 
    bson_destroy (&speculative_auth_response);
-   mongoc_set_add (cluster->nodes, server_id, cluster_node);
    _mongoc_host_list_destroy_all (host);
 
 #ifdef MONGOC_ENABLE_CRYPTO
@@ -1930,6 +2077,38 @@ error:
    RETURN (NULL);
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_add_node --
+ *
+ *       Add a new node to this cluster for the given server description.
+ *
+ *       NOTE: does NOT check if this server is already in the cluster.
+ *
+ * Returns:
+ *       A stream connected to the server, or NULL on failure.
+ *
+ * Side effects:
+ *       Adds a cluster node, or sets error on failure.
+ *
+ *--------------------------------------------------------------------------
+ */
+static mongoc_cluster_node_t *
+_cluster_add_node (mongoc_cluster_t *cluster,
+                   const mongoc_topology_description_t *td,
+                   uint32_t server_id,
+                   bson_error_t *error /* OUT */)
+{
+   mongoc_cluster_node_t *const cluster_node = mongoc_cluster_create_node (cluster, td, server_id, error);
+
+   if (cluster_node) {
+      mongoc_set_add (cluster->nodes, server_id, cluster_node);
+   }
+
+   return cluster_node;
+}
+
 static void
 node_not_found (const mongoc_topology_description_t *td, uint32_t server_id, bson_error_t *error /* OUT */)
 {
@@ -2346,7 +2525,31 @@ _cluster_fetch_stream_pooled (mongoc_cluster_t *cluster,
       return NULL;
    }
 
-   cluster_node = _cluster_add_node (cluster, td, server_id, error);
+   mongoc_connection_pool_t *const connection_pool = cluster->client->topology->connection_pool;
+
+   if (connection_pool) {
+      /* borrow an idle connection returned by another client of the pool,
+       * or wait for a maxConnecting slot to establish a new one */
+      bool may_connect = false;
+
+      cluster_node = mongoc_connection_pool_checkout (connection_pool, td, server_id, &may_connect, error);
+
+      if (cluster_node) {
+         mongoc_set_add (cluster->nodes, server_id, cluster_node);
+         return _mongoc_cluster_create_server_stream (td, cluster_node->handshake_sd, cluster_node->stream);
+      }
+
+      if (!may_connect) {
+         /* timed out waiting for a connection */
+         return NULL;
+      }
+
+      cluster_node = _cluster_add_node (cluster, td, server_id, error);
+      mongoc_connection_pool_connect_done (connection_pool, server_id);
+   } else {
+      cluster_node = _cluster_add_node (cluster, td, server_id, error);
+   }
+
    if (cluster_node) {
       return _mongoc_cluster_create_server_stream (td, cluster_node->handshake_sd, cluster_node->stream);
    } else {
@@ -2397,6 +2600,11 @@ mongoc_cluster_init (mongoc_cluster_t *cluster, const mongoc_uri_t *uri, void *c
 
    _mongoc_array_init (&cluster->iov, sizeof (mongoc_iovec_t));
 
+   _mongoc_buffer_init (&cluster->compress_buffer, NULL, 0, NULL, NULL);
+   cluster->compression_ctx = mongoc_compression_ctx_new ();
+   cluster->compression_min_bytes = mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_COMPRESSIONMINBYTES, 0);
+   cluster->compression_adaptive = mongoc_uri_get_option_as_bool (uri, MONGOC_URI_COMPRESSIONADAPTIVE, false);
+
    cluster->operation_id = rand ();
 
    EXIT;
@@ -2432,9 +2640,61 @@ mongoc_cluster_destroy (mongoc_cluster_t *cluster) /* INOUT */
 
    _mongoc_array_destroy (&cluster->iov);
 
+   _mongoc_buffer_destroy (&cluster->recv_buffer);
+   _mongoc_buffer_destroy (&cluster->compress_buffer);
+   mongoc_compression_ctx_destroy (cluster->compression_ctx);
+
+   {
+      mongoc_cluster_compression_stats_t *stats, *tmp;
+
+      HASH_ITER (hh, cluster->compression_stats, stats, tmp)
+      {
+         HASH_DEL (cluster->compression_stats, stats);
+         bson_free (stats->command_name);
+         bson_free (stats);
+      }
+   }
+
    EXIT;
 }
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_release_nodes --
+ *
+ *       Moves the connections of @cluster into @connection_pool for other
+ *       clients of the client pool to borrow. Connections of a client
+ *       still in exhaust have unread replies and are closed instead.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_cluster_release_nodes (mongoc_cluster_t *cluster, mongoc_connection_pool_t *connection_pool)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (connection_pool);
+
+   mongoc_set_t *const nodes = cluster->nodes;
+
+   cluster->nodes = mongoc_set_new (8, _mongoc_cluster_node_dtor, NULL);
+
+   if (!cluster->client->in_exhaust) {
+      for (size_t i = 0u; i < nodes->items_len; i++) {
+         uint32_t server_id;
+         mongoc_cluster_node_t *const node = mongoc_set_get_item_and_id (nodes, i, &server_id);
+
+         mongoc_connection_pool_checkin (connection_pool, server_id, node);
+      }
+
+      /* the connection pool owns the nodes now */
+      nodes->dtor = NULL;
+   }
+
+   mongoc_set_destroy (nodes);
+}
+
 void
 mongoc_cluster_set_sockettimeoutms (mongoc_cluster_t *cluster, int32_t timeoutms)
 {
@@ -2918,8 +3178,6 @@ mongoc_cluster_legacy_rpc_sendv_to_server (mongoc_cluster_t *cluster,
 
    bool ret = false;
 
-   void *compressed_data = NULL;
-   size_t compressed_data_len = 0u;
    mongoc_iovec_t *iovecs = NULL;
    size_t num_iovecs = 0u;
 
@@ -2931,12 +3189,8 @@ mongoc_cluster_legacy_rpc_sendv_to_server (mongoc_cluster_t *cluster,
 
    const int32_t compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
-   if (compressor_id != -1 && !mcd_rpc_message_compress (rpc,
-                                                         compressor_id,
-                                                         _compression_level_from_uri (compressor_id, cluster->uri),
-                                                         &compressed_data,
-                                                         &compressed_data_len,
-                                                         error)) {
+   if (compressor_id != -1 &&
+       !_mongoc_cluster_compress (cluster, rpc, compressor_id, NULL, &cluster->compress_buffer, error)) {
       GOTO (done);
    }
 
@@ -2970,7 +3224,7 @@ mongoc_cluster_legacy_rpc_sendv_to_server (mongoc_cluster_t *cluster,
 
 done:
    bson_free (iovecs);
-   bson_free (compressed_data);
+   _mongoc_cluster_compress_buffer_release (cluster);
 
    RETURN (ret);
 }
@@ -3043,7 +3297,10 @@ mongoc_cluster_try_recv (mongoc_cluster_t *cluster,
    void *decompressed_data = NULL;
    size_t decompressed_data_len = 0u;
 
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (rpc,
+                                                 cluster->compression_ctx,
+                                                 &decompressed_data,
+                                                 &decompressed_data_len)) {
       _mongoc_set_error (
          error, MONGOC_ERROR_PROTOCOL, MONGOC_ERROR_PROTOCOL_INVALID_REPLY, "could not decompress server reply");
       GOTO (done);
@@ -3102,13 +3359,20 @@ network_error_reply (bson_t *reply, const mongoc_cmd_t *cmd)
 }
 
 
+/* Builds the OP_MSG for @cmd in @rpc, compressing it into @compress_buffer if
+ * a compressor was negotiated with the server. */
 static bool
-_mongoc_cluster_run_opmsg_send (
-   mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, mcd_rpc_message *rpc, bson_t *reply, bson_error_t *error)
+_mongoc_cluster_build_opmsg (mongoc_cluster_t *cluster,
+                             const mongoc_cmd_t *cmd,
+                             mcd_rpc_message *rpc,
+                             mongoc_buffer_t *compress_buffer,
+                             bson_t *reply,
+                             bson_error_t *error)
 {
    BSON_ASSERT_PARAM (cluster);
    BSON_ASSERT_PARAM (cmd);
    BSON_ASSERT_PARAM (rpc);
+   BSON_ASSERT_PARAM (compress_buffer);
    BSON_ASSERT_PARAM (reply);
    BSON_ASSERT_PARAM (error);
 
@@ -3152,20 +3416,13 @@ _mongoc_cluster_run_opmsg_send (
       mcd_rpc_message_set_length (rpc, message_length);
    }
 
-   void *compressed_data = NULL;
-   size_t compressed_data_len = 0u;
-
    if (mongoc_cmd_is_compressible (cmd)) {
       const int32_t compressor_id = mongoc_server_description_compressor_id (server_stream->sd);
 
       TRACE ("Function '%s' is compressible: %d", cmd->command_name, compressor_id);
 
-      if (compressor_id != -1 && !mcd_rpc_message_compress (rpc,
-                                                            compressor_id,
-                                                            _compression_level_from_uri (compressor_id, cluster->uri),
-                                                            &compressed_data,
-                                                            &compressed_data_len,
-                                                            error)) {
+      if (compressor_id != -1 &&
+          !_mongoc_cluster_compress (cluster, rpc, compressor_id, cmd->command_name, compress_buffer, error)) {
          RUN_CMD_ERR_DECORATE;
          _handle_network_error (cluster, server_stream, error);
          server_stream->stream = NULL;
@@ -3174,6 +3431,26 @@ _mongoc_cluster_run_opmsg_send (
       }
    }
 
+   return true;
+}
+
+static bool
+_mongoc_cluster_run_opmsg_send (
+   mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, mcd_rpc_message *rpc, bson_t *reply, bson_error_t *error)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (cmd);
+   BSON_ASSERT_PARAM (rpc);
+   BSON_ASSERT_PARAM (reply);
+   BSON_ASSERT_PARAM (error);
+
+   mongoc_server_stream_t *const server_stream = cmd->server_stream;
+
+   if (!_mongoc_cluster_build_opmsg (cluster, cmd, rpc, &cluster->compress_buffer, reply, error)) {
+      _mongoc_cluster_compress_buffer_release (cluster);
+      return false;
+   }
+
    size_t num_iovecs = 0u;
    mongoc_iovec_t *const iovecs = mcd_rpc_message_to_iovecs (rpc, &num_iovecs);
    BSON_ASSERT (iovecs);
@@ -3190,39 +3467,46 @@ _mongoc_cluster_run_opmsg_send (
    }
 
    bson_free (iovecs);
-   bson_free (compressed_data);
+   _mongoc_cluster_compress_buffer_release (cluster);
 
    return res;
 }
 
+/* Reads the next OP_MSG on @cmd's stream into @rpc using @buffer, and
+ * decompresses it into @decompressed_data if it is an OP_COMPRESSED message.
+ * On failure the stream is invalidated and @reply is set. */
 static bool
-_mongoc_cluster_run_opmsg_recv (
-   mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, mcd_rpc_message *rpc, bson_t *reply, bson_error_t *error)
+_mongoc_cluster_recv_opmsg (mongoc_cluster_t *cluster,
+                            const mongoc_cmd_t *cmd,
+                            mcd_rpc_message *rpc,
+                            mongoc_buffer_t *buffer,
+                            void **decompressed_data,
+                            size_t *decompressed_data_len,
+                            bson_t *reply,
+                            bson_error_t *error)
 {
    BSON_ASSERT_PARAM (cluster);
    BSON_ASSERT_PARAM (cmd);
    BSON_ASSERT_PARAM (rpc);
+   BSON_ASSERT_PARAM (buffer);
+   BSON_ASSERT_PARAM (decompressed_data);
+   BSON_ASSERT_PARAM (decompressed_data_len);
    BSON_ASSERT_PARAM (reply);
    BSON_ASSERT_PARAM (error);
 
-   bool ret = false;
-
    mongoc_server_stream_t *const server_stream = cmd->server_stream;
 
-   mongoc_buffer_t buffer;
-   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
-
    if (!_mongoc_buffer_append_from_stream (
-          &buffer, server_stream->stream, sizeof (int32_t), cluster->sockettimeoutms, error)) {
+          buffer, server_stream->stream, sizeof (int32_t), cluster->sockettimeoutms, error)) {
       MONGOC_DEBUG ("could not read message length, stream probably closed or timed out");
       RUN_CMD_ERR_DECORATE;
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      goto done;
+      return false;
    }
 
-   const int32_t message_length = _int32_from_le (buffer.data);
+   const int32_t message_length = _int32_from_le (buffer->data);
 
    if (message_length < message_header_length || message_length > server_stream->sd->max_msg_size) {
       RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
@@ -3234,44 +3518,37 @@ _mongoc_cluster_run_opmsg_recv (
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      goto done;
+      return false;
    }
 
    const size_t remaining_bytes = (size_t) message_length - sizeof (int32_t);
 
    if (!_mongoc_buffer_append_from_stream (
-          &buffer, server_stream->stream, remaining_bytes, cluster->sockettimeoutms, error)) {
+          buffer, server_stream->stream, remaining_bytes, cluster->sockettimeoutms, error)) {
       RUN_CMD_ERR_DECORATE;
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      goto done;
+      return false;
    }
 
-   if (!mcd_rpc_message_from_data_in_place (rpc, buffer.data, buffer.len, NULL)) {
+   if (!mcd_rpc_message_from_data_in_place (rpc, buffer->data, buffer->len, NULL)) {
       RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL, MONGOC_ERROR_PROTOCOL_INVALID_REPLY, "malformed server message");
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      goto done;
+      return false;
    }
    mcd_rpc_message_ingress (rpc);
 
-   void *decompressed_data = NULL;
-   size_t decompressed_data_len = 0u;
-
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (
+          rpc, cluster->compression_ctx, decompressed_data, decompressed_data_len)) {
       _mongoc_set_error (
          error, MONGOC_ERROR_PROTOCOL, MONGOC_ERROR_PROTOCOL_INVALID_REPLY, "could not decompress message from server");
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      GOTO (done);
-   }
-
-   if (decompressed_data) {
-      _mongoc_buffer_destroy (&buffer);
-      _mongoc_buffer_init (&buffer, decompressed_data, decompressed_data_len, NULL, NULL);
+      return false;
    }
 
    // CDRIVER-5584
@@ -3287,10 +3564,35 @@ _mongoc_cluster_run_opmsg_recv (
          _handle_network_error (cluster, server_stream, error);
          server_stream->stream = NULL;
          network_error_reply (reply, cmd);
-         goto done;
+         return false;
       }
    }
 
+   return true;
+}
+
+/* Processes the OP_MSG reply to @cmd in @rpc, read by _mongoc_cluster_recv_opmsg,
+ * and sets @reply to its body. */
+static bool
+_mongoc_cluster_handle_opmsg_reply (mongoc_cluster_t *cluster,
+                                    const mongoc_cmd_t *cmd,
+                                    mcd_rpc_message *rpc,
+                                    mongoc_buffer_t *buffer,
+                                    void **decompressed_data,
+                                    size_t decompressed_data_len,
+                                    bson_t *reply,
+                                    bson_error_t *error)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (cmd);
+   BSON_ASSERT_PARAM (rpc);
+   BSON_ASSERT_PARAM (buffer);
+   BSON_ASSERT_PARAM (decompressed_data);
+   BSON_ASSERT_PARAM (reply);
+   BSON_ASSERT_PARAM (error);
+
+   mongoc_server_stream_t *const server_stream = cmd->server_stream;
+
    bson_t body;
 
    if (!mcd_rpc_message_get_body (rpc, &body)) {
@@ -3298,23 +3600,71 @@ _mongoc_cluster_run_opmsg_recv (
       _handle_network_error (cluster, server_stream, error);
       server_stream->stream = NULL;
       network_error_reply (reply, cmd);
-      goto done;
+      return false;
    }
 
    cluster->client->in_exhaust = (mcd_rpc_op_msg_get_flag_bits (rpc) & MONGOC_OP_MSG_FLAG_MORE_TO_COME) != 0u;
    _mongoc_topology_update_cluster_time (cluster->client->topology, &body);
 
-   ret = _mongoc_cmd_check_ok (&body, cluster->client->error_api_version, error);
+   const bool ret = _mongoc_cmd_check_ok (&body, cluster->client->error_api_version, error);
 
    if (cmd->session) {
       _mongoc_client_session_handle_reply (cmd->session, cmd->is_acknowledged, cmd->command_name, &body);
    }
 
-   bson_copy_to (&body, reply);
-   bson_destroy (&body);
+   // Large replies adopt the buffer they were read into rather than copying the body out of it. Small replies are
+   // copied so the cluster's receive buffer can be reused for the next message.
+   if (*decompressed_data) {
+      const size_t body_offset = (size_t) (bson_get_data (&body) - (const uint8_t *) *decompressed_data);
 
-done:
-   _mongoc_buffer_destroy (&buffer);
+      bson_destroy (&body);
+
+      BSON_ASSERT (bson_init_from_buffer_steal (reply, *decompressed_data, decompressed_data_len, body_offset));
+      *decompressed_data = NULL;
+   } else if (buffer->datalen > MONGOC_CLUSTER_RECV_BUFFER_MAX_SIZE) {
+      const size_t body_offset = (size_t) (bson_get_data (&body) - buffer->data);
+      uint8_t *const data = buffer->data;
+      const size_t datalen = buffer->datalen;
+
+      bson_destroy (&body);
+
+      BSON_ASSERT (buffer->realloc_func == bson_realloc_ctx);
+      BSON_ASSERT (bson_init_from_buffer_steal (reply, data, datalen, body_offset));
+      buffer->data = NULL;
+      _mongoc_buffer_destroy (buffer);
+   } else {
+      bson_copy_to (&body, reply);
+      bson_destroy (&body);
+   }
+
+   return ret;
+}
+
+static bool
+_mongoc_cluster_run_opmsg_recv (
+   mongoc_cluster_t *cluster, const mongoc_cmd_t *cmd, mcd_rpc_message *rpc, bson_t *reply, bson_error_t *error)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (cmd);
+   BSON_ASSERT_PARAM (rpc);
+   BSON_ASSERT_PARAM (reply);
+   BSON_ASSERT_PARAM (error);
+
+   bool ret = false;
+
+   mongoc_buffer_t *const buffer = _mongoc_cluster_recv_buffer_acquire (cluster);
+
+   void *decompressed_data = NULL;
+   size_t decompressed_data_len = 0u;
+
+   if (_mongoc_cluster_recv_opmsg (
+          cluster, cmd, rpc, buffer, &decompressed_data, &decompressed_data_len, reply, error)) {
+      ret = _mongoc_cluster_handle_opmsg_reply (
+         cluster, cmd, rpc, buffer, &decompressed_data, decompressed_data_len, reply, error);
+   }
+
+   bson_free (decompressed_data);
+   _mongoc_cluster_recv_buffer_release (cluster);
 
    return ret;
 }
@@ -3372,22 +3722,324 @@ done:
 }
 
 
+// Upper bound on the iovecs passed to a single writev, which rejects more than IOV_MAX.
+#define PIPELINE_MAX_IOVECS_PER_WRITE 1024u
+
+/* Fails every command in @cmds still marked in @pending with @error after a
+ * network error on their shared stream. */
+static void
+_mongoc_cluster_pipeline_fail_pending (const mongoc_cmd_t *cmds,
+                                       size_t n_cmds,
+                                       bool *pending,
+                                       bson_t *replies,
+                                       bson_error_t *errors,
+                                       const bson_error_t *error)
+{
+   for (size_t i = 0u; i < n_cmds; i++) {
+      if (pending[i]) {
+         pending[i] = false;
+         network_error_reply (&replies[i], &cmds[i]);
+
+         if (&errors[i] != error) {
+            memcpy (&errors[i], error, sizeof (bson_error_t));
+         }
+      }
+   }
+}
+
+
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cluster_run_opmsg_pipeline --
+ *
+ *       Internal function to send @n_cmds OP_MSG commands on the stream
+ *       they share in a single write, then receive the replies of the
+ *       acknowledged ones. Replies are matched to their commands by
+ *       responseTo. Unacknowledged commands are sent with moreToCome and
+ *       get an empty reply.
+ *       Exhaust commands cannot be pipelined. If the client's APM callbacks
+ *       are set, they are executed for each command. Automatic
+ *       encryption/decryption is not performed.
+ *
+ * Returns:
+ *       true if every command succeeded; otherwise false and the
+ *       @errors of the commands that failed are set.
+ *
+ * Side effects:
+ *       Each of the @n_cmds @replies is set and should ALWAYS be released
+ *       with bson_destroy().
+ *
+ *--------------------------------------------------------------------------
+ */
+
+bool
+mongoc_cluster_run_opmsg_pipeline (
+   mongoc_cluster_t *cluster, mongoc_cmd_t *cmds, size_t n_cmds, bson_t *replies, bson_error_t *errors)
+{
+   BSON_ASSERT_PARAM (cluster);
+   BSON_ASSERT_PARAM (cmds);
+   BSON_ASSERT_PARAM (replies);
+   BSON_ASSERT_PARAM (errors);
+   BSON_ASSERT (n_cmds > 0u);
+
+   ENTRY;
+
+   bool ret = false;
+   bson_error_t error;
+
+   mongoc_server_stream_t *const server_stream = cmds[0].server_stream;
+
+   mcd_rpc_message **const rpcs = bson_malloc0 (n_cmds * sizeof (mcd_rpc_message *));
+   mongoc_buffer_t *const compress_buffers = bson_malloc0 (n_cmds * sizeof (mongoc_buffer_t));
+   int32_t *const request_ids = bson_malloc0 (n_cmds * sizeof (int32_t));
+   int32_t *const apm_request_ids = bson_malloc0 (n_cmds * sizeof (int32_t));
+   bool *const is_redacted_by_apm = bson_malloc0 (n_cmds * sizeof (bool));
+   bool *const pending = bson_malloc0 (n_cmds * sizeof (bool));
+   const int64_t started = bson_get_monotonic_time ();
+   size_t n_pending = 0u;
+   mcd_rpc_message *reply_rpc = NULL;
+   mongoc_array_t iov;
+
+   _mongoc_array_init (&iov, sizeof (mongoc_iovec_t));
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      bson_init (&replies[i]);
+      memset (&errors[i], 0, sizeof (bson_error_t));
+      _mongoc_buffer_init (&compress_buffers[i], NULL, 0, NULL, NULL);
+   }
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      apm_request_ids[i] = ++cluster->request_id;
+      _mongoc_cluster_command_started (cluster, &cmds[i], apm_request_ids[i], &is_redacted_by_apm[i]);
+   }
+
+   /* the powerOfTwoChoices selection policy prefers less busy servers */
+   mc_tpl_sd_add_operation_count (server_stream->sd, (int64_t) n_cmds);
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      const mongoc_cmd_t *const cmd = &cmds[i];
+
+      if (!cmd->command_name) {
+         _mongoc_set_error (&error, MONGOC_ERROR_COMMAND, MONGOC_ERROR_COMMAND_INVALID_ARG, "empty command document");
+         GOTO (invalid);
+      }
+
+      if (cmd->server_stream != server_stream) {
+         _mongoc_set_error (&error,
+                            MONGOC_ERROR_COMMAND,
+                            MONGOC_ERROR_COMMAND_INVALID_ARG,
+                            "pipelined commands must be sent on the same server stream");
+         GOTO (invalid);
+      }
+
+      if (cmd->op_msg_is_exhaust) {
+         _mongoc_set_error (
+            &error, MONGOC_ERROR_COMMAND, MONGOC_ERROR_COMMAND_INVALID_ARG, "exhaust commands cannot be pipelined");
+         GOTO (invalid);
+      }
+   }
+
+   if (cluster->client->in_exhaust) {
+      _mongoc_set_error (&error,
+                         MONGOC_ERROR_CLIENT,
+                         MONGOC_ERROR_CLIENT_IN_EXHAUST,
+                         "another cursor derived from this client is in exhaust");
+      GOTO (invalid);
+   }
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      rpcs[i] = mcd_rpc_message_new ();
+
+      if (!_mongoc_cluster_build_opmsg (cluster, &cmds[i], rpcs[i], &compress_buffers[i], &replies[i], &errors[i])) {
+         // The stream was invalidated: none of the commands can be sent.
+         for (size_t j = 0u; j < n_cmds; j++) {
+            pending[j] = j != i;
+         }
+
+         _mongoc_cluster_pipeline_fail_pending (cmds, n_cmds, pending, replies, errors, &errors[i]);
+         GOTO (done);
+      }
+
+      request_ids[i] = mcd_rpc_header_get_request_id (rpcs[i]);
+
+      size_t num_iovecs = 0u;
+      mongoc_iovec_t *const iovecs = mcd_rpc_message_to_iovecs (rpcs[i], &num_iovecs);
+      BSON_ASSERT (iovecs);
+      BSON_ASSERT (mlib_in_range (uint32_t, num_iovecs));
+      _mongoc_array_append_vals (&iov, iovecs, (uint32_t) num_iovecs);
+      bson_free (iovecs);
+
+      mcd_rpc_message_egress (rpcs[i]);
+   }
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      pending[i] = true;
+   }
+
+   for (size_t offset = 0u; offset < iov.len;) {
+      const size_t count = BSON_MIN (iov.len - offset, PIPELINE_MAX_IOVECS_PER_WRITE);
+      mongoc_iovec_t *const iovecs = &_mongoc_array_index (&iov, mongoc_iovec_t, offset);
+
+      if (!_mongoc_stream_writev_full (server_stream->stream, iovecs, count, cluster->sockettimeoutms, &errors[0])) {
+         const mongoc_cmd_t *const cmd = &cmds[0];
+         bson_error_t *const error = &errors[0];
+
+         RUN_CMD_ERR_DECORATE;
+         _handle_network_error (cluster, server_stream, error);
+         server_stream->stream = NULL;
+         _mongoc_cluster_pipeline_fail_pending (cmds, n_cmds, pending, replies, errors, error);
+         GOTO (done);
+      }
+
+      offset += count;
+   }
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      pending[i] = cmds[i].is_acknowledged;
+      n_pending += pending[i] ? 1u : 0u;
+   }
+
+   ret = true;
+   reply_rpc = mcd_rpc_message_new ();
+
+   while (n_pending > 0u) {
+      // Errors reading a reply are reported for the earliest command still waiting for one.
+      size_t first = 0u;
+
+      while (!pending[first]) {
+         first++;
+      }
+
+      mongoc_buffer_t *const buffer = _mongoc_cluster_recv_buffer_acquire (cluster);
+      void *decompressed_data = NULL;
+      size_t decompressed_data_len = 0u;
+
+      mcd_rpc_message_reset (reply_rpc);
+
+      if (!_mongoc_cluster_recv_opmsg (cluster,
+                                       &cmds[first],
+                                       reply_rpc,
+                                       buffer,
+                                       &decompressed_data,
+                                       &decompressed_data_len,
+                                       &replies[first],
+                                       &errors[first])) {
+         _mongoc_cluster_recv_buffer_release (cluster);
+         pending[first] = false;
+         _mongoc_cluster_pipeline_fail_pending (cmds, n_cmds, pending, replies, errors, &errors[first]);
+         ret = false;
+         GOTO (done);
+      }
+
+      const int32_t response_to = mcd_rpc_header_get_response_to (reply_rpc);
+      size_t matched = 0u;
+
+      while (matched < n_cmds && !(pending[matched] && request_ids[matched] == response_to)) {
+         matched++;
+      }
+
+      if (matched == n_cmds) {
+         const mongoc_cmd_t *const cmd = &cmds[first];
+         bson_error_t *const error = &errors[first];
+
+         RUN_CMD_ERR (MONGOC_ERROR_PROTOCOL,
+                      MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
+                      "reply responseTo %" PRId32 " does not match any pipelined request",
+                      response_to);
+         _handle_network_error (cluster, server_stream, error);
+         server_stream->stream = NULL;
+         bson_free (decompressed_data);
+         _mongoc_cluster_recv_buffer_release (cluster);
+         _mongoc_cluster_pipeline_fail_pending (cmds, n_cmds, pending, replies, errors, error);
+         ret = false;
+         GOTO (done);
+      }
+
+      pending[matched] = false;
+      n_pending--;
+
+      bson_destroy (&replies[matched]);
+
+      if (!_mongoc_cluster_handle_opmsg_reply (cluster,
+                                               &cmds[matched],
+                                               reply_rpc,
+                                               buffer,
+                                               &decompressed_data,
+                                               decompressed_data_len,
+                                               &replies[matched],
+                                               &errors[matched])) {
+         ret = false;
+      }
+
+      bson_free (decompressed_data);
+      _mongoc_cluster_recv_buffer_release (cluster);
+
+      if (!server_stream->stream) {
+         // The reply was malformed and the stream invalidated.
+         _mongoc_cluster_pipeline_fail_pending (cmds, n_cmds, pending, replies, errors, &errors[matched]);
+         GOTO (done);
+      }
+   }
+
+   // Handled once all replies are read: a "not primary" error may disconnect the stream.
+   for (size_t i = 0u; i < n_cmds; i++) {
+      if (cmds[i].is_acknowledged) {
+         _handle_not_primary_error (cluster, server_stream, &replies[i]);
+      }
+   }
+
+   _mongoc_topology_update_last_used (cluster->client->topology, server_stream->sd->id);
+
+   GOTO (done);
+
+invalid:
+   for (size_t i = 0u; i < n_cmds; i++) {
+      memcpy (&errors[i], &error, sizeof (bson_error_t));
+   }
+
+done:
+   mc_tpl_sd_add_operation_count (server_stream->sd, -(int64_t) n_cmds);
+
+   for (size_t i = 0u; i < n_cmds; i++) {
+      if (errors[i].code) {
+         _mongoc_cluster_command_failed (
+            cluster, &cmds[i], apm_request_ids[i], started, &replies[i], &errors[i], is_redacted_by_apm[i]);
+      } else {
+         _mongoc_cluster_command_succeeded (
+            cluster, &cmds[i], apm_request_ids[i], started, &replies[i], is_redacted_by_apm[i]);
+      }
+
+      mcd_rpc_message_destroy (rpcs[i]);
+      _mongoc_buffer_destroy (&compress_buffers[i]);
+   }
+
+   mcd_rpc_message_destroy (reply_rpc);
+   _mongoc_array_destroy (&iov);
+   bson_free (pending);
+   bson_free (is_redacted_by_apm);
+   bson_free (apm_request_ids);
+   bson_free (request_ids);
+   bson_free (compress_buffers);
+   bson_free (rpcs);
+
+   RETURN (ret);
+}
+
+
 bool
 mcd_rpc_message_compress (mcd_rpc_message *rpc,
+                          mongoc_compression_ctx_t *ctx,
                           int32_t compressor_id,
                           int32_t compression_level,
-                          void **data,
-                          size_t *data_len,
+                          mongoc_buffer_t *buffer,
                           bson_error_t *error)
 {
    BSON_ASSERT_PARAM (rpc);
-   BSON_ASSERT_PARAM (data);
-   BSON_ASSERT_PARAM (data_len);
+   BSON_ASSERT_PARAM (buffer);
 
    bool ret = false;
 
-   char *uncompressed_message = NULL;
-   char *compressed_message = NULL;
    mongoc_iovec_t *iovecs = NULL;
 
    const int32_t original_message_length = mcd_rpc_header_get_message_length (rpc);
@@ -3420,26 +4072,46 @@ mcd_rpc_message_compress (mcd_rpc_message *rpc,
    iovecs = mcd_rpc_message_to_iovecs (rpc, &num_iovecs);
    BSON_ASSERT (iovecs);
 
-   uncompressed_message = bson_malloc (uncompressed_size);
-   BSON_ASSERT (_mongoc_cluster_buffer_iovec (iovecs, num_iovecs, message_header_length, uncompressed_message) ==
-                uncompressed_size);
+   // Skip the msgHeader fields and compress the remaining iovecs in place.
+   size_t first_iovec = 0u;
 
-   compressed_message = bson_malloc (estimated_compressed_size);
+   {
+      size_t skip = (size_t) message_header_length;
+
+      while (skip > 0u) {
+         BSON_ASSERT (first_iovec < num_iovecs);
+
+         if (iovecs[first_iovec].iov_len <= skip) {
+            skip -= iovecs[first_iovec].iov_len;
+            first_iovec++;
+         } else {
+            iovecs[first_iovec].iov_base = (char *) iovecs[first_iovec].iov_base + skip;
+            iovecs[first_iovec].iov_len -= skip;
+            skip = 0u;
+         }
+      }
+   }
+
+   _mongoc_buffer_clear (buffer, false);
+   char *const compressed_message = (char *) _mongoc_buffer_reserve (buffer, estimated_compressed_size);
 
    // This value may be passed as an argument to an in-out parameter depending
    // on the compressor, not just an out-parameter.
    size_t compressed_size = estimated_compressed_size;
 
-   if (!mongoc_compress (compressor_id,
-                         compression_level,
-                         uncompressed_message,
-                         uncompressed_size,
-                         compressed_message,
-                         &compressed_size)) {
+   if (!mongoc_compress_iovec (ctx,
+                               compressor_id,
+                               compression_level,
+                               iovecs + first_iovec,
+                               num_iovecs - first_iovec,
+                               compressed_message,
+                               &compressed_size)) {
       MONGOC_WARNING ("Could not compress data with %s", mongoc_compressor_id_to_name (compressor_id));
       goto fail;
    }
 
+   buffer->len = compressed_size;
+
    mcd_rpc_message_reset (rpc);
 
    {
@@ -3457,22 +4129,16 @@ mcd_rpc_message_compress (mcd_rpc_message *rpc,
       mcd_rpc_message_set_length (rpc, message_len);
    }
 
-   *data = compressed_message;
-   *data_len = compressed_size;
-   compressed_message = NULL;
-
    ret = true;
 
 fail:
-   bson_free (compressed_message);
-   bson_free (uncompressed_message);
    bson_free (iovecs);
 
    return ret;
 }
 
 bool
-mcd_rpc_message_decompress (mcd_rpc_message *rpc, void **data, size_t *data_len)
+mcd_rpc_message_decompress (mcd_rpc_message *rpc, mongoc_compression_ctx_t *ctx, void **data, size_t *data_len)
 {
    BSON_ASSERT_PARAM (rpc);
    BSON_ASSERT_PARAM (data);
@@ -3532,7 +4198,8 @@ mcd_rpc_message_decompress (mcd_rpc_message *rpc, void **data, size_t *data_len)
    size_t actual_uncompressed_size = uncompressed_size;
 
    // Populate the rest of the uncompressed message.
-   if (!mongoc_uncompress (mcd_rpc_op_compressed_get_compressor_id (rpc),
+   if (!mongoc_uncompress (ctx,
+                           mcd_rpc_op_compressed_get_compressor_id (rpc),
                            mcd_rpc_op_compressed_get_compressed_message (rpc),
                            mcd_rpc_op_compressed_get_compressed_message_length (rpc),
                            ptr + message_header_length,
@@ -3556,7 +4223,10 @@ mcd_rpc_message_decompress (mcd_rpc_message *rpc, void **data, size_t *data_len)
 }
 
 bool
-mcd_rpc_message_decompress_if_necessary (mcd_rpc_message *rpc, void **data, size_t *data_len)
+mcd_rpc_message_decompress_if_necessary (mcd_rpc_message *rpc,
+                                         mongoc_compression_ctx_t *ctx,
+                                         void **data,
+                                         size_t *data_len)
 {
    BSON_ASSERT_PARAM (rpc);
    BSON_ASSERT_PARAM (data);
@@ -3569,7 +4239,7 @@ mcd_rpc_message_decompress_if_necessary (mcd_rpc_message *rpc, void **data, size
       return true;
    }
 
-   return mcd_rpc_message_decompress (rpc, data, data_len);
+   return mcd_rpc_message_decompress (rpc, ctx, data, data_len);
 }
 
 bool
@@ -97,6 +97,8 @@ typedef struct _mongoc_cmd_parts_t {
    bool has_temp_session;
    mongoc_client_t *client;
    mongoc_server_api_t *api;
+   /* the arena the documents above are allocated from, or NULL */
+   bson_arena_t *arena;
 } mongoc_cmd_parts_t;
 
 
@@ -113,6 +115,9 @@ mongoc_cmd_parts_set_session (mongoc_cmd_parts_t *parts, mongoc_client_session_t
 void
 mongoc_cmd_parts_set_server_api (mongoc_cmd_parts_t *parts, mongoc_server_api_t *api);
 
+void
+mongoc_cmd_parts_set_arena (mongoc_cmd_parts_t *parts, bson_arena_t *arena);
+
 bool
 mongoc_cmd_parts_append_opts (mongoc_cmd_parts_t *parts, bson_iter_t *iter, bson_error_t *error);
 
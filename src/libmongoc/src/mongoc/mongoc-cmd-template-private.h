@@ -0,0 +1,50 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc-prelude.h>
+
+
+#ifndef MONGOC_CMD_TEMPLATE_PRIVATE_H
+#define MONGOC_CMD_TEMPLATE_PRIVATE_H
+
+#include <bson/bson.h>
+
+BSON_BEGIN_DECLS
+
+/* Pre-encoded fields of commands the driver sends with a fixed shape. The
+ * slots of each template are listed in order. */
+typedef enum {
+   /* getMore: int64, collection: utf8 */
+   MONGOC_CMD_TEMPLATE_GETMORE,
+   /* topologyVersion: document, maxAwaitTimeMS: int64, $db: utf8 */
+   MONGOC_CMD_TEMPLATE_AWAITABLE_HELLO,
+   MONGOC_CMD_TEMPLATE_COUNT
+} mongoc_cmd_template_id_t;
+
+/* Builds the templates unless already built. Called by mongoc_init, and by
+ * _mongoc_cmd_template in case mongoc_init was not. */
+void
+_mongoc_cmd_templates_init (void);
+
+void
+_mongoc_cmd_templates_cleanup (void);
+
+const bson_template_t *
+_mongoc_cmd_template (mongoc_cmd_template_id_t id);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_CMD_TEMPLATE_PRIVATE_H */
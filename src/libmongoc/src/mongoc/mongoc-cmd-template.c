@@ -0,0 +1,82 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <mongoc/mongoc-cmd-template-private.h>
+
+#include <common-thread-private.h>
+
+
+/* Built once, by mongoc_init or on first use, and only read afterward, so
+ * they are shared by all threads without locking. */
+static bson_template_t *gCmdTemplates[MONGOC_CMD_TEMPLATE_COUNT];
+static bson_once_t gCmdTemplatesOnce = BSON_ONCE_INIT;
+
+
+/* The most slots in a template. */
+#define MONGOC_CMD_TEMPLATE_MAX_SLOTS 3
+
+
+static BSON_ONCE_FUN (_mongoc_cmd_templates_build)
+{
+   static const struct {
+      const char *key;
+      bson_type_t type;
+   } slots[MONGOC_CMD_TEMPLATE_COUNT][MONGOC_CMD_TEMPLATE_MAX_SLOTS] = {
+      [MONGOC_CMD_TEMPLATE_GETMORE] = {{"getMore", BSON_TYPE_INT64}, {"collection", BSON_TYPE_UTF8}},
+      [MONGOC_CMD_TEMPLATE_AWAITABLE_HELLO] = {{"topologyVersion", BSON_TYPE_DOCUMENT},
+                                               {"maxAwaitTimeMS", BSON_TYPE_INT64},
+                                               {"$db", BSON_TYPE_UTF8}},
+   };
+
+   for (int i = 0; i < MONGOC_CMD_TEMPLATE_COUNT; i++) {
+      gCmdTemplates[i] = bson_template_new ();
+
+      for (int j = 0; j < MONGOC_CMD_TEMPLATE_MAX_SLOTS && slots[i][j].key; j++) {
+         BSON_ASSERT (bson_template_add (gCmdTemplates[i], slots[i][j].key, -1, slots[i][j].type));
+      }
+   }
+
+   BSON_ONCE_RETURN;
+}
+
+
+void
+_mongoc_cmd_templates_init (void)
+{
+   bson_once (&gCmdTemplatesOnce, _mongoc_cmd_templates_build);
+}
+
+
+void
+_mongoc_cmd_templates_cleanup (void)
+{
+   for (int i = 0; i < MONGOC_CMD_TEMPLATE_COUNT; i++) {
+      bson_template_destroy (gCmdTemplates[i]);
+      gCmdTemplates[i] = NULL;
+   }
+}
+
+
+const bson_template_t *
+_mongoc_cmd_template (mongoc_cmd_template_id_t id)
+{
+   BSON_ASSERT (id < MONGOC_CMD_TEMPLATE_COUNT);
+
+   _mongoc_cmd_templates_init ();
+
+   return gCmdTemplates[id];
+}
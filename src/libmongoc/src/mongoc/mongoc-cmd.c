@@ -47,6 +47,7 @@ mongoc_cmd_parts_init (mongoc_cmd_parts_t *parts,
    parts->is_retryable_write = false;
    parts->has_temp_session = false;
    parts->client = client;
+   parts->arena = NULL;
    bson_init (&parts->read_concern_document);
    bson_init (&parts->write_concern_document);
    bson_init (&parts->extra);
@@ -64,6 +65,56 @@ mongoc_cmd_parts_init (mongoc_cmd_parts_t *parts,
 }
 
 
+/*
+ *--------------------------------------------------------------------------
+ *
+ * mongoc_cmd_parts_set_arena --
+ *
+ *       Allocate the documents @parts builds from @arena, which must outlive
+ *       mongoc_cmd_parts_cleanup.
+ *
+ * Side effects:
+ *       Aborts if anything was added to @parts before.
+ *
+ *--------------------------------------------------------------------------
+ */
+
+void
+mongoc_cmd_parts_set_arena (mongoc_cmd_parts_t *parts, bson_arena_t *arena)
+{
+   BSON_ASSERT (parts);
+   BSON_ASSERT (arena);
+   BSON_ASSERT (!parts->assembled.command);
+   BSON_ASSERT (bson_empty (&parts->read_concern_document));
+   BSON_ASSERT (bson_empty (&parts->write_concern_document));
+   BSON_ASSERT (bson_empty (&parts->extra));
+
+   parts->arena = arena;
+   bson_destroy (&parts->read_concern_document);
+   bson_destroy (&parts->write_concern_document);
+   bson_destroy (&parts->extra);
+   bson_destroy (&parts->assembled_body);
+   bson_init_arena (&parts->read_concern_document, arena);
+   bson_init_arena (&parts->write_concern_document, arena);
+   bson_init_arena (&parts->extra, arena);
+   bson_init_arena (&parts->assembled_body, arena);
+}
+
+
+/* Replace @dst, one of the documents of @parts, with a copy of @src. */
+static void
+_mongoc_cmd_parts_copy_to (const mongoc_cmd_parts_t *parts, const bson_t *src, bson_t *dst)
+{
+   bson_destroy (dst);
+
+   if (parts->arena) {
+      bson_copy_to_arena (src, dst, parts->arena);
+   } else {
+      bson_copy_to (src, dst);
+   }
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -147,8 +198,7 @@ mongoc_cmd_parts_append_opts (mongoc_cmd_parts_t *parts, bson_iter_t *iter, bson
          /* add readConcern later, once we know about causal consistency */
          bson_iter_document (iter, &len, &data);
          BSON_ASSERT (bson_init_static (&read_concern, data, (size_t) len));
-         bson_destroy (&parts->read_concern_document);
-         bson_copy_to (&read_concern, &parts->read_concern_document);
+         _mongoc_cmd_parts_copy_to (parts, &read_concern, &parts->read_concern_document);
          continue;
       } else if (BSON_ITER_IS_KEY (iter, "sessionId")) {
          BSON_ASSERT (!parts->assembled.session);
@@ -212,8 +262,8 @@ mongoc_cmd_parts_set_read_concern (mongoc_cmd_parts_t *parts, const mongoc_read_
       RETURN (true);
    }
 
-   bson_destroy (&parts->read_concern_document);
-   bson_copy_to (_mongoc_read_concern_get_bson ((mongoc_read_concern_t *) rc), &parts->read_concern_document);
+   _mongoc_cmd_parts_copy_to (
+      parts, _mongoc_read_concern_get_bson ((mongoc_read_concern_t *) rc), &parts->read_concern_document);
 
    RETURN (true);
 }
@@ -237,8 +287,8 @@ mongoc_cmd_parts_set_write_concern (mongoc_cmd_parts_t *parts, const mongoc_writ
    }
 
    parts->assembled.is_acknowledged = mongoc_write_concern_is_acknowledged (wc);
-   bson_destroy (&parts->write_concern_document);
-   bson_copy_to (_mongoc_write_concern_get_bson ((mongoc_write_concern_t *) wc), &parts->write_concern_document);
+   _mongoc_cmd_parts_copy_to (
+      parts, _mongoc_write_concern_get_bson ((mongoc_write_concern_t *) wc), &parts->write_concern_document);
 
    RETURN (true);
 }
@@ -284,8 +334,7 @@ mongoc_cmd_parts_append_read_write (mongoc_cmd_parts_t *parts, mongoc_read_write
    /* process explicit read concern */
    if (!bson_empty (&rw_opts->readConcern)) {
       /* save readConcern for later, once we know about causal consistency */
-      bson_destroy (&parts->read_concern_document);
-      bson_copy_to (&rw_opts->readConcern, &parts->read_concern_document);
+      _mongoc_cmd_parts_copy_to (parts, &rw_opts->readConcern, &parts->read_concern_document);
    }
 
    if (rw_opts->client_session) {
@@ -699,6 +748,7 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts, mongoc_server_stream_t *se
    mongoc_server_description_type_t server_type;
    mongoc_client_session_t *cs;
    const bson_t *cluster_time = NULL;
+   mongoc_shared_ptr topology_cluster_time = MONGOC_SHARED_PTR_NULL;
    mongoc_read_prefs_t *prefs = NULL;
    const char *cmd_name;
    bool is_get_more;
@@ -843,9 +893,10 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts, mongoc_server_stream_t *se
          parts->is_retryable_read = true;
       }
 
-      if (!bson_empty (&server_stream->cluster_time)) {
-         cluster_time = _largest_cluster_time (&server_stream->cluster_time, cluster_time);
-      }
+      /* Read the cluster time from the topology rather than its description,
+       * which is not copied when the cluster time advances. */
+      topology_cluster_time = _mongoc_topology_get_cluster_time (parts->client->topology);
+      cluster_time = _largest_cluster_time (topology_cluster_time.ptr, cluster_time);
 
       if (cluster_time && server_type != MONGOC_SERVER_STANDALONE) {
          _mongoc_cmd_parts_ensure_copied (parts);
@@ -902,6 +953,7 @@ mongoc_cmd_parts_assemble (mongoc_cmd_parts_t *parts, mongoc_server_stream_t *se
    }
 
 done:
+   mongoc_shared_ptr_reset_null (&topology_cluster_time);
    mongoc_read_prefs_destroy (prefs);
    RETURN (ret);
 }
@@ -22,6 +22,8 @@
 
 #include <bson/bson.h>
 
+#include <mongoc/mongoc-iovec.h>
+
 /* Compressor IDs */
 #define MONGOC_COMPRESSOR_NOOP_ID 0
 #define MONGOC_COMPRESSOR_NOOP_STR "noop"
@@ -38,6 +40,16 @@
 
 BSON_BEGIN_DECLS
 
+/* Compressor and decompressor state reused across messages to avoid
+ * allocating it anew for every message. Members are created on first use.
+ * A context must not be used by more than one thread at a time. */
+typedef struct _mongoc_compression_ctx_t mongoc_compression_ctx_t;
+
+mongoc_compression_ctx_t *
+mongoc_compression_ctx_new (void);
+
+void
+mongoc_compression_ctx_destroy (mongoc_compression_ctx_t *ctx);
 
 size_t
 mongoc_compressor_max_compressed_length (int32_t compressor_id, size_t size);
@@ -51,8 +63,11 @@ mongoc_compressor_id_to_name (int32_t compressor_id);
 int
 mongoc_compressor_name_to_id (const char *compressor);
 
+/* @ctx may be NULL, in which case decompressor state is created for this call
+ * only. */
 bool
-mongoc_uncompress (int32_t compressor_id,
+mongoc_uncompress (mongoc_compression_ctx_t *ctx,
+                   int32_t compressor_id,
                    const uint8_t *compressed,
                    size_t compressed_len,
                    uint8_t *uncompressed,
@@ -66,6 +81,20 @@ mongoc_compress (int32_t compressor_id,
                  char *compressed,
                  size_t *compressed_len);
 
+/* Compresses the concatenation of @iov into @compressed without first copying
+ * the input into a contiguous buffer where the compressor supports it.
+ * @compressed_len must be at least mongoc_compressor_max_compressed_length ()
+ * of the total input length. @ctx may be NULL, in which case compressor state is
+ * created for this call only. */
+bool
+mongoc_compress_iovec (mongoc_compression_ctx_t *ctx,
+                       int32_t compressor_id,
+                       int32_t compression_level,
+                       const mongoc_iovec_t *iov,
+                       size_t iovcnt,
+                       char *compressed,
+                       size_t *compressed_len);
+
 BSON_END_DECLS
 
 #endif
@@ -34,6 +34,110 @@
 #endif
 #endif
 
+struct _mongoc_compression_ctx_t {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   z_stream deflate_stream;
+   bool deflate_initialized;
+   int32_t deflate_level;
+   z_stream inflate_stream;
+   bool inflate_initialized;
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   ZSTD_CCtx *zstd_cctx;
+   ZSTD_DCtx *zstd_dctx;
+#endif
+   // Keeps the struct non-empty when no compressor is compiled in.
+   bool unused;
+};
+
+mongoc_compression_ctx_t *
+mongoc_compression_ctx_new (void)
+{
+   return bson_malloc0 (sizeof (mongoc_compression_ctx_t));
+}
+
+void
+mongoc_compression_ctx_destroy (mongoc_compression_ctx_t *ctx)
+{
+   if (!ctx) {
+      return;
+   }
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   if (ctx->deflate_initialized) {
+      deflateEnd (&ctx->deflate_stream);
+   }
+
+   if (ctx->inflate_initialized) {
+      inflateEnd (&ctx->inflate_stream);
+   }
+#endif
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   ZSTD_freeCCtx (ctx->zstd_cctx);
+   ZSTD_freeDCtx (ctx->zstd_dctx);
+#endif
+
+   bson_free (ctx);
+}
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+/* Returns the deflate stream of @ctx ready to compress a new message at
+ * @compression_level, initializing it on first use. */
+static z_stream *
+_mongoc_compression_ctx_deflate (mongoc_compression_ctx_t *ctx, int32_t compression_level)
+{
+   if (ctx->deflate_initialized) {
+      if (ctx->deflate_level == compression_level) {
+         return deflateReset (&ctx->deflate_stream) == Z_OK ? &ctx->deflate_stream : NULL;
+      }
+
+      deflateEnd (&ctx->deflate_stream);
+      ctx->deflate_initialized = false;
+   }
+
+   memset (&ctx->deflate_stream, 0, sizeof ctx->deflate_stream);
+
+   if (deflateInit (&ctx->deflate_stream, compression_level) != Z_OK) {
+      return NULL;
+   }
+
+   ctx->deflate_initialized = true;
+   ctx->deflate_level = compression_level;
+
+   return &ctx->deflate_stream;
+}
+
+/* Returns the inflate stream of @ctx ready to decompress a new message,
+ * initializing it on first use. */
+static z_stream *
+_mongoc_compression_ctx_inflate (mongoc_compression_ctx_t *ctx)
+{
+   if (ctx->inflate_initialized) {
+      return inflateReset (&ctx->inflate_stream) == Z_OK ? &ctx->inflate_stream : NULL;
+   }
+
+   memset (&ctx->inflate_stream, 0, sizeof ctx->inflate_stream);
+
+   if (inflateInit (&ctx->inflate_stream) != Z_OK) {
+      return NULL;
+   }
+
+   ctx->inflate_initialized = true;
+
+   return &ctx->inflate_stream;
+}
+#endif
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+// zstd treats level 0 as its default level.
+static int
+_mongoc_zstd_level (int32_t compression_level)
+{
+   return compression_level < 0 ? 0 : (int) compression_level;
+}
+#endif
+
 size_t
 mongoc_compressor_max_compressed_length (int32_t compressor_id, size_t len)
 {
@@ -142,7 +246,8 @@ mongoc_compressor_name_to_id (const char *compressor)
 BSON_STATIC_ASSERT2 (size_t_gte_ulong, SIZE_MAX >= ULONG_MAX);
 
 bool
-mongoc_uncompress (int32_t compressor_id,
+mongoc_uncompress (mongoc_compression_ctx_t *ctx,
+                   int32_t compressor_id,
                    const uint8_t *compressed,
                    size_t compressed_len,
                    uint8_t *uncompressed,
@@ -180,16 +285,42 @@ mongoc_uncompress (int32_t compressor_id,
          return false;
       }
 
-      uLong actual_uncompressed_len = (uLong) *uncompressed_len;
+      if (!ctx) {
+         uLong actual_uncompressed_len = (uLong) *uncompressed_len;
+
+         const int res =
+            uncompress (uncompressed, &actual_uncompressed_len, (const Bytef *) compressed, (uLong) compressed_len);
+
+         if (BSON_UNLIKELY (res != Z_OK)) {
+            return false;
+         }
+
+         *uncompressed_len = (size_t) actual_uncompressed_len;
+
+         return true;
+      }
+
+      // Malformed message: unrepresentable.
+      if (BSON_UNLIKELY (!mlib_in_range (uInt, compressed_len) || !mlib_in_range (uInt, *uncompressed_len))) {
+         return false;
+      }
+
+      z_stream *const strm = _mongoc_compression_ctx_inflate (ctx);
+
+      if (!strm) {
+         return false;
+      }
 
-      const int res =
-         uncompress (uncompressed, &actual_uncompressed_len, (const Bytef *) compressed, (uLong) compressed_len);
+      strm->next_in = (Bytef *) compressed;
+      strm->avail_in = (uInt) compressed_len;
+      strm->next_out = (Bytef *) uncompressed;
+      strm->avail_out = (uInt) *uncompressed_len;
 
-      if (BSON_UNLIKELY (res != Z_OK)) {
+      if (BSON_UNLIKELY (inflate (strm, Z_FINISH) != Z_STREAM_END)) {
          return false;
       }
 
-      *uncompressed_len = (size_t) actual_uncompressed_len;
+      *uncompressed_len = (size_t) strm->total_out;
 
       return true;
 #else
@@ -201,7 +332,13 @@ mongoc_uncompress (int32_t compressor_id,
 
    case MONGOC_COMPRESSOR_ZSTD_ID: {
 #ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
-      const size_t res = ZSTD_decompress (uncompressed, *uncompressed_len, compressed, compressed_len);
+      size_t res;
+
+      if (ctx && (ctx->zstd_dctx || (ctx->zstd_dctx = ZSTD_createDCtx ()))) {
+         res = ZSTD_decompressDCtx (ctx->zstd_dctx, uncompressed, *uncompressed_len, compressed, compressed_len);
+      } else {
+         res = ZSTD_decompress (uncompressed, *uncompressed_len, compressed, compressed_len);
+      }
 
       if (BSON_UNLIKELY (ZSTD_isError (res))) {
          return false;
@@ -268,9 +405,13 @@ mongoc_compress (int32_t compressor_id,
 
    case MONGOC_COMPRESSOR_ZSTD_ID: {
 #ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
-      int ok;
+      size_t ok;
 
-      ok = ZSTD_compress ((void *) compressed, *compressed_len, (const void *) uncompressed, uncompressed_len, 0);
+      ok = ZSTD_compress ((void *) compressed,
+                          *compressed_len,
+                          (const void *) uncompressed,
+                          uncompressed_len,
+                          _mongoc_zstd_level (compression_level));
 
       if (!ZSTD_isError (ok)) {
          *compressed_len = ok;
@@ -291,3 +432,210 @@ mongoc_compress (int32_t compressor_id,
       return false;
    }
 }
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+static bool
+_mongoc_compress_iovec_zlib (
+   z_stream *strm, const mongoc_iovec_t *iov, size_t iovcnt, char *compressed, size_t *compressed_len)
+{
+   if (!mlib_in_range (uInt, *compressed_len)) {
+      return false;
+   }
+
+   strm->next_out = (Bytef *) compressed;
+   strm->avail_out = (uInt) *compressed_len;
+
+   for (size_t i = 0u; i < iovcnt; i++) {
+      // deflate returns Z_BUF_ERROR when it can make no progress, as with an empty segment.
+      if (iov[i].iov_len == 0u) {
+         continue;
+      }
+
+      BSON_ASSERT (mlib_in_range (uInt, iov[i].iov_len));
+
+      strm->next_in = (Bytef *) iov[i].iov_base;
+      strm->avail_in = (uInt) iov[i].iov_len;
+
+      // The output buffer is sized by compressBound, so each segment is consumed in a single call.
+      if (deflate (strm, Z_NO_FLUSH) != Z_OK || strm->avail_in != 0u) {
+         return false;
+      }
+   }
+
+   if (deflate (strm, Z_FINISH) != Z_STREAM_END) {
+      return false;
+   }
+
+   *compressed_len = (size_t) strm->total_out;
+
+   return true;
+}
+#endif
+
+#if defined(MONGOC_ENABLE_COMPRESSION_ZSTD) && ZSTD_VERSION_NUMBER >= 10400
+static bool
+_mongoc_compress_iovec_zstd (ZSTD_CCtx *cctx,
+                             int32_t compression_level,
+                             const mongoc_iovec_t *iov,
+                             size_t iovcnt,
+                             char *compressed,
+                             size_t *compressed_len)
+{
+   size_t total_len = 0u;
+   size_t res;
+   ZSTD_outBuffer out = {compressed, *compressed_len, 0u};
+   ZSTD_inBuffer in;
+
+   for (size_t i = 0u; i < iovcnt; i++) {
+      total_len += iov[i].iov_len;
+   }
+
+   // Discard any state left by a previous message; parameters are set again below.
+   if (ZSTD_isError (ZSTD_CCtx_reset (cctx, ZSTD_reset_session_only)) ||
+       ZSTD_isError (ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel, _mongoc_zstd_level (compression_level)))) {
+      return false;
+   }
+
+   // Record the content size in the frame header as ZSTD_compress does.
+   if (ZSTD_isError (ZSTD_CCtx_setPledgedSrcSize (cctx, total_len))) {
+      return false;
+   }
+
+   for (size_t i = 0u; i < iovcnt; i++) {
+      in.src = iov[i].iov_base;
+      in.size = iov[i].iov_len;
+      in.pos = 0u;
+
+      while (in.pos < in.size) {
+         res = ZSTD_compressStream2 (cctx, &out, &in, ZSTD_e_continue);
+
+         if (ZSTD_isError (res) || (out.pos == out.size && in.pos < in.size)) {
+            return false;
+         }
+      }
+   }
+
+   in.src = NULL;
+   in.size = 0u;
+   in.pos = 0u;
+
+   do {
+      res = ZSTD_compressStream2 (cctx, &out, &in, ZSTD_e_end);
+
+      if (ZSTD_isError (res) || (res != 0u && out.pos == out.size)) {
+         return false;
+      }
+   } while (res != 0u);
+
+   *compressed_len = out.pos;
+
+   return true;
+}
+#endif
+
+bool
+mongoc_compress_iovec (mongoc_compression_ctx_t *ctx,
+                       int32_t compressor_id,
+                       int32_t compression_level,
+                       const mongoc_iovec_t *iov,
+                       size_t iovcnt,
+                       char *compressed,
+                       size_t *compressed_len)
+{
+   BSON_ASSERT_PARAM (iov);
+   BSON_ASSERT_PARAM (compressed);
+   BSON_ASSERT_PARAM (compressed_len);
+
+   TRACE ("Compressing iovecs with '%s' (%d)", mongoc_compressor_id_to_name (compressor_id), compressor_id);
+
+   switch (compressor_id) {
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   case MONGOC_COMPRESSOR_ZLIB_ID: {
+      if (ctx) {
+         z_stream *const strm = _mongoc_compression_ctx_deflate (ctx, compression_level);
+
+         return strm && _mongoc_compress_iovec_zlib (strm, iov, iovcnt, compressed, compressed_len);
+      }
+
+      z_stream strm;
+
+      memset (&strm, 0, sizeof strm);
+
+      if (deflateInit (&strm, compression_level) != Z_OK) {
+         return false;
+      }
+
+      const bool ret = _mongoc_compress_iovec_zlib (&strm, iov, iovcnt, compressed, compressed_len);
+
+      deflateEnd (&strm);
+
+      return ret;
+   }
+#endif
+
+#if defined(MONGOC_ENABLE_COMPRESSION_ZSTD) && ZSTD_VERSION_NUMBER >= 10400
+   case MONGOC_COMPRESSOR_ZSTD_ID: {
+      if (ctx) {
+         if (!ctx->zstd_cctx && !(ctx->zstd_cctx = ZSTD_createCCtx ())) {
+            return false;
+         }
+
+         return _mongoc_compress_iovec_zstd (
+            ctx->zstd_cctx, compression_level, iov, iovcnt, compressed, compressed_len);
+      }
+
+      ZSTD_CCtx *const cctx = ZSTD_createCCtx ();
+
+      if (!cctx) {
+         return false;
+      }
+
+      const bool ret = _mongoc_compress_iovec_zstd (cctx, compression_level, iov, iovcnt, compressed, compressed_len);
+
+      ZSTD_freeCCtx (cctx);
+
+      return ret;
+   }
+#endif
+
+   case MONGOC_COMPRESSOR_NOOP_ID: {
+      size_t offset = 0u;
+
+      for (size_t i = 0u; i < iovcnt; i++) {
+         if (iov[i].iov_len > *compressed_len - offset) {
+            return false;
+         }
+
+         memcpy (compressed + offset, iov[i].iov_base, iov[i].iov_len);
+         offset += iov[i].iov_len;
+      }
+
+      *compressed_len = offset;
+      return true;
+   }
+
+   default: {
+      // snappy-c has no scatter/gather interface: linearize the input first.
+      size_t uncompressed_len = 0u;
+
+      for (size_t i = 0u; i < iovcnt; i++) {
+         uncompressed_len += iov[i].iov_len;
+      }
+
+      char *const uncompressed = bson_malloc (uncompressed_len);
+      size_t offset = 0u;
+
+      for (size_t i = 0u; i < iovcnt; i++) {
+         memcpy (uncompressed + offset, iov[i].iov_base, iov[i].iov_len);
+         offset += iov[i].iov_len;
+      }
+
+      const bool ret =
+         mongoc_compress (compressor_id, compression_level, uncompressed, uncompressed_len, compressed, compressed_len);
+
+      bson_free (uncompressed);
+
+      return ret;
+   }
+   }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc-prelude.h>
+
+#ifndef MONGOC_CONNECTION_POOL_PRIVATE_H
+#define MONGOC_CONNECTION_POOL_PRIVATE_H
+
+#include <bson/bson.h>
+
+#include <mongoc/mongoc-array-private.h>
+#include <mongoc/mongoc-topology-description-private.h>
+#include <mongoc/mongoc-uri.h>
+
+BSON_BEGIN_DECLS
+
+/* Default for MONGOC_URI_MAXCONNECTING, from the Connection Monitoring and
+ * Pooling spec. */
+#define MONGOC_CONNECTION_POOL_MAX_CONNECTING_DEFAULT 2
+
+/* Idle connections are closed once unused for this long. */
+#define MONGOC_CONNECTION_POOL_MAX_IDLE_USEC (60 * 1000 * 1000)
+
+struct _mongoc_cluster_node_t;
+
+/* mongoc_connection_pool_t holds the idle connections of the clients in a
+ * mongoc_client_pool_t created with MONGOC_URI_SHAREDCONNECTIONPOOL, keyed by
+ * server id. A pooled client returns its connections here when it is pushed
+ * back to the client pool, and its cluster borrows one before establishing a
+ * new connection. It is thread-safe. */
+typedef struct _mongoc_connection_pool_t mongoc_connection_pool_t;
+
+mongoc_connection_pool_t *
+mongoc_connection_pool_new (const mongoc_uri_t *uri);
+
+void
+mongoc_connection_pool_destroy (mongoc_connection_pool_t *pool);
+
+/* Returns the most recently used idle connection to @server_id that is not
+ * stale in @td. If there is none, returns NULL and sets @may_connect to true if
+ * fewer than maxConnecting connections to @server_id are being established, in
+ * which case the caller must call mongoc_connection_pool_connect_done once
+ * done connecting. Otherwise waits for either to happen, for at most
+ * waitQueueTimeoutMS, or serverSelectionTimeoutMS if it is unset. On timeout
+ * returns NULL, leaves @may_connect false, and sets @error. */
+struct _mongoc_cluster_node_t *
+mongoc_connection_pool_checkout (mongoc_connection_pool_t *pool,
+                                 const mongoc_topology_description_t *td,
+                                 uint32_t server_id,
+                                 bool *may_connect,
+                                 bson_error_t *error);
+
+void
+mongoc_connection_pool_connect_done (mongoc_connection_pool_t *pool, uint32_t server_id);
+
+/* Takes ownership of @node, an established connection to @server_id. */
+void
+mongoc_connection_pool_checkin (mongoc_connection_pool_t *pool,
+                                uint32_t server_id,
+                                struct _mongoc_cluster_node_t *node);
+
+/* Closes idle connections to servers not in @known_server_ids, a sorted array
+ * of uint32_t. */
+void
+mongoc_connection_pool_prune (mongoc_connection_pool_t *pool, const mongoc_array_t *known_server_ids);
+
+/* Returns true if fewer than @min_idle connections to @server_id are idle or
+ * being established, and fewer than maxConnecting are being established. The
+ * caller must then establish one connection, check it in if it succeeded, and
+ * call mongoc_connection_pool_connect_done. */
+bool
+mongoc_connection_pool_begin_prewarm (mongoc_connection_pool_t *pool, uint32_t server_id, int32_t min_idle);
+
+/* Closes idle connections that are expired, stale in @td, or to servers not in
+ * @td. */
+void
+mongoc_connection_pool_discard_stale (mongoc_connection_pool_t *pool, const mongoc_topology_description_t *td);
+
+/* for tests */
+size_t
+mongoc_connection_pool_num_idle (mongoc_connection_pool_t *pool, uint32_t server_id);
+
+BSON_END_DECLS
+
+#endif /* MONGOC_CONNECTION_POOL_PRIVATE_H */
@@ -0,0 +1,381 @@
+/*
+ * Copyright 2009-present MongoDB, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <mongoc/mongoc-connection-pool-private.h>
+
+#include <mongoc/mongoc-cluster-private.h>
+#include <mongoc/mongoc-error-private.h>
+#include <mongoc/mongoc-set-private.h>
+#include <mongoc/mongoc-thread-private.h>
+#include <mongoc/mongoc-topology-private.h>
+#include <mongoc/mongoc-trace-private.h>
+
+#undef MONGOC_LOG_DOMAIN
+#define MONGOC_LOG_DOMAIN "connection-pool"
+
+typedef struct {
+   mongoc_cluster_node_t *node;
+   int64_t last_used_usec;
+} idle_connection_t;
+
+typedef struct {
+   // A stack of idle_connection_t: the most recently used connection is last.
+   mongoc_array_t idle;
+   // The number of connections to this server being established.
+   int32_t connecting;
+} server_pool_t;
+
+struct _mongoc_connection_pool_t {
+   bson_mutex_t mutex;
+   // Signaled when a connection is checked in or finishes connecting.
+   mongoc_cond_t cond;
+   // Maps a server id to its server_pool_t.
+   mongoc_set_t *servers;
+   int32_t max_connecting;
+   // How long mongoc_connection_pool_checkout waits for a connection.
+   int64_t wait_queue_timeout_msec;
+};
+
+static void
+_server_pool_dtor (void *item, void *ctx)
+{
+   server_pool_t *const server_pool = (server_pool_t *) item;
+
+   BSON_UNUSED (ctx);
+
+   for (size_t i = 0u; i < server_pool->idle.len; i++) {
+      _mongoc_cluster_node_destroy (_mongoc_array_index (&server_pool->idle, idle_connection_t, i).node);
+   }
+
+   _mongoc_array_destroy (&server_pool->idle);
+   bson_free (server_pool);
+}
+
+/* This function assumes the pool's mutex is locked. */
+static server_pool_t *
+_server_pool_get (mongoc_connection_pool_t *pool, uint32_t server_id)
+{
+   server_pool_t *server_pool = (server_pool_t *) mongoc_set_get (pool->servers, server_id);
+
+   if (!server_pool) {
+      server_pool = (server_pool_t *) bson_malloc0 (sizeof *server_pool);
+      _mongoc_array_init (&server_pool->idle, sizeof (idle_connection_t));
+      mongoc_set_add (pool->servers, server_id, server_pool);
+   }
+
+   return server_pool;
+}
+
+/* Moves connections idle for longer than MONGOC_CONNECTION_POOL_MAX_IDLE_USEC
+ * to @discarded. The least recently used connections are first in the stack.
+ * This function assumes the pool's mutex is locked. */
+static void
+_server_pool_reap (server_pool_t *server_pool, int64_t now_usec, mongoc_array_t *discarded)
+{
+   size_t expired = 0u;
+
+   while (expired < server_pool->idle.len &&
+          now_usec - _mongoc_array_index (&server_pool->idle, idle_connection_t, expired).last_used_usec >
+             MONGOC_CONNECTION_POOL_MAX_IDLE_USEC) {
+      _mongoc_array_append_val (discarded, _mongoc_array_index (&server_pool->idle, idle_connection_t, expired).node);
+      expired++;
+   }
+
+   if (expired > 0u) {
+      memmove (server_pool->idle.data,
+               (idle_connection_t *) server_pool->idle.data + expired,
+               (server_pool->idle.len - expired) * sizeof (idle_connection_t));
+      server_pool->idle.len -= expired;
+   }
+}
+
+/* Closes the connections in @discarded, outside of the pool's mutex. */
+static void
+_destroy_discarded (mongoc_array_t *discarded)
+{
+   for (size_t i = 0u; i < discarded->len; i++) {
+      _mongoc_cluster_node_destroy (_mongoc_array_index (discarded, mongoc_cluster_node_t *, i));
+   }
+
+   _mongoc_array_destroy (discarded);
+}
+
+mongoc_connection_pool_t *
+mongoc_connection_pool_new (const mongoc_uri_t *uri)
+{
+   BSON_ASSERT_PARAM (uri);
+
+   mongoc_connection_pool_t *const pool = (mongoc_connection_pool_t *) bson_malloc0 (sizeof *pool);
+
+   bson_mutex_init (&pool->mutex);
+   mongoc_cond_init (&pool->cond);
+   pool->servers = mongoc_set_new (8, _server_pool_dtor, NULL);
+   pool->max_connecting =
+      mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_MAXCONNECTING, MONGOC_CONNECTION_POOL_MAX_CONNECTING_DEFAULT);
+   pool->wait_queue_timeout_msec = mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_WAITQUEUETIMEOUTMS, -1);
+   if (pool->wait_queue_timeout_msec <= 0) {
+      pool->wait_queue_timeout_msec = mongoc_uri_get_option_as_int32 (
+         uri, MONGOC_URI_SERVERSELECTIONTIMEOUTMS, MONGOC_TOPOLOGY_SERVER_SELECTION_TIMEOUT_MS);
+   }
+
+   return pool;
+}
+
+void
+mongoc_connection_pool_destroy (mongoc_connection_pool_t *pool)
+{
+   if (!pool) {
+      return;
+   }
+
+   mongoc_set_destroy (pool->servers);
+   mongoc_cond_destroy (&pool->cond);
+   bson_mutex_destroy (&pool->mutex);
+   bson_free (pool);
+}
+
+mongoc_cluster_node_t *
+mongoc_connection_pool_checkout (mongoc_connection_pool_t *pool,
+                                 const mongoc_topology_description_t *td,
+                                 uint32_t server_id,
+                                 bool *may_connect,
+                                 bson_error_t *error)
+{
+   BSON_ASSERT_PARAM (pool);
+   BSON_ASSERT_PARAM (td);
+   BSON_ASSERT_PARAM (may_connect);
+
+   ENTRY;
+
+   const bool server_exists = mongoc_topology_description_server_by_id_const (td, server_id, NULL) != NULL;
+   const int64_t expire_at_msec = bson_get_monotonic_time () / 1000 + pool->wait_queue_timeout_msec;
+   mongoc_cluster_node_t *node = NULL;
+   mongoc_array_t discarded;
+
+   _mongoc_array_init (&discarded, sizeof (mongoc_cluster_node_t *));
+   *may_connect = false;
+
+   bson_mutex_lock (&pool->mutex);
+
+   for (;;) {
+      // Look the server up again after waiting: mongoc_connection_pool_prune may have removed it.
+      server_pool_t *const server_pool = _server_pool_get (pool, server_id);
+
+      _server_pool_reap (server_pool, bson_get_monotonic_time (), &discarded);
+
+      while (!node && server_pool->idle.len > 0u) {
+         mongoc_cluster_node_t *const candidate =
+            _mongoc_array_index (&server_pool->idle, idle_connection_t, server_pool->idle.len - 1u).node;
+
+         server_pool->idle.len--;
+
+         // Connections created before the pool to this server was cleared are stale.
+         if (server_exists &&
+             candidate->handshake_sd->generation >=
+                _mongoc_topology_get_connection_pool_generation (td, server_id, &candidate->handshake_sd->service_id)) {
+            node = candidate;
+         } else {
+            _mongoc_array_append_val (&discarded, candidate);
+         }
+      }
+
+      if (node) {
+         break;
+      }
+
+      if (server_pool->connecting < pool->max_connecting) {
+         server_pool->connecting++;
+         *may_connect = true;
+         break;
+      }
+
+      const int64_t now_msec = bson_get_monotonic_time () / 1000;
+
+      if (now_msec >= expire_at_msec ||
+          mongo_cond_ret_is_timedout (mongoc_cond_timedwait (&pool->cond, &pool->mutex, expire_at_msec - now_msec))) {
+         _mongoc_set_error (error,
+                            MONGOC_ERROR_SERVER_SELECTION,
+                            MONGOC_ERROR_SERVER_SELECTION_FAILURE,
+                            "Timed out after %" PRId64 "ms waiting for a connection to server %" PRIu32,
+                            pool->wait_queue_timeout_msec,
+                            server_id);
+         break;
+      }
+   }
+
+   bson_mutex_unlock (&pool->mutex);
+
+   _destroy_discarded (&discarded);
+
+   RETURN (node);
+}
+
+void
+mongoc_connection_pool_connect_done (mongoc_connection_pool_t *pool, uint32_t server_id)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   bson_mutex_lock (&pool->mutex);
+   server_pool_t *const server_pool = _server_pool_get (pool, server_id);
+   BSON_ASSERT (server_pool->connecting > 0);
+   server_pool->connecting--;
+   mongoc_cond_broadcast (&pool->cond);
+   bson_mutex_unlock (&pool->mutex);
+}
+
+void
+mongoc_connection_pool_checkin (mongoc_connection_pool_t *pool, uint32_t server_id, mongoc_cluster_node_t *node)
+{
+   BSON_ASSERT_PARAM (pool);
+   BSON_ASSERT_PARAM (node);
+
+   const int64_t now_usec = bson_get_monotonic_time ();
+   const idle_connection_t idle = {.node = node, .last_used_usec = now_usec};
+   mongoc_array_t discarded;
+
+   _mongoc_array_init (&discarded, sizeof (mongoc_cluster_node_t *));
+
+   bson_mutex_lock (&pool->mutex);
+   server_pool_t *const server_pool = _server_pool_get (pool, server_id);
+   _server_pool_reap (server_pool, now_usec, &discarded);
+   _mongoc_array_append_val (&server_pool->idle, idle);
+   mongoc_cond_broadcast (&pool->cond);
+   bson_mutex_unlock (&pool->mutex);
+
+   _destroy_discarded (&discarded);
+}
+
+static int
+_server_id_cmp (const void *a_, const void *b_)
+{
+   const uint32_t a = *(const uint32_t *) a_;
+   const uint32_t b = *(const uint32_t *) b_;
+
+   return a == b ? 0 : (a < b ? -1 : 1);
+}
+
+void
+mongoc_connection_pool_prune (mongoc_connection_pool_t *pool, const mongoc_array_t *known_server_ids)
+{
+   BSON_ASSERT_PARAM (pool);
+   BSON_ASSERT_PARAM (known_server_ids);
+
+   mongoc_array_t discarded;
+
+   _mongoc_array_init (&discarded, sizeof (mongoc_cluster_node_t *));
+
+   bson_mutex_lock (&pool->mutex);
+
+   for (size_t i = pool->servers->items_len; i > 0u; i--) {
+      uint32_t server_id;
+      server_pool_t *const server_pool = mongoc_set_get_item_and_id (pool->servers, i - 1u, &server_id);
+
+      if (bsearch (&server_id, known_server_ids->data, known_server_ids->len, sizeof (uint32_t), _server_id_cmp)) {
+         continue;
+      }
+
+      for (size_t j = 0u; j < server_pool->idle.len; j++) {
+         _mongoc_array_append_val (&discarded, _mongoc_array_index (&server_pool->idle, idle_connection_t, j).node);
+      }
+      server_pool->idle.len = 0u;
+
+      // Keep the entry while connections are being established so their connect_done finds it.
+      if (server_pool->connecting == 0) {
+         mongoc_set_rm (pool->servers, server_id);
+      }
+   }
+
+   bson_mutex_unlock (&pool->mutex);
+
+   _destroy_discarded (&discarded);
+}
+
+bool
+mongoc_connection_pool_begin_prewarm (mongoc_connection_pool_t *pool, uint32_t server_id, int32_t min_idle)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   bool begin = false;
+
+   bson_mutex_lock (&pool->mutex);
+   server_pool_t *const server_pool = _server_pool_get (pool, server_id);
+   if ((int64_t) server_pool->idle.len + server_pool->connecting < min_idle &&
+       server_pool->connecting < pool->max_connecting) {
+      server_pool->connecting++;
+      begin = true;
+   }
+   bson_mutex_unlock (&pool->mutex);
+
+   return begin;
+}
+
+void
+mongoc_connection_pool_discard_stale (mongoc_connection_pool_t *pool, const mongoc_topology_description_t *td)
+{
+   BSON_ASSERT_PARAM (pool);
+   BSON_ASSERT_PARAM (td);
+
+   const int64_t now_usec = bson_get_monotonic_time ();
+   mongoc_array_t discarded;
+
+   _mongoc_array_init (&discarded, sizeof (mongoc_cluster_node_t *));
+
+   bson_mutex_lock (&pool->mutex);
+
+   for (size_t i = pool->servers->items_len; i > 0u; i--) {
+      uint32_t server_id;
+      server_pool_t *const server_pool = mongoc_set_get_item_and_id (pool->servers, i - 1u, &server_id);
+      const bool server_exists = mongoc_topology_description_server_by_id_const (td, server_id, NULL) != NULL;
+      size_t kept = 0u;
+
+      _server_pool_reap (server_pool, now_usec, &discarded);
+
+      // Compact the stack in place, preserving the order of the connections kept.
+      for (size_t j = 0u; j < server_pool->idle.len; j++) {
+         const idle_connection_t idle = _mongoc_array_index (&server_pool->idle, idle_connection_t, j);
+
+         if (server_exists &&
+             idle.node->handshake_sd->generation >=
+                _mongoc_topology_get_connection_pool_generation (td, server_id, &idle.node->handshake_sd->service_id)) {
+            _mongoc_array_index (&server_pool->idle, idle_connection_t, kept++) = idle;
+         } else {
+            _mongoc_array_append_val (&discarded, idle.node);
+         }
+      }
+      server_pool->idle.len = kept;
+
+      if (!server_exists && server_pool->connecting == 0) {
+         mongoc_set_rm (pool->servers, server_id);
+      }
+   }
+
+   bson_mutex_unlock (&pool->mutex);
+
+   _destroy_discarded (&discarded);
+}
+
+size_t
+mongoc_connection_pool_num_idle (mongoc_connection_pool_t *pool, uint32_t server_id)
+{
+   BSON_ASSERT_PARAM (pool);
+
+   bson_mutex_lock (&pool->mutex);
+   const server_pool_t *const server_pool = (const server_pool_t *) mongoc_set_get (pool->servers, server_id);
+   const size_t num_idle = server_pool ? server_pool->idle.len : 0u;
+   bson_mutex_unlock (&pool->mutex);
+
+   return num_idle;
+}
@@ -29,12 +29,14 @@ _prime (mongoc_cursor_t *cursor)
    data_find_cmd_t *data = (data_find_cmd_t *) cursor->impl.data;
    bson_t find_cmd;
 
-   bson_init (&find_cmd);
+   /* the command is only needed until the reply is read */
+   bson_init_arena (&find_cmd, _mongoc_client_acquire_arena (cursor->client));
    cursor->operation_id = ++cursor->client->cluster.operation_id;
    /* construct { find: "<collection>", filter: {<filter>} } */
    _mongoc_cursor_prepare_find_command (cursor, &data->filter, &find_cmd);
    _mongoc_cursor_response_refresh (cursor, &find_cmd, &cursor->opts, &data->response);
    bson_destroy (&find_cmd);
+   _mongoc_client_release_arena (cursor->client);
    return IN_BATCH;
 }
 
@@ -19,6 +19,7 @@
 #include <mongoc/mongoc-cursor-private.h>
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-client-session-private.h>
+#include <mongoc/mongoc-cmd-template-private.h>
 #include <mongoc/mongoc-counters-private.h>
 #include <mongoc/mongoc-error-private.h>
 #include <mongoc/mongoc-log.h>
@@ -963,7 +964,10 @@ _mongoc_cursor_run_command (
 
    const char *cmd_name = _mongoc_get_command_name (command);
 
+   bson_arena_t *const arena = _mongoc_client_acquire_arena (cursor->client);
+
    mongoc_cmd_parts_init (&parts, cursor->client, db, MONGOC_QUERY_NONE, command);
+   mongoc_cmd_parts_set_arena (&parts, arena);
    parts.is_read_command = true;
    parts.read_prefs = cursor->read_prefs;
    parts.assembled.operation_id = cursor->operation_id;
@@ -1017,7 +1021,9 @@ _mongoc_cursor_run_command (
       GOTO (done);
    }
 
-   db = bson_strndup (cursor->ns, cursor->dblen);
+   db = bson_arena_alloc (arena, cursor->dblen + 1u);
+   memcpy (db, cursor->ns, cursor->dblen);
+   db[cursor->dblen] = '\0';
    parts.assembled.db_name = db;
 
    {
@@ -1147,7 +1153,8 @@ done:
    mongoc_server_stream_cleanup (server_stream);
    mongoc_cmd_parts_cleanup (&parts);
    mongoc_read_prefs_destroy (prefs);
-   bson_free (db);
+   /* release the assembled command and the other temporaries at once */
+   _mongoc_client_release_arena (cursor->client);
 
    return ret;
 }
@@ -1735,14 +1742,20 @@ _mongoc_cursor_prepare_getmore_command (mongoc_cursor_t *cursor, bson_t *command
    bson_iter_t iter;
    bool await_data;
    int64_t max_await_time_ms;
+   bson_value_t values[2];
 
    ENTRY;
 
    _mongoc_cursor_collection (cursor, &collection, &collection_len);
 
+   values[0].value_type = BSON_TYPE_INT64;
+   values[0].value.v_int64 = mongoc_cursor_get_id (cursor);
+   values[1].value_type = BSON_TYPE_UTF8;
+   values[1].value.v_utf8.str = (char *) collection;
+   values[1].value.v_utf8.len = (uint32_t) collection_len;
+
    bson_init (command);
-   bson_append_int64 (command, "getMore", 7, mongoc_cursor_get_id (cursor));
-   bson_append_utf8 (command, "collection", 10, collection, collection_len);
+   BSON_ASSERT (bson_template_append (_mongoc_cmd_template (MONGOC_CMD_TEMPLATE_GETMORE), command, values, 2u));
 
    batch_size = mongoc_cursor_get_batch_size (cursor);
 
@@ -22,6 +22,7 @@
 #include <mongoc/mongoc-init.h>
 
 #include <mongoc/mongoc-handshake-private.h>
+#include <mongoc/mongoc-cmd-template-private.h>
 
 #include <mongoc/mongoc-cluster-aws-private.h>
 
@@ -150,6 +151,8 @@ static BSON_ONCE_FUN (_mongoc_do_init)
 
    _mongoc_handshake_init ();
 
+   _mongoc_cmd_templates_init ();
+
 #if defined(MONGOC_ENABLE_MONGODB_AWS_AUTH)
    kms_message_init ();
    _mongoc_aws_credentials_cache_init ();
@@ -196,6 +199,8 @@ static BSON_ONCE_FUN (_mongoc_do_cleanup)
 
    _mongoc_handshake_cleanup ();
 
+   _mongoc_cmd_templates_cleanup ();
+
 #if defined(MONGOC_ENABLE_MONGODB_AWS_AUTH)
    kms_message_cleanup ();
    _mongoc_aws_credentials_cache_cleanup ();
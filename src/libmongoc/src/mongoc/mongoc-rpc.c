@@ -83,31 +83,30 @@ _parse_error_reply (const bson_t *doc, bool check_wce, uint32_t *code, const cha
    BSON_ASSERT (code);
    *code = 0;
 
+   /* index the reply once rather than scanning it for each field below; most
+    * replies have none of them, so every lookup would scan to the end. */
+   bson_index_t *const index = bson_index_new (doc);
+
    /* The server only returns real error codes as int32.
     * But it may return as a double or int64 if a failpoint
     * based on how it is configured to error. */
-   if (bson_iter_init_find (&iter, doc, "code") && BSON_ITER_HOLDS_NUMBER (&iter)) {
+   if (bson_index_find (index, "code", &iter) && BSON_ITER_HOLDS_NUMBER (&iter)) {
       *code = (uint32_t) bson_iter_as_int64 (&iter);
       BSON_ASSERT (*code);
       found_error = true;
    }
 
-   if (bson_iter_init_find (&iter, doc, "errmsg") && BSON_ITER_HOLDS_UTF8 (&iter)) {
+   if (bson_index_find (index, "errmsg", &iter) && BSON_ITER_HOLDS_UTF8 (&iter)) {
       *msg = bson_iter_utf8 (&iter, NULL);
       found_error = true;
-   } else if (bson_iter_init_find (&iter, doc, "$err") && BSON_ITER_HOLDS_UTF8 (&iter)) {
+   } else if (bson_index_find (index, "$err", &iter) && BSON_ITER_HOLDS_UTF8 (&iter)) {
       *msg = bson_iter_utf8 (&iter, NULL);
       found_error = true;
    }
 
-   if (found_error) {
-      /* there was a command error */
-      RETURN (true);
-   }
-
-   if (check_wce) {
-      /* check for a write concern error */
-      if (bson_iter_init_find (&iter, doc, "writeConcernError") && BSON_ITER_HOLDS_DOCUMENT (&iter)) {
+   /* there was a command error, else check for a write concern error */
+   if (!found_error && check_wce) {
+      if (bson_index_find (index, "writeConcernError", &iter) && BSON_ITER_HOLDS_DOCUMENT (&iter)) {
          bson_iter_t child;
          BSON_ASSERT (bson_iter_recurse (&iter, &child));
          if (bson_iter_find (&child, "code") && BSON_ITER_HOLDS_NUMBER (&child)) {
@@ -123,6 +122,8 @@ _parse_error_reply (const bson_t *doc, bool check_wce, uint32_t *code, const cha
       }
    }
 
+   bson_index_destroy (index);
+
    RETURN (found_error);
 }
 
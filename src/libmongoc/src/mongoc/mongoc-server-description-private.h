@@ -22,6 +22,9 @@
 #include <mongoc/mongoc-server-description.h>
 #include <mongoc/mongoc-generation-map-private.h>
 #include <mongoc/mongoc-log-and-monitor-private.h>
+#include <mongoc/mongoc-shared-private.h>
+
+#include <common-atomic-private.h>
 
 
 #define MONGOC_DEFAULT_WIRE_VERSION 0
@@ -125,6 +128,17 @@ struct _mongoc_server_description_t {
    mongoc_generation_map_t *_generation_map_;
    bson_oid_t service_id;
    int64_t server_connection_id;
+
+   /* _operation_count_ points to the number of operations in progress against
+    * this server, shared by all copies of this server description. It is only
+    * allocated for servers of a topology that selects servers by operation
+    * count (the powerOfTwoChoices URI option), otherwise it is null. */
+   mongoc_shared_ptr _operation_count_;
+
+   /* _shared_count_ is the number of topology descriptions holding this
+    * server description. Copies of a topology description share the server
+    * descriptions they do not modify. */
+   int32_t _shared_count_;
 };
 
 /** Get a mutable pointer to the server's generation map */
@@ -161,6 +175,57 @@ mc_tpl_sd_get_generation (const mongoc_server_description_t *sd, const bson_oid_
    return mongoc_generation_map_get (mc_tpl_sd_generation_map_const (sd), service_id);
 }
 
+/**
+ * @brief Get the number of operations in progress against the given server,
+ * or zero if operations against it are not counted.
+ */
+static BSON_INLINE int64_t
+mc_tpl_sd_get_operation_count (const mongoc_server_description_t *sd)
+{
+   const int64_t *const count = sd->_operation_count_.ptr;
+   return count ? mcommon_atomic_int64_fetch (count, mcommon_memory_order_relaxed) : 0;
+}
+
+/**
+ * @brief Add @delta to the number of operations in progress against the given
+ * server, if operations against it are counted.
+ */
+static BSON_INLINE void
+mc_tpl_sd_add_operation_count (const mongoc_server_description_t *sd, int64_t delta)
+{
+   int64_t *const count = sd->_operation_count_.ptr;
+   if (count) {
+      mcommon_atomic_int64_fetch_add (count, delta, mcommon_memory_order_relaxed);
+   }
+}
+
+/**
+ * @brief Add a topology description holding the given server description.
+ */
+static BSON_INLINE mongoc_server_description_t *
+mc_tpl_sd_share (mongoc_server_description_t *sd)
+{
+   mcommon_atomic_int32_fetch_add (&sd->_shared_count_, 1, mcommon_memory_order_relaxed);
+   return sd;
+}
+
+/**
+ * @brief Return true if more than one topology description holds the given
+ * server description, in which case it must not be modified.
+ */
+static BSON_INLINE bool
+mc_tpl_sd_is_shared (const mongoc_server_description_t *sd)
+{
+   return mcommon_atomic_int32_fetch (&sd->_shared_count_, mcommon_memory_order_acquire) > 1;
+}
+
+/**
+ * @brief Remove a topology description holding the given server description,
+ * and destroy it if that was the last one.
+ */
+void
+mc_tpl_sd_release (mongoc_server_description_t *sd);
+
 void
 mongoc_server_description_init (mongoc_server_description_t *sd, const char *address, uint32_t id);
 bool
@@ -51,6 +51,7 @@ mongoc_server_description_cleanup (mongoc_server_description_t *sd)
    bson_destroy (&sd->compressors);
    bson_destroy (&sd->topology_version);
    mongoc_generation_map_destroy (sd->_generation_map_);
+   mongoc_shared_ptr_reset_null (&sd->_operation_count_);
 }
 
 /* Reset fields inside this sd, but keep same id, host information, RTT,
@@ -128,6 +129,8 @@ mongoc_server_description_init (mongoc_server_description_t *sd, const char *add
    sd->generation = 0;
    sd->opened = false;
    sd->_generation_map_ = mongoc_generation_map_new ();
+   sd->_operation_count_ = MONGOC_SHARED_PTR_NULL;
+   sd->_shared_count_ = 1;
 
    if (!_mongoc_host_list_from_string (&sd->host, address)) {
       MONGOC_WARNING ("Failed to parse uri for %s", address);
@@ -180,6 +183,15 @@ mongoc_server_description_destroy (mongoc_server_description_t *description)
    EXIT;
 }
 
+
+void
+mc_tpl_sd_release (mongoc_server_description_t *sd)
+{
+   if (mcommon_atomic_int32_fetch_sub (&sd->_shared_count_, 1, mcommon_memory_order_acq_rel) == 1) {
+      mongoc_server_description_destroy (sd);
+   }
+}
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -852,6 +864,8 @@ mongoc_server_description_new_copy (const mongoc_server_description_t *descripti
    copy->_generation_map_ = mongoc_generation_map_copy (mc_tpl_sd_generation_map_const (description));
    COPY_FIELD (service_id);
    COPY_FIELD (server_connection_id);
+   copy->_operation_count_ = mongoc_shared_ptr_copy (description->_operation_count_);
+   copy->_shared_count_ = 1;
 
 #undef COPY_INTERNAL_STRING_FIELD
 #undef COPY_INTERNAL_BSON_FIELD
@@ -21,6 +21,7 @@
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-error-private.h>
 #include <mongoc/mongoc-handshake-private.h>
+#include <mongoc/mongoc-cmd-template-private.h>
 #include <mongoc/mongoc-ssl-private.h>
 #include <mongoc/mongoc-stream-private.h>
 #include <mongoc/mongoc-topology-background-monitoring-private.h>
@@ -250,13 +251,14 @@ _server_monitor_heartbeat_failed (mongoc_server_monitor_t *server_monitor,
 static void
 _server_monitor_append_cluster_time (mongoc_server_monitor_t *server_monitor, bson_t *cmd)
 {
-   mc_shared_tpld td = mc_tpld_take_ref (BSON_ASSERT_PTR_INLINE (server_monitor)->topology);
+   mongoc_shared_ptr cluster_time =
+      _mongoc_topology_get_cluster_time (BSON_ASSERT_PTR_INLINE (server_monitor)->topology);
 
    /* Cluster time is updated on every reply. */
-   if (!bson_empty (&td.ptr->cluster_time)) {
-      bson_append_document (cmd, "$clusterTime", 12, &td.ptr->cluster_time);
+   if (!mongoc_shared_ptr_is_null (cluster_time)) {
+      bson_append_document (cmd, "$clusterTime", 12, cluster_time.ptr);
    }
-   mc_tpld_drop_ref (&td);
+   mongoc_shared_ptr_reset_null (&cluster_time);
 }
 
 static int32_t
@@ -348,7 +350,7 @@ _server_monitor_send_and_recv_hello_opmsg (mongoc_server_monitor_t *server_monit
 
    mcd_rpc_message_ingress (rpc);
 
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (rpc, NULL, &decompressed_data, &decompressed_data_len)) {
       _mongoc_set_error (error,
                          MONGOC_ERROR_PROTOCOL,
                          MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
@@ -461,7 +463,7 @@ _server_monitor_send_and_recv_opquery (mongoc_server_monitor_t *server_monitor,
 
    mcd_rpc_message_ingress (rpc);
 
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (rpc, NULL, &decompressed_data, &decompressed_data_len)) {
       _mongoc_set_error (error,
                          MONGOC_ERROR_PROTOCOL,
                          MONGOC_ERROR_PROTOCOL_INVALID_REPLY,
@@ -734,7 +736,7 @@ _server_monitor_awaitable_hello_recv (mongoc_server_monitor_t *server_monitor,
 
    mcd_rpc_message_ingress (rpc);
 
-   if (!mcd_rpc_message_decompress_if_necessary (rpc, &decompressed_data, &decompressed_data_len)) {
+   if (!mcd_rpc_message_decompress_if_necessary (rpc, NULL, &decompressed_data, &decompressed_data_len)) {
       _mongoc_set_error (error, MONGOC_ERROR_PROTOCOL, MONGOC_ERROR_PROTOCOL_INVALID_REPLY, "decompression failure");
       GOTO (fail);
    }
@@ -780,15 +782,24 @@ _server_monitor_awaitable_hello (mongoc_server_monitor_t *server_monitor,
 {
    bson_t cmd;
    const bson_t *hello;
+   bson_value_t values[3];
    bool ret = false;
 
    hello = _mongoc_topology_scanner_get_monitoring_cmd (server_monitor->topology->scanner, description->hello_ok);
    bson_copy_to (hello, &cmd);
 
    _server_monitor_append_cluster_time (server_monitor, &cmd);
-   bson_append_document (&cmd, "topologyVersion", 15, &description->topology_version);
-   bson_append_int64 (&cmd, "maxAwaitTimeMS", 14, server_monitor->heartbeat_frequency_ms);
-   bson_append_utf8 (&cmd, "$db", 3, "admin", 5);
+
+   values[0].value_type = BSON_TYPE_DOCUMENT;
+   values[0].value.v_doc.data = (uint8_t *) bson_get_data (&description->topology_version);
+   values[0].value.v_doc.data_len = description->topology_version.len;
+   values[1].value_type = BSON_TYPE_INT64;
+   values[1].value.v_int64 = server_monitor->heartbeat_frequency_ms;
+   values[2].value_type = BSON_TYPE_UTF8;
+   values[2].value.v_utf8.str = (char *) "admin";
+   values[2].value.v_utf8.len = 5u;
+   BSON_ASSERT (
+      bson_template_append (_mongoc_cmd_template (MONGOC_CMD_TEMPLATE_AWAITABLE_HELLO), &cmd, values, 3u));
 
    if (!_server_monitor_awaitable_hello_send (server_monitor, &cmd, error)) {
       GOTO (fail);
@@ -32,7 +32,6 @@ BSON_BEGIN_DECLS
 typedef struct _mongoc_server_stream_t {
    mongoc_topology_description_type_t topology_type;
    mongoc_server_description_t *sd; // owned
-   bson_t cluster_time;             // owned
    mongoc_stream_t *stream;         // borrowed
    // If the stream was created in a way that may have overwritten the user's
    // readPreference, we need to know if server selection forced that change.
@@ -34,12 +34,20 @@ mongoc_server_stream_new (const mongoc_topology_description_t *td,
 
    server_stream = BSON_ALIGNED_ALLOC (mongoc_server_stream_t);
    server_stream->topology_type = td->type;
-   bson_copy_to (&td->cluster_time, &server_stream->cluster_time);
    server_stream->sd = sd;         /* becomes owned */
    server_stream->stream = stream; /* merely borrowed */
    server_stream->must_use_primary = false;
    server_stream->retry_attempted = false;
 
+   if (td->power_of_two_choices && mongoc_shared_ptr_is_null (sd->_operation_count_)) {
+      /* @sd describes a connection, count its operations with the server's */
+      const mongoc_server_description_t *const td_sd =
+         mongoc_topology_description_server_by_id_const (td, sd->id, NULL);
+      if (td_sd) {
+         sd->_operation_count_ = mongoc_shared_ptr_copy (td_sd->_operation_count_);
+      }
+   }
+
    return server_stream;
 }
 
@@ -48,7 +56,6 @@ mongoc_server_stream_cleanup (mongoc_server_stream_t *server_stream)
 {
    if (server_stream) {
       mongoc_server_description_destroy (server_stream->sd);
-      bson_destroy (&server_stream->cluster_time);
       bson_free (server_stream);
    }
 }
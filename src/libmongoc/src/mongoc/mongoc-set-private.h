@@ -53,6 +53,11 @@ mongoc_set_add (mongoc_set_t *set, uint32_t id, void *item);
 void
 mongoc_set_rm (mongoc_set_t *set, uint32_t id);
 
+/* replace the item with "id", which must be in the set, destroying the old
+ * item */
+void
+mongoc_set_replace (mongoc_set_t *set, uint32_t id, void *item);
+
 void *
 mongoc_set_get (mongoc_set_t *set, uint32_t id);
 
@@ -92,6 +92,23 @@ mongoc_set_rm (mongoc_set_t *set, uint32_t id)
    }
 }
 
+void
+mongoc_set_replace (mongoc_set_t *set, uint32_t id, void *item)
+{
+   const mongoc_set_item_t key = {.id = id};
+
+   mongoc_set_item_t *const ptr =
+      (mongoc_set_item_t *) bsearch (&key, set->items, set->items_len, sizeof (key), mongoc_set_id_cmp);
+
+   BSON_ASSERT (ptr);
+
+   if (set->dtor) {
+      set->dtor (ptr->item, set->dtor_ctx);
+   }
+
+   ptr->item = item;
+}
+
 void *
 mongoc_set_get (mongoc_set_t *set, uint32_t id)
 {
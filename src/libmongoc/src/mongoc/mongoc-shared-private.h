@@ -115,10 +115,33 @@ mongoc_shared_ptr_assign (mongoc_shared_ptr *dest, mongoc_shared_ptr from);
  * @param from The shared pointer to take from
  *
  * Thread-safe equivalent of `mongoc_shared_ptr_assign`
+ *
+ * @note Neither this nor `mongoc_atomic_shared_ptr_load` takes a lock. While
+ * loads are in flight the book-keeping member of 'dest' is tagged, so 'dest'
+ * must not be copied or reset non-atomically while other threads may access it.
  */
 extern void
 mongoc_atomic_shared_ptr_store (mongoc_shared_ptr *dest, mongoc_shared_ptr from);
 
+/**
+ * @brief Replace 'dest' with 'desired' only if 'dest' still refers to the same
+ * pointee and managed object as 'expect'.
+ *
+ * @param dest The shared pointer to change
+ * @param expect The value that 'dest' is expected to hold, such as one
+ * previously returned by `mongoc_atomic_shared_ptr_load`
+ * @param desired The shared pointer to take from
+ * @returns true if 'dest' was replaced. Otherwise 'dest' is unmodified, and the
+ * caller may load it again and retry.
+ *
+ * Like `mongoc_atomic_shared_ptr_store`, this is safe to call while other
+ * threads access 'dest' with the atomic functions.
+ */
+extern bool
+mongoc_atomic_shared_ptr_compare_exchange (mongoc_shared_ptr *dest,
+                                           mongoc_shared_ptr expect,
+                                           mongoc_shared_ptr desired);
+
 /**
  * @brief Create a copy of the given shared pointer. Increases the reference
  * count on the object.
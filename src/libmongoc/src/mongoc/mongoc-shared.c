@@ -16,30 +16,114 @@
 
 #include <mongoc/mongoc-shared-private.h>
 
-#include <common-thread-private.h>
 #include <bson/bson.h>
 #include <common-atomic-private.h>
 
+/* The book-keeping block is aligned so that the low bits of a pointer to it
+ * are free to carry the state used by the atomic load and store below. The
+ * alignment also keeps the reference count of each block on its own cache
+ * line. */
+#define SHARED_AUX_ALIGN 64u
+/* Set while a store is replacing the pointee, which is not a single word. */
+#define SHARED_TAG_BUSY ((uintptr_t) 1u)
+/* Each in-flight atomic load adds one unit to the "local" reference count. */
+#define SHARED_TAG_UNIT ((uintptr_t) 2u)
+#define SHARED_TAG_MASK ((uintptr_t) (SHARED_AUX_ALIGN - 1u))
+#define SHARED_TAG_COUNT_MAX (SHARED_TAG_MASK & ~SHARED_TAG_BUSY)
+
 typedef struct _mongoc_shared_ptr_aux {
    int refcount;
    void (*deleter) (void *);
    void *managed;
+   /* The allocation that holds this block, which may start before it. */
+   void *block;
 } _mongoc_shared_ptr_aux;
 
+/* The book-keeping block that an atomic store publishes. It holds a reference
+ * to the stored pointer, so a load that pins the block also pins the pointee,
+ * even if the block address was freed and reused in between. */
+typedef struct _mongoc_shared_ptr_node {
+   _mongoc_shared_ptr_aux aux;
+   mongoc_shared_ptr stored;
+} _mongoc_shared_ptr_node;
+
+/* 'size' is the size of the block, which begins with a _mongoc_shared_ptr_aux */
+static _mongoc_shared_ptr_aux *
+_new_aux (size_t size)
+{
+   /* bson_aligned_alloc may fall back to malloc, so align by hand. */
+   void *const block = bson_malloc0 (size + SHARED_AUX_ALIGN - 1u);
+   const uintptr_t addr = ((uintptr_t) block + SHARED_AUX_ALIGN - 1u) & ~SHARED_TAG_MASK;
+   _mongoc_shared_ptr_aux *const aux = (_mongoc_shared_ptr_aux *) addr;
+
+   aux->block = block;
+   return aux;
+}
+
 static void
 _release_aux (_mongoc_shared_ptr_aux *aux)
 {
    aux->deleter (aux->managed);
-   bson_free (aux);
+   bson_free (aux->block);
+}
+
+static void
+_release_node (void *stored)
+{
+   mongoc_shared_ptr_reset_null ((mongoc_shared_ptr *) stored);
+}
+
+static BSON_INLINE bool
+_is_node (const _mongoc_shared_ptr_aux *aux)
+{
+   return aux->deleter == _release_node;
+}
+
+/* Wrap a reference to 'from' in a new node, whose pointee is the same as that
+ * of 'from' */
+static mongoc_shared_ptr
+_new_node (mongoc_shared_ptr from)
+{
+   mongoc_shared_ptr ret = MONGOC_SHARED_PTR_NULL;
+   _mongoc_shared_ptr_node *node;
+
+   if (mongoc_shared_ptr_is_null (from)) {
+      return ret;
+   }
+
+   node = (_mongoc_shared_ptr_node *) _new_aux (sizeof (_mongoc_shared_ptr_node));
+   node->aux.refcount = 1;
+   node->aux.deleter = _release_node;
+   node->aux.managed = &node->stored;
+   node->stored.ptr = from.ptr;
+   /* Refer to the block of a loaded value rather than nesting its node */
+   node->stored._aux = _is_node (from._aux) ? ((_mongoc_shared_ptr_node *) from._aux)->stored._aux : from._aux;
+   (void) mongoc_shared_ptr_copy (node->stored);
+
+   ret.ptr = from.ptr;
+   ret._aux = &node->aux;
+   return ret;
 }
 
-static bson_shared_mutex_t g_shared_ptr_mtx;
-static bson_once_t g_shared_ptr_mtx_init_once = BSON_ONCE_INIT;
+static BSON_INLINE _mongoc_shared_ptr_aux *
+_untag (uintptr_t word)
+{
+   return (_mongoc_shared_ptr_aux *) (word & ~SHARED_TAG_MASK);
+}
 
-static BSON_ONCE_FUN (_init_mtx)
+static BSON_INLINE uintptr_t
+_fetch_word (mongoc_shared_ptr const *ptr, enum mcommon_memory_order order)
 {
-   bson_shared_mutex_init (&g_shared_ptr_mtx);
-   BSON_ONCE_RETURN;
+   return (uintptr_t) mcommon_atomic_ptr_fetch ((void *volatile const *) &ptr->_aux, order);
+}
+
+/* Returns the value of the word before the exchange, which equals 'expect' if
+ * the exchange succeeded. */
+static BSON_INLINE uintptr_t
+_cas_word (mongoc_shared_ptr const *ptr, uintptr_t expect, uintptr_t desired)
+{
+   return (uintptr_t) mcommon_atomic_ptr_compare_exchange_strong (
+      (void *volatile *) &ptr->_aux, (void *) expect, (void *) desired, mcommon_memory_order_seq_cst);
 }
 
 void
@@ -55,12 +139,11 @@ mongoc_shared_ptr_reset (mongoc_shared_ptr *ptr, void *pointee, void (*deleter)
    /* Take the new value */
    if (pointee != NULL) {
       BSON_ASSERT (deleter != NULL);
-      ptr->_aux = bson_malloc0 (sizeof (_mongoc_shared_ptr_aux));
+      ptr->_aux = _new_aux (sizeof (_mongoc_shared_ptr_aux));
       ptr->_aux->deleter = deleter;
       ptr->_aux->refcount = 1;
       ptr->_aux->managed = pointee;
    }
-   bson_once (&g_shared_ptr_mtx_init_once, _init_mtx);
 }
 
 void
@@ -81,33 +164,171 @@ mongoc_shared_ptr_create (void *pointee, void (*deleter) (void *))
    return ret;
 }
 
-void
-mongoc_atomic_shared_ptr_store (mongoc_shared_ptr *dest, mongoc_shared_ptr from)
+/* The atomic load and store below use a split reference count instead of a
+ * lock. The `_aux` word of a shared pointer that is accessed atomically carries
+ * a "local" count of loads that are in flight in its low bits. A load first
+ * bumps the local count, which pins the book-keeping block, then takes a real
+ * reference and gives back its local count. A store that replaces the block
+ * moves whatever local count it finds into the block's reference count, so an
+ * in-flight load that finds the word has changed drops that extra reference
+ * itself instead. Since the pointee and the block are two separate words, a
+ * store sets the busy tag while it replaces the pointee, and loads wait for a
+ * store to finish instead of reading a mismatched pair.
+ *
+ * The word alone does not identify the pointee: between a load reading the
+ * word and pinning it, stores may free the block and allocate another one at
+ * the same address. So each store publishes a new node that holds the stored
+ * pointer, and a load that pins a node takes the pointee from it. */
+
+/* Set the busy tag on the word of 'dest', waiting for any other store to
+ * finish first. Returns the word with the busy tag set. */
+static uintptr_t
+_begin_store (mongoc_shared_ptr *dest)
+{
+   uintptr_t word = _fetch_word (dest, mcommon_memory_order_relaxed);
+
+   for (;;) {
+      uintptr_t prev_word;
+
+      if (word & SHARED_TAG_BUSY) {
+         /* Another store is in progress */
+         mcommon_thrd_yield ();
+         word = _fetch_word (dest, mcommon_memory_order_relaxed);
+         continue;
+      }
+      prev_word = _cas_word (dest, word, word | SHARED_TAG_BUSY);
+      if (prev_word == word) {
+         return word | SHARED_TAG_BUSY;
+      }
+      word = prev_word;
+   }
+}
+
+/* Clear the busy tag set by _begin_store without storing. In-flight loads may
+ * still be giving back their local count. */
+static void
+_cancel_store (mongoc_shared_ptr *dest, uintptr_t word)
+{
+   for (;;) {
+      const uintptr_t prev_word = _cas_word (dest, word, word & ~SHARED_TAG_BUSY);
+      if (prev_word == word) {
+         return;
+      }
+      word = prev_word;
+   }
+}
+
+/* Replace the pointer after _begin_store, taking over the reference held by
+ * 'from' */
+static void
+_finish_store (mongoc_shared_ptr *dest, mongoc_shared_ptr from)
 {
    mongoc_shared_ptr prev = MONGOC_SHARED_PTR_NULL;
-   BSON_ASSERT_PARAM (dest);
+   uintptr_t word;
 
-   /* We are effectively "copying" the 'from' */
-   (void) mongoc_shared_ptr_copy (from);
+   /* Loads cannot pin the block while the busy tag is set, so the pointee can
+    * be replaced before the block. Storing the block clears the busy tag and
+    * any local count. */
+   prev.ptr = mcommon_atomic_ptr_exchange ((void *volatile *) &dest->ptr, from.ptr, mcommon_memory_order_relaxed);
+   word = (uintptr_t) mcommon_atomic_ptr_exchange (
+      (void *volatile *) &dest->_aux, from._aux, mcommon_memory_order_acq_rel);
 
-   bson_shared_mutex_lock (&g_shared_ptr_mtx);
-   /* Do the exchange. Quick! */
-   prev = *dest;
-   *dest = from;
-   bson_shared_mutex_unlock (&g_shared_ptr_mtx);
+   prev._aux = _untag (word);
+   if (prev._aux && (word & SHARED_TAG_COUNT_MAX)) {
+      /* Loads that were still in flight take a reference of their own */
+      mcommon_atomic_int_fetch_add (
+         &prev._aux->refcount, (int) ((word & SHARED_TAG_COUNT_MAX) / SHARED_TAG_UNIT), mcommon_memory_order_relaxed);
+   }
 
    /* Free the pointer that we just overwrote */
    mongoc_shared_ptr_reset_null (&prev);
 }
 
+void
+mongoc_atomic_shared_ptr_store (mongoc_shared_ptr *dest, mongoc_shared_ptr from)
+{
+   BSON_ASSERT_PARAM (dest);
+
+   /* The new node holds our copy of 'from' */
+   from = _new_node (from);
+
+   (void) _begin_store (dest);
+   _finish_store (dest, from);
+}
+
+bool
+mongoc_atomic_shared_ptr_compare_exchange (mongoc_shared_ptr *dest,
+                                           mongoc_shared_ptr expect,
+                                           mongoc_shared_ptr desired)
+{
+   uintptr_t word;
+   BSON_ASSERT_PARAM (dest);
+
+   word = _begin_store (dest);
+   if (_untag (word) != expect._aux ||
+       mcommon_atomic_ptr_fetch ((void *volatile const *) &dest->ptr, mcommon_memory_order_relaxed) != expect.ptr) {
+      _cancel_store (dest, word);
+      return false;
+   }
+
+   _finish_store (dest, _new_node (desired));
+   return true;
+}
+
 mongoc_shared_ptr
 mongoc_atomic_shared_ptr_load (mongoc_shared_ptr const *ptr)
 {
-   mongoc_shared_ptr r;
+   mongoc_shared_ptr r = MONGOC_SHARED_PTR_NULL;
+   uintptr_t word;
+   void *pointee;
    BSON_ASSERT_PARAM (ptr);
-   bson_shared_mutex_lock_shared (&g_shared_ptr_mtx);
-   r = mongoc_shared_ptr_copy (*ptr);
-   bson_shared_mutex_unlock_shared (&g_shared_ptr_mtx);
+
+   word = _fetch_word (ptr, mcommon_memory_order_acquire);
+   for (;;) {
+      uintptr_t prev_word;
+
+      if (!_untag (word)) {
+         return MONGOC_SHARED_PTR_NULL;
+      }
+      if ((word & SHARED_TAG_BUSY) || (word & SHARED_TAG_COUNT_MAX) == SHARED_TAG_COUNT_MAX) {
+         /* A store is replacing the pointer, or too many loads are in flight */
+         mcommon_thrd_yield ();
+         word = _fetch_word (ptr, mcommon_memory_order_acquire);
+         continue;
+      }
+      pointee = mcommon_atomic_ptr_fetch ((void *volatile const *) &ptr->ptr, mcommon_memory_order_relaxed);
+      prev_word = _cas_word (ptr, word, word + SHARED_TAG_UNIT);
+      if (prev_word == word) {
+         break;
+      }
+      word = prev_word;
+   }
+
+   r._aux = _untag (word);
+   /* A block that is not a node was set non-atomically, and no store has
+    * replaced it, so the pointee read before pinning it still belongs to it */
+   r.ptr = _is_node (r._aux) ? ((_mongoc_shared_ptr_node *) r._aux)->stored.ptr : pointee;
+   /* The local count keeps the block alive until this reference is taken */
+   mcommon_atomic_int_fetch_add (&r._aux->refcount, 1, mcommon_memory_order_relaxed);
+
+   /* Give back the local count, unless a store already moved it into the
+    * reference count of the block */
+   word += SHARED_TAG_UNIT;
+   for (;;) {
+      uintptr_t prev_word;
+
+      if (_untag (word) != r._aux || !(word & SHARED_TAG_COUNT_MAX)) {
+         /* Cannot drop to zero: we hold a reference */
+         mcommon_atomic_int_fetch_sub (&r._aux->refcount, 1, mcommon_memory_order_relaxed);
+         break;
+      }
+      prev_word = _cas_word (ptr, word, word - SHARED_TAG_UNIT);
+      if (prev_word == word) {
+         break;
+      }
+      word = prev_word;
+   }
+
    return r;
 }
 
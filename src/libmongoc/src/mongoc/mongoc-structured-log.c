@@ -540,10 +540,13 @@ _mongoc_structured_log_append_json_truncation_marker (mcommon_string_append_t *a
 static mcommon_string_t *
 _mongoc_structured_log_document_as_truncated_json (const bson_t *document, const mongoc_structured_log_opts_t *opts)
 {
-   // Use the bson_t document length as an initial buffer capacity guess
+   // Size the buffer from an estimate of the output length, which stops at the maximum document length
    mcommon_string_append_t append;
    mcommon_string_set_append_with_limit (
-      mcommon_string_new_with_capacity ("", 0, document->len), &append, opts->max_document_length);
+      mcommon_string_new_with_capacity (
+         "", 0, mcommon_json_estimate_len (document, BSON_JSON_MODE_RELAXED, opts->max_document_length)),
+      &append,
+      opts->max_document_length);
 
    if (mcommon_json_append_bson_document (&append, document, BSON_JSON_MODE_RELAXED, BSON_MAX_RECURSION)) {
       return _mongoc_structured_log_append_json_truncation_marker (&append);
@@ -570,11 +573,14 @@ _mongoc_structured_log_command_with_payloads_as_truncated_json (const mongoc_cmd
    BSON_ASSERT (!bson_empty0 (cmd->command));
    BSON_ASSERT (cmd->payloads_count <= MONGOC_CMD_PAYLOADS_COUNT_MAX);
 
-   // Use the bson length of the command itself as an initial buffer capacity guess.
+   // Size the buffer from an estimate for the command itself. Payloads may grow it.
    bool invalid_document = false;
    mcommon_string_append_t append;
    mcommon_string_set_append_with_limit (
-      mcommon_string_new_with_capacity ("", 0, cmd->command->len), &append, opts->max_document_length);
+      mcommon_string_new_with_capacity (
+         "", 0, mcommon_json_estimate_len (cmd->command, BSON_JSON_MODE_RELAXED, opts->max_document_length)),
+      &append,
+      opts->max_document_length);
 
    if (!mcommon_string_append (&append, "{ ")) {
       goto done;
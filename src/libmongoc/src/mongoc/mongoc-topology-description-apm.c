@@ -134,9 +134,11 @@ _mongoc_topology_description_monitor_opening (mongoc_topology_description_t *td,
    /* send initial description-changed event */
    _mongoc_topology_description_monitor_changed (prev_td, td, log_and_monitor);
 
-   for (size_t i = 0u; i < mc_tpld_servers (td)->items_len; i++) {
-      mongoc_server_description_t *sd = mongoc_set_get_item (mc_tpld_servers (td), i);
-      _mongoc_topology_description_monitor_server_opening (td, log_and_monitor, sd);
+   for (size_t i = 0u; i < mc_tpld_servers_const (td)->items_len; i++) {
+      uint32_t id;
+      mongoc_set_get_item_and_id_const (mc_tpld_servers_const (td), i, &id);
+      _mongoc_topology_description_monitor_server_opening (
+         td, log_and_monitor, mongoc_topology_description_server_by_id (td, id, NULL));
    }
 
    /* If this is a load balanced topology:
@@ -149,14 +151,19 @@ _mongoc_topology_description_monitor_opening (mongoc_topology_description_t *td,
 
       /* LoadBalanced deployments must have exactly one host listed. Otherwise,
        * an error would have occurred when constructing the topology. */
-      BSON_ASSERT (mc_tpld_servers (td)->items_len == 1);
-      mongoc_server_description_t *sd = mongoc_set_get_item (mc_tpld_servers (td), 0);
-      prev_sd = mongoc_server_description_new_copy (sd);
+      BSON_ASSERT (mc_tpld_servers_const (td)->items_len == 1);
+      uint32_t id;
+      const mongoc_server_description_t *const lb_sd =
+         mongoc_set_get_item_and_id_const (mc_tpld_servers_const (td), 0, &id);
+      prev_sd = mongoc_server_description_new_copy (lb_sd);
       BSON_ASSERT (prev_sd);
 
       mongoc_topology_description_cleanup (prev_td);
       _mongoc_topology_description_copy_to (td, prev_td);
 
+      /* get the server description after copying prev_td, so modifying it
+       * does not modify prev_td's */
+      mongoc_server_description_t *sd = mongoc_topology_description_server_by_id (td, id, NULL);
       sd->type = MONGOC_SERVER_LOAD_BALANCER;
       _mongoc_topology_description_monitor_server_changed (td, log_and_monitor, prev_sd, sd);
       mongoc_server_description_destroy (prev_sd);
@@ -39,6 +39,11 @@ typedef enum {
    MONGOC_TOPOLOGY_DESCRIPTION_TYPES
 } mongoc_topology_description_type_t;
 
+/* number of server selection results a topology description caches */
+#define MONGOC_TD_SELECT_CACHE_SIZE 8
+
+struct _mongoc_td_select_cache_entry_t;
+
 struct _mongoc_topology_description_t {
    bson_oid_t topology_id;
    mongoc_topology_description_type_t type;
@@ -53,14 +58,19 @@ struct _mongoc_topology_description_t {
    bool stale;
    bool opened;
    unsigned int rand_seed;
-
-   /* the greatest seen cluster time, for a MongoDB 3.6+ sharded cluster.
-    * see Driver Sessions Spec. */
-   bson_t cluster_time;
+   /* the powerOfTwoChoices URI option: choose the server with fewer operations
+    * in progress of two picked at random from the latency window */
+   bool power_of_two_choices;
 
    /* smallest seen logicalSessionTimeoutMinutes, or -1 if any server has no
     * logicalSessionTimeoutMinutes. see Server Discovery and Monitoring Spec */
    int64_t session_timeout_minutes;
+
+   /* suitable servers found by mongoc_topology_description_select, keyed by
+    * operation type and read preference. threads sharing a description fill
+    * free slots with compare-and-exchange; the slots are emptied whenever the
+    * description is modified, and a copy starts with an empty cache. */
+   struct _mongoc_td_select_cache_entry_t *_select_cache_[MONGOC_TD_SELECT_CACHE_SIZE];
 };
 
 typedef enum { MONGOC_SS_READ, MONGOC_SS_WRITE, MONGOC_SS_AGGREGATE_WITH_WRITE } mongoc_ss_optype_t;
@@ -84,6 +94,10 @@ mongoc_topology_description_init (mongoc_topology_description_t *description, in
 /**
  * @brief Get a pointer to the set of server descriptions in the topology
  * description.
+ *
+ * The server descriptions in the set may be shared with copies of the topology
+ * description. Get one with mongoc_topology_description_server_by_id to
+ * modify it.
  */
 static BSON_INLINE mongoc_set_t *
 mc_tpld_servers (mongoc_topology_description_t *tpld)
@@ -167,9 +181,6 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
                                         const char *server,
                                         uint32_t *id /* OUT */);
 
-void
-mongoc_topology_description_update_cluster_time (mongoc_topology_description_t *td, const bson_t *reply);
-
 void
 mongoc_topology_description_reconcile (mongoc_topology_description_t *td,
                                        const mongoc_log_and_monitor_instance_t *log_and_monitor,
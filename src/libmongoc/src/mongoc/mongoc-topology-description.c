@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <common-atomic-private.h>
 #include <common-oid-private.h>
 #include <mongoc/mongoc-array-private.h>
 #include <mongoc/mongoc-error-private.h>
@@ -56,7 +57,164 @@ _mongoc_topology_server_dtor (void *server_, void *ctx_)
 {
    BSON_UNUSED (ctx_);
 
-   mongoc_server_description_destroy ((mongoc_server_description_t *) server_);
+   mc_tpl_sd_release ((mongoc_server_description_t *) server_);
+}
+
+
+/* The servers suitable for one kind of server selection from one topology
+ * description. Entries are immutable once published in the description's
+ * cache, and live until the cache is cleared. */
+typedef struct _mongoc_td_select_cache_entry_t {
+   mongoc_ss_optype_t optype;
+   mongoc_read_mode_t read_mode;
+   int64_t max_staleness_seconds;
+   int64_t local_threshold_ms;
+   uint32_t tags_hash;
+   uint32_t tags_len;
+   uint8_t *tags_data;
+   bool must_use_primary;
+   mongoc_array_t servers; /* of const mongoc_server_description_t * */
+} mongoc_td_select_cache_entry_t;
+
+
+/* FNV-1a, to reject most mismatched tag sets without comparing them */
+static uint32_t
+_select_cache_hash (const uint8_t *data, uint32_t len)
+{
+   uint32_t hash = 2166136261u;
+
+   for (uint32_t i = 0u; i < len; i++) {
+      hash ^= data[i];
+      hash *= 16777619u;
+   }
+
+   return hash;
+}
+
+
+/* Fill out @key for a selection with @read_pref. @key borrows the tags. */
+static void
+_select_cache_key_init (mongoc_td_select_cache_entry_t *key,
+                        mongoc_ss_optype_t optype,
+                        const mongoc_read_prefs_t *read_pref,
+                        int64_t local_threshold_ms)
+{
+   memset (key, 0, sizeof (*key));
+
+   key->optype = optype;
+   key->read_mode = mongoc_read_prefs_get_mode (read_pref);
+   key->max_staleness_seconds = MONGOC_NO_MAX_STALENESS;
+   key->local_threshold_ms = local_threshold_ms;
+
+   if (read_pref) {
+      const bson_t *const tags = mongoc_read_prefs_get_tags (read_pref);
+
+      key->max_staleness_seconds = mongoc_read_prefs_get_max_staleness_seconds (read_pref);
+      key->tags_len = tags->len;
+      key->tags_data = (uint8_t *) bson_get_data (tags);
+      key->tags_hash = _select_cache_hash (key->tags_data, key->tags_len);
+   }
+}
+
+
+static bool
+_select_cache_key_equal (const mongoc_td_select_cache_entry_t *a, const mongoc_td_select_cache_entry_t *b)
+{
+   return a->optype == b->optype && a->read_mode == b->read_mode &&
+          a->max_staleness_seconds == b->max_staleness_seconds && a->local_threshold_ms == b->local_threshold_ms &&
+          a->tags_hash == b->tags_hash && a->tags_len == b->tags_len &&
+          (a->tags_len == 0u || 0 == memcmp (a->tags_data, b->tags_data, a->tags_len));
+}
+
+
+/* A new entry with an empty list of servers and a copy of the tags in @key */
+static mongoc_td_select_cache_entry_t *
+_select_cache_entry_new (const mongoc_td_select_cache_entry_t *key)
+{
+   mongoc_td_select_cache_entry_t *const entry = BSON_ALIGNED_ALLOC0 (mongoc_td_select_cache_entry_t);
+
+   *entry = *key;
+   entry->tags_data = key->tags_len ? bson_malloc (key->tags_len) : NULL;
+   if (key->tags_len) {
+      memcpy (entry->tags_data, key->tags_data, key->tags_len);
+   }
+
+   _mongoc_array_init (&entry->servers, sizeof (mongoc_server_description_t *));
+
+   return entry;
+}
+
+
+static void
+_select_cache_entry_destroy (mongoc_td_select_cache_entry_t *entry)
+{
+   if (!entry) {
+      return;
+   }
+
+   _mongoc_array_destroy (&entry->servers);
+   bson_free (entry->tags_data);
+   bson_free (entry);
+}
+
+
+static const mongoc_td_select_cache_entry_t *
+_select_cache_lookup (const mongoc_topology_description_t *td, const mongoc_td_select_cache_entry_t *key)
+{
+   for (size_t i = 0u; i < MONGOC_TD_SELECT_CACHE_SIZE; i++) {
+      const mongoc_td_select_cache_entry_t *const entry =
+         mcommon_atomic_ptr_fetch ((void *volatile const *) &td->_select_cache_[i], mcommon_memory_order_acquire);
+
+      if (!entry) {
+         /* slots are filled in order, so there are no more entries */
+         return NULL;
+      }
+
+      if (_select_cache_key_equal (entry, key)) {
+         return entry;
+      }
+   }
+
+   return NULL;
+}
+
+
+/* Publish @entry in the first free slot of @td's cache. Returns @entry, or an
+ * equal entry that another thread published first, in which case @entry is
+ * destroyed. Returns NULL if the cache is full, and @entry still belongs to
+ * the caller. Published descriptions are shared read-only between threads,
+ * the cache is the only part of them that is modified. */
+static const mongoc_td_select_cache_entry_t *
+_select_cache_publish (const mongoc_topology_description_t *td, mongoc_td_select_cache_entry_t *entry)
+{
+   void *volatile *const slots = (void *volatile *) td->_select_cache_;
+
+   for (size_t i = 0u; i < MONGOC_TD_SELECT_CACHE_SIZE; i++) {
+      const mongoc_td_select_cache_entry_t *const prev =
+         mcommon_atomic_ptr_compare_exchange_strong (&slots[i], NULL, entry, mcommon_memory_order_acq_rel);
+
+      if (!prev) {
+         return entry;
+      }
+
+      if (_select_cache_key_equal (prev, entry)) {
+         _select_cache_entry_destroy (entry);
+         return prev;
+      }
+   }
+
+   return NULL;
+}
+
+
+/* Empty @td's cache. @td must not be shared with other threads. */
+static void
+_select_cache_clear (mongoc_topology_description_t *td)
+{
+   for (size_t i = 0u; i < MONGOC_TD_SELECT_CACHE_SIZE; i++) {
+      _select_cache_entry_destroy (td->_select_cache_[i]);
+      td->_select_cache_[i] = NULL;
+   }
 }
 
 /*
@@ -91,7 +249,6 @@ mongoc_topology_description_init (mongoc_topology_description_t *description, in
    description->max_set_version = MONGOC_NO_SET_VERSION;
    description->stale = true;
    description->rand_seed = (unsigned int) bson_get_monotonic_time ();
-   bson_init (&description->cluster_time);
    description->session_timeout_minutes = MONGOC_NO_SESSIONS;
 
    EXIT;
@@ -102,10 +259,14 @@ mongoc_topology_description_init (mongoc_topology_description_t *description, in
  *
  * _mongoc_topology_description_copy_to --
  *
- *       Deep-copy @src to an uninitialized topology description @dst.
+ *       Copy @src to an uninitialized topology description @dst.
  *       @dst must not already point to any allocated resources. Clean
  *       up with mongoc_topology_description_cleanup.
  *
+ *       The server descriptions are shared, not copied. Each is copied
+ *       when first modified through either topology description, see
+ *       mongoc_topology_description_server_by_id.
+ *
  * Returns:
  *       None.
  *
@@ -132,12 +293,13 @@ _mongoc_topology_description_copy_to (const mongoc_topology_description_t *src,
    dst->type = src->type;
    dst->heartbeat_msec = src->heartbeat_msec;
    dst->rand_seed = src->rand_seed;
+   dst->power_of_two_choices = src->power_of_two_choices;
 
    nitems = bson_next_power_of_two (mc_tpld_servers_const (src)->items_len);
    dst->_servers_ = mongoc_set_new (nitems, _mongoc_topology_server_dtor, NULL);
    for (size_t i = 0u; i < mc_tpld_servers_const (src)->items_len; i++) {
       sd = mongoc_set_get_item_and_id_const (mc_tpld_servers_const (src), i, &id);
-      mongoc_set_add (mc_tpld_servers (dst), id, mongoc_server_description_new_copy (sd));
+      mongoc_set_add (mc_tpld_servers (dst), id, mc_tpl_sd_share ((mongoc_server_description_t *) sd));
    }
 
    dst->set_name = bson_strdup (src->set_name);
@@ -147,10 +309,11 @@ _mongoc_topology_description_copy_to (const mongoc_topology_description_t *src,
    dst->max_hosts = src->max_hosts;
    dst->stale = src->stale;
 
-   bson_copy_to (&src->cluster_time, &dst->cluster_time);
-
    dst->session_timeout_minutes = src->session_timeout_minutes;
 
+   /* the copy may be modified, so it does not share the cache */
+   memset (dst->_select_cache_, 0, sizeof (dst->_select_cache_));
+
    EXIT;
 }
 
@@ -159,7 +322,7 @@ _mongoc_topology_description_copy_to (const mongoc_topology_description_t *src,
  *
  * mongoc_topology_description_new_copy --
  *
- *       Allocates a new topology description and deep-copies @description to it
+ *       Allocates a new topology description and copies @description to it
  *       using _mongoc_topology_description_copy_to.
  *
  * Returns:
@@ -217,7 +380,7 @@ mongoc_topology_description_cleanup (mongoc_topology_description_t *description)
       bson_free (description->set_name);
    }
 
-   bson_destroy (&description->cluster_time);
+   _select_cache_clear (description);
 
    EXIT;
 }
@@ -993,7 +1156,8 @@ mongoc_topology_description_has_data_node (const mongoc_topology_description_t *
  *      Selected server description, or NULL upon failure.
  *
  * Side effects:
- *      None.
+ *      Caches the suitable servers in @topology, so that later selections
+ *      with the same operation type and read preference only pick one.
  *
  *-------------------------------------------------------------------------
  */
@@ -1005,8 +1169,6 @@ mongoc_topology_description_select (const mongoc_topology_description_t *topolog
                                     const mongoc_deprioritized_servers_t *ds,
                                     int64_t local_threshold_ms)
 {
-   mongoc_array_t suitable_servers;
-
    ENTRY;
 
    if (topology->type == MONGOC_TOPOLOGY_SINGLE) {
@@ -1030,20 +1192,55 @@ mongoc_topology_description_select (const mongoc_topology_description_t *topolog
       }
    }
 
-   _mongoc_array_init (&suitable_servers, sizeof (mongoc_server_description_t *));
+   /* deprioritized servers only affect selection from sharded clusters */
+   const bool cacheable = !ds || topology->type != MONGOC_TOPOLOGY_SHARDED;
+   mongoc_td_select_cache_entry_t key;
+   mongoc_td_select_cache_entry_t *owned = NULL;
 
-   mongoc_topology_description_suitable_servers (
-      &suitable_servers, optype, topology, read_pref, must_use_primary, ds, local_threshold_ms);
+   _select_cache_key_init (&key, optype, read_pref, local_threshold_ms);
+
+   const mongoc_td_select_cache_entry_t *entry = cacheable ? _select_cache_lookup (topology, &key) : NULL;
+
+   if (!entry) {
+      mongoc_td_select_cache_entry_t *const found = _select_cache_entry_new (&key);
+
+      mongoc_topology_description_suitable_servers (
+         &found->servers, optype, topology, read_pref, &found->must_use_primary, ds, local_threshold_ms);
+
+      entry = cacheable ? _select_cache_publish (topology, found) : NULL;
+      if (!entry) {
+         entry = owned = found;
+      }
+   }
+
+   if (must_use_primary) {
+      *must_use_primary = entry->must_use_primary;
+   }
 
    mongoc_server_description_t const *sd = NULL;
 
-   if (suitable_servers.len != 0) {
-      const int rand_n = _mongoc_rand_simple ((unsigned *) &topology->rand_seed);
-      sd =
-         _mongoc_array_index (&suitable_servers, mongoc_server_description_t *, (size_t) rand_n % suitable_servers.len);
+   if (entry->servers.len != 0) {
+      const size_t len = entry->servers.len;
+      const size_t i = (size_t) _mongoc_rand_simple ((unsigned *) &topology->rand_seed) % len;
+      sd = _mongoc_array_index (&entry->servers, mongoc_server_description_t *, i);
+
+      if (topology->power_of_two_choices && len > 1) {
+         /* pick a second, different server, and use whichever of the two has
+          * fewer operations in progress */
+         size_t j = (size_t) _mongoc_rand_simple ((unsigned *) &topology->rand_seed) % (len - 1u);
+         if (j >= i) {
+            j++;
+         }
+
+         mongoc_server_description_t const *const other =
+            _mongoc_array_index (&entry->servers, mongoc_server_description_t *, j);
+         if (mc_tpl_sd_get_operation_count (other) < mc_tpl_sd_get_operation_count (sd)) {
+            sd = other;
+         }
+      }
    }
 
-   _mongoc_array_destroy (&suitable_servers);
+   _select_cache_entry_destroy (owned);
 
    if (sd) {
       TRACE ("Topology type [%s], selected [%s] [%s]",
@@ -1067,6 +1264,11 @@ mongoc_topology_description_select (const mongoc_topology_description_t *topolog
  *       NOTE: In most cases, caller should create a duplicate of the
  *       returned server description.
  *
+ *       The returned server description may be modified. If it was shared
+ *       with another copy of @description, it is replaced with a copy of
+ *       its own first, so pointers to it obtained earlier are invalid. Use
+ *       mongoc_topology_description_server_by_id_const to only read it.
+ *
  * Returns:
  *       A mongoc_server_description_t *, or NULL.
  *
@@ -1079,7 +1281,17 @@ mongoc_topology_description_select (const mongoc_topology_description_t *topolog
 mongoc_server_description_t *
 mongoc_topology_description_server_by_id (mongoc_topology_description_t *description, uint32_t id, bson_error_t *error)
 {
-   return (mongoc_server_description_t *) mongoc_topology_description_server_by_id_const (description, id, error);
+   mongoc_server_description_t *sd;
+
+   sd = (mongoc_server_description_t *) mongoc_topology_description_server_by_id_const (description, id, error);
+   if (sd && mc_tpl_sd_is_shared (sd)) {
+      sd = mongoc_server_description_new_copy (sd);
+      /* cached selections point to the server description being replaced */
+      _select_cache_clear (description);
+      mongoc_set_replace (mc_tpld_servers (description), id, sd);
+   }
+
+   return sd;
 }
 
 const mongoc_server_description_t *
@@ -1124,6 +1336,7 @@ _mongoc_topology_description_remove_server (mongoc_topology_description_t *descr
    BSON_ASSERT (server);
 
    _mongoc_topology_description_monitor_server_closed (description, log_and_monitor, server);
+   _select_cache_clear (description);
    mongoc_set_rm (mc_tpld_servers (description), server->id);
 
    /* Check if removing server resulted in an empty set of servers */
@@ -1211,22 +1424,13 @@ _mongoc_topology_description_has_server (mongoc_topology_description_t *descript
    return data.found;
 }
 
-typedef struct _mongoc_address_and_type_t {
-   const char *address;
-   mongoc_server_description_type_t type;
-} mongoc_address_and_type_t;
-
 static bool
-_mongoc_label_unknown_member_cb (void *item, void *ctx)
+_mongoc_label_unknown_member_cb (const void *item, void *ctx)
 {
-   mongoc_server_description_t *server = (mongoc_server_description_t *) item;
-   mongoc_address_and_type_t *data = (mongoc_address_and_type_t *) ctx;
+   const mongoc_server_description_t *server = item;
+   const char *address = ctx;
 
-   if (strcasecmp (server->connection_address, data->address) == 0 && server->type == MONGOC_SERVER_UNKNOWN) {
-      mongoc_server_description_set_state (server, data->type);
-      return false;
-   }
-   return true;
+   return strcasecmp (server->connection_address, address) == 0 && server->type == MONGOC_SERVER_UNKNOWN;
 }
 
 /*
@@ -1250,15 +1454,15 @@ _mongoc_topology_description_label_unknown_member (mongoc_topology_description_t
                                                    const char *address,
                                                    mongoc_server_description_type_t type)
 {
-   mongoc_address_and_type_t data;
+   uint32_t id;
 
    BSON_ASSERT (description);
    BSON_ASSERT (address);
 
-   data.type = type;
-   data.address = address;
-
-   mongoc_set_for_each (mc_tpld_servers (description), _mongoc_label_unknown_member_cb, &data);
+   id = mongoc_set_find_id (mc_tpld_servers_const (description), _mongoc_label_unknown_member_cb, (void *) address);
+   if (id) {
+      mongoc_server_description_set_state (mongoc_topology_description_server_by_id (description, id, NULL), type);
+   }
 }
 
 /*
@@ -1281,6 +1485,7 @@ static void
 _mongoc_topology_description_set_state (mongoc_topology_description_t *description,
                                         mongoc_topology_description_type_t type)
 {
+   _select_cache_clear (description);
    description->type = type;
 }
 
@@ -1392,7 +1597,11 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
 
       description = BSON_ALIGNED_ALLOC0 (mongoc_server_description_t);
       mongoc_server_description_init (description, server, server_id);
+      if (topology->power_of_two_choices) {
+         description->_operation_count_ = mongoc_shared_ptr_create (bson_malloc0 (sizeof (int64_t)), bson_free);
+      }
 
+      _select_cache_clear (topology);
       mongoc_set_add (mc_tpld_servers (topology), server_id, description);
 
       /* Note that libmongoc defers topology 'opening' until server selection or background monitoring begins,
@@ -1412,66 +1621,6 @@ mongoc_topology_description_add_server (mongoc_topology_description_t *topology,
 }
 
 
-/*
- *--------------------------------------------------------------------------
- *
- * mongoc_topology_description_update_cluster_time --
- *
- *  Drivers Session Spec: Drivers MUST examine responses to server commands to
- *  see if they contain a top level field named $clusterTime formatted as
- *  follows:
- *
- *  {
- *      ...
- *      $clusterTime : {
- *          clusterTime : <BsonTimestamp>,
- *          signature : {
- *              hash : <BsonBinaryData>,
- *              keyId : <BsonInt64>
- *          }
- *      },
- *      ...
- *  }
- *
- *  Whenever a driver receives a clusterTime from a server it MUST compare it
- *  to the current highest seen clusterTime for the cluster. If the new
- *  clusterTime is higher than the highest seen clusterTime it MUST become
- *  the new highest seen clusterTime. Two clusterTimes are compared using
- *  only the BsonTimestamp value of the clusterTime embedded field (be sure to
- *  include both the timestamp and the increment of the BsonTimestamp in the
- *  comparison). The signature field does not participate in the comparison.
- *
- *--------------------------------------------------------------------------
- */
-
-void
-mongoc_topology_description_update_cluster_time (mongoc_topology_description_t *td, const bson_t *reply)
-{
-   bson_iter_t iter;
-   bson_iter_t child;
-   const uint8_t *data;
-   uint32_t size;
-   bson_t cluster_time;
-
-   if (!reply || !bson_iter_init_find (&iter, reply, "$clusterTime")) {
-      return;
-   }
-
-   if (!BSON_ITER_HOLDS_DOCUMENT (&iter) || !bson_iter_recurse (&iter, &child)) {
-      MONGOC_ERROR ("Can't parse $clusterTime");
-      return;
-   }
-
-   bson_iter_document (&iter, &size, &data);
-   BSON_ASSERT (bson_init_static (&cluster_time, data, (size_t) size));
-
-   if (bson_empty (&td->cluster_time) || _mongoc_cluster_time_greater (&cluster_time, &td->cluster_time)) {
-      bson_destroy (&td->cluster_time);
-      bson_copy_to (&cluster_time, &td->cluster_time);
-   }
-}
-
-
 static void
 _mongoc_topology_description_add_new_servers (mongoc_topology_description_t *topology,
                                               const mongoc_log_and_monitor_instance_t *log_and_monitor,
@@ -1494,25 +1643,23 @@ _mongoc_topology_description_add_new_servers (mongoc_topology_description_t *top
    }
 }
 
-typedef struct _mongoc_primary_and_topology_t {
-   mongoc_topology_description_t *topology;
-   const mongoc_server_description_t *primary;
-} mongoc_primary_and_topology_t;
-
 /* invalidate old primaries */
-static bool
-_mongoc_topology_description_invalidate_primaries_cb (void *item, void *ctx)
+static void
+_mongoc_topology_description_invalidate_primaries (mongoc_topology_description_t *topology,
+                                                   const mongoc_server_description_t *primary)
 {
-   mongoc_server_description_t *server = (mongoc_server_description_t *) item;
-   mongoc_primary_and_topology_t *data = (mongoc_primary_and_topology_t *) ctx;
+   for (size_t i = 0u; i < mc_tpld_servers_const (topology)->items_len; i++) {
+      const mongoc_server_description_t *member = mongoc_set_get_item_const (mc_tpld_servers_const (topology), i);
 
-   if (server->id != data->primary->id && server->type == MONGOC_SERVER_RS_PRIMARY) {
-      mongoc_server_description_set_state (server, MONGOC_SERVER_UNKNOWN);
-      mongoc_server_description_set_set_version (server, MONGOC_NO_SET_VERSION);
-      mongoc_server_description_set_election_id (server, NULL);
-      mongoc_server_description_reset (server);
+      if (member->id != primary->id && member->type == MONGOC_SERVER_RS_PRIMARY) {
+         mongoc_server_description_t *server = mongoc_topology_description_server_by_id (topology, member->id, NULL);
+
+         mongoc_server_description_set_state (server, MONGOC_SERVER_UNKNOWN);
+         mongoc_server_description_set_set_version (server, MONGOC_NO_SET_VERSION);
+         mongoc_server_description_set_election_id (server, NULL);
+         mongoc_server_description_reset (server);
+      }
    }
-   return true;
 }
 
 
@@ -1616,7 +1763,6 @@ _mongoc_topology_description_update_rs_from_primary (mongoc_topology_description
                                                      const mongoc_log_and_monitor_instance_t *log_and_monitor,
                                                      const mongoc_server_description_t *server)
 {
-   mongoc_primary_and_topology_t data;
    bson_error_t error;
 
    BSON_ASSERT (topology);
@@ -1680,9 +1826,7 @@ _mongoc_topology_description_update_rs_from_primary (mongoc_topology_description
       }
    }
    /* 'Server' is the primary! Invalidate other primaries if found */
-   data.primary = server;
-   data.topology = topology;
-   mongoc_set_for_each (mc_tpld_servers (topology), _mongoc_topology_description_invalidate_primaries_cb, &data);
+   _mongoc_topology_description_invalidate_primaries (topology, server);
 
    /* Add to topology description any new servers primary knows about */
    _mongoc_topology_description_add_new_servers (topology, log_and_monitor, server);
@@ -2148,16 +2292,21 @@ mongoc_topology_description_handle_hello (mongoc_topology_description_t *topolog
    BSON_ASSERT (topology);
    BSON_ASSERT (server_id != 0);
 
-   sd = mongoc_topology_description_server_by_id (topology, server_id, NULL);
-   if (!sd) {
+   if (!mongoc_topology_description_server_by_id_const (topology, server_id, NULL)) {
       return; /* server already removed from topology */
    }
 
+   _select_cache_clear (topology);
+
    if (log_and_monitor->apm_callbacks.topology_changed) {
       prev_td = BSON_ALIGNED_ALLOC0 (mongoc_topology_description_t);
       _mongoc_topology_description_copy_to (topology, prev_td);
    }
 
+   /* get the server description after copying prev_td, so modifying it does
+    * not modify prev_td's */
+   sd = mongoc_topology_description_server_by_id (topology, server_id, NULL);
+
    if (hello_response && bson_iter_init_find (&iter, hello_response, "topologyVersion") &&
        BSON_ITER_HOLDS_DOCUMENT (&iter)) {
       bson_t incoming_topology_version;
@@ -2219,8 +2368,6 @@ mongoc_topology_description_handle_hello (mongoc_topology_description_t *topolog
       }
    }
 
-   mongoc_topology_description_update_cluster_time (topology, hello_response);
-
    if (prev_sd) {
       sd_changed = !_mongoc_server_description_equal (prev_sd, sd);
    }
@@ -116,6 +116,14 @@ typedef struct _mongoc_topology_t {
     */
    mc_shared_tpld _shared_descr_;
 
+   /**
+    * @brief The highest $clusterTime seen from any server, as a shared `bson_t`
+    * that is null until one is seen. It is published on its own so advancing
+    * the cluster time does not copy the topology description. Do not access
+    * directly. Instead, use _mongoc_topology_get_cluster_time()
+    */
+   mongoc_shared_ptr _cluster_time_;
+
    /* topology->uri is initialized as a copy of the client/pool's URI.
     * For a "mongodb+srv://" URI, topology->uri is then updated in
     * mongoc_topology_new() after initial seedlist discovery.
@@ -176,6 +184,10 @@ typedef struct _mongoc_topology_t {
 
    mongoc_server_session_pool session_pool;
 
+   /* Idle connections shared by the clients of a pool created with
+    * MONGOC_URI_SHAREDCONNECTIONPOOL. NULL otherwise. */
+   struct _mongoc_connection_pool_t *connection_pool;
+
    /* Is client side encryption enabled? */
    mongoc_topology_cse_state_t cse_state;
    bool is_srv_polling;
@@ -363,6 +375,16 @@ _mongoc_topology_set_appname (mongoc_topology_t *topology, const char *appname);
 void
 _mongoc_topology_update_cluster_time (mongoc_topology_t *topology, const bson_t *reply);
 
+/**
+ * @brief Obtain a reference to the highest $clusterTime seen by the topology.
+ *
+ * The `ptr` member of the returned shared pointer is a `const bson_t *`, or
+ * NULL if no cluster time has been seen yet. The returned reference must later
+ * be released with mongoc_shared_ptr_reset_null().
+ */
+mongoc_shared_ptr
+_mongoc_topology_get_cluster_time (const mongoc_topology_t *topology);
+
 mongoc_server_session_t *
 _mongoc_topology_pop_server_session (mongoc_topology_t *topology,
                                      const mongoc_ss_log_context_t *log_context,
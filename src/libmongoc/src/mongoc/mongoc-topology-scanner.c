@@ -1400,6 +1400,7 @@ _cancel_commands_excluding (mongoc_topology_scanner_node_t *node, mongoc_async_c
    {
       if ((mongoc_topology_scanner_node_t *) iter->data == node && iter != acmd) {
          iter->state = MONGOC_ASYNC_CMD_CANCELED_STATE;
+         mongoc_async_cmd_reschedule (iter);
       }
    }
 }
@@ -1427,6 +1428,7 @@ _jumpstart_other_acmds (mongoc_topology_scanner_node_t *node, mongoc_async_cmd_t
       if ((mongoc_topology_scanner_node_t *) iter->data == node && iter != acmd &&
           acmd->initiate_delay_ms < iter->initiate_delay_ms) {
          iter->initiate_delay_ms = BSON_MAX (iter->initiate_delay_ms - HAPPY_EYEBALLS_DELAY_MS, 0);
+         mongoc_async_cmd_reschedule (iter);
       }
    }
 }
@@ -25,6 +25,7 @@
 #include <mongoc/mongoc-topology-description-apm-private.h>
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-cmd-private.h>
+#include <mongoc/mongoc-connection-pool-private.h>
 #include <mongoc/mongoc-uri-private.h>
 #include <mongoc/mongoc-util-private.h>
 #include <mongoc/mongoc-trace-private.h>
@@ -84,7 +85,7 @@ mongoc_topology_reconcile (const mongoc_topology_t *topology, mongoc_topology_de
    /* Remove removed nodes */
    DL_FOREACH_SAFE (topology->scanner->nodes, ele, tmp)
    {
-      if (!mongoc_topology_description_server_by_id (td, ele->id, NULL)) {
+      if (!mongoc_topology_description_server_by_id_const (td, ele->id, NULL)) {
          mongoc_topology_scanner_node_retire (ele);
       }
    }
@@ -93,17 +94,18 @@ mongoc_topology_reconcile (const mongoc_topology_t *topology, mongoc_topology_de
 
 /* call this while already holding the lock */
 static bool
-_mongoc_topology_update_no_lock (uint32_t id,
+_mongoc_topology_update_no_lock (mongoc_topology_t *topology,
+                                 uint32_t id,
                                  const bson_t *hello_response,
                                  int64_t rtt_msec,
                                  mongoc_topology_description_t *td,
-                                 const mongoc_log_and_monitor_instance_t *log_and_monitor,
                                  const bson_error_t *error /* IN */)
 {
-   mongoc_topology_description_handle_hello (td, log_and_monitor, id, hello_response, rtt_msec, error);
+   _mongoc_topology_update_cluster_time (topology, hello_response);
+   mongoc_topology_description_handle_hello (td, &topology->log_and_monitor, id, hello_response, rtt_msec, error);
 
    /* return false if server removed from topology */
-   return mongoc_topology_description_server_by_id (td, id, NULL) != NULL;
+   return mongoc_topology_description_server_by_id_const (td, id, NULL) != NULL;
 }
 
 
@@ -155,7 +157,7 @@ _mongoc_topology_scanner_cb (
    uint32_t id, const bson_t *hello_response, int64_t rtt_msec, void *data, const bson_error_t *error /* IN */)
 {
    mongoc_topology_t *const topology = BSON_ASSERT_PTR_INLINE (data);
-   mongoc_server_description_t *sd;
+   const mongoc_server_description_t *sd;
    mongoc_topology_description_t *td;
 
    BSON_ASSERT (topology->single_threaded);
@@ -169,8 +171,6 @@ _mongoc_topology_scanner_cb (
    // without locking. This function only applies to single-threaded clients.
    td = mc_tpld_unsafe_get_mutable (topology);
 
-   sd = mongoc_topology_description_server_by_id (td, id, NULL);
-
    if (!hello_response) {
       /* Server monitoring: When a server check fails due to a network error
        * (including a network timeout), the client MUST clear its connection
@@ -178,17 +178,19 @@ _mongoc_topology_scanner_cb (
       _mongoc_topology_description_clear_connection_pool (td, id, &kZeroObjectId);
    }
 
+   sd = mongoc_topology_description_server_by_id_const (td, id, NULL);
+
    /* Server Discovery and Monitoring Spec: "Once a server is connected, the
     * client MUST change its type to Unknown only after it has retried the
     * server once." */
    if (!hello_response && sd && sd->type != MONGOC_SERVER_UNKNOWN) {
-      _mongoc_topology_update_no_lock (id, hello_response, rtt_msec, td, &topology->log_and_monitor, error);
+      _mongoc_topology_update_no_lock (topology, id, hello_response, rtt_msec, td, error);
 
       /* add another hello call to the current scan - the scan continues
        * until all commands are done */
-      mongoc_topology_scanner_scan (topology->scanner, sd->id);
+      mongoc_topology_scanner_scan (topology->scanner, id);
    } else {
-      _mongoc_topology_update_no_lock (id, hello_response, rtt_msec, td, &topology->log_and_monitor, error);
+      _mongoc_topology_update_no_lock (topology, id, hello_response, rtt_msec, td, error);
 
       /* The processing of the hello results above may have added, changed, or
        * removed server descriptions. We need to reconcile that with our
@@ -415,10 +417,12 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
 
    topology->_shared_descr_._sptr_ =
       mongoc_shared_ptr_create (BSON_ALIGNED_ALLOC0 (mongoc_topology_description_t), _tpld_destroy_and_free);
+   topology->_cluster_time_ = MONGOC_SHARED_PTR_NULL;
    td = mc_tpld_unsafe_get_mutable (topology);
    mongoc_topology_description_init (td, heartbeat);
 
    td->set_name = bson_strdup (mongoc_uri_get_replica_set (uri));
+   td->power_of_two_choices = mongoc_uri_get_option_as_bool (uri, MONGOC_URI_POWEROFTWOCHOICES, false);
 
    topology->uri = mongoc_uri_copy (uri);
    topology->cse_state = MONGOC_CSE_DISABLED;
@@ -611,6 +615,9 @@ mongoc_topology_new (const mongoc_uri_t *uri, bool single_threaded)
    if (!topology->single_threaded) {
       topology->server_monitors = mongoc_set_new (1, NULL, NULL);
       topology->rtt_monitors = mongoc_set_new (1, NULL, NULL);
+      if (mongoc_uri_get_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, false)) {
+         topology->connection_pool = mongoc_connection_pool_new (uri);
+      }
       bson_mutex_init (&topology->srv_polling_mtx);
       mongoc_cond_init (&topology->srv_polling_cond);
    }
@@ -707,8 +714,10 @@ mongoc_topology_destroy (mongoc_topology_t *topology)
 
    mongoc_uri_destroy (topology->uri);
    mongoc_shared_ptr_reset_null (&topology->_shared_descr_._sptr_);
+   mongoc_shared_ptr_reset_null (&topology->_cluster_time_);
    mongoc_topology_scanner_destroy (topology->scanner);
    mongoc_server_session_pool_free (topology->session_pool);
+   mongoc_connection_pool_destroy (topology->connection_pool);
    bson_free (topology->clientSideEncryption.autoOptions.extraOptions.cryptSharedLibPath);
    mongoc_log_and_monitor_instance_destroy_contents (&topology->log_and_monitor);
 
@@ -1128,10 +1137,8 @@ mongoc_topology_select_server_id (mongoc_topology_t *topology,
    mc_shared_tpld td = mc_tpld_take_ref (topology);
    const mongoc_log_and_monitor_instance_t *log_and_monitor = &topology->log_and_monitor;
 
-   mcommon_string_append_t topology_type;
-   mcommon_string_new_as_append (&topology_type);
-   mcommon_string_append (&topology_type, ". Topology type: ");
-   mcommon_string_append (&topology_type, mongoc_topology_description_type (td.ptr));
+   /* only formatted into the error message if selection fails */
+   const char *const topology_type = mongoc_topology_description_type (td.ptr);
 
    /* These names come from the Server Selection Spec pseudocode */
    int64_t loop_start;  /* when we entered this function */
@@ -1369,7 +1376,8 @@ done:
    /* server_id set to zero indicates an error has occured and that `error` should be initialized */
    if (server_id == 0) {
       if (error && error->domain == MONGOC_ERROR_SERVER_SELECTION) {
-         _mongoc_error_append (error, mcommon_str_from_append (&topology_type));
+         _mongoc_error_append (error, ". Topology type: ");
+         _mongoc_error_append (error, topology_type);
       }
       mongoc_structured_log (log_and_monitor->structured_log,
                              MONGOC_STRUCTURED_LOG_LEVEL_DEBUG,
@@ -1393,7 +1401,6 @@ done:
          server_description (
             mongoc_topology_description_server_by_id_const (td.ptr, server_id, NULL), SERVER_HOST, SERVER_PORT));
    }
-   mcommon_string_from_append_destroy (&topology_type);
    mc_tpld_drop_ref (&td);
    return server_id;
 }
@@ -1443,7 +1450,7 @@ _mongoc_topology_update_from_handshake (mongoc_topology_t *topology, const mongo
 
    /* return false if server was removed from topology */
    has_server = _mongoc_topology_update_no_lock (
-      sd->id, &sd->last_hello_response, sd->round_trip_time_msec, tdmod.new_td, &topology->log_and_monitor, NULL);
+      topology, sd->id, &sd->last_hello_response, sd->round_trip_time_msec, tdmod.new_td, NULL);
 
    /* if pooled, wake threads waiting in mongoc_topology_server_by_id */
    mongoc_cond_broadcast (&topology->cond_client);
@@ -1504,6 +1511,13 @@ _mongoc_topology_set_appname (mongoc_topology_t *topology, const char *appname)
    return ret;
 }
 
+static void
+_cluster_time_destroy (void *cluster_time)
+{
+   bson_destroy ((bson_t *) cluster_time);
+}
+
+
 /*
  *--------------------------------------------------------------------------
  *
@@ -1513,6 +1527,10 @@ _mongoc_topology_set_appname (mongoc_topology_t *topology, const char *appname)
  *       any seen before, update the topology's clusterTime. See the Driver
  *       Sessions Spec.
  *
+ *       The cluster time advances on nearly every reply from a sharded
+ *       cluster, so it is kept outside the topology description and advanced
+ *       with a compare-and-swap rather than a topology modification.
+ *
  *--------------------------------------------------------------------------
  */
 
@@ -1524,7 +1542,8 @@ _mongoc_topology_update_cluster_time (mongoc_topology_t *topology, const bson_t
    const uint8_t *data;
    uint32_t size;
    bson_t cluster_time;
-   mc_shared_tpld td;
+   mongoc_shared_ptr current;
+   mongoc_shared_ptr update = MONGOC_SHARED_PTR_NULL;
 
    if (!reply || !bson_iter_init_find (&iter, reply, "$clusterTime")) {
       return;
@@ -1538,30 +1557,38 @@ _mongoc_topology_update_cluster_time (mongoc_topology_t *topology, const bson_t
    bson_iter_document (&iter, &size, &data);
    BSON_ASSERT (bson_init_static (&cluster_time, data, (size_t) size));
 
-   td = mc_tpld_take_ref (topology);
+   current = mongoc_atomic_shared_ptr_load (&topology->_cluster_time_);
 
-   /* This func is called frequently and repeatedly, but the cluster time itself
-    * is infrequently updated. mc_tpld_modify_begin() is very expensive, so we
-    * only want to actually call it if we anticipate performing an update to the
-    * cluster time.
-    *
-    * Check that the cluster time has actually changed from what we have on
-    * record before opening a topology modification to update it. */
-   if (bson_empty (&td.ptr->cluster_time) || _mongoc_cluster_time_greater (&cluster_time, &td.ptr->cluster_time)) {
-      mc_tpld_modification tdmod = mc_tpld_modify_begin (topology);
-      /* Check again if we need to update the cluster time, since it may have
-       * been updated behind our back. */
-      if (bson_empty (&tdmod.new_td->cluster_time) ||
-          _mongoc_cluster_time_greater (&cluster_time, &tdmod.new_td->cluster_time)) {
-         bson_destroy (&tdmod.new_td->cluster_time);
-         bson_copy_to (&cluster_time, &tdmod.new_td->cluster_time);
-         _mongoc_topology_scanner_set_cluster_time (topology->scanner, &tdmod.new_td->cluster_time);
-         mc_tpld_modify_commit (tdmod);
-      } else {
-         mc_tpld_modify_drop (tdmod);
+   /* Retry until this cluster time is published or a cluster time at least as
+    * high has been published by another thread. */
+   while (mongoc_shared_ptr_is_null (current) || _mongoc_cluster_time_greater (&cluster_time, current.ptr)) {
+      if (mongoc_shared_ptr_is_null (update)) {
+         update = mongoc_shared_ptr_create (bson_copy (&cluster_time), _cluster_time_destroy);
       }
+
+      if (mongoc_atomic_shared_ptr_compare_exchange (&topology->_cluster_time_, current, update)) {
+         if (topology->single_threaded) {
+            /* The scanner only runs in single-threaded mode */
+            _mongoc_topology_scanner_set_cluster_time (topology->scanner, &cluster_time);
+         }
+         break;
+      }
+
+      mongoc_shared_ptr_reset_null (&current);
+      current = mongoc_atomic_shared_ptr_load (&topology->_cluster_time_);
    }
-   mc_tpld_drop_ref (&td);
+
+   mongoc_shared_ptr_reset_null (&update);
+   mongoc_shared_ptr_reset_null (&current);
+}
+
+
+mongoc_shared_ptr
+_mongoc_topology_get_cluster_time (const mongoc_topology_t *topology)
+{
+   BSON_ASSERT_PARAM (topology);
+
+   return mongoc_atomic_shared_ptr_load (&topology->_cluster_time_);
 }
 
 
@@ -2004,7 +2031,7 @@ mc_tpld_modify_begin (mongoc_topology_t *tpl)
 void
 mc_tpld_modify_commit (mc_tpld_modification mod)
 {
-   mongoc_shared_ptr old_sptr = mongoc_shared_ptr_copy (mod.topology->_shared_descr_._sptr_);
+   mongoc_shared_ptr old_sptr = mongoc_atomic_shared_ptr_load (&mod.topology->_shared_descr_._sptr_);
    mongoc_shared_ptr new_sptr = mongoc_shared_ptr_create (mod.new_td, _tpld_destroy_and_free);
    mongoc_atomic_shared_ptr_store (&mod.topology->_shared_descr_._sptr_, new_sptr);
    bson_mutex_unlock (&mod.topology->tpld_modification_mtx);
@@ -720,8 +720,10 @@ mongoc_uri_option_is_int32 (const char *key)
           !strcasecmp (key, MONGOC_URI_SERVERSELECTIONTIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_SOCKETCHECKINTERVALMS) || !strcasecmp (key, MONGOC_URI_SOCKETTIMEOUTMS) ||
           !strcasecmp (key, MONGOC_URI_LOCALTHRESHOLDMS) || !strcasecmp (key, MONGOC_URI_MAXPOOLSIZE) ||
+          !strcasecmp (key, MONGOC_URI_MAXCONNECTING) || !strcasecmp (key, MONGOC_URI_MINIDLECONNECTIONS) ||
           !strcasecmp (key, MONGOC_URI_MAXSTALENESSSECONDS) || !strcasecmp (key, MONGOC_URI_MINPOOLSIZE) ||
           !strcasecmp (key, MONGOC_URI_WAITQUEUETIMEOUTMS) || !strcasecmp (key, MONGOC_URI_ZLIBCOMPRESSIONLEVEL) ||
+          !strcasecmp (key, MONGOC_URI_ZSTDCOMPRESSIONLEVEL) || !strcasecmp (key, MONGOC_URI_COMPRESSIONMINBYTES) ||
           !strcasecmp (key, MONGOC_URI_SRVMAXHOSTS);
    /* Not including deprecated unimplemented options:
     * - MONGOC_URI_MAXIDLETIMEMS
@@ -746,6 +748,8 @@ mongoc_uri_option_is_bool (const char *key)
           !strcasecmp (key, MONGOC_URI_TLSALLOWINVALIDHOSTNAMES) ||
           !strcasecmp (key, MONGOC_URI_TLSDISABLECERTIFICATEREVOCATIONCHECK) ||
           !strcasecmp (key, MONGOC_URI_TLSDISABLEOCSPENDPOINTCHECK) || !strcasecmp (key, MONGOC_URI_LOADBALANCED) ||
+          !strcasecmp (key, MONGOC_URI_COMPRESSIONADAPTIVE) || !strcasecmp (key, MONGOC_URI_SHAREDCONNECTIONPOOL) ||
+          !strcasecmp (key, MONGOC_URI_POWEROFTWOCHOICES) ||
           /* deprecated options with canonical equivalents */
           !strcasecmp (key, MONGOC_URI_SSL) || !strcasecmp (key, MONGOC_URI_SSLALLOWINVALIDCERTIFICATES) ||
           !strcasecmp (key, MONGOC_URI_SSLALLOWINVALIDHOSTNAMES);
@@ -1047,6 +1051,13 @@ mongoc_uri_apply_options (mongoc_uri_t *uri, const bson_t *options, bool from_dn
                goto UNSUPPORTED_VALUE;
             }
 
+            /* Connection Monitoring and Pooling spec: a non-positive
+             * maxConnecting is a warning, not an error. */
+            if (!strcasecmp (key, MONGOC_URI_MAXCONNECTING) && v_int <= 0) {
+               MONGOC_WARNING ("Invalid \"%s\" of %d: must be positive", key, v_int);
+               continue;
+            }
+
             if (!_mongoc_uri_set_option_as_int32_with_error (uri, canon, v_int, error)) {
                return false;
             }
@@ -2548,6 +2559,27 @@ _mongoc_uri_set_option_as_int32_with_error (mongoc_uri_t *uri,
       return false;
    }
 
+   /* zstd levels are from -1 (default) through 22 (best compression) */
+   if (!bson_strcasecmp (option, MONGOC_URI_ZSTDCOMPRESSIONLEVEL) && (value < -1 || value > 22)) {
+      MONGOC_URI_ERROR (error, "Invalid \"%s\" of %d: must be between -1 and 22", option_orig, value);
+      return false;
+   }
+
+   if (!bson_strcasecmp (option, MONGOC_URI_COMPRESSIONMINBYTES) && value < 0) {
+      MONGOC_URI_ERROR (error, "Invalid \"%s\" of %d: must be non-negative", option_orig, value);
+      return false;
+   }
+
+   if (!bson_strcasecmp (option, MONGOC_URI_MAXCONNECTING) && value <= 0) {
+      MONGOC_URI_ERROR (error, "Invalid \"%s\" of %d: must be positive", option_orig, value);
+      return false;
+   }
+
+   if (!bson_strcasecmp (option, MONGOC_URI_MINIDLECONNECTIONS) && value < 0) {
+      MONGOC_URI_ERROR (error, "Invalid \"%s\" of %d: must be non-negative", option_orig, value);
+      return false;
+   }
+
    if ((options = mongoc_uri_get_options (uri)) && bson_iter_init_find_case (&iter, options, option)) {
       if (BSON_ITER_HOLDS_INT32 (&iter)) {
          bson_iter_overwrite_int32 (&iter, value);
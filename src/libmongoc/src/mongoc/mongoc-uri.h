@@ -39,6 +39,8 @@
 #define MONGOC_URI_AUTHSOURCE "authsource"
 #define MONGOC_URI_CANONICALIZEHOSTNAME "canonicalizehostname"
 #define MONGOC_URI_CONNECTTIMEOUTMS "connecttimeoutms"
+#define MONGOC_URI_COMPRESSIONADAPTIVE "compressionadaptive"
+#define MONGOC_URI_COMPRESSIONMINBYTES "compressionminbytes"
 #define MONGOC_URI_COMPRESSORS "compressors"
 #define MONGOC_URI_DIRECTCONNECTION "directconnection"
 #define MONGOC_URI_GSSAPISERVICENAME "gssapiservicename"
@@ -46,10 +48,13 @@
 #define MONGOC_URI_JOURNAL "journal"
 #define MONGOC_URI_LOADBALANCED "loadbalanced"
 #define MONGOC_URI_LOCALTHRESHOLDMS "localthresholdms"
+#define MONGOC_URI_MAXCONNECTING "maxconnecting"
 #define MONGOC_URI_MAXIDLETIMEMS "maxidletimems"
 #define MONGOC_URI_MAXPOOLSIZE "maxpoolsize"
 #define MONGOC_URI_MAXSTALENESSSECONDS "maxstalenessseconds"
+#define MONGOC_URI_MINIDLECONNECTIONS "minidleconnections"
 #define MONGOC_URI_MINPOOLSIZE "minpoolsize"
+#define MONGOC_URI_POWEROFTWOCHOICES "poweroftwochoices"
 #define MONGOC_URI_READCONCERNLEVEL "readconcernlevel"
 #define MONGOC_URI_READPREFERENCE "readpreference"
 #define MONGOC_URI_READPREFERENCETAGS "readpreferencetags"
@@ -60,6 +65,7 @@
 #define MONGOC_URI_SERVERMONITORINGMODE "servermonitoringmode"
 #define MONGOC_URI_SERVERSELECTIONTIMEOUTMS "serverselectiontimeoutms"
 #define MONGOC_URI_SERVERSELECTIONTRYONCE "serverselectiontryonce"
+#define MONGOC_URI_SHAREDCONNECTIONPOOL "sharedconnectionpool"
 #define MONGOC_URI_SLAVEOK "slaveok"
 #define MONGOC_URI_SOCKETCHECKINTERVALMS "socketcheckintervalms"
 #define MONGOC_URI_SOCKETTIMEOUTMS "sockettimeoutms"
@@ -79,6 +85,7 @@
 #define MONGOC_URI_WAITQUEUETIMEOUTMS "waitqueuetimeoutms"
 #define MONGOC_URI_WTIMEOUTMS "wtimeoutms"
 #define MONGOC_URI_ZLIBCOMPRESSIONLEVEL "zlibcompressionlevel"
+#define MONGOC_URI_ZSTDCOMPRESSIONLEVEL "zstdcompressionlevel"
 
 /* Deprecated in MongoDB 4.2, use "tls" variants instead. */
 #define MONGOC_URI_SSL "ssl"
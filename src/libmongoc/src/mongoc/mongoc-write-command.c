@@ -607,6 +607,59 @@ _mongoc_write_result_merge (mongoc_write_result_t *result,   /* IN */
 }
 
 
+// Upper bound on the unacknowledged batches sent in one pipelined write, to bound the memory held for them.
+#define MONGOC_WRITE_PIPELINE_MAX_BATCHES 16u
+
+/* Sends the unacknowledged write commands in @batches in a single pipelined
+ * write on @server_stream, and merges their results. @batch_counts holds the
+ * number of documents of each batch. Both arrays are emptied. */
+static bool
+_mongoc_write_opmsg_pipeline (mongoc_write_command_t *command,
+                              mongoc_client_t *client,
+                              mongoc_server_stream_t *server_stream,
+                              mongoc_array_t *batches,
+                              mongoc_array_t *batch_counts,
+                              uint32_t *index_offset,
+                              mongoc_write_result_t *result,
+                              bson_error_t *error)
+{
+   const size_t n_batches = batches->len;
+   bson_t *const replies = bson_malloc0 (n_batches * sizeof (bson_t));
+   bson_error_t *const errors = bson_malloc0 (n_batches * sizeof (bson_error_t));
+   bool error_set = false;
+
+   const bool ret = mongoc_cluster_run_opmsg_pipeline (
+      &client->cluster, (mongoc_cmd_t *) batches->data, n_batches, replies, errors);
+
+   for (size_t i = 0u; i < n_batches; i++) {
+      if (errors[i].code) {
+         /* report the error of the first batch that failed */
+         if (!error_set) {
+            memcpy (error, &errors[i], sizeof (bson_error_t));
+            error_set = true;
+         }
+
+         result->failed = true;
+
+         if (command->flags.ordered || !mongoc_cluster_stream_valid (&client->cluster, server_stream)) {
+            result->must_stop = true;
+         }
+      }
+
+      _mongoc_write_result_merge (result, command, &replies[i], *index_offset);
+      *index_offset += _mongoc_array_index (batch_counts, uint32_t, i);
+      bson_destroy (&replies[i]);
+   }
+
+   batches->len = 0u;
+   batch_counts->len = 0u;
+   bson_free (errors);
+   bson_free (replies);
+
+   return ret;
+}
+
+
 static void
 _mongoc_write_opmsg (mongoc_write_command_t *command,
                      mongoc_client_t *client,
@@ -632,6 +685,9 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
    bool ship_it = false;
    int document_count = 0;
    mongoc_server_stream_t *retry_server_stream = NULL;
+   bool pipeline;
+   mongoc_array_t batches;
+   mongoc_array_t batch_counts;
 
    ENTRY;
 
@@ -696,6 +752,13 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
       // OP_MSG.Section[1].payload.documents is omitted. Calculated below with remaining size.
    }
 
+   /* Unacknowledged batches get no reply to wait for, so they are written to
+    * the stream together rather than one write per batch. Automatic
+    * encryption must see each batch, so it is not pipelined. */
+   pipeline = !parts.assembled.is_acknowledged && !_mongoc_cse_is_enabled (client);
+   _mongoc_array_init (&batches, sizeof (mongoc_cmd_t));
+   _mongoc_array_init (&batch_counts, sizeof (uint32_t));
+
    do {
       uint32_t ulen;
       memcpy (&ulen, command->payload.data + payload_batch_size + payload_total_offset, 4);
@@ -706,7 +769,13 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
       const int32_t slen = (int32_t) ulen;
 
       if (slen > max_bson_obj_size + BSON_OBJECT_ALLOWANCE) {
-         /* Quit if the document is too large */
+         /* Send the batches before this document, then quit since it is too
+          * large */
+         if (batches.len > 0u) {
+            ret = _mongoc_write_opmsg_pipeline (
+               command, client, server_stream, &batches, &batch_counts, &index_offset, result, error);
+         }
+
          _mongoc_write_command_too_large_error (error, index_offset, slen, max_bson_obj_size);
          result->failed = true;
          break;
@@ -737,6 +806,22 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
          payload->size = payload_batch_size;
          payload->identifier = gCommandFields[command->type];
 
+         if (pipeline) {
+            const uint32_t batch_count = (uint32_t) document_count;
+
+            _mongoc_array_append_val (&batches, parts.assembled);
+            _mongoc_array_append_val (&batch_counts, batch_count);
+            payload_total_offset += payload_batch_size;
+            payload_batch_size = 0;
+            document_count = 0;
+
+            if (batches.len == MONGOC_WRITE_PIPELINE_MAX_BATCHES || payload_total_offset == command->payload.len) {
+               ret = _mongoc_write_opmsg_pipeline (
+                  command, client, server_stream, &batches, &batch_counts, &index_offset, result, error);
+            }
+
+            continue;
+         }
 
          mongoc_server_stream_t *new_retry_server_stream = NULL;
          ret = mongoc_cluster_run_retryable_write (
@@ -770,6 +855,8 @@ _mongoc_write_opmsg (mongoc_write_command_t *command,
       /* While we have more documents to write */
    } while (payload_total_offset < command->payload.len && !result->must_stop);
 
+   _mongoc_array_destroy (&batch_counts);
+   _mongoc_array_destroy (&batches);
    bson_destroy (&cmd);
    mongoc_cmd_parts_cleanup (&parts);
 
@@ -0,0 +1,106 @@
+/*
+ * Measures the cost of a blocking topology scan of many mongos hosts by a single-threaded client, with the async
+ * engine waiting on the hosts' sockets with epoll (where available) versus mongoc_stream_poll.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-async-scan
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-async-scan [number of hosts] [number of scans]
+ * The integer arguments are optional, if not provided 200 hosts are scanned 50 times by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <mongoc/mongoc-client-private.h>
+#include <mongoc/mongoc-topology-private.h>
+
+#include <common-string-private.h>
+
+#include "TestSuite.h"
+#include "mock_server/mock-server.h"
+#include "test-libmongoc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+// Scan all hosts @n times, returning the average cost of one scan in microseconds.
+static double
+run (mongoc_client_t *client, bool force_poll, int n)
+{
+   mongoc_topology_t *const topology = client->topology;
+   bson_error_t error;
+
+   topology->scanner->async->force_poll = force_poll;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < n; i++) {
+      _mongoc_topology_do_blocking_scan (topology, &error);
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   return (double) elapsed_usec / (double) n;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_hosts = 200;
+   int num_scans = 50;
+
+   if (argc > 1) {
+      num_hosts = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      num_scans = atoi (argv[2]);
+   }
+
+   // The mock server logs through the test suite.
+   TestSuite suite;
+   TestSuite_Init (&suite, "benchmark-async-scan", 1, argv);
+
+   mongoc_init ();
+   // Silence the mock servers starting up.
+   mongoc_log_set_handler (NULL, NULL);
+
+   mock_server_t **const servers = bson_malloc (sizeof (mock_server_t *) * (size_t) num_hosts);
+   mcommon_string_append_t uri_str;
+
+   mcommon_string_new_as_append (&uri_str);
+   mcommon_string_append (&uri_str, "mongodb://");
+
+   for (int i = 0; i < num_hosts; i++) {
+      servers[i] = mock_mongos_new (WIRE_VERSION_MAX);
+      mcommon_string_append_printf (&uri_str, "%s127.0.0.1:%hu", i > 0 ? "," : "", mock_server_run (servers[i]));
+   }
+
+   mcommon_string_append (&uri_str, "/?serverSelectionTryOnce=false");
+
+   mongoc_client_t *const client = mongoc_client_new (mcommon_str_from_append (&uri_str));
+   BSON_ASSERT (client);
+
+   // Connect to every host before measuring. Later scans reuse the connections.
+   run (client, false, 1);
+
+   printf ("%d hosts, %d scans\n", num_hosts, num_scans);
+   printf ("poll:  %10.0f us/scan\n", run (client, true, num_scans));
+#ifdef MONGOC_HAVE_EPOLL
+   printf ("epoll: %10.0f us/scan\n", run (client, false, num_scans));
+#else
+   printf ("epoll: not available\n");
+#endif
+
+   mongoc_client_destroy (client);
+
+   for (int i = 0; i < num_hosts; i++) {
+      mock_server_destroy (servers[i]);
+   }
+
+   bson_free (servers);
+   mcommon_string_from_append_destroy (&uri_str);
+
+   mongoc_cleanup ();
+
+   TestSuite_Destroy (&suite);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,161 @@
+/*
+ * Measures the throughput of bson_as_relaxed_extended_json, bson_as_canonical_extended_json, and length-limited
+ * bson_as_json_with_opts over documents shaped like commands, numeric data, and text.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-bson-as-json
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-bson-as-json [number of iterations]
+ * The arguments are optional, if not provided each document is converted 100000 times.
+ */
+
+#include <bson/bson.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// An insert command with a few small documents, like those logged for command monitoring.
+static void
+make_command (bson_t *doc)
+{
+   bson_t documents;
+   bson_oid_t oid;
+
+   bson_init (doc);
+   BSON_APPEND_UTF8 (doc, "insert", "collection");
+   BSON_APPEND_BOOL (doc, "ordered", true);
+   BSON_APPEND_UTF8 (doc, "$db", "database");
+   BSON_APPEND_ARRAY_BEGIN (doc, "documents", &documents);
+   for (uint32_t i = 0u; i < 10u; i++) {
+      char key[16];
+      const char *key_str;
+      bson_t child;
+      bson_t tags;
+
+      bson_uint32_to_string (i, &key_str, key, sizeof key);
+      bson_oid_init_from_string (&oid, "5f1a00000000000000000000");
+      BSON_APPEND_DOCUMENT_BEGIN (&documents, key_str, &child);
+      BSON_APPEND_OID (&child, "_id", &oid);
+      BSON_APPEND_INT32 (&child, "index", (int32_t) i);
+      BSON_APPEND_UTF8 (&child, "name", "User Name");
+      BSON_APPEND_UTF8 (&child, "email", "user@example.com");
+      BSON_APPEND_DOUBLE (&child, "balance", 1234.5 + i);
+      BSON_APPEND_DATE_TIME (&child, "registered", 1500000000000 + i);
+      BSON_APPEND_ARRAY_BEGIN (&child, "tags", &tags);
+      BSON_APPEND_UTF8 (&tags, "0", "alpha");
+      BSON_APPEND_UTF8 (&tags, "1", "beta");
+      bson_append_array_end (&child, &tags);
+      bson_append_document_end (&documents, &child);
+   }
+   bson_append_array_end (doc, &documents);
+}
+
+// Doubles and integers, as in time series or metrics.
+static void
+make_numbers (bson_t *doc)
+{
+   bson_t values;
+
+   bson_init (doc);
+   BSON_APPEND_ARRAY_BEGIN (doc, "values", &values);
+   for (uint32_t i = 0u; i < 200u; i++) {
+      char key[16];
+      const char *key_str;
+
+      bson_uint32_to_string (i, &key_str, key, sizeof key);
+      if (i % 2u) {
+         BSON_APPEND_DOUBLE (&values, key_str, 0.1 * i + 1.0 / (i + 3.0));
+      } else {
+         BSON_APPEND_INT64 (&values, key_str, (int64_t) i * 1000003);
+      }
+   }
+   bson_append_array_end (doc, &values);
+}
+
+// Long strings, some of which need escaping.
+static void
+make_text (bson_t *doc)
+{
+   bson_init (doc);
+   for (uint32_t i = 0u; i < 20u; i++) {
+      char key[16];
+      const char *key_str;
+
+      bson_uint32_to_string (i, &key_str, key, sizeof key);
+      BSON_APPEND_UTF8 (doc,
+                        key_str,
+                        i % 4u ? "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor "
+                                 "incididunt ut labore et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud."
+                               : "Lorem ipsum dolor sit amet,\n\t\"consectetur\" adipiscing elit.\n");
+   }
+}
+
+// Convert @doc @iterations times, returning the elapsed time in microseconds and the length of the output.
+static int64_t
+run (const bson_t *doc, bson_json_mode_t mode, int32_t max_len, int iterations, size_t *json_len)
+{
+   bson_json_opts_t *const opts = bson_json_opts_new (mode, max_len);
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < iterations; i++) {
+      char *const json = bson_as_json_with_opts (doc, json_len, opts);
+      BSON_ASSERT (json);
+      bson_free (json);
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   bson_json_opts_destroy (opts);
+
+   return elapsed_usec;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int iterations = 100000;
+
+   if (argc > 1) {
+      iterations = atoi (argv[1]);
+   }
+
+   const struct {
+      const char *name;
+      void (*make) (bson_t *doc);
+   } docs[] = {
+      {"command", make_command},
+      {"numbers", make_numbers},
+      {"text", make_text},
+   };
+
+   const struct {
+      const char *name;
+      bson_json_mode_t mode;
+      int32_t max_len;
+   } formats[] = {
+      {"relaxed", BSON_JSON_MODE_RELAXED, BSON_MAX_LEN_UNLIMITED},
+      {"canonical", BSON_JSON_MODE_CANONICAL, BSON_MAX_LEN_UNLIMITED},
+      {"relaxed, max 1000", BSON_JSON_MODE_RELAXED, 1000},
+   };
+
+   for (size_t i = 0u; i < sizeof docs / sizeof docs[0]; i++) {
+      bson_t doc;
+
+      docs[i].make (&doc);
+
+      for (size_t j = 0u; j < sizeof formats / sizeof formats[0]; j++) {
+         size_t json_len = 0u;
+         const int64_t usec = BSON_MAX (run (&doc, formats[j].mode, formats[j].max_len, iterations, &json_len), 1);
+
+         printf ("%-8s %-18s %5" PRIu32 " bytes of BSON to %5zu of JSON: %8.1f MB/s, %6.0f ns/doc\n",
+                 docs[i].name,
+                 formats[j].name,
+                 doc.len,
+                 json_len,
+                 (double) doc.len * iterations / (double) usec,
+                 (double) usec * 1000.0 / (double) BSON_MAX (iterations, 1));
+      }
+
+      bson_destroy (&doc);
+   }
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,125 @@
+/*
+ * Measures the cost of iterating wide documents (hundreds of fields) with bson_iter_next and of looking up their
+ * fields by key with bson_iter_init_find, for short and long keys.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-bson-iter
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-bson-iter [number of fields] [number of passes]
+ * The integer arguments are optional, if not provided documents of 500 fields are scanned 2000 times by default.
+ */
+
+#include <bson/bson.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Build a document of @num_fields int32 fields whose keys are @prefix followed by the field number.
+static bson_t *
+make_doc (int num_fields, const char *prefix, char ***keys)
+{
+   bson_t *const doc = bson_new ();
+
+   *keys = bson_malloc (sizeof (char *) * (size_t) num_fields);
+
+   for (int i = 0; i < num_fields; i++) {
+      (*keys)[i] = bson_strdup_printf ("%s%d", prefix, i);
+      BSON_ASSERT (bson_append_int32 (doc, (*keys)[i], -1, i));
+   }
+
+   return doc;
+}
+
+// Iterate all fields of @doc @passes times, returning the average cost of one field in nanoseconds.
+static double
+run_iterate (const bson_t *doc, int num_fields, int passes)
+{
+   int64_t sum = 0;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < passes; i++) {
+      bson_iter_t iter;
+
+      BSON_ASSERT (bson_iter_init (&iter, doc));
+      while (bson_iter_next (&iter)) {
+         sum += bson_iter_int32_unsafe (&iter);
+      }
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   BSON_ASSERT (sum == (int64_t) passes * num_fields * (num_fields - 1) / 2);
+
+   return (double) elapsed_usec * 1000.0 / ((double) passes * (double) num_fields);
+}
+
+// Look up every @stride'th field of @doc by key @passes times, returning the average cost of one lookup in
+// nanoseconds.
+static double
+run_find (const bson_t *doc, char **keys, int num_fields, int stride, int passes)
+{
+   int64_t lookups = 0;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < passes; i++) {
+      for (int j = 0; j < num_fields; j += stride) {
+         bson_iter_t iter;
+
+         BSON_ASSERT (bson_iter_init_find (&iter, doc, keys[j]));
+         BSON_ASSERT (bson_iter_int32_unsafe (&iter) == j);
+         lookups++;
+      }
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   return (double) elapsed_usec * 1000.0 / (double) lookups;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_fields = 500;
+   int passes = 2000;
+
+   if (argc > 1) {
+      num_fields = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      passes = atoi (argv[2]);
+   }
+
+   const struct {
+      const char *name;
+      const char *prefix;
+   } shapes[] = {
+      {"short keys", "f"},
+      {"long keys", "customer_billing_address_line_"},
+   };
+
+   printf ("%d fields, %d passes\n", num_fields, passes);
+
+   for (size_t i = 0u; i < sizeof shapes / sizeof shapes[0]; i++) {
+      char **keys;
+      bson_t *const doc = make_doc (num_fields, shapes[i].prefix, &keys);
+
+      // Looking up every field is quadratic, so sample every tenth field with fewer passes.
+      const double iterate_ns = run_iterate (doc, num_fields, passes);
+      const double find_ns = run_find (doc, keys, num_fields, 10, passes / 10 + 1);
+
+      printf ("%-10s (%6" PRIu32 " bytes) iterate: %6.1f ns/field  find: %8.0f ns/lookup\n",
+              shapes[i].name,
+              doc->len,
+              iterate_ns,
+              find_ns);
+
+      for (int j = 0; j < num_fields; j++) {
+         bson_free (keys[j]);
+      }
+
+      bson_free (keys);
+      bson_destroy (doc);
+   }
+
+   return EXIT_SUCCESS;
+}
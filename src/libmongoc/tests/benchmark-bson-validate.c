@@ -0,0 +1,217 @@
+/*
+ * Measures the cost of bson_validate over the BSON corpus test vectors, both document by document and as a single
+ * large document embedding all of them, with the validation flags the driver applies to inserted documents.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-bson-validate
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-bson-validate [number of passes] [corpus directory]
+ * The arguments are optional, if not provided 2000 passes are made over src/libbson/tests/json/bson_corpus.
+ */
+
+#include <bson/bson.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static const char *const corpus_files[] = {
+   "array.json",          "binary.json",         "boolean.json",          "code.json",
+   "code_w_scope.json",   "datetime.json",       "dbpointer.json",        "dbref.json",
+   "decimal128-1.json",   "decimal128-2.json",   "decimal128-3.json",     "decimal128-4.json",
+   "decimal128-5.json",   "decimal128-6.json",   "decimal128-7.json",     "decimal128-mongoc.json",
+   "document.json",       "double.json",         "double2.json",          "int32.json",
+   "int64.json",          "maxkey.json",         "minkey.json",           "multi-type-deprecated.json",
+   "multi-type.json",     "null.json",           "oid.json",              "regex.json",
+   "string.json",         "symbol.json",         "timestamp.json",        "top-mongoc.json",
+   "top.json",            "undefined.json",
+};
+
+typedef struct {
+   bson_t *docs[2048];
+   size_t n;
+} corpus_t;
+
+static uint8_t *
+unhexlify (const char *hex, uint32_t *len)
+{
+   const size_t hex_len = strlen (hex);
+   uint8_t *const data = bson_malloc (hex_len / 2u + 1u);
+
+   for (size_t i = 0u; i + 1u < hex_len; i += 2u) {
+      unsigned int byte;
+
+      if (sscanf (hex + i, "%2x", &byte) != 1) {
+         break;
+      }
+
+      data[i / 2u] = (uint8_t) byte;
+   }
+
+   *len = (uint32_t) (hex_len / 2u);
+
+   return data;
+}
+
+// Add the BSON of each test in the @array_name array of @scenario that has a @field_name field.
+static void
+add_tests (corpus_t *corpus, const bson_t *scenario, const char *array_name, const char *field_name)
+{
+   bson_iter_t iter;
+   bson_iter_t tests;
+
+   if (!bson_iter_init_find (&iter, scenario, array_name) || !bson_iter_recurse (&iter, &tests)) {
+      return;
+   }
+
+   while (bson_iter_next (&tests) && corpus->n < sizeof corpus->docs / sizeof corpus->docs[0]) {
+      bson_iter_t test;
+      bson_iter_t field;
+
+      if (!bson_iter_recurse (&tests, &test) || !bson_iter_find_descendant (&test, field_name, &field) ||
+          !BSON_ITER_HOLDS_UTF8 (&field)) {
+         continue;
+      }
+
+      uint32_t len;
+      uint8_t *const data = unhexlify (bson_iter_utf8 (&field, NULL), &len);
+
+      // Decode error tests may not even frame a document.
+      corpus->docs[corpus->n] = bson_new_from_data (data, len);
+      if (corpus->docs[corpus->n]) {
+         corpus->n++;
+      }
+
+      bson_free (data);
+   }
+}
+
+// Validate every document of @corpus @passes times, returning the average cost of one document in nanoseconds.
+static double
+run (const corpus_t *corpus, bson_validate_flags_t flags, int passes, size_t *num_invalid)
+{
+   *num_invalid = 0u;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < passes; i++) {
+      for (size_t j = 0u; j < corpus->n; j++) {
+         size_t offset;
+
+         if (!bson_validate (corpus->docs[j], flags, &offset)) {
+            (*num_invalid)++;
+         }
+      }
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   *num_invalid /= (size_t) passes;
+
+   return (double) elapsed_usec * 1000.0 / ((double) passes * (double) corpus->n);
+}
+
+int
+main (int argc, char *argv[])
+{
+   int passes = 2000;
+   const char *dir = "src/libbson/tests/json/bson_corpus";
+
+   if (argc > 1) {
+      passes = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      dir = argv[2];
+   }
+
+   static corpus_t valid;
+   static corpus_t invalid;
+   static corpus_t combined;
+
+   for (size_t i = 0u; i < sizeof corpus_files / sizeof corpus_files[0]; i++) {
+      char path[512];
+      bson_error_t error;
+      bson_t scenario;
+
+      bson_snprintf (path, sizeof path, "%s/%s", dir, corpus_files[i]);
+
+      bson_json_reader_t *const reader = bson_json_reader_new_from_file (path, &error);
+      if (!reader) {
+         fprintf (stderr, "cannot open %s: %s\n", path, error.message);
+         return EXIT_FAILURE;
+      }
+
+      bson_init (&scenario);
+      if (bson_json_reader_read (reader, &scenario, &error) != 1) {
+         fprintf (stderr, "cannot parse %s: %s\n", path, error.message);
+         return EXIT_FAILURE;
+      }
+
+      add_tests (&valid, &scenario, "valid", "canonical_bson");
+      add_tests (&invalid, &scenario, "decodeErrors", "bson");
+
+      bson_destroy (&scenario);
+      bson_json_reader_destroy (reader);
+   }
+
+   const bson_validate_flags_t insert_flags =
+      BSON_VALIDATE_UTF8 | BSON_VALIDATE_EMPTY_KEYS | BSON_VALIDATE_DOT_KEYS | BSON_VALIDATE_DOLLAR_KEYS;
+
+   // One large document embedding every valid document that passes all checks, repeated to a few hundred kilobytes.
+   {
+      bson_t *const doc = bson_new ();
+      bson_array_builder_t *bab;
+
+      BSON_APPEND_ARRAY_BUILDER_BEGIN (doc, "corpus", &bab);
+      for (int copy = 0; copy < 16; copy++) {
+         for (size_t j = 0u; j < valid.n; j++) {
+            if (bson_validate (valid.docs[j], insert_flags, NULL)) {
+               bson_array_builder_append_document (bab, valid.docs[j]);
+            }
+         }
+      }
+      bson_append_array_builder_end (doc, bab);
+      combined.docs[0] = doc;
+      combined.n = 1u;
+   }
+
+   const struct {
+      const char *name;
+      bson_validate_flags_t flags;
+   } flag_sets[] = {
+      {"none", BSON_VALIDATE_NONE},
+      {"utf8", BSON_VALIDATE_UTF8},
+      {"insert", insert_flags},
+   };
+
+   printf ("%zu valid documents, %zu decode errors, combined document of %" PRIu32 " bytes\n",
+           valid.n,
+           invalid.n,
+           combined.docs[0]->len);
+
+   for (size_t i = 0u; i < sizeof flag_sets / sizeof flag_sets[0]; i++) {
+      size_t num_invalid[3];
+
+      const double valid_ns = run (&valid, flag_sets[i].flags, passes, &num_invalid[0]);
+      const double invalid_ns = run (&invalid, flag_sets[i].flags, passes, &num_invalid[1]);
+      const double combined_ns = run (&combined, flag_sets[i].flags, passes / 10 + 1, &num_invalid[2]);
+
+      printf ("%-7s valid: %6.0f ns/doc (%zu rejected)  decode errors: %6.0f ns/doc (%zu rejected)  combined: %8.0f "
+              "ns\n",
+              flag_sets[i].name,
+              valid_ns,
+              num_invalid[0],
+              invalid_ns,
+              num_invalid[1],
+              combined_ns);
+   }
+
+   for (size_t j = 0u; j < valid.n; j++) {
+      bson_destroy (valid.docs[j]);
+   }
+
+   for (size_t j = 0u; j < invalid.n; j++) {
+      bson_destroy (invalid.docs[j]);
+   }
+
+   bson_destroy (combined.docs[0]);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,82 @@
+/*
+ * Measures contention on mongoc_client_pool_pop and mongoc_client_pool_push when many threads check clients in and
+ * out without running any operation. No server is needed: clients are never used to send commands.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-client-pool
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-client-pool [number of threads] [checkouts per thread]
+ * The integer arguments are optional, if not provided 128 threads each check out a client 10000 times by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int checkouts_per_thread = 10000;
+
+static void *
+worker (void *data)
+{
+   mongoc_client_pool_t *pool = data;
+
+   for (int i = 0; i < checkouts_per_thread; i++) {
+      mongoc_client_t *const client = mongoc_client_pool_pop (pool);
+      mongoc_client_pool_push (pool, client);
+   }
+
+   return NULL;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_threads = 128;
+
+   if (argc > 1) {
+      num_threads = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      checkouts_per_thread = atoi (argv[2]);
+   }
+
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   pthread_t *threads;
+   int64_t start;
+   int64_t elapsed_usec;
+   int i;
+
+   mongoc_init ();
+
+   // Allow every thread to hold a client so only the free list is measured, not waiting for a client.
+   uri = mongoc_uri_new ("mongodb://localhost:27017/");
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MAXPOOLSIZE, num_threads);
+   pool = mongoc_client_pool_new (uri);
+   threads = bson_malloc0 ((size_t) num_threads * sizeof (pthread_t));
+
+   start = bson_get_monotonic_time ();
+
+   for (i = 0; i < num_threads; i++) {
+      pthread_create (&threads[i], NULL, worker, pool);
+   }
+
+   for (i = 0; i < num_threads; i++) {
+      pthread_join (threads[i], NULL);
+   }
+
+   elapsed_usec = bson_get_monotonic_time () - start;
+
+   printf ("%d threads, %d checkouts each: %.0f ns/checkout\n",
+           num_threads,
+           checkouts_per_thread,
+           (double) elapsed_usec * 1000.0 / ((double) num_threads * (double) checkouts_per_thread));
+
+   bson_free (threads);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+
+   mongoc_cleanup ();
+
+   return EXIT_SUCCESS;
+}
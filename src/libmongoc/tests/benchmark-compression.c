@@ -0,0 +1,143 @@
+/*
+ * Measures the per-message CPU cost of compressing and decompressing small command messages with one-shot
+ * compressor calls versus compressor state cached in a mongoc_compression_ctx_t.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-compression
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-compression [number of messages]
+ * The integer argument is optional, if not provided 100000 messages are compressed by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <mongoc/mongoc-compression-private.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct {
+   const char *name;
+   int32_t compressor_id;
+   int32_t compression_level;
+} compressor_t;
+
+// Compress and decompress @iov @n times, returning the average cost of one round trip in nanoseconds.
+static double
+run (const compressor_t *compressor,
+     mongoc_compression_ctx_t *ctx,
+     const mongoc_iovec_t *iov,
+     size_t iovcnt,
+     size_t uncompressed_len,
+     int n)
+{
+   const size_t compressed_cap = mongoc_compressor_max_compressed_length (compressor->compressor_id, uncompressed_len);
+   char *const compressed = bson_malloc (compressed_cap);
+   uint8_t *const uncompressed = bson_malloc (uncompressed_len);
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < n; i++) {
+      size_t compressed_len = compressed_cap;
+      size_t actual_len = uncompressed_len;
+
+      if (!mongoc_compress_iovec (ctx,
+                                  compressor->compressor_id,
+                                  compressor->compression_level,
+                                  iov,
+                                  iovcnt,
+                                  compressed,
+                                  &compressed_len)) {
+         fprintf (stderr, "%s: compression failed\n", compressor->name);
+         abort ();
+      }
+
+      if (!mongoc_uncompress (ctx,
+                              compressor->compressor_id,
+                              (const uint8_t *) compressed,
+                              compressed_len,
+                              uncompressed,
+                              &actual_len) ||
+          actual_len != uncompressed_len) {
+         fprintf (stderr, "%s: decompression failed\n", compressor->name);
+         abort ();
+      }
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   bson_free (uncompressed);
+   bson_free (compressed);
+
+   return (double) elapsed_usec * 1000.0 / (double) n;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int n = 100000;
+
+   if (argc > 1) {
+      n = atoi (argv[1]);
+   }
+
+   const compressor_t compressors[] = {
+      {MONGOC_COMPRESSOR_ZLIB_STR, MONGOC_COMPRESSOR_ZLIB_ID, -1},
+      {MONGOC_COMPRESSOR_ZSTD_STR, MONGOC_COMPRESSOR_ZSTD_ID, -1},
+      {MONGOC_COMPRESSOR_SNAPPY_STR, MONGOC_COMPRESSOR_SNAPPY_ID, -1},
+   };
+
+   mongoc_init ();
+
+   // A typical small command: a find with a filter, split into iovecs like an OP_MSG.
+   bson_t *const header = BCON_NEW ("find", "coll", "$db", "db", "lsid", "{", "id", BCON_INT64 (42), "}");
+   bson_t *const filter = BCON_NEW ("filter",
+                                    "{",
+                                    "status",
+                                    "active",
+                                    "qty",
+                                    "{",
+                                    "$gt",
+                                    BCON_INT32 (10),
+                                    "}",
+                                    "}",
+                                    "projection",
+                                    "{",
+                                    "_id",
+                                    BCON_INT32 (0),
+                                    "}");
+   const uint8_t flags[5] = {0};
+   mongoc_iovec_t iov[3];
+
+   iov[0].iov_base = (void *) flags;
+   iov[0].iov_len = sizeof flags;
+   iov[1].iov_base = (void *) bson_get_data (header);
+   iov[1].iov_len = header->len;
+   iov[2].iov_base = (void *) bson_get_data (filter);
+   iov[2].iov_len = filter->len;
+
+   const size_t uncompressed_len = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+
+   printf ("%d messages of %zu bytes\n", n, uncompressed_len);
+
+   for (size_t i = 0u; i < sizeof compressors / sizeof compressors[0]; i++) {
+      const compressor_t *const compressor = &compressors[i];
+
+      if (!mongoc_compressor_supported (compressor->name)) {
+         printf ("%-8s not compiled in\n", compressor->name);
+         continue;
+      }
+
+      mongoc_compression_ctx_t *const ctx = mongoc_compression_ctx_new ();
+
+      const double one_shot_ns = run (compressor, NULL, iov, 3u, uncompressed_len, n);
+      const double cached_ns = run (compressor, ctx, iov, 3u, uncompressed_len, n);
+
+      printf ("%-8s one-shot: %8.0f ns/msg  cached context: %8.0f ns/msg\n", compressor->name, one_shot_ns, cached_ns);
+
+      mongoc_compression_ctx_destroy (ctx);
+   }
+
+   bson_destroy (filter);
+   bson_destroy (header);
+
+   mongoc_cleanup ();
+
+   return EXIT_SUCCESS;
+}
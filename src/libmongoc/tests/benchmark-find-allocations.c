@@ -0,0 +1,177 @@
+/*
+ * Counts the heap allocations made by one mongoc_collection_find_with_opts call, from creating the cursor through
+ * iterating its results to destroying it, against a mock server answering every find with a small batch.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-find-allocations
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-find-allocations [number of finds]
+ * The integer argument is optional, if not provided 10000 finds are run by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <mongoc/mongoc-client-private.h>
+
+#include "TestSuite.h"
+#include "mock_server/mock-server.h"
+#include "mock_server/request.h"
+#include "test-libmongoc.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec (thread)
+#else
+#define THREAD_LOCAL __thread
+#endif
+
+// Only allocations made by the thread running the finds are counted, not those of the mock server's threads.
+static THREAD_LOCAL bool counting;
+static THREAD_LOCAL int64_t allocations;
+static THREAD_LOCAL int64_t allocated_bytes;
+
+static void *
+counting_malloc (size_t num_bytes)
+{
+   if (counting) {
+      allocations++;
+      allocated_bytes += (int64_t) num_bytes;
+   }
+
+   return malloc (num_bytes);
+}
+
+static void *
+counting_calloc (size_t n_members, size_t num_bytes)
+{
+   if (counting) {
+      allocations++;
+      allocated_bytes += (int64_t) (n_members * num_bytes);
+   }
+
+   return calloc (n_members, num_bytes);
+}
+
+static void *
+counting_realloc (void *mem, size_t num_bytes)
+{
+   if (counting) {
+      allocations++;
+      allocated_bytes += (int64_t) num_bytes;
+   }
+
+   return realloc (mem, num_bytes);
+}
+
+static bool
+auto_find (request_t *request, void *data)
+{
+   BSON_UNUSED (data);
+
+   if (!request->is_command || strcasecmp (request->command_name, "find") != 0) {
+      return false;
+   }
+
+   reply_to_request_simple (request,
+                            "{'ok': 1, 'cursor': {'id': 0, 'ns': 'db.coll', 'firstBatch': [{'_id': 1}, {'_id': 2}]}}");
+   request_destroy (request);
+
+   return true;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_finds = 10000;
+
+   if (argc > 1) {
+      num_finds = atoi (argv[1]);
+   }
+
+   // The vtable must be installed before anything is allocated. Aligned allocations fall back to counting_malloc.
+   const bson_mem_vtable_t vtable = {counting_malloc, counting_calloc, counting_realloc, free, NULL, {0}};
+   bson_mem_set_vtable (&vtable);
+
+   // The mock server logs through the test suite.
+   TestSuite suite;
+   TestSuite_Init (&suite, "benchmark-find-allocations", 1, argv);
+
+   mongoc_init ();
+   // Silence the mock server starting up.
+   mongoc_log_set_handler (NULL, NULL);
+
+   mock_server_t *const server = mock_server_with_auto_hello (WIRE_VERSION_MAX);
+   mock_server_autoresponds (server, auto_find, NULL, NULL);
+   mock_server_auto_endsessions (server);
+   mock_server_run (server);
+
+   mongoc_client_t *const client = mongoc_client_new_from_uri (mock_server_get_uri (server));
+   BSON_ASSERT (client);
+   mongoc_collection_t *const coll = mongoc_client_get_collection (client, "db", "coll");
+
+   bson_t *const filter = BCON_NEW ("status", "active", "region", "{", "$in", "[", "emea", "apac", "]", "}");
+   bson_t *const opts = BCON_NEW ("projection",
+                                  "{",
+                                  "_id",
+                                  BCON_INT32 (1),
+                                  "}",
+                                  "sort",
+                                  "{",
+                                  "_id",
+                                  BCON_INT32 (1),
+                                  "}",
+                                  "limit",
+                                  BCON_INT64 (100),
+                                  "comment",
+                                  "benchmark");
+
+   int64_t num_docs = 0;
+   int64_t elapsed_usec = 0;
+
+   // The first find connects to the server, which is not measured.
+   for (int i = -1; i < num_finds; i++) {
+      const int64_t start = bson_get_monotonic_time ();
+      const bson_t *doc;
+      bson_error_t error;
+
+      counting = i >= 0;
+
+      mongoc_cursor_t *const cursor = mongoc_collection_find_with_opts (coll, filter, opts, NULL);
+
+      while (mongoc_cursor_next (cursor, &doc)) {
+         num_docs++;
+      }
+
+      if (mongoc_cursor_error (cursor, &error)) {
+         fprintf (stderr, "find failed: %s\n", error.message);
+         return EXIT_FAILURE;
+      }
+
+      mongoc_cursor_destroy (cursor);
+
+      counting = false;
+
+      if (i >= 0) {
+         elapsed_usec += bson_get_monotonic_time () - start;
+      }
+   }
+
+   BSON_ASSERT (num_docs == 2 * ((int64_t) num_finds + 1));
+
+   printf ("%d finds\n", num_finds);
+   printf ("allocations: %8.1f per find (%.0f bytes)\n",
+           (double) allocations / (double) num_finds,
+           (double) allocated_bytes / (double) num_finds);
+   printf ("time:        %8.1f us per find\n", (double) elapsed_usec / (double) num_finds);
+
+   bson_destroy (opts);
+   bson_destroy (filter);
+   mongoc_collection_destroy (coll);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+
+   mongoc_cleanup ();
+
+   TestSuite_Destroy (&suite);
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,179 @@
+/*
+ * Measures the throughput of bson_json_reader_read over newline-delimited JSON with the streaming and indexed
+ * parsers, and checks that both produce the same documents.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-json-parse
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-json-parse [number of passes] [NDJSON file]
+ * The arguments are optional, if not provided 5 passes are made over about 64 MB of generated extended JSON.
+ */
+
+#include <bson/bson.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// Generate documents shaped like typical application data, with a mix of strings, numbers, nested documents,
+// arrays, and canonical extended JSON values.
+static char *
+generate (size_t min_len, size_t *len)
+{
+   const size_t alloc = min_len + 4096u;
+   char *const data = bson_malloc (alloc);
+
+   *len = 0u;
+
+   for (uint32_t i = 0u; *len < min_len; i++) {
+      const int n = bson_snprintf (
+         data + *len,
+         alloc - *len,
+         "{\"_id\": {\"$oid\": \"5f1a%020" PRIx32 "\"}, \"index\": %" PRIu32 ", \"guid\": \"%08" PRIx32
+         "-7d4c-4bb2-8a27-3c1b0e9a4f61\", \"isActive\": %s, \"balance\": %" PRIu32 ".%02" PRIu32
+         ", \"name\": \"User %" PRIu32 "\", \"email\": \"user%" PRIu32
+         "@example.com\", \"about\": \"Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod "
+         "tempor incididunt ut labore et dolore magna aliqua.\\nUt enim ad minim veniam.\", \"registered\": "
+         "{\"$date\": {\"$numberLong\": \"%" PRIu32 "000\"}}, \"visits\": {\"$numberLong\": \"%" PRIu32
+         "\"}, \"location\": {\"latitude\": -%" PRIu32 ".125, \"longitude\": %" PRIu32
+         ".5e1}, \"tags\": [\"alpha\", \"beta\", \"gamma\", \"delta\"], \"friends\": [{\"id\": 0, \"name\": "
+         "\"Ann\"}, {\"id\": 1, \"name\": \"Bob\"}, {\"id\": 2, \"name\": \"Cy\"}], \"score\": null}\n",
+         i,
+         i,
+         i,
+         i % 2u ? "true" : "false",
+         i % 10000u,
+         i % 100u,
+         i,
+         i,
+         1500000000u + i,
+         i * 7u,
+         i % 90u,
+         i % 180u);
+
+      BSON_ASSERT (n > 0 && (size_t) n < alloc - *len);
+      *len += (size_t) n;
+   }
+
+   return data;
+}
+
+static char *
+read_file (const char *path, size_t *len)
+{
+   FILE *const f = fopen (path, "rb");
+   char *data;
+
+   if (!f || fseek (f, 0, SEEK_END) != 0) {
+      return NULL;
+   }
+
+   *len = (size_t) ftell (f);
+   rewind (f);
+   data = bson_malloc (*len + 1u);
+
+   if (fread (data, 1u, *len, f) != *len) {
+      bson_free (data);
+      data = NULL;
+   }
+
+   fclose (f);
+
+   return data;
+}
+
+// Parse every document of @data, returning the elapsed time in microseconds and the number and total size of the
+// documents parsed.
+static int64_t
+run (const char *data, size_t len, bson_json_parser_t parser, size_t *num_docs, uint64_t *bson_bytes)
+{
+   bson_json_reader_t *const reader = bson_json_data_reader_new (true, 64u * 1024u);
+   bson_error_t error;
+   bson_t doc;
+   int r;
+
+   bson_json_reader_set_parser (reader, parser);
+   bson_json_data_reader_ingest (reader, (const uint8_t *) data, len);
+
+   *num_docs = 0u;
+   *bson_bytes = 0u;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   bson_init (&doc);
+   while ((r = bson_json_reader_read (reader, &doc, &error)) == 1) {
+      (*num_docs)++;
+      *bson_bytes += doc.len;
+      bson_reinit (&doc);
+   }
+   bson_destroy (&doc);
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   if (r < 0) {
+      fprintf (stderr, "parse error after %zu documents: %s\n", *num_docs, error.message);
+      exit (EXIT_FAILURE);
+   }
+
+   bson_json_reader_destroy (reader);
+
+   return elapsed_usec;
+}
+
+int
+main (int argc, char *argv[])
+{
+   int passes = 5;
+   size_t len;
+   char *data;
+
+   if (argc > 1) {
+      passes = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      data = read_file (argv[2], &len);
+      if (!data) {
+         fprintf (stderr, "cannot read %s\n", argv[2]);
+         return EXIT_FAILURE;
+      }
+   } else {
+      data = generate (64u * 1024u * 1024u, &len);
+   }
+
+   const struct {
+      const char *name;
+      bson_json_parser_t parser;
+   } parsers[] = {
+      {"streaming", BSON_JSON_PARSER_STREAMING},
+      {"indexed", BSON_JSON_PARSER_INDEXED},
+   };
+
+   size_t expected_docs = 0u;
+   uint64_t expected_bytes = 0u;
+
+   for (size_t i = 0u; i < sizeof parsers / sizeof parsers[0]; i++) {
+      int64_t best_usec = INT64_MAX;
+      size_t num_docs = 0u;
+      uint64_t bson_bytes = 0u;
+
+      for (int pass = 0; pass < passes; pass++) {
+         best_usec = BSON_MIN (best_usec, run (data, len, parsers[i].parser, &num_docs, &bson_bytes));
+      }
+
+      if (i == 0u) {
+         expected_docs = num_docs;
+         expected_bytes = bson_bytes;
+      } else if (num_docs != expected_docs || bson_bytes != expected_bytes) {
+         fprintf (stderr, "%s parser produced different documents\n", parsers[i].name);
+         return EXIT_FAILURE;
+      }
+
+      printf ("%-9s %zu documents, %zu bytes of JSON: %8.1f MB/s, %6.0f ns/doc\n",
+              parsers[i].name,
+              num_docs,
+              len,
+              (double) len / (double) BSON_MAX (best_usec, 1),
+              (double) best_usec * 1000.0 / (double) BSON_MAX (num_docs, 1u));
+   }
+
+   bson_free (data);
+
+   return EXIT_SUCCESS;
+}
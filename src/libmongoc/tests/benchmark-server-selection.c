@@ -0,0 +1,209 @@
+/*
+ * Measures the cost of mongoc_topology_select_server_id in a replica set with 50 tagged members, for read preferences
+ * that select the primary, secondaries by tag, and the nearest members by tag with maxStalenessSeconds. Threads share
+ * one topology, as the clients of a pool do. No server is needed: the topology is built from made-up hello responses
+ * and is never scanned.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-server-selection
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-server-selection [number of threads] [selections per thread]
+ * The integer arguments are optional, if not provided 4 threads each select 200000 servers by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <mongoc/mongoc-client-private.h>
+#include <mongoc/mongoc-topology-private.h>
+
+#include <common-thread-private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define NUM_MEMBERS 50
+#define NUM_DCS 5
+
+static int selections_per_thread = 200000;
+
+static mongoc_topology_t *topology;
+
+static const mongoc_read_prefs_t *read_prefs;
+
+static BSON_THREAD_FUN (worker, arg)
+{
+   const mongoc_ss_log_context_t log_context = {.operation = "benchmark"};
+   bson_error_t error;
+
+   BSON_UNUSED (arg);
+
+   for (int i = 0; i < selections_per_thread; i++) {
+      if (!mongoc_topology_select_server_id (
+             topology, MONGOC_SS_READ, &log_context, read_prefs, NULL /* must_use_primary */, NULL, &error)) {
+         fprintf (stderr, "server selection failed: %s\n", error.message);
+         abort ();
+      }
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+static void
+run (const char *name, const mongoc_read_prefs_t *prefs, int num_threads)
+{
+   bson_thread_t *const threads = bson_malloc0 ((size_t) num_threads * sizeof (bson_thread_t));
+
+   read_prefs = prefs;
+
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < num_threads; i++) {
+      if (mcommon_thread_create (&threads[i], worker, NULL) != 0) {
+         fprintf (stderr, "failed to create thread\n");
+         abort ();
+      }
+   }
+
+   for (int i = 0; i < num_threads; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   printf ("%-24s %d threads, %d selections each: %.1f ns/selection\n",
+           name,
+           num_threads,
+           selections_per_thread,
+           (double) elapsed_usec * 1000.0 / ((double) num_threads * (double) selections_per_thread));
+
+   bson_free (threads);
+}
+
+// Respond to hello on behalf of every member. "host0" is the primary, the others are secondaries spread across
+// NUM_DCS data centers with different round trip times.
+static void
+build_replica_set (void)
+{
+   mc_tpld_modification tdmod = mc_tpld_modify_begin (topology);
+   bson_t hosts = BSON_INITIALIZER;
+   const int64_t now_ms = (int64_t) time (NULL) * 1000;
+
+   for (int i = 0; i < NUM_MEMBERS; i++) {
+      char key[16];
+      char host[32];
+
+      bson_snprintf (key, sizeof key, "%d", i);
+      bson_snprintf (host, sizeof host, "host%d:27017", i);
+      BSON_APPEND_UTF8 (&hosts, key, host);
+   }
+
+   // The hello from the primary adds the other members to the topology description, so respond for it first.
+   for (int i = 0; i < NUM_MEMBERS; i++) {
+      char host[32];
+      char dc[16];
+      uint32_t id;
+
+      bson_snprintf (host, sizeof host, "host%d:27017", i);
+      bson_snprintf (dc, sizeof dc, "dc%d", i % NUM_DCS);
+
+      bson_t *const hello = BCON_NEW ("ok",
+                                      BCON_INT32 (1),
+                                      "isWritablePrimary",
+                                      BCON_BOOL (i == 0),
+                                      "secondary",
+                                      BCON_BOOL (i != 0),
+                                      "setName",
+                                      "rs",
+                                      "minWireVersion",
+                                      BCON_INT32 (WIRE_VERSION_MIN),
+                                      "maxWireVersion",
+                                      BCON_INT32 (WIRE_VERSION_MAX),
+                                      "hosts",
+                                      BCON_ARRAY (&hosts),
+                                      "tags",
+                                      "{",
+                                      "dc",
+                                      BCON_UTF8 (dc),
+                                      "rack",
+                                      BCON_UTF8 (host),
+                                      "}",
+                                      "lastWrite",
+                                      "{",
+                                      "lastWriteDate",
+                                      BCON_DATE_TIME (now_ms),
+                                      "}");
+
+      if (!mongoc_topology_description_add_server (tdmod.new_td, &topology->log_and_monitor, host, &id)) {
+         abort ();
+      }
+
+      mongoc_topology_description_handle_hello (
+         tdmod.new_td, &topology->log_and_monitor, id, hello, 1 + i % 20 /* rtt_msec */, NULL);
+
+      bson_destroy (hello);
+   }
+
+   if (tdmod.new_td->type != MONGOC_TOPOLOGY_RS_WITH_PRIMARY ||
+       mc_tpld_servers_const (tdmod.new_td)->items_len != NUM_MEMBERS) {
+      fprintf (stderr, "failed to build the replica set\n");
+      abort ();
+   }
+
+   mc_tpld_modify_commit (tdmod);
+   bson_destroy (&hosts);
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_threads = 4;
+
+   if (argc > 1) {
+      num_threads = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      selections_per_thread = atoi (argv[2]);
+   }
+
+   if (num_threads < 1 || selections_per_thread < 1) {
+      fprintf (stderr, "usage: %s [number of threads] [selections per thread]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_init ();
+
+   mongoc_uri_t *const uri = mongoc_uri_new ("mongodb://host0/?replicaSet=rs");
+   topology = mongoc_topology_new (uri, false /* single-threaded */);
+   build_replica_set ();
+
+   mongoc_read_prefs_t *const primary = mongoc_read_prefs_new (MONGOC_READ_PRIMARY);
+
+   mongoc_read_prefs_t *const secondary = mongoc_read_prefs_new (MONGOC_READ_SECONDARY);
+   bson_t *const tags = BCON_NEW ("0", "{", "dc", "dc7", "}", "1", "{", "dc", "dc2", "}");
+   mongoc_read_prefs_set_tags (secondary, tags);
+
+   mongoc_read_prefs_t *const nearest = mongoc_read_prefs_new (MONGOC_READ_NEAREST);
+   mongoc_read_prefs_set_tags (nearest, tags);
+   mongoc_read_prefs_set_max_staleness_seconds (nearest, 120);
+
+   run ("primary", primary, 1);
+   run ("secondary, tags", secondary, 1);
+   run ("nearest, tags, staleness", nearest, 1);
+
+   if (num_threads > 1) {
+      run ("primary", primary, num_threads);
+      run ("secondary, tags", secondary, num_threads);
+      run ("nearest, tags, staleness", nearest, num_threads);
+   }
+
+   mongoc_read_prefs_destroy (nearest);
+   mongoc_read_prefs_destroy (secondary);
+   mongoc_read_prefs_destroy (primary);
+   bson_destroy (tags);
+
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+
+   mongoc_cleanup ();
+
+   return EXIT_SUCCESS;
+}
@@ -0,0 +1,106 @@
+/*
+ * Measures the cost of mc_tpld_take_ref and mc_tpld_drop_ref when many threads take references to the topology
+ * description at once, as server selection does. Threads either all share one topology or each use their own, which
+ * shows whether unrelated topologies contend with each other. No server is needed: topologies are never scanned.
+ *
+ * TO BUILD: % cmake --build cmake-build --target benchmark-tpld-ref
+ * TO RUN: % ./cmake-build/src/libmongoc/benchmark-tpld-ref [number of threads] [references per thread]
+ * The integer arguments are optional, if not provided 8 threads each take 1000000 references by default.
+ */
+
+#include <mongoc/mongoc.h>
+#include <mongoc/mongoc-topology-private.h>
+
+#include <common-thread-private.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int refs_per_thread = 1000000;
+
+static BSON_THREAD_FUN (worker, arg)
+{
+   const mongoc_topology_t *topology = arg;
+
+   for (int i = 0; i < refs_per_thread; i++) {
+      mc_shared_tpld td = mc_tpld_take_ref (topology);
+      if (!td.ptr) {
+         abort ();
+      }
+      mc_tpld_drop_ref (&td);
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+// Run @num_threads threads over @topologies, thread i using topology i modulo @num_topologies.
+static void
+run (const char *name, mongoc_topology_t **topologies, int num_topologies, int num_threads)
+{
+   bson_thread_t *const threads = bson_malloc0 ((size_t) num_threads * sizeof (bson_thread_t));
+   const int64_t start = bson_get_monotonic_time ();
+
+   for (int i = 0; i < num_threads; i++) {
+      if (mcommon_thread_create (&threads[i], worker, topologies[i % num_topologies]) != 0) {
+         fprintf (stderr, "failed to create thread\n");
+         abort ();
+      }
+   }
+
+   for (int i = 0; i < num_threads; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   const int64_t elapsed_usec = bson_get_monotonic_time () - start;
+
+   printf ("%-20s %d threads, %d refs each: %.1f ns/ref\n",
+           name,
+           num_threads,
+           refs_per_thread,
+           (double) elapsed_usec * 1000.0 / ((double) num_threads * (double) refs_per_thread));
+
+   bson_free (threads);
+}
+
+int
+main (int argc, char *argv[])
+{
+   int num_threads = 8;
+
+   if (argc > 1) {
+      num_threads = atoi (argv[1]);
+   }
+
+   if (argc > 2) {
+      refs_per_thread = atoi (argv[2]);
+   }
+
+   if (num_threads < 1 || refs_per_thread < 1) {
+      fprintf (stderr, "usage: %s [number of threads] [references per thread]\n", argv[0]);
+      return EXIT_FAILURE;
+   }
+
+   mongoc_init ();
+
+   mongoc_uri_t *const uri = mongoc_uri_new ("mongodb://localhost:27017/");
+   mongoc_topology_t **const topologies = bson_malloc0 ((size_t) num_threads * sizeof (mongoc_topology_t *));
+
+   for (int i = 0; i < num_threads; i++) {
+      topologies[i] = mongoc_topology_new (uri, false /* single-threaded */);
+   }
+
+   run ("single thread", topologies, 1, 1);
+   run ("shared topology", topologies, 1, num_threads);
+   run ("topology per thread", topologies, num_threads, num_threads);
+
+   for (int i = 0; i < num_threads; i++) {
+      mongoc_topology_destroy (topologies[i]);
+   }
+
+   bson_free (topologies);
+   mongoc_uri_destroy (uri);
+
+   mongoc_cleanup ();
+
+   return EXIT_SUCCESS;
+}
@@ -24,6 +24,7 @@ main (int argc, char *argv[])
    } else                                      \
       ((void) 0)
 
+   TEST_INSTALL (test_arena_install);
    TEST_INSTALL (test_atomic_install);
    TEST_INSTALL (test_bcon_basic_install);
    TEST_INSTALL (test_bcon_extract_install);
@@ -35,12 +36,14 @@ main (int argc, char *argv[])
    TEST_INSTALL (test_clock_install);
    TEST_INSTALL (test_decimal128_install);
    TEST_INSTALL (test_endian_install);
+   TEST_INSTALL (test_index_install);
    TEST_INSTALL (test_iso8601_install);
    TEST_INSTALL (test_iter_install);
    TEST_INSTALL (test_json_install);
    TEST_INSTALL (test_oid_install);
    TEST_INSTALL (test_reader_install);
    TEST_INSTALL (test_string_install);
+   TEST_INSTALL (test_template_install);
    TEST_INSTALL (test_utf8_install);
    TEST_INSTALL (test_value_install);
    TEST_INSTALL (test_writer_install);
@@ -75,7 +75,7 @@ test_hello_helper (mongoc_async_cmd_t *acmd,
 
 
 static void
-test_hello_impl (bool with_ssl)
+test_hello_impl (bool with_ssl, bool force_poll)
 {
    mock_server_t *servers[NSERVERS];
    mongoc_async_t *async;
@@ -120,6 +120,7 @@ test_hello_impl (bool with_ssl)
    }
 
    async = mongoc_async_new ();
+   async->force_poll = force_poll;
 
    for (i = 0; i < NSERVERS; i++) {
       sock_streams[i] = get_localhost_stream (ports[i]);
@@ -199,7 +200,13 @@ test_hello_impl (bool with_ssl)
 static void
 test_hello (void)
 {
-   test_hello_impl (false);
+   test_hello_impl (false, false);
+}
+
+static void
+test_hello_poll (void)
+{
+   test_hello_impl (false, true);
 }
 
 
@@ -207,7 +214,7 @@ test_hello (void)
 static void
 test_hello_ssl (void)
 {
-   test_hello_impl (true);
+   test_hello_impl (true, false);
 }
 #else
 
@@ -370,6 +377,7 @@ void
 test_async_install (TestSuite *suite)
 {
    TestSuite_AddMockServerTest (suite, "/Async/hello", test_hello);
+   TestSuite_AddMockServerTest (suite, "/Async/hello/poll", test_hello_poll);
 #if defined(MONGOC_ENABLE_SSL_OPENSSL)
    TestSuite_AddMockServerTest (suite, "/Async/hello_ssl", test_hello_ssl);
 #else
@@ -3530,8 +3530,12 @@ test_bulk_max_msg_size (void)
    mongoc_collection_drop (collection, NULL);
 
    /* Cluster time document argument is injected sometimes */
-   if (!bson_empty (&client->topology->_shared_descr_.ptr->cluster_time)) {
-      filler_string -= client->topology->_shared_descr_.ptr->cluster_time.len + strlen ("$clusterTime") + 2u;
+   {
+      mongoc_shared_ptr cluster_time = _mongoc_topology_get_cluster_time (client->topology);
+      if (!mongoc_shared_ptr_is_null (cluster_time)) {
+         filler_string -= ((const bson_t *) cluster_time.ptr)->len + strlen ("$clusterTime") + 2u;
+      }
+      mongoc_shared_ptr_reset_null (&cluster_time);
    }
 
    /* API version may be appended */
@@ -3750,6 +3754,80 @@ test_bulk_max_batch_size (void)
 }
 
 
+static void
+command_started (const mongoc_apm_command_started_t *event)
+{
+   const char *cmd_name = mongoc_apm_command_started_get_command_name (event);
+
+   if (!strcasecmp (cmd_name, "insert")) {
+      ((stats_t *) mongoc_apm_command_started_get_context (event))->started++;
+   }
+}
+
+
+/* Unacknowledged batches are pipelined, each with its own command events. */
+static void
+test_bulk_unacknowledged_batches (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_collection_t *collection;
+   mongoc_bulk_operation_t *bulk;
+   mongoc_apm_callbacks_t *callbacks;
+   stats_t stats = {0};
+   bson_error_t error;
+   bson_t reply;
+   request_t *request;
+   int i;
+
+   server = mock_server_new ();
+   mock_server_run (server);
+   mock_server_auto_hello (server,
+                           "{'ok': 1,"
+                           " 'minWireVersion': %d,"
+                           " 'maxWireVersion': %d,"
+                           " 'maxWriteBatchSize': 1,"
+                           " 'isWritablePrimary': true}",
+                           WIRE_VERSION_MIN,
+                           WIRE_VERSION_MAX);
+
+   client = test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+   callbacks = mongoc_apm_callbacks_new ();
+   mongoc_apm_set_command_started_cb (callbacks, command_started);
+   mongoc_apm_set_command_succeeded_cb (callbacks, command_succeeded);
+   mongoc_client_set_apm_callbacks (client, callbacks, (void *) &stats);
+   collection = mongoc_client_get_collection (client, "db", "test");
+   bulk = mongoc_collection_create_bulk_operation_with_opts (collection, tmp_bson ("{'writeConcern': {'w': 0}}"));
+
+   /* maxWriteBatchSize is set to 1; with 3 inserts we get 3 batches */
+   for (i = 0; i < 3; i++) {
+      ASSERT_OR_PRINT (mongoc_bulk_operation_insert_with_opts (bulk, tmp_bson ("{'_id': %d}", i), NULL, &error),
+                       error);
+   }
+
+   /* no reply to wait for */
+   ASSERT_OR_PRINT (mongoc_bulk_operation_execute (bulk, &reply, &error), error);
+   ASSERT_CMPINT (stats.started, ==, 3);
+   ASSERT_CMPINT (stats.succeeded, ==, 3);
+
+   for (i = 0; i < 3; i++) {
+      request = mock_server_receives_msg (server,
+                                          MONGOC_MSG_MORE_TO_COME,
+                                          tmp_bson ("{'$db': 'db', 'insert': 'test'}"),
+                                          tmp_bson ("{'_id': %d}", i));
+      BSON_ASSERT (request);
+      request_destroy (request);
+   }
+
+   bson_destroy (&reply);
+   mongoc_bulk_operation_destroy (bulk);
+   mongoc_collection_destroy (collection);
+   mongoc_apm_callbacks_destroy (callbacks);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+
 static void
 test_bulk_new (void)
 {
@@ -4902,6 +4980,8 @@ test_bulk_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/BulkOperation/new", test_bulk_new);
    TestSuite_AddLive (suite, "/BulkOperation/OP_MSG/max_batch_size", test_bulk_max_batch_size);
    TestSuite_AddLive (suite, "/BulkOperation/OP_MSG/max_msg_size", test_bulk_max_msg_size);
+   TestSuite_AddMockServerTest (
+      suite, "/BulkOperation/OP_MSG/unacknowledged_batches", test_bulk_unacknowledged_batches);
    TestSuite_AddFull (suite,
                       "/BulkOperation/split",
                       test_bulk_split,
@@ -456,6 +456,43 @@ test_client_pool_max_pool_size_exceeded (void)
    bson_free (args);
 }
 
+static BSON_THREAD_FUN (pop_push_worker, arg)
+{
+   mongoc_client_pool_t *pool = arg;
+
+   for (int i = 0; i < 1000; i++) {
+      mongoc_client_t *client = mongoc_client_pool_pop (pool);
+      BSON_ASSERT (client);
+      mongoc_client_pool_push (pool, client);
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+/* Threads checking clients in and out concurrently never exceed maxPoolSize
+ * and every client ends up back in the pool. */
+static void
+test_client_pool_concurrent_pop_push (void)
+{
+   mongoc_uri_t *uri = mongoc_uri_new ("mongodb://127.0.0.1/?maxpoolsize=3");
+   mongoc_client_pool_t *pool = mongoc_client_pool_new (uri);
+   bson_thread_t threads[8];
+
+   for (size_t i = 0u; i < sizeof threads / sizeof threads[0]; i++) {
+      ASSERT_CMPINT (0, ==, mcommon_thread_create (&threads[i], pop_push_worker, pool));
+   }
+
+   for (size_t i = 0u; i < sizeof threads / sizeof threads[0]; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPSIZE_T (mongoc_client_pool_get_size (pool), <=, (size_t) 3);
+   ASSERT_CMPSIZE_T (mongoc_client_pool_num_pushed (pool), ==, mongoc_client_pool_get_size (pool));
+
+   mongoc_uri_destroy (uri);
+   mongoc_client_pool_destroy (pool);
+}
+
 static void
 test_client_pool_can_override_sockettimeoutms (void)
 {
@@ -679,6 +716,7 @@ test_client_pool_install (TestSuite *suite)
    TestSuite_AddLive (suite, "/ClientPool/destroy_without_push", test_client_pool_destroy_without_pushing);
    TestSuite_AddLive (suite, "/ClientPool/max_pool_size_exceeded", test_client_pool_max_pool_size_exceeded);
    TestSuite_Add (suite, "/ClientPool/can_override_sockettimeoutms", test_client_pool_can_override_sockettimeoutms);
+   TestSuite_Add (suite, "/ClientPool/concurrent_pop_push", test_client_pool_concurrent_pop_push);
 
    TestSuite_AddFull (
       suite,
@@ -3,9 +3,11 @@
 
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-client-pool-private.h>
+#include <mongoc/mongoc-compression-private.h>
 #include <mongoc/mongoc-topology-background-monitoring-private.h>
 #include <mongoc/mongoc-uri-private.h>
 #include <common-oid-private.h>
+#include <common-thread-private.h>
 
 #include "mock_server/mock-server.h"
 #include "mock_server/future.h"
@@ -55,7 +57,7 @@ test_get_max_bson_obj_size (void)
 
    id = server_id_for_reads (&client->cluster);
    tdmod = mc_tpld_modify_begin (client->topology);
-   sd = mongoc_set_get (mc_tpld_servers (tdmod.new_td), id);
+   sd = mongoc_topology_description_server_by_id (tdmod.new_td, id, NULL);
    sd->max_bson_obj_size = max_bson_obj_size;
    mc_tpld_modify_commit (tdmod);
    BSON_ASSERT (max_bson_obj_size == mongoc_cluster_get_max_bson_obj_size (&client->cluster));
@@ -91,7 +93,7 @@ test_get_max_msg_size (void)
    id = server_id_for_reads (&client->cluster);
 
    tdmod = mc_tpld_modify_begin (client->topology);
-   sd = mongoc_set_get (mc_tpld_servers (tdmod.new_td), id);
+   sd = mongoc_topology_description_server_by_id (tdmod.new_td, id, NULL);
    sd->max_msg_size = max_msg_size;
    mc_tpld_modify_commit (tdmod);
    BSON_ASSERT (max_msg_size == mongoc_cluster_get_max_msg_size (&client->cluster));
@@ -1404,6 +1406,787 @@ test_cluster_command_error (void)
    mongoc_client_destroy (client);
 }
 
+static void
+_run_ping_with_reply (mock_server_t *server, mongoc_client_t *client, const bson_t *server_reply, bson_t *reply)
+{
+   bson_error_t error;
+   request_t *request;
+   future_t *future;
+
+   future = future_client_command_simple (
+      client, "db", tmp_bson ("{'ping': 1}"), NULL /* read prefs */, reply, &error);
+   request = mock_server_receives_msg (server, MONGOC_QUERY_NONE, tmp_bson ("{'$db': 'db', 'ping': 1}"));
+   reply_to_op_msg_request (request, MONGOC_MSG_NONE, server_reply);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+}
+
+/* Replies must remain valid after the cluster's receive buffer is reused. */
+static void
+test_cluster_recv_buffer_reuse (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   bson_t small_reply_1;
+   bson_t small_reply_2;
+   bson_t large_reply;
+   bson_t *large;
+   char *large_str;
+   const size_t large_str_len = 2u * MONGOC_CLUSTER_RECV_BUFFER_MAX_SIZE;
+
+   large_str = bson_malloc (large_str_len + 1u);
+   memset (large_str, 'x', large_str_len);
+   large_str[large_str_len] = '\0';
+   large = BCON_NEW ("ok", BCON_INT32 (1), "s", BCON_UTF8 (large_str));
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   client = test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+
+   _run_ping_with_reply (server, client, tmp_bson ("{'ok': 1, 'n': 1}"), &small_reply_1);
+   BSON_ASSERT (client->cluster.recv_buffer.data);
+
+   _run_ping_with_reply (server, client, large, &large_reply);
+   /* the large reply took ownership of the buffer it was read into, so the
+    * idle client holds no memory for it */
+   BSON_ASSERT (!client->cluster.recv_buffer.data);
+
+   _run_ping_with_reply (server, client, tmp_bson ("{'ok': 1, 'n': 2}"), &small_reply_2);
+
+   ASSERT_MATCH (&small_reply_1, "{'ok': 1, 'n': 1}");
+   ASSERT_MATCH (&small_reply_2, "{'ok': 1, 'n': 2}");
+   BSON_ASSERT (bson_equal (&large_reply, large));
+
+   bson_destroy (&small_reply_1);
+   bson_destroy (&small_reply_2);
+   bson_destroy (&large_reply);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+   bson_destroy (large);
+   bson_free (large_str);
+}
+
+/* Runs a ping on @client and returns the port of the connection it used. */
+static uint16_t
+_ping_get_client_port (mock_server_t *server, mongoc_client_t *client)
+{
+   bson_error_t error;
+   request_t *request;
+   future_t *future;
+   uint16_t client_port;
+
+   future = future_client_command_simple (client, "db", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
+   request = mock_server_receives_msg (server, MONGOC_MSG_NONE, tmp_bson ("{'ping': 1}"));
+   BSON_ASSERT (request);
+   client_port = request_get_client_port (request);
+   reply_to_request_with_ok_and_destroy (request);
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+
+   return client_port;
+}
+
+/* With sharedConnectionPool, a client pushed back to the pool leaves its
+ * connections for other clients to borrow. */
+static void
+test_cluster_shared_connection_pool (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client_a;
+   mongoc_client_t *client_b;
+   mongoc_connection_pool_t *connection_pool;
+   uint16_t port_a;
+   uint32_t server_id;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, true);
+   pool = test_framework_client_pool_new_from_uri (uri, NULL);
+   client_a = mongoc_client_pool_pop (pool);
+   client_b = mongoc_client_pool_pop (pool);
+   connection_pool = client_a->topology->connection_pool;
+   BSON_ASSERT (connection_pool);
+
+   port_a = _ping_get_client_port (server, client_a);
+   server_id = server_id_for_reads (&client_a->cluster);
+   ASSERT_CMPSIZE_T (client_a->cluster.nodes->items_len, ==, (size_t) 1);
+
+   mongoc_client_pool_push (pool, client_a);
+   ASSERT_CMPSIZE_T (client_a->cluster.nodes->items_len, ==, (size_t) 0);
+   ASSERT_CMPSIZE_T (mongoc_connection_pool_num_idle (connection_pool, server_id), ==, (size_t) 1);
+
+   // client_b never connected: it borrows the connection client_a returned.
+   ASSERT_CMPINT (_ping_get_client_port (server, client_b), ==, port_a);
+   ASSERT_CMPSIZE_T (mongoc_connection_pool_num_idle (connection_pool, server_id), ==, (size_t) 0);
+
+   mongoc_client_pool_push (pool, client_b);
+   ASSERT_CMPSIZE_T (mongoc_connection_pool_num_idle (connection_pool, server_id), ==, (size_t) 1);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+/* With minIdleConnections, a background thread establishes idle connections
+ * ahead of use and replaces those that are borrowed. */
+static void
+test_cluster_shared_connection_pool_prewarm (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_connection_pool_t *connection_pool;
+   const uint32_t server_id = 1u;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, true);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MINIDLECONNECTIONS, 2);
+   pool = test_framework_client_pool_new_from_uri (uri, NULL);
+   client = mongoc_client_pool_pop (pool);
+   connection_pool = client->topology->connection_pool;
+   BSON_ASSERT (connection_pool);
+
+   WAIT_UNTIL (mongoc_connection_pool_num_idle (connection_pool, server_id) == 2u);
+
+   // The client borrows a prewarmed connection, which the thread replaces.
+   _ping_get_client_port (server, client);
+   ASSERT_CMPSIZE_T (client->cluster.nodes->items_len, ==, (size_t) 1);
+   WAIT_UNTIL (mongoc_connection_pool_num_idle (connection_pool, server_id) == 2u);
+
+   mongoc_client_pool_push (pool, client);
+   ASSERT_CMPSIZE_T (mongoc_connection_pool_num_idle (connection_pool, server_id), ==, (size_t) 3);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+/* A client waits at most waitQueueTimeoutMS for a connection when
+ * maxConnecting connections are already being established. */
+static void
+test_cluster_shared_connection_pool_timeout (void)
+{
+   mock_server_t *server;
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   mongoc_connection_pool_t *connection_pool;
+   mc_shared_tpld td;
+   bool may_connect;
+   bson_error_t error;
+   const uint32_t server_id = 1u;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, true);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MAXCONNECTING, 1);
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_WAITQUEUETIMEOUTMS, 100);
+   pool = test_framework_client_pool_new_from_uri (uri, NULL);
+   client = mongoc_client_pool_pop (pool);
+   connection_pool = client->topology->connection_pool;
+   BSON_ASSERT (connection_pool);
+
+   // Hold the only maxConnecting slot.
+   td = mc_tpld_take_ref (client->topology);
+   BSON_ASSERT (!mongoc_connection_pool_checkout (connection_pool, td.ptr, server_id, &may_connect, &error));
+   BSON_ASSERT (may_connect);
+
+   ASSERT (!mongoc_client_command_simple (client, "db", tmp_bson ("{'ping': 1}"), NULL, NULL, &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_SERVER_SELECTION,
+                          MONGOC_ERROR_SERVER_SELECTION_FAILURE,
+                          "Timed out after 100ms waiting for a connection");
+   ASSERT_CMPSIZE_T (client->cluster.nodes->items_len, ==, (size_t) 0);
+
+   // Once the slot is released the client connects.
+   mongoc_connection_pool_connect_done (connection_pool, server_id);
+   _ping_get_client_port (server, client);
+
+   mc_tpld_drop_ref (&td);
+   mongoc_client_pool_push (pool, client);
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+}
+
+typedef struct {
+   int64_t delay_usec;
+   int32_t pings;
+} load_mongos_t;
+
+/* Reply to pings after a delay, counting them. */
+static bool
+_load_mongos_responder (request_t *request, void *data)
+{
+   load_mongos_t *const mongos = data;
+
+   if (!request->is_command || strcasecmp (request->command_name, "ping") != 0) {
+      return false;
+   }
+
+   mcommon_atomic_int32_fetch_add (&mongos->pings, 1, mcommon_memory_order_relaxed);
+   if (mongos->delay_usec) {
+      _mongoc_usleep (mongos->delay_usec);
+   }
+
+   reply_to_request_with_ok_and_destroy (request);
+   return true;
+}
+
+#define LOAD_THREADS 8
+#define LOAD_PINGS_PER_THREAD 25
+
+static BSON_THREAD_FUN (load_thread, arg)
+{
+   mongoc_client_pool_t *const pool = arg;
+   mongoc_client_t *const client = mongoc_client_pool_pop (pool);
+   bson_error_t error;
+
+   for (int i = 0; i < LOAD_PINGS_PER_THREAD; i++) {
+      ASSERT_OR_PRINT (mongoc_client_command_simple (client, "admin", tmp_bson ("{'ping': 1}"), NULL, NULL, &error),
+                       error);
+   }
+
+   mongoc_client_pool_push (pool, client);
+
+   BSON_THREAD_RETURN;
+}
+
+static size_t
+_num_mongos (mongoc_client_t *client)
+{
+   mc_shared_tpld td = mc_tpld_take_ref (client->topology);
+   const mongoc_set_t *const servers = mc_tpld_servers_const (td.ptr);
+   size_t n = 0u;
+
+   for (size_t i = 0u; i < servers->items_len; i++) {
+      if (((const mongoc_server_description_t *) mongoc_set_get_item_const (servers, i))->type ==
+          MONGOC_SERVER_MONGOS) {
+         n++;
+      }
+   }
+
+   mc_tpld_drop_ref (&td);
+   return n;
+}
+
+/* Simulate load on two mongos, one of which replies slowly, and return the
+ * number of pings the slow one received. */
+static int32_t
+_run_load (bool power_of_two_choices)
+{
+   load_mongos_t fast = {0};
+   load_mongos_t slow = {.delay_usec = 50 * 1000};
+   mock_server_t *const fast_server = mock_mongos_new (WIRE_VERSION_MIN);
+   mock_server_t *const slow_server = mock_mongos_new (WIRE_VERSION_MIN);
+   bson_thread_t threads[LOAD_THREADS];
+   mongoc_uri_t *uri;
+   mongoc_client_pool_t *pool;
+   mongoc_client_t *client;
+   bson_error_t error;
+
+   mock_server_auto_endsessions (fast_server);
+   mock_server_auto_endsessions (slow_server);
+   mock_server_autoresponds (fast_server, _load_mongos_responder, &fast, NULL);
+   mock_server_autoresponds (slow_server, _load_mongos_responder, &slow, NULL);
+   mock_server_run (fast_server);
+   mock_server_run (slow_server);
+
+   uri = mongoc_uri_copy (mock_server_get_uri (fast_server));
+   ASSERT_OR_PRINT (mongoc_uri_upsert_host (uri, "localhost", mock_server_get_port (slow_server), &error), error);
+   /* both servers are always within the latency window */
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_LOCALTHRESHOLDMS, 10000);
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_POWEROFTWOCHOICES, power_of_two_choices);
+   pool = test_framework_client_pool_new_from_uri (uri, NULL);
+
+   client = mongoc_client_pool_pop (pool);
+   WAIT_UNTIL (_num_mongos (client) == 2u);
+   mongoc_client_pool_push (pool, client);
+
+   for (int i = 0; i < LOAD_THREADS; i++) {
+      ASSERT_CMPINT (0, ==, mcommon_thread_create (&threads[i], load_thread, pool));
+   }
+
+   for (int i = 0; i < LOAD_THREADS; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   ASSERT_CMPINT32 (fast.pings + slow.pings, ==, LOAD_THREADS * LOAD_PINGS_PER_THREAD);
+
+   mongoc_client_pool_destroy (pool);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (slow_server);
+   mock_server_destroy (fast_server);
+
+   return slow.pings;
+}
+
+/* With powerOfTwoChoices, operations avoid a mongos that already has more
+ * operations in progress, so a slow mongos receives less of the load. */
+static void
+test_cluster_power_of_two_choices (void)
+{
+   const int32_t total = LOAD_THREADS * LOAD_PINGS_PER_THREAD;
+
+   /* a random choice splits the load about evenly */
+   ASSERT_CMPINT32 (_run_load (false), >, total / 4);
+
+   /* the slow mongos is only chosen when the fast one is at least as busy */
+   ASSERT_CMPINT32 (_run_load (true), <, total / 4);
+}
+
+typedef struct {
+   mongoc_cluster_t *cluster;
+   mongoc_cmd_t *cmds;
+   size_t n_cmds;
+   bson_t *replies;
+   bson_error_t *errors;
+   bool ret;
+} pipeline_args_t;
+
+static BSON_THREAD_FUN (pipeline_thread, arg)
+{
+   pipeline_args_t *const args = arg;
+
+   args->ret =
+      mongoc_cluster_run_opmsg_pipeline (args->cluster, args->cmds, args->n_cmds, args->replies, args->errors);
+
+   BSON_THREAD_RETURN;
+}
+
+/* Pipelined commands are written together and their replies are matched by
+ * responseTo, whatever order they arrive in. */
+static void
+test_cluster_opmsg_pipeline (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_server_stream_t *server_stream;
+   mongoc_cmd_parts_t parts[3];
+   mongoc_cmd_t cmds[3];
+   bson_t replies[3];
+   bson_error_t errors[3];
+   request_t *requests[3];
+   bson_thread_t thread;
+   bson_error_t error;
+   pipeline_args_t args;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   client = test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+
+   server_stream = mongoc_cluster_stream_for_writes (&client->cluster, TEST_SS_LOG_CONTEXT, NULL, NULL, NULL, &error);
+   ASSERT_OR_PRINT (server_stream, error);
+
+   mongoc_cmd_parts_init (&parts[0], client, "db", MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+   mongoc_cmd_parts_init (&parts[1], client, "db", MONGOC_QUERY_NONE, tmp_bson ("{'count': 'coll'}"));
+   mongoc_cmd_parts_init (&parts[2], client, "db", MONGOC_QUERY_NONE, tmp_bson ("{'insert': 'coll'}"));
+
+   for (size_t i = 0u; i < 3u; i++) {
+      ASSERT_OR_PRINT (mongoc_cmd_parts_assemble (&parts[i], server_stream, &error), error);
+      cmds[i] = parts[i].assembled;
+   }
+
+   // The insert is unacknowledged: it is sent with moreToCome and gets no reply.
+   cmds[2].is_acknowledged = false;
+
+   args.cluster = &client->cluster;
+   args.cmds = cmds;
+   args.n_cmds = 3u;
+   args.replies = replies;
+   args.errors = errors;
+   args.ret = false;
+
+   ASSERT_CMPINT (0, ==, mcommon_thread_create (&thread, pipeline_thread, &args));
+
+   for (size_t i = 0u; i < 3u; i++) {
+      requests[i] = mock_server_receives_request (server);
+      BSON_ASSERT (requests[i]);
+   }
+
+   ASSERT_CMPSTR (requests[0]->command_name, "ping");
+   ASSERT_CMPSTR (requests[1]->command_name, "count");
+   ASSERT_CMPSTR (requests[2]->command_name, "insert");
+
+   reply_to_op_msg_request (requests[1], MONGOC_MSG_NONE, tmp_bson ("{'ok': 1, 'n': 2}"));
+   reply_to_op_msg_request (requests[0], MONGOC_MSG_NONE, tmp_bson ("{'ok': 1, 'n': 1}"));
+
+   mcommon_thread_join (thread);
+
+   ASSERT_OR_PRINT (args.ret, errors[0]);
+   ASSERT_MATCH (&replies[0], "{'ok': 1, 'n': 1}");
+   ASSERT_MATCH (&replies[1], "{'ok': 1, 'n': 2}");
+   ASSERT_CMPUINT32 (replies[2].len, ==, 5u);
+   BSON_ASSERT (!client->in_exhaust);
+
+   for (size_t i = 0u; i < 3u; i++) {
+      bson_destroy (&replies[i]);
+      request_destroy (requests[i]);
+      mongoc_cmd_parts_cleanup (&parts[i]);
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+/* A reply whose responseTo matches no pipelined request fails every command
+ * still waiting for a reply. */
+static void
+test_cluster_opmsg_pipeline_bad_response_to (void)
+{
+   mock_server_t *server;
+   mongoc_client_t *client;
+   mongoc_server_stream_t *server_stream;
+   mongoc_cmd_parts_t parts[2];
+   mongoc_cmd_t cmds[2];
+   bson_t replies[2];
+   bson_error_t errors[2];
+   request_t *requests[2];
+   bson_thread_t thread;
+   bson_error_t error;
+   pipeline_args_t args;
+
+   server = mock_server_with_auto_hello (WIRE_VERSION_MIN);
+   mock_server_run (server);
+   client = test_framework_client_new_from_uri (mock_server_get_uri (server), NULL);
+
+   server_stream = mongoc_cluster_stream_for_writes (&client->cluster, TEST_SS_LOG_CONTEXT, NULL, NULL, NULL, &error);
+   ASSERT_OR_PRINT (server_stream, error);
+
+   for (size_t i = 0u; i < 2u; i++) {
+      mongoc_cmd_parts_init (&parts[i], client, "db", MONGOC_QUERY_NONE, tmp_bson ("{'ping': 1}"));
+      ASSERT_OR_PRINT (mongoc_cmd_parts_assemble (&parts[i], server_stream, &error), error);
+      cmds[i] = parts[i].assembled;
+   }
+
+   args.cluster = &client->cluster;
+   args.cmds = cmds;
+   args.n_cmds = 2u;
+   args.replies = replies;
+   args.errors = errors;
+   args.ret = true;
+
+   ASSERT_CMPINT (0, ==, mcommon_thread_create (&thread, pipeline_thread, &args));
+
+   for (size_t i = 0u; i < 2u; i++) {
+      requests[i] = mock_server_receives_request (server);
+      BSON_ASSERT (requests[i]);
+   }
+
+   // Reply with a responseTo that matches neither pipelined request.
+   mcd_rpc_header_set_request_id (requests[0]->rpc, -1);
+   reply_to_op_msg_request (requests[0], MONGOC_MSG_NONE, tmp_bson ("{'ok': 1}"));
+
+   mcommon_thread_join (thread);
+
+   BSON_ASSERT (!args.ret);
+
+   for (size_t i = 0u; i < 2u; i++) {
+      ASSERT_ERROR_CONTAINS (
+         errors[i], MONGOC_ERROR_PROTOCOL, MONGOC_ERROR_PROTOCOL_INVALID_REPLY, "does not match any pipelined request");
+      bson_destroy (&replies[i]);
+      request_destroy (requests[i]);
+      mongoc_cmd_parts_cleanup (&parts[i]);
+   }
+
+   mongoc_server_stream_cleanup (server_stream);
+   mongoc_client_destroy (client);
+   mock_server_destroy (server);
+}
+
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+/* Runs @command and returns the opcode the mock server received it with. */
+static int32_t
+_run_command_get_opcode (mock_server_t *server, mongoc_client_t *client, const bson_t *command)
+{
+   bson_error_t error;
+   request_t *request;
+   future_t *future;
+   int32_t opcode;
+
+   future = future_client_command_simple (client, "db", command, NULL /* read prefs */, NULL, &error);
+   request = mock_server_receives_request (server);
+   BSON_ASSERT (request);
+   opcode = request->opcode;
+   reply_to_op_msg_request (request, MONGOC_MSG_NONE, tmp_bson ("{'ok': 1}"));
+   ASSERT_OR_PRINT (future_get_bool (future), error);
+   future_destroy (future);
+   request_destroy (request);
+
+   return opcode;
+}
+
+static mock_server_t *
+_mock_server_with_zlib (void)
+{
+   mock_server_t *const server = mock_server_new ();
+
+   mock_server_auto_hello (server,
+                           "{'ok': 1.0,"
+                           " 'isWritablePrimary': true,"
+                           " 'minWireVersion': %d,"
+                           " 'maxWireVersion': %d,"
+                           " 'compression': ['zlib']}",
+                           WIRE_VERSION_MIN,
+                           WIRE_VERSION_MAX);
+   mock_server_run (server);
+
+   return server;
+}
+
+static void
+test_cluster_compression_min_bytes (void)
+{
+   mock_server_t *const server = _mock_server_with_zlib ();
+   mongoc_uri_t *const uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_client_t *client;
+   bson_t *large;
+   char *large_str;
+
+   large_str = bson_malloc (1024u + 1u);
+   memset (large_str, 'x', 1024u);
+   large_str[1024u] = '\0';
+   large = BCON_NEW ("ping", BCON_INT32 (1), "s", BCON_UTF8 (large_str));
+
+   mongoc_uri_set_compressors (uri, "zlib");
+   mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_COMPRESSIONMINBYTES, 512);
+   client = test_framework_client_new_from_uri (uri, NULL);
+
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, tmp_bson ("{'ping': 1}")), ==, MONGOC_OP_CODE_MSG);
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, large), ==, MONGOC_OP_CODE_COMPRESSED);
+
+   mongoc_client_destroy (client);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+   bson_destroy (large);
+   bson_free (large_str);
+}
+
+/* A command whose messages do not shrink is sent uncompressed, except for a
+ * periodic probe. */
+static void
+test_cluster_compression_adaptive (void)
+{
+   mock_server_t *const server = _mock_server_with_zlib ();
+   mongoc_uri_t *const uri = mongoc_uri_copy (mock_server_get_uri (server));
+   mongoc_client_t *client;
+   uint8_t random_bytes[1024];
+   bson_t *incompressible;
+   bson_t *compressible;
+   char *str;
+
+   unsigned int seed = 42u;
+
+   for (size_t i = 0u; i < sizeof random_bytes; i++) {
+      random_bytes[i] = (uint8_t) _mongoc_rand_simple (&seed);
+   }
+
+   str = bson_malloc (sizeof random_bytes + 1u);
+   memset (str, 'x', sizeof random_bytes);
+   str[sizeof random_bytes] = '\0';
+
+   incompressible =
+      BCON_NEW ("ping", BCON_INT32 (1), "b", BCON_BIN (BSON_SUBTYPE_BINARY, random_bytes, sizeof random_bytes));
+   compressible = BCON_NEW ("find", "coll", "filter", "{", "s", BCON_UTF8 (str), "}");
+
+   mongoc_uri_set_compressors (uri, "zlib");
+   mongoc_uri_set_option_as_bool (uri, MONGOC_URI_COMPRESSIONADAPTIVE, true);
+   client = test_framework_client_new_from_uri (uri, NULL);
+
+   // The first message samples the compression ratio.
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, incompressible), ==, MONGOC_OP_CODE_COMPRESSED);
+
+   for (int i = 1; i < MONGOC_CLUSTER_COMPRESSION_PROBE_INTERVAL; i++) {
+      ASSERT_CMPINT32 (_run_command_get_opcode (server, client, incompressible), ==, MONGOC_OP_CODE_MSG);
+   }
+
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, incompressible), ==, MONGOC_OP_CODE_COMPRESSED);
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, incompressible), ==, MONGOC_OP_CODE_MSG);
+
+   // Statistics are kept per command name.
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, compressible), ==, MONGOC_OP_CODE_COMPRESSED);
+   ASSERT_CMPINT32 (_run_command_get_opcode (server, client, compressible), ==, MONGOC_OP_CODE_COMPRESSED);
+
+   mongoc_client_destroy (client);
+   mongoc_uri_destroy (uri);
+   mock_server_destroy (server);
+   bson_destroy (compressible);
+   bson_destroy (incompressible);
+   bson_free (str);
+}
+#endif
+
+static uint8_t *
+_rpc_message_to_data (mcd_rpc_message *rpc, size_t *len)
+{
+   size_t num_iovecs = 0u;
+   mongoc_iovec_t *const iovecs = mcd_rpc_message_to_iovecs (rpc, &num_iovecs);
+   uint8_t *data;
+   size_t offset = 0u;
+
+   *len = 0u;
+   for (size_t i = 0u; i < num_iovecs; i++) {
+      *len += iovecs[i].iov_len;
+   }
+
+   data = bson_malloc (*len);
+   for (size_t i = 0u; i < num_iovecs; i++) {
+      memcpy (data + offset, iovecs[i].iov_base, iovecs[i].iov_len);
+      offset += iovecs[i].iov_len;
+   }
+
+   bson_free (iovecs);
+
+   return data;
+}
+
+static mcd_rpc_message *
+_make_op_msg_with_document_sequence (const bson_t *body, const uint8_t *documents, size_t documents_len)
+{
+   mcd_rpc_message *const rpc = mcd_rpc_message_new ();
+   const char *const identifier = "documents";
+   int32_t message_length = 0;
+
+   message_length += mcd_rpc_header_set_message_length (rpc, 0);
+   message_length += mcd_rpc_header_set_request_id (rpc, 123);
+   message_length += mcd_rpc_header_set_response_to (rpc, 0);
+   message_length += mcd_rpc_header_set_op_code (rpc, MONGOC_OP_CODE_MSG);
+   mcd_rpc_op_msg_set_sections_count (rpc, 2u);
+   message_length += mcd_rpc_op_msg_set_flag_bits (rpc, MONGOC_OP_MSG_FLAG_NONE);
+   message_length += mcd_rpc_op_msg_section_set_kind (rpc, 0u, 0);
+   message_length += mcd_rpc_op_msg_section_set_body (rpc, 0u, bson_get_data (body));
+   message_length += mcd_rpc_op_msg_section_set_kind (rpc, 1u, 1);
+   message_length += mcd_rpc_op_msg_section_set_length (
+      rpc, 1u, (int32_t) (sizeof (int32_t) + strlen (identifier) + 1u + documents_len));
+   message_length += mcd_rpc_op_msg_section_set_identifier (rpc, 1u, identifier);
+   message_length += mcd_rpc_op_msg_section_set_document_sequence (rpc, 1u, documents, documents_len);
+   mcd_rpc_message_set_length (rpc, message_length);
+
+   return rpc;
+}
+
+static void
+_test_compress_roundtrip (int32_t compressor_id, mongoc_compression_ctx_t *ctx)
+{
+   mcd_rpc_message *rpc;
+   mongoc_buffer_t buffer;
+   bson_error_t error;
+   bson_t *body = BCON_NEW ("insert", "coll", "$db", "db");
+   bson_t *doc = BCON_NEW ("x", BCON_UTF8 ("aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"));
+   uint8_t *documents;
+   size_t documents_len;
+   size_t original_len;
+   size_t compressed_len;
+   uint8_t *original;
+   uint8_t *compressed;
+   void *decompressed = NULL;
+   size_t decompressed_len = 0u;
+
+   // A document sequence of several documents gives a message split over many iovecs.
+   documents_len = 10u * doc->len;
+   documents = bson_malloc (documents_len);
+   for (size_t i = 0u; i < 10u; i++) {
+      memcpy (documents + i * doc->len, bson_get_data (doc), doc->len);
+   }
+
+   rpc = _make_op_msg_with_document_sequence (body, documents, documents_len);
+   original = _rpc_message_to_data (rpc, &original_len);
+   mcd_rpc_message_destroy (rpc);
+
+   rpc = _make_op_msg_with_document_sequence (body, documents, documents_len);
+   _mongoc_buffer_init (&buffer, NULL, 0, NULL, NULL);
+   ASSERT_OR_PRINT (mcd_rpc_message_compress (rpc, ctx, compressor_id, -1, &buffer, &error), error);
+   ASSERT_CMPINT32 (mcd_rpc_header_get_op_code (rpc), ==, MONGOC_OP_CODE_COMPRESSED);
+   ASSERT_CMPSIZE_T (buffer.len, ==, mcd_rpc_op_compressed_get_compressed_message_length (rpc));
+
+   compressed = _rpc_message_to_data (rpc, &compressed_len);
+   mcd_rpc_message_destroy (rpc);
+
+   rpc = mcd_rpc_message_from_data (compressed, compressed_len, NULL);
+   BSON_ASSERT (rpc);
+   BSON_ASSERT (mcd_rpc_message_decompress (rpc, ctx, &decompressed, &decompressed_len));
+
+   ASSERT_CMPSIZE_T (decompressed_len, ==, original_len);
+   BSON_ASSERT (memcmp (decompressed, original, original_len) == 0);
+
+   bson_free (decompressed);
+   bson_free (compressed);
+   bson_free (original);
+   _mongoc_buffer_destroy (&buffer);
+   mcd_rpc_message_destroy (rpc);
+   bson_free (documents);
+   bson_destroy (doc);
+   bson_destroy (body);
+}
+
+/* Empty segments, as a message section without documents gives, are skipped. */
+static void
+_test_compress_iovec_empty_segment (int32_t compressor_id, mongoc_compression_ctx_t *ctx)
+{
+   char data[] = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz";
+   const mongoc_iovec_t iov[] = {
+      {.iov_base = data, .iov_len = 10u},
+      {.iov_base = data + 10, .iov_len = 0u},
+      {.iov_base = data + 10, .iov_len = sizeof data - 10u},
+      {.iov_base = data, .iov_len = 0u},
+   };
+   size_t compressed_len = (size_t) mongoc_compressor_max_compressed_length (compressor_id, sizeof data);
+   char *const compressed = bson_malloc (compressed_len);
+   uint8_t uncompressed[sizeof data];
+   size_t uncompressed_len = sizeof uncompressed;
+
+   BSON_ASSERT (
+      mongoc_compress_iovec (ctx, compressor_id, -1, iov, sizeof iov / sizeof iov[0], compressed, &compressed_len));
+   BSON_ASSERT (mongoc_uncompress (
+      ctx, compressor_id, (const uint8_t *) compressed, compressed_len, uncompressed, &uncompressed_len));
+   ASSERT_CMPSIZE_T (uncompressed_len, ==, sizeof data);
+   BSON_ASSERT (memcmp (uncompressed, data, sizeof data) == 0);
+
+   bson_free (compressed);
+}
+
+static void
+_test_compress_roundtrip_all (mongoc_compression_ctx_t *ctx)
+{
+   _test_compress_roundtrip (MONGOC_COMPRESSOR_NOOP_ID, ctx);
+   _test_compress_iovec_empty_segment (MONGOC_COMPRESSOR_NOOP_ID, ctx);
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   _test_compress_roundtrip (MONGOC_COMPRESSOR_ZLIB_ID, ctx);
+   _test_compress_iovec_empty_segment (MONGOC_COMPRESSOR_ZLIB_ID, ctx);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_ZSTD
+   _test_compress_roundtrip (MONGOC_COMPRESSOR_ZSTD_ID, ctx);
+   _test_compress_iovec_empty_segment (MONGOC_COMPRESSOR_ZSTD_ID, ctx);
+#endif
+#ifdef MONGOC_ENABLE_COMPRESSION_SNAPPY
+   _test_compress_roundtrip (MONGOC_COMPRESSOR_SNAPPY_ID, ctx);
+   _test_compress_iovec_empty_segment (MONGOC_COMPRESSOR_SNAPPY_ID, ctx);
+#endif
+}
+
+static void
+test_cluster_compress_roundtrip (void)
+{
+   mongoc_compression_ctx_t *const ctx = mongoc_compression_ctx_new ();
+
+   _test_compress_roundtrip_all (NULL);
+
+   // Cached compressor state must be reset between messages.
+   _test_compress_roundtrip_all (ctx);
+   _test_compress_roundtrip_all (ctx);
+
+   mongoc_compression_ctx_destroy (ctx);
+}
+
 static void
 test_advanced_cluster_time_not_sent_to_standalone (void)
 {
@@ -1843,6 +2626,21 @@ test_cluster_install (TestSuite *suite)
    TestSuite_AddMockServerTest (suite, "/Cluster/hello_fails", test_cluster_hello_fails);
    TestSuite_AddMockServerTest (suite, "/Cluster/hello_hangup", test_cluster_hello_hangup);
    TestSuite_AddMockServerTest (suite, "/Cluster/command_error/op_msg", test_cluster_command_error);
+   TestSuite_AddMockServerTest (suite, "/Cluster/recv_buffer_reuse", test_cluster_recv_buffer_reuse);
+   TestSuite_Add (suite, "/Cluster/compress_roundtrip", test_cluster_compress_roundtrip);
+   TestSuite_AddMockServerTest (suite, "/Cluster/opmsg_pipeline", test_cluster_opmsg_pipeline);
+   TestSuite_AddMockServerTest (suite, "/Cluster/shared_connection_pool", test_cluster_shared_connection_pool);
+   TestSuite_AddMockServerTest (
+      suite, "/Cluster/shared_connection_pool/prewarm", test_cluster_shared_connection_pool_prewarm);
+   TestSuite_AddMockServerTest (
+      suite, "/Cluster/shared_connection_pool/timeout", test_cluster_shared_connection_pool_timeout);
+   TestSuite_AddMockServerTest (suite, "/Cluster/power_of_two_choices", test_cluster_power_of_two_choices);
+   TestSuite_AddMockServerTest (
+      suite, "/Cluster/opmsg_pipeline/bad_response_to", test_cluster_opmsg_pipeline_bad_response_to);
+#ifdef MONGOC_ENABLE_COMPRESSION_ZLIB
+   TestSuite_AddMockServerTest (suite, "/Cluster/compression/min_bytes", test_cluster_compression_min_bytes);
+   TestSuite_AddMockServerTest (suite, "/Cluster/compression/adaptive", test_cluster_compression_adaptive);
+#endif
    TestSuite_AddMockServerTest (suite, "/Cluster/hello_on_unknown/mock", test_hello_on_unknown);
    /* These tests exhibit some mysterious behavior after the new feature
    changes-- see: "https://jira.mongodb.org/browse/CDRIVER-4293".
@@ -81,6 +81,10 @@ test_set_new (void)
    mongoc_set_add (set, 5, items + 5);
    BSON_ASSERT (mongoc_set_get (set, 5) == items + 5);
 
+   mongoc_set_replace (set, 5, items + 0);
+   BSON_ASSERT (destroyed == 4);
+   BSON_ASSERT (mongoc_set_get (set, 5) == items + 0);
+
    mongoc_set_for_each (set, test_set_visit_cb, &visited);
    BSON_ASSERT (visited == 8);
 
@@ -2,6 +2,9 @@
 
 #include <mongoc/mongoc-shared-private.h>
 
+#include <common-atomic-private.h>
+#include <common-thread-private.h>
+
 typedef struct {
    int value;
    int *store_value_on_dtor;
@@ -117,9 +120,219 @@ test_aliased (void)
    ASSERT_CMPINT (destroyed_valued, ==, 42);
 }
 
+typedef struct {
+   int magic;
+   int *live;
+} counted_value;
+
+#define COUNTED_VALUE_MAGIC 0x5ca1ab1e
+
+static void
+counted_value_free (void *p)
+{
+   counted_value *v = p;
+   ASSERT_CMPINT (v->magic, ==, COUNTED_VALUE_MAGIC);
+   v->magic = 0;
+   mcommon_atomic_int_fetch_sub (v->live, 1, mcommon_memory_order_relaxed);
+   bson_free (v);
+}
+
+static mongoc_shared_ptr
+counted_value_new (int *live)
+{
+   counted_value *v = bson_malloc0 (sizeof (counted_value));
+   v->magic = COUNTED_VALUE_MAGIC;
+   v->live = live;
+   mcommon_atomic_int_fetch_add (live, 1, mcommon_memory_order_relaxed);
+   return mongoc_shared_ptr_create (v, counted_value_free);
+}
+
+typedef struct counted_wrapper {
+   struct counted_wrapper *next_freed;
+   struct counted_wrapper *volatile *freed;
+   counted_value value;
+} counted_wrapper;
+
+/* Freed wrappers are kept on a list until the test ends instead of going back
+ * to the allocator, so a stale pointee can be told from a new one. */
+static void
+counted_wrapper_free (void *p)
+{
+   counted_wrapper *w = p;
+   ASSERT_CMPINT (w->value.magic, ==, COUNTED_VALUE_MAGIC);
+   w->value.magic = 0;
+   mcommon_atomic_int_fetch_sub (w->value.live, 1, mcommon_memory_order_relaxed);
+
+   w->next_freed = mcommon_atomic_ptr_fetch ((void *volatile const *) w->freed, mcommon_memory_order_relaxed);
+   for (;;) {
+      counted_wrapper *const prev = mcommon_atomic_ptr_compare_exchange_strong (
+         (void *volatile *) w->freed, w->next_freed, w, mcommon_memory_order_release);
+      if (prev == w->next_freed) {
+         break;
+      }
+      w->next_freed = prev;
+   }
+}
+
+/* Returns a pointer aliased to a sub-object, so that the pointee cannot be
+ * recovered from the managed object. */
+static mongoc_shared_ptr
+counted_wrapper_new (int *live, counted_wrapper *volatile *freed)
+{
+   counted_wrapper *w = bson_malloc0 (sizeof (counted_wrapper));
+   mongoc_shared_ptr ret;
+
+   w->freed = freed;
+   w->value.magic = COUNTED_VALUE_MAGIC;
+   w->value.live = live;
+   mcommon_atomic_int_fetch_add (live, 1, mcommon_memory_order_relaxed);
+   ret = mongoc_shared_ptr_create (w, counted_wrapper_free);
+   ret.ptr = &w->value;
+   return ret;
+}
+
+typedef struct {
+   mongoc_shared_ptr shared;
+   int live;
+   int stop;
+   counted_wrapper *volatile freed;
+} atomic_test_ctx;
+
+static BSON_THREAD_FUN (atomic_load_worker, arg)
+{
+   atomic_test_ctx *ctx = arg;
+
+   while (!mcommon_atomic_int_fetch (&ctx->stop, mcommon_memory_order_acquire)) {
+      mongoc_shared_ptr p = mongoc_atomic_shared_ptr_load (&ctx->shared);
+      ASSERT (!mongoc_shared_ptr_is_null (p));
+      ASSERT_CMPINT (((counted_value *) p.ptr)->magic, ==, COUNTED_VALUE_MAGIC);
+      mongoc_shared_ptr_reset_null (&p);
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+static void
+test_atomic_load_store (void)
+{
+   atomic_test_ctx ctx = {.shared = MONGOC_SHARED_PTR_NULL};
+   bson_thread_t threads[4];
+   mongoc_shared_ptr first;
+   size_t i;
+
+   first = counted_value_new (&ctx.live);
+   mongoc_atomic_shared_ptr_store (&ctx.shared, first);
+   mongoc_shared_ptr_reset_null (&first);
+
+   for (i = 0; i < sizeof threads / sizeof threads[0]; i++) {
+      ASSERT_CMPINT (0, ==, mcommon_thread_create (&threads[i], atomic_load_worker, &ctx));
+   }
+
+   /* Replace the pointee while the workers load it */
+   for (i = 0; i < 20000; i++) {
+      mongoc_shared_ptr next = counted_value_new (&ctx.live);
+      mongoc_atomic_shared_ptr_store (&ctx.shared, next);
+      mongoc_shared_ptr_reset_null (&next);
+   }
+
+   mcommon_atomic_int_exchange (&ctx.stop, 1, mcommon_memory_order_release);
+   for (i = 0; i < sizeof threads / sizeof threads[0]; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   /* Only the stored value is still alive, and it holds a single reference */
+   ASSERT_CMPINT (ctx.live, ==, 1);
+   ASSERT_CMPINT (mongoc_shared_ptr_use_count (ctx.shared), ==, 1);
+   mongoc_shared_ptr_reset_null (&ctx.shared);
+   ASSERT_CMPINT (ctx.live, ==, 0);
+}
+
+static BSON_THREAD_FUN (atomic_store_worker, arg)
+{
+   atomic_test_ctx *ctx = arg;
+   int i;
+
+   /* Each store frees the block it replaces, so the allocator hands the same
+    * addresses out again. Yielding lets the other storer replace the block
+    * again while the loader is preempted mid-load. */
+   for (i = 0; i < 20000; i++) {
+      mongoc_shared_ptr next = counted_wrapper_new (&ctx->live, &ctx->freed);
+      mongoc_atomic_shared_ptr_store (&ctx->shared, next);
+      mongoc_shared_ptr_reset_null (&next);
+      mcommon_thrd_yield ();
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+static void
+test_atomic_load_store_reuse (void)
+{
+   atomic_test_ctx ctx = {.shared = MONGOC_SHARED_PTR_NULL};
+   bson_thread_t loader;
+   bson_thread_t storers[2];
+   mongoc_shared_ptr first;
+   size_t i;
+
+   first = counted_wrapper_new (&ctx.live, &ctx.freed);
+   mongoc_atomic_shared_ptr_store (&ctx.shared, first);
+   mongoc_shared_ptr_reset_null (&first);
+
+   ASSERT_CMPINT (0, ==, mcommon_thread_create (&loader, atomic_load_worker, &ctx));
+   for (i = 0; i < sizeof storers / sizeof storers[0]; i++) {
+      ASSERT_CMPINT (0, ==, mcommon_thread_create (&storers[i], atomic_store_worker, &ctx));
+   }
+   for (i = 0; i < sizeof storers / sizeof storers[0]; i++) {
+      mcommon_thread_join (storers[i]);
+   }
+
+   mcommon_atomic_int_exchange (&ctx.stop, 1, mcommon_memory_order_release);
+   mcommon_thread_join (loader);
+
+   ASSERT_CMPINT (ctx.live, ==, 1);
+   mongoc_shared_ptr_reset_null (&ctx.shared);
+   ASSERT_CMPINT (ctx.live, ==, 0);
+
+   while (ctx.freed) {
+      counted_wrapper *const w = ctx.freed;
+      ctx.freed = w->next_freed;
+      bson_free (w);
+   }
+}
+
+static void
+test_atomic_compare_exchange (void)
+{
+   int live = 0;
+   mongoc_shared_ptr shared = counted_value_new (&live);
+   mongoc_shared_ptr stale = mongoc_atomic_shared_ptr_load (&shared);
+   mongoc_shared_ptr next = counted_value_new (&live);
+   mongoc_shared_ptr other = counted_value_new (&live);
+
+   /* succeeds while 'shared' still holds the expected value */
+   ASSERT (mongoc_atomic_shared_ptr_compare_exchange (&shared, stale, next));
+   ASSERT (shared.ptr == next.ptr);
+   ASSERT_CMPINT (mongoc_shared_ptr_use_count (next), ==, 2);
+
+   /* fails once it has changed, leaving 'shared' unmodified */
+   ASSERT (!mongoc_atomic_shared_ptr_compare_exchange (&shared, stale, other));
+   ASSERT (shared.ptr == next.ptr);
+   ASSERT_CMPINT (mongoc_shared_ptr_use_count (other), ==, 1);
+
+   mongoc_shared_ptr_reset_null (&stale);
+   mongoc_shared_ptr_reset_null (&next);
+   mongoc_shared_ptr_reset_null (&other);
+   ASSERT_CMPINT (live, ==, 1);
+   mongoc_shared_ptr_reset_null (&shared);
+   ASSERT_CMPINT (live, ==, 0);
+}
+
 void
 test_shared_install (TestSuite *suite)
 {
    TestSuite_Add (suite, "/shared/simple", test_simple);
    TestSuite_Add (suite, "/shared/aliased", test_aliased);
+   TestSuite_Add (suite, "/shared/atomic_load_store", test_atomic_load_store);
+   TestSuite_Add (suite, "/shared/atomic_load_store_reuse", test_atomic_load_store_reuse);
+   TestSuite_Add (suite, "/shared/atomic_compare_exchange", test_atomic_compare_exchange);
 }
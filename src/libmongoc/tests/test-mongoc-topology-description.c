@@ -313,6 +313,209 @@ test_topology_pool_clear_by_serviceid (void)
    mongoc_topology_destroy (topology);
 }
 
+/* Respond to a hello on behalf of the member of replica set "rs" at @host. */
+static void
+_rs_member_hello (mongoc_topology_description_t *td,
+                  const mongoc_log_and_monitor_instance_t *log_and_monitor,
+                  const char *host,
+                  bool primary,
+                  const char *dc)
+{
+   const mongoc_server_description_t *const sd = _sd_for_host (td, host);
+
+   mongoc_topology_description_handle_hello (td,
+                                             log_and_monitor,
+                                             sd->id,
+                                             tmp_bson ("{'ok': 1,"
+                                                       " 'isWritablePrimary': %s,"
+                                                       " 'secondary': %s,"
+                                                       " 'setName': 'rs',"
+                                                       " 'minWireVersion': %d,"
+                                                       " 'maxWireVersion': %d,"
+                                                       " 'hosts': ['a:27017', 'b:27017', 'c:27017'],"
+                                                       " 'tags': {'dc': '%s'}}",
+                                                       primary ? "true" : "false",
+                                                       primary ? "false" : "true",
+                                                       WIRE_VERSION_MIN,
+                                                       WIRE_VERSION_MAX,
+                                                       dc),
+                                             10,
+                                             NULL);
+}
+
+
+static const mongoc_server_description_t *
+_select_with_tags (const mongoc_topology_description_t *td, mongoc_read_mode_t mode, const char *tags)
+{
+   mongoc_read_prefs_t *const prefs = mongoc_read_prefs_new (mode);
+   const mongoc_server_description_t *sd;
+
+   if (tags) {
+      mongoc_read_prefs_set_tags (prefs, tmp_bson (tags));
+   }
+
+   sd = mongoc_topology_description_select (td, MONGOC_SS_READ, prefs, NULL, NULL, 15);
+   mongoc_read_prefs_destroy (prefs);
+
+   return sd;
+}
+
+
+/* Test that selection results are cached per read preference and forgotten
+ * when the description changes. */
+static void
+test_topology_description_select_cache (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_topology_t *topology;
+   mongoc_topology_description_t *td;
+   mc_tpld_modification tdmod;
+
+   uri = mongoc_uri_new ("mongodb://a,b,c/?replicaSet=rs");
+   topology = mongoc_topology_new (uri, true /* single-threaded */);
+   tdmod = mc_tpld_modify_begin (topology);
+   td = tdmod.new_td;
+
+   _rs_member_hello (td, &topology->log_and_monitor, "a", true, "ny");
+   _rs_member_hello (td, &topology->log_and_monitor, "b", false, "ny");
+   _rs_member_hello (td, &topology->log_and_monitor, "c", false, "sf");
+   ASSERT (!td->_select_cache_[0]);
+
+   /* repeated selections with the same read preference share an entry */
+   for (int i = 0; i < 10; i++) {
+      ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_SECONDARY, "[{'dc': 'ny'}]")->host.host, "b");
+   }
+
+   ASSERT (td->_select_cache_[0]);
+   ASSERT (!td->_select_cache_[1]);
+
+   /* different tags or modes have their own entries */
+   ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_SECONDARY, "[{'dc': 'sf'}]")->host.host, "c");
+   ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_NEAREST, "[{'dc': 'sf'}]")->host.host, "c");
+   ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_PRIMARY, NULL)->host.host, "a");
+   ASSERT (td->_select_cache_[3]);
+   ASSERT (!td->_select_cache_[4]);
+
+   /* a copy starts with an empty cache */
+   {
+      mongoc_topology_description_t *const td_copy = mongoc_topology_description_new_copy (td);
+      ASSERT (!td_copy->_select_cache_[0]);
+      mongoc_topology_description_destroy (td_copy);
+   }
+
+   /* "b" becomes unknown: the cached result for "ny" must not be used */
+   mongoc_topology_description_handle_hello (
+      td, &topology->log_and_monitor, _sd_for_host (td, "b")->id, NULL, -1, NULL);
+   ASSERT (!td->_select_cache_[0]);
+   ASSERT (!_select_with_tags (td, MONGOC_READ_SECONDARY, "[{'dc': 'ny'}]"));
+   ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_SECONDARY, "[{'dc': 'sf'}]")->host.host, "c");
+
+   mc_tpld_modify_drop (tdmod);
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
+/* Test that with powerOfTwoChoices the server with fewer operations in
+ * progress is selected. */
+static void
+test_topology_description_power_of_two_choices (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_topology_t *topology;
+   mongoc_topology_description_t *td;
+   mc_tpld_modification tdmod;
+   const mongoc_server_description_t *sd_a;
+   const mongoc_server_description_t *sd_b;
+
+   uri = mongoc_uri_new ("mongodb://a,b/?powerOfTwoChoices=true");
+   topology = mongoc_topology_new (uri, true /* single-threaded */);
+   tdmod = mc_tpld_modify_begin (topology);
+   td = tdmod.new_td;
+
+   mongoc_topology_description_handle_hello (
+      td, &topology->log_and_monitor, _sd_for_host (td, "a")->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+   mongoc_topology_description_handle_hello (
+      td, &topology->log_and_monitor, _sd_for_host (td, "b")->id, tmp_bson ("{'ok': 1, 'msg': 'isdbgrid'}"), 10, NULL);
+   sd_a = _sd_for_host (td, "a");
+   sd_b = _sd_for_host (td, "b");
+
+   /* copies of a server description share its operation count */
+   {
+      mongoc_server_description_t *const copy = mongoc_server_description_new_copy (sd_a);
+      mc_tpl_sd_add_operation_count (copy, 1);
+      ASSERT_CMPINT64 (mc_tpl_sd_get_operation_count (sd_a), ==, 1);
+      mongoc_server_description_destroy (copy);
+   }
+
+   for (int i = 0; i < 20; i++) {
+      ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_NEAREST, NULL)->host.host, "b");
+   }
+
+   mc_tpl_sd_add_operation_count (sd_b, 2);
+
+   for (int i = 0; i < 20; i++) {
+      ASSERT_CMPSTR (_select_with_tags (td, MONGOC_READ_NEAREST, NULL)->host.host, "a");
+   }
+
+   mc_tpl_sd_add_operation_count (sd_a, -1);
+   mc_tpld_modify_drop (tdmod);
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
+/* Test that copies of a topology description share the server descriptions
+ * that neither of them modified. */
+static void
+test_topology_description_share_servers (void)
+{
+   mongoc_uri_t *uri;
+   mongoc_topology_t *topology;
+   mongoc_topology_description_t *td;
+   mongoc_topology_description_t *td_copy;
+   mongoc_server_description_t *sd;
+   mc_tpld_modification tdmod;
+
+   uri = mongoc_uri_new ("mongodb://a,b,c/?replicaSet=rs");
+   topology = mongoc_topology_new (uri, true /* single-threaded */);
+   tdmod = mc_tpld_modify_begin (topology);
+   td = tdmod.new_td;
+
+   _rs_member_hello (td, &topology->log_and_monitor, "a", true, "ny");
+   _rs_member_hello (td, &topology->log_and_monitor, "b", false, "ny");
+   _rs_member_hello (td, &topology->log_and_monitor, "c", false, "sf");
+
+   td_copy = mongoc_topology_description_new_copy (td);
+   ASSERT (_sd_for_host (td_copy, "a") == _sd_for_host (td, "a"));
+   ASSERT (_sd_for_host (td_copy, "b") == _sd_for_host (td, "b"));
+   ASSERT (_sd_for_host (td_copy, "c") == _sd_for_host (td, "c"));
+   ASSERT (mc_tpl_sd_is_shared (_sd_for_host (td, "b")));
+
+   /* "b" becomes unknown: only its server description is replaced */
+   mongoc_topology_description_handle_hello (
+      td, &topology->log_and_monitor, _sd_for_host (td, "b")->id, NULL, -1, NULL);
+   ASSERT (_sd_for_host (td_copy, "a") == _sd_for_host (td, "a"));
+   ASSERT (_sd_for_host (td_copy, "b") != _sd_for_host (td, "b"));
+   ASSERT (_sd_for_host (td_copy, "c") == _sd_for_host (td, "c"));
+   ASSERT_CMPINT (_sd_for_host (td, "b")->type, ==, MONGOC_SERVER_UNKNOWN);
+   ASSERT_CMPINT (_sd_for_host (td_copy, "b")->type, ==, MONGOC_SERVER_RS_SECONDARY);
+
+   /* modifying a server description of the copy does not modify the original */
+   sd = mongoc_topology_description_server_by_id (td_copy, _sd_for_host (td_copy, "c")->id, NULL);
+   ASSERT (sd != _sd_for_host (td, "c"));
+   mongoc_server_description_update_rtt (sd, 1000);
+   ASSERT_CMPINT64 (_sd_for_host (td, "c")->round_trip_time_msec, ==, (int64_t) 10);
+
+   mongoc_topology_description_destroy (td_copy);
+
+   /* once the copy is destroyed, server descriptions are modified in place */
+   ASSERT (!mc_tpl_sd_is_shared (_sd_for_host (td, "a")));
+   ASSERT (mongoc_topology_description_server_by_id (td, _sd_for_host (td, "a")->id, NULL) == _sd_for_host (td, "a"));
+
+   mc_tpld_modify_drop (tdmod);
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
 void
 test_topology_description_install (TestSuite *suite)
 {
@@ -323,4 +526,7 @@ test_topology_description_install (TestSuite *suite)
    TestSuite_Add (suite, "/TopologyDescription/new_copy", test_topology_description_new_copy);
    TestSuite_Add (suite, "/TopologyDescription/pool_clear", test_topology_pool_clear);
    TestSuite_Add (suite, "/TopologyDescription/pool_clear_by_serviceid", test_topology_pool_clear_by_serviceid);
+   TestSuite_Add (suite, "/TopologyDescription/select_cache", test_topology_description_select_cache);
+   TestSuite_Add (suite, "/TopologyDescription/power_of_two_choices", test_topology_description_power_of_two_choices);
+   TestSuite_Add (suite, "/TopologyDescription/share_servers", test_topology_description_share_servers);
 }
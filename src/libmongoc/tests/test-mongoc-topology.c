@@ -2,6 +2,7 @@
 #include <mongoc/mongoc-uri-private.h>
 #include <mongoc/mongoc-client-pool-private.h>
 #include <common-oid-private.h>
+#include <common-thread-private.h>
 
 #include <mongoc/mongoc-client-private.h>
 #include <mongoc/mongoc-server-api-private.h>
@@ -658,7 +659,7 @@ test_max_wire_version_race_condition (void *ctx)
 
    /* "disconnect": increment generation and reset server description */
    tdmod = mc_tpld_modify_begin (client->topology);
-   sd = mongoc_set_get (mc_tpld_servers (tdmod.new_td), id);
+   sd = mongoc_topology_description_server_by_id (tdmod.new_td, id, NULL);
    BSON_ASSERT (sd);
    mc_tpl_sd_increment_generation (sd, &kZeroObjectId);
    mongoc_server_description_reset (sd);
@@ -1729,6 +1730,103 @@ cluster_time_fmt (int t)
                               t);
 }
 
+static void
+assert_topology_cluster_time (const mongoc_topology_t *topology, const char *cluster_time)
+{
+   mongoc_shared_ptr topology_cluster_time = _mongoc_topology_get_cluster_time (topology);
+
+   ASSERT (!mongoc_shared_ptr_is_null (topology_cluster_time));
+   ASSERT_MATCH (topology_cluster_time.ptr, cluster_time);
+   mongoc_shared_ptr_reset_null (&topology_cluster_time);
+}
+
+static void
+update_topology_cluster_time (mongoc_topology_t *topology, int t)
+{
+   char *const cluster_time = cluster_time_fmt (t);
+   bson_t *const reply = tmp_bson ("{'ok': 1, '$clusterTime': %s}", cluster_time);
+
+   _mongoc_topology_update_cluster_time (topology, reply);
+   bson_free (cluster_time);
+}
+
+static void
+test_cluster_time_advances (void)
+{
+   mongoc_uri_t *uri = mongoc_uri_new ("mongodb://localhost");
+   mongoc_topology_t *topology = mongoc_topology_new (uri, true);
+   const mongoc_topology_description_t *td = mc_tpld_unsafe_get_const (topology);
+   mongoc_shared_ptr topology_cluster_time = _mongoc_topology_get_cluster_time (topology);
+   char *cluster_time;
+
+   ASSERT (mongoc_shared_ptr_is_null (topology_cluster_time));
+
+   update_topology_cluster_time (topology, 2);
+   cluster_time = cluster_time_fmt (2);
+   assert_topology_cluster_time (topology, cluster_time);
+
+   /* an older cluster time is ignored */
+   update_topology_cluster_time (topology, 1);
+   assert_topology_cluster_time (topology, cluster_time);
+   bson_free (cluster_time);
+
+   update_topology_cluster_time (topology, 3);
+   cluster_time = cluster_time_fmt (3);
+   assert_topology_cluster_time (topology, cluster_time);
+   bson_free (cluster_time);
+
+   /* advancing the cluster time does not replace the topology description */
+   ASSERT (td == mc_tpld_unsafe_get_const (topology));
+
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
+typedef struct {
+   mongoc_topology_t *topology;
+   int first;
+} cluster_time_thread_args_t;
+
+static BSON_THREAD_FUN (advance_cluster_time, arg)
+{
+   cluster_time_thread_args_t *const args = arg;
+
+   /* threads interleave their cluster times */
+   for (int t = args->first; t <= 400; t += 4) {
+      update_topology_cluster_time (args->topology, t);
+   }
+
+   BSON_THREAD_RETURN;
+}
+
+static void
+test_cluster_time_advances_concurrently (void)
+{
+   mongoc_uri_t *uri = mongoc_uri_new ("mongodb://localhost");
+   mongoc_topology_t *topology = mongoc_topology_new (uri, false);
+   cluster_time_thread_args_t args[4];
+   bson_thread_t threads[4];
+   char *cluster_time;
+
+   for (int i = 0; i < 4; i++) {
+      args[i].topology = topology;
+      args[i].first = i + 1;
+      ASSERT_CMPINT (0, ==, mcommon_thread_create (&threads[i], advance_cluster_time, &args[i]));
+   }
+
+   for (int i = 0; i < 4; i++) {
+      mcommon_thread_join (threads[i]);
+   }
+
+   /* the highest cluster time wins regardless of the order of updates */
+   cluster_time = cluster_time_fmt (400);
+   assert_topology_cluster_time (topology, cluster_time);
+   bson_free (cluster_time);
+
+   mongoc_topology_destroy (topology);
+   mongoc_uri_destroy (uri);
+}
+
 static void
 test_cluster_time_updated_during_handshake (void)
 {
@@ -1773,8 +1871,8 @@ test_cluster_time_updated_during_handshake (void)
    ASSERT_OR_PRINT (sd, error);
    mongoc_server_description_destroy (sd);
 
-   /* check the cluster time stored on the topology description. */
-   ASSERT_MATCH (&mc_tpld_unsafe_get_const (client->topology)->cluster_time, cluster_time);
+   /* check the cluster time stored on the topology. */
+   assert_topology_cluster_time (client->topology, cluster_time);
    bson_free (cluster_time);
    cluster_time = cluster_time_fmt (2);
 
@@ -1799,7 +1897,7 @@ test_cluster_time_updated_during_handshake (void)
    r = mongoc_client_command_simple (client, "db", tmp_bson ("{'ping': 1}"), NULL, NULL, &error);
 
    ASSERT_OR_PRINT (r, error);
-   ASSERT_MATCH (&mc_tpld_unsafe_get_const (client->topology)->cluster_time, cluster_time);
+   assert_topology_cluster_time (client->topology, cluster_time);
    bson_free (cluster_time);
    mongoc_client_pool_push (pool, client);
    mongoc_client_pool_destroy (pool);
@@ -2688,6 +2786,8 @@ test_topology_install (TestSuite *suite)
                                 "/Topology/compatible_null_error_pointer",
                                 test_compatible_null_error_pointer,
                                 test_framework_skip_if_slow);
+   TestSuite_Add (suite, "/Topology/cluster_time/advances", test_cluster_time_advances);
+   TestSuite_Add (suite, "/Topology/cluster_time/advances_concurrently", test_cluster_time_advances_concurrently);
    TestSuite_AddMockServerTest (
       suite, "/Topology/handshake/updates_clustertime", test_cluster_time_updated_during_handshake);
    TestSuite_AddMockServerTest (suite, "/Topology/request_scan_on_error", test_request_scan_on_error);
@@ -671,6 +671,20 @@ test_mongoc_uri_new_with_error (void)
                           MONGOC_ERROR_COMMAND_INVALID_ARG,
                           "Invalid \"zlibcompressionlevel\" of 10: must be between -1 and 9");
 
+   memset (&error, 0, sizeof (bson_error_t));
+   ASSERT (!mongoc_uri_new_with_error ("mongodb://localhost/db?zstdcompressionlevel=23", &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid \"zstdcompressionlevel\" of 23: must be between -1 and 22");
+
+   memset (&error, 0, sizeof (bson_error_t));
+   ASSERT (!mongoc_uri_new_with_error ("mongodb://localhost/db?compressionminbytes=-1", &error));
+   ASSERT_ERROR_CONTAINS (error,
+                          MONGOC_ERROR_COMMAND,
+                          MONGOC_ERROR_COMMAND_INVALID_ARG,
+                          "Invalid \"compressionminbytes\" of -1: must be non-negative");
+
    memset (&error, 0, sizeof (bson_error_t));
    ASSERT (!mongoc_uri_new_with_error ("mongodb+srv://", &error));
    ASSERT_ERROR_CONTAINS (
@@ -2318,6 +2332,67 @@ test_uri_depr (void)
    }
 }
 
+static void
+test_uri_connection_pool_options (void)
+{
+   // Test that a non-positive maxConnecting warns and is ignored.
+   {
+      capture_logs (true);
+      mongoc_uri_t *uri = mongoc_uri_new ("mongodb://host/?maxConnecting=0");
+      ASSERT (uri);
+      ASSERT_CAPTURED_LOG ("uri", MONGOC_LOG_LEVEL_WARNING, "must be positive");
+      ASSERT (!mongoc_uri_has_option (uri, MONGOC_URI_MAXCONNECTING));
+      capture_logs (false);
+      mongoc_uri_destroy (uri);
+   }
+   // Test that maxConnecting and sharedConnectionPool are parsed.
+   {
+      mongoc_uri_t *uri = mongoc_uri_new ("mongodb://host/?maxConnecting=5&sharedConnectionPool=true");
+      ASSERT (uri);
+      ASSERT_CMPINT32 (mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_MAXCONNECTING, 0), ==, 5);
+      ASSERT (mongoc_uri_get_option_as_bool (uri, MONGOC_URI_SHAREDCONNECTIONPOOL, false));
+      mongoc_uri_destroy (uri);
+   }
+   // Test that the setter rejects a non-positive maxConnecting.
+   {
+      mongoc_uri_t *uri = mongoc_uri_new ("mongodb://host/");
+      ASSERT (uri);
+      capture_logs (true);
+      ASSERT (!mongoc_uri_set_option_as_int32 (uri, MONGOC_URI_MAXCONNECTING, 0));
+      capture_logs (false);
+      ASSERT (!mongoc_uri_has_option (uri, MONGOC_URI_MAXCONNECTING));
+      mongoc_uri_destroy (uri);
+   }
+   // Test that a negative minIdleConnections is an error.
+   {
+      bson_error_t error;
+      capture_logs (true);
+      mongoc_uri_t *uri = mongoc_uri_new_with_error ("mongodb://host/?minIdleConnections=-1", &error);
+      ASSERT (!uri);
+      ASSERT_ERROR_CONTAINS (error, MONGOC_ERROR_COMMAND, MONGOC_ERROR_COMMAND_INVALID_ARG, "must be non-negative");
+      capture_logs (false);
+
+      uri = mongoc_uri_new ("mongodb://host/?minIdleConnections=3");
+      ASSERT (uri);
+      ASSERT_CMPINT32 (mongoc_uri_get_option_as_int32 (uri, MONGOC_URI_MINIDLECONNECTIONS, 0), ==, 3);
+      mongoc_uri_destroy (uri);
+   }
+}
+
+static void
+test_uri_power_of_two_choices (void)
+{
+   mongoc_uri_t *uri = mongoc_uri_new ("mongodb://host/?powerOfTwoChoices=true");
+   ASSERT (uri);
+   ASSERT (mongoc_uri_get_option_as_bool (uri, MONGOC_URI_POWEROFTWOCHOICES, false));
+   mongoc_uri_destroy (uri);
+
+   uri = mongoc_uri_new ("mongodb://host/");
+   ASSERT (uri);
+   ASSERT (!mongoc_uri_get_option_as_bool (uri, MONGOC_URI_POWEROFTWOCHOICES, false));
+   mongoc_uri_destroy (uri);
+}
+
 void
 test_uri_install (TestSuite *suite)
 {
@@ -2346,4 +2421,6 @@ test_uri_install (TestSuite *suite)
    TestSuite_Add (suite, "/Uri/options_casing", test_casing_options);
    TestSuite_Add (suite, "/Uri/parses_long_ipv6", test_parses_long_ipv6);
    TestSuite_Add (suite, "/Uri/depr", test_uri_depr);
+   TestSuite_Add (suite, "/Uri/connection_pool_options", test_uri_connection_pool_options);
+   TestSuite_Add (suite, "/Uri/power_of_two_choices", test_uri_power_of_two_choices);
 }